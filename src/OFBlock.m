@@ -441,6 +441,17 @@ _Block_object_dispose(const void *obj_, const int flags_)
 	return OF_RETAIN_COUNT_MAX;
 }
 
+- (BOOL)allowsWeakReference
+{
+	/* Blocks don't have the retain count of OFObject */
+	return NO;
+}
+
+- (BOOL)retainWeakReference
+{
+	return NO;
+}
+
 - (void)release
 {
 	if (object_getClass(self) == (Class)&_NSConcreteMallocBlock)
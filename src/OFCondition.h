@@ -38,6 +38,31 @@
  */
 - (void)wait;
 
+/*!
+ * @brief Blocks the current thread until another thread calls @ref signal or
+ *	  @ref broadcast or the specified time interval has passed.
+ *
+ * The time interval is measured with a monotonic clock, so it is not affected
+ * by changes of the system time.
+ *
+ * @param timeInterval The time interval until the wait times out, in seconds
+ * @return Whether the condition was signaled. NO means the wait timed out.
+ */
+- (BOOL)waitForTimeInterval: (double)timeInterval;
+
+/*!
+ * @brief Blocks the current thread until another thread calls @ref signal or
+ *	  @ref broadcast or the specified deadline is reached.
+ *
+ * As conditions can be woken up spuriously, waiting is usually done in a loop.
+ * Passing the same deadline in each iteration makes sure the total time
+ * waited does not exceed the deadline.
+ *
+ * @param deadline The deadline as a time comparable to of_monotonic_time()
+ * @return Whether the condition was signaled. NO means the wait timed out.
+ */
+- (BOOL)waitUntilDeadline: (uint64_t)deadline;
+
 /*!
  * @brief Signals the next waiting thread to continue.
  */
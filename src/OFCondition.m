@@ -16,6 +16,8 @@
 
 #include "config.h"
 
+#include <errno.h>
+
 #import "OFCondition.h"
 
 #import "OFConditionBroadcastFailedException.h"
@@ -53,6 +55,26 @@
 			     condition: self];
 }
 
+- (BOOL)waitForTimeInterval: (double)timeInterval
+{
+	return [self waitUntilDeadline:
+	    of_deadline_after(of_monotonic_time(), timeInterval)];
+}
+
+- (BOOL)waitUntilDeadline: (uint64_t)deadline
+{
+	if (!of_condition_timed_wait(&condition, &mutex, deadline)) {
+		if (errno == ETIMEDOUT)
+			return NO;
+
+		@throw [OFConditionWaitFailedException
+		    exceptionWithClass: [self class]
+			     condition: self];
+	}
+
+	return YES;
+}
+
 - (void)signal
 {
 	if (!of_condition_signal(&condition))
@@ -105,6 +105,16 @@ struct {
 	return OF_RETAIN_COUNT_MAX;
 }
 
+- (BOOL)allowsWeakReference
+{
+	return YES;
+}
+
+- (BOOL)retainWeakReference
+{
+	return YES;
+}
+
 - (void)release
 {
 }
@@ -225,6 +235,16 @@ struct {
 	return OF_RETAIN_COUNT_MAX;
 }
 
+- (BOOL)allowsWeakReference
+{
+	return YES;
+}
+
+- (BOOL)retainWeakReference
+{
+	return YES;
+}
+
 - (void)release
 {
 }
@@ -20,12 +20,19 @@
 @class OFString;
 @class OFConstantString;
 
+struct of_date_civil;
+
 /*!
  * @brief A class for storing, accessing and comparing dates.
+ *
+ * The date in UTC is only computed once per OFDate when it is first needed
+ * and then cached, so accessing several components of the same date is cheap.
+ * See OFDateFormatter for fast formatting and parsing of dates.
  */
 @interface OFDate: OFObject <OFCopying, OFComparing, OFSerialization>
 {
 	double seconds;
+	struct of_date_civil *volatile civil;
 }
 
 /*!
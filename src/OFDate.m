@@ -17,6 +17,7 @@
 #include "config.h"
 
 #define _GNU_SOURCE
+#include <stdlib.h>
 #include <stdint.h>
 #include <limits.h>
 #include <time.h>
@@ -26,6 +27,7 @@
 #include <sys/time.h>
 
 #import "OFDate.h"
+#import "OFDateFormatter.h"
 #import "OFString.h"
 #import "OFDictionary.h"
 #import "OFXMLElement.h"
@@ -36,31 +38,34 @@
 #import "OFInitializationFailedException.h"
 #import "OFInvalidArgumentException.h"
 #import "OFInvalidFormatException.h"
+#import "OFOutOfMemoryException.h"
 #import "OFOutOfRangeException.h"
 
 #import "autorelease.h"
+#import "atomic.h"
 #import "macros.h"
 #import "of_strptime.h"
 
-#if (!defined(HAVE_GMTIME_R) || !defined(HAVE_LOCALTIME_R)) && \
-    defined(OF_THREADS)
+#if !defined(HAVE_LOCALTIME_R) && defined(OF_THREADS)
 static OFMutex *mutex;
 #endif
 
-#ifdef HAVE_GMTIME_R
-# define GMTIME_RET(field)						\
-	time_t seconds_ = (time_t)seconds;				\
-	struct tm tm;							\
-									\
-	if (seconds_ != floor(seconds))					\
-		@throw [OFOutOfRangeException				\
-		    exceptionWithClass: [self class]];			\
-									\
-	if (gmtime_r(&seconds_, &tm) == NULL)				\
-		@throw [OFOutOfRangeException				\
-		    exceptionWithClass: [self class]];			\
-									\
-	return tm.field;
+struct of_date_civil {
+	int64_t year;
+	uint16_t dayOfYear;
+	uint8_t monthOfYear, dayOfMonth, dayOfWeek;
+	uint8_t hour, minute, second;
+};
+
+/*
+ * The civil date is only needed for UTC and is computed without gmtime(), so
+ * it can be cached in the date. Local time still needs localtime(), as it
+ * depends on the time zone.
+ */
+#define CIVIL_RET(field)						\
+	return [self OF_civilDate]->field;
+
+#ifdef HAVE_LOCALTIME_R
 # define LOCALTIME_RET(field)						\
 	time_t seconds_ = (time_t)seconds;				\
 	struct tm tm;							\
@@ -76,25 +81,6 @@ static OFMutex *mutex;
 	return tm.field;
 #else
 # ifdef OF_THREADS
-#  define GMTIME_RET(field)						\
-	time_t seconds_ = (time_t)seconds;				\
-	struct tm *tm;							\
-									\
-	if (seconds_ != floor(seconds))					\
-		@throw [OFOutOfRangeException				\
-		    exceptionWithClass: [self class]];			\
-									\
-	[mutex lock];							\
-									\
-	@try {								\
-		if ((tm = gmtime(&seconds_)) == NULL)			\
-			@throw [OFOutOfRangeException			\
-			    exceptionWithClass: [self class]];		\
-									\
-		return tm->field;					\
-	} @finally {							\
-		[mutex unlock];						\
-	}
 #  define LOCALTIME_RET(field)						\
 	time_t seconds_ = (time_t)seconds;				\
 	struct tm *tm;							\
@@ -115,19 +101,6 @@ static OFMutex *mutex;
 		[mutex unlock];						\
 	}
 # else
-#  define GMTIME_RET(field)						\
-	time_t seconds_ = (time_t)seconds;				\
-	struct tm *tm;							\
-									\
-	if (seconds_ != floor(seconds))					\
-		@throw [OFOutOfRangeException				\
-		    exceptionWithClass: [self class]];			\
-									\
-	if ((tm = gmtime(&seconds_)) == NULL)				\
-		@throw [OFOutOfRangeException				\
-		    exceptionWithClass: [self class]];			\
-									\
-	return tm->field;
 #  define LOCALTIME_RET(field)						\
 	time_t seconds_ = (time_t)seconds;				\
 	struct tm *tm;							\
@@ -144,6 +117,9 @@ static OFMutex *mutex;
 # endif
 #endif
 
+/* Dates further away than this can't be represented in an int64_t anymore */
+#define MAX_CIVIL_SECONDS 4611686018427387904.0
+
 static int month_to_day_of_year[12] = {
 	0,
 	31,
@@ -159,9 +135,39 @@ static int month_to_day_of_year[12] = {
 	31 + 28 + 31 + 30 + 31 + 30 + 31 + 31 + 30 + 31 + 30,
 };
 
+static OFString*
+string_from_tm(struct tm *tm, OFConstantString *format, Class class)
+{
+	OFString *ret;
+	char stackBuffer[128], *buffer;
+
+	/* Most formats fit into a small buffer, so try without malloc first */
+	if (strftime(stackBuffer, sizeof(stackBuffer), [format UTF8String], tm))
+		return [OFString stringWithUTF8String: stackBuffer];
+
+	if ((buffer = malloc(of_pagesize)) == NULL)
+		@throw [OFOutOfMemoryException exceptionWithClass: class
+						    requestedSize: of_pagesize];
+
+	@try {
+		if (!strftime(buffer, of_pagesize, [format UTF8String], tm))
+			@throw [OFOutOfRangeException
+			    exceptionWithClass: class];
+
+		ret = [OFString stringWithUTF8String: buffer];
+	} @finally {
+		free(buffer);
+	}
+
+	return ret;
+}
+
+@interface OFDate (OF_PrivateMethods)
+- (const struct of_date_civil*)OF_civilDate;
+@end
+
 @implementation OFDate
-#if (!defined(HAVE_GMTIME_R) || !defined(HAVE_LOCALTIME_R)) && \
-    defined(OF_THREADS)
+#if !defined(HAVE_LOCALTIME_R) && defined(OF_THREADS)
 + (void)initialize
 {
 	if (self == [OFDate class])
@@ -250,7 +256,7 @@ static int month_to_day_of_year[12] = {
 	self = [super init];
 
 	@try {
-		struct tm tm = {};
+		struct tm tm = { 0 };
 
 		tm.tm_isdst = -1;
 
@@ -297,7 +303,7 @@ static int month_to_day_of_year[12] = {
 	self = [super init];
 
 	@try {
-		struct tm tm = {};
+		struct tm tm = { 0 };
 
 		tm.tm_isdst = -1;
 
@@ -382,6 +388,13 @@ static int month_to_day_of_year[12] = {
 	return hash;
 }
 
+- (void)dealloc
+{
+	free(civil);
+
+	[super dealloc];
+}
+
 - copy
 {
 	return [self retain];
@@ -408,7 +421,13 @@ static int month_to_day_of_year[12] = {
 
 - (OFString*)description
 {
-	return [self dateStringWithFormat: @"%Y-%m-%dT%H:%M:%SZ"];
+	int64_t year = [self OF_civilDate]->year;
+
+	/* The ISO 8601 formatter only handles years with four digits */
+	if (year < 0 || year > 9999)
+		return [self dateStringWithFormat: @"%Y-%m-%dT%H:%M:%SZ"];
+
+	return [[OFDateFormatter ISO8601DateFormatter] stringFromDate: self];
 }
 
 - (OFXMLElement*)XMLElementBySerializing
@@ -441,17 +460,17 @@ static int month_to_day_of_year[12] = {
 
 - (uint8_t)second
 {
-	GMTIME_RET(tm_sec)
+	CIVIL_RET(second)
 }
 
 - (uint8_t)minute
 {
-	GMTIME_RET(tm_min)
+	CIVIL_RET(minute)
 }
 
 - (uint8_t)hour
 {
-	GMTIME_RET(tm_hour)
+	CIVIL_RET(hour)
 }
 
 - (uint8_t)localHour
@@ -461,7 +480,7 @@ static int month_to_day_of_year[12] = {
 
 - (uint8_t)dayOfMonth
 {
-	GMTIME_RET(tm_mday)
+	CIVIL_RET(dayOfMonth)
 }
 
 - (uint8_t)localDayOfMonth
@@ -471,7 +490,7 @@ static int month_to_day_of_year[12] = {
 
 - (uint8_t)monthOfYear
 {
-	GMTIME_RET(tm_mon + 1)
+	CIVIL_RET(monthOfYear)
 }
 
 - (uint8_t)localMonthOfYear
@@ -481,7 +500,7 @@ static int month_to_day_of_year[12] = {
 
 - (uint16_t)year
 {
-	GMTIME_RET(tm_year + 1900)
+	CIVIL_RET(year)
 }
 
 - (uint16_t)localYear
@@ -491,7 +510,7 @@ static int month_to_day_of_year[12] = {
 
 - (uint8_t)dayOfWeek
 {
-	GMTIME_RET(tm_wday)
+	CIVIL_RET(dayOfWeek)
 }
 
 - (uint8_t)localDayOfWeek
@@ -501,7 +520,7 @@ static int month_to_day_of_year[12] = {
 
 - (uint16_t)dayOfYear
 {
-	GMTIME_RET(tm_yday + 1)
+	CIVIL_RET(dayOfYear)
 }
 
 - (uint16_t)localDayOfYear
@@ -509,60 +528,105 @@ static int month_to_day_of_year[12] = {
 	LOCALTIME_RET(tm_yday + 1)
 }
 
-- (OFString*)dateStringWithFormat: (OFConstantString*)format
+- (const struct of_date_civil*)OF_civilDate
 {
-	OFString *ret;
-	time_t seconds_ = (time_t)seconds;
-	struct tm tm;
-	char *buffer;
+	struct of_date_civil *date = civil;
+	int64_t days, rem, z, era, doe, yoe, doy, mp, year;
+	uint8_t month;
 
-	if (seconds_ != floor(seconds))
-		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+	if (date != NULL) {
+		/* Make sure the fields are not read before the pointer */
+		of_memory_read_barrier();
+		return date;
+	}
 
-#ifdef HAVE_GMTIME_R
-	if (gmtime_r(&seconds_, &tm) == NULL)
+	if (!(seconds > -MAX_CIVIL_SECONDS && seconds < MAX_CIVIL_SECONDS))
 		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
-#else
-# ifdef OF_THREADS
-	[mutex lock];
 
-	@try {
-# endif
-		struct tm *tmp;
+	days = (int64_t)floor(seconds);
+	rem = days % 86400;
+	days /= 86400;
 
-		if ((tmp = gmtime(&seconds_)) == NULL)
-			@throw [OFOutOfRangeException
-			    exceptionWithClass: [self class]];
+	if (rem < 0) {
+		rem += 86400;
+		days--;
+	}
 
-		tm = *tmp;
-# ifdef OF_THREADS
-	} @finally {
-		[mutex unlock];
+	if ((date = malloc(sizeof(*date))) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithClass: [self class]
+			 requestedSize: sizeof(*date)];
+
+	date->hour = (uint8_t)(rem / 3600);
+	date->minute = (uint8_t)(rem / 60 % 60);
+	date->second = (uint8_t)(rem % 60);
+	/* 1970-01-01 was a Thursday */
+	date->dayOfWeek = (uint8_t)(((days % 7) + 11) % 7);
+
+	/*
+	 * Convert the days since the epoch to a date in the proleptic Gregorian
+	 * calendar. Years are counted from March here, so that the leap day is
+	 * the last day of a year. An era is a cycle of 400 years, after which
+	 * the calendar repeats.
+	 */
+	z = days + 719468;
+	era = (z >= 0 ? z : z - 146096) / 146097;
+	doe = z - era * 146097;
+	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	mp = (5 * doy + 2) / 153;
+	month = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+	year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+	date->year = year;
+	date->monthOfYear = month;
+	date->dayOfMonth = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+
+	if (month <= 2)
+		date->dayOfYear = (uint16_t)(doy - 306 + 1);
+	else
+		date->dayOfYear = (uint16_t)(doy + 60 +
+		    ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0
+		    ? 1 : 0));
+
+	/*
+	 * Other threads might compute the same date concurrently. The one
+	 * that publishes it first wins, and the barrier of the compare and
+	 * swap makes sure the fields are stored before the pointer.
+	 */
+	if (!of_atomic_cmpswap_ptr((void* volatile*)&civil, NULL, date)) {
+		free(date);
+		date = civil;
+		of_memory_read_barrier();
 	}
-# endif
-#endif
 
-	buffer = [self allocMemoryWithSize: of_pagesize];
+	return date;
+}
 
-	@try {
-		if (!strftime(buffer, of_pagesize, [format UTF8String], &tm))
-			@throw [OFOutOfRangeException
-			    exceptionWithClass: [self class]];
+- (OFString*)dateStringWithFormat: (OFConstantString*)format
+{
+	const struct of_date_civil *date = [self OF_civilDate];
+	struct tm tm = { 0 };
 
-		ret = [OFString stringWithUTF8String: buffer];
-	} @finally {
-		[self freeMemory: buffer];
-	}
+	if (date->year - 1900 < INT_MIN || date->year - 1900 > INT_MAX)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
 
-	return ret;
+	tm.tm_sec = date->second;
+	tm.tm_min = date->minute;
+	tm.tm_hour = date->hour;
+	tm.tm_mday = date->dayOfMonth;
+	tm.tm_mon = date->monthOfYear - 1;
+	tm.tm_year = (int)(date->year - 1900);
+	tm.tm_wday = date->dayOfWeek;
+	tm.tm_yday = date->dayOfYear - 1;
+
+	return string_from_tm(&tm, format, [self class]);
 }
 
 - (OFString*)localDateStringWithFormat: (OFConstantString*)format
 {
-	OFString *ret;
 	time_t seconds_ = (time_t)seconds;
 	struct tm tm;
-	char *buffer;
 
 	if (seconds_ != floor(seconds))
 		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
@@ -590,19 +654,7 @@ static int month_to_day_of_year[12] = {
 # endif
 #endif
 
-	buffer = [self allocMemoryWithSize: of_pagesize];
-
-	@try {
-		if (!strftime(buffer, of_pagesize, [format UTF8String], &tm))
-			@throw [OFOutOfRangeException
-			    exceptionWithClass: [self class]];
-
-		ret = [OFString stringWithUTF8String: buffer];
-	} @finally {
-		[self freeMemory: buffer];
-	}
-
-	return ret;
+	return string_from_tm(&tm, format, [self class]);
 }
 
 - (OFDate*)earlierDate: (OFDate*)otherDate
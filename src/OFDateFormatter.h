@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+@class OFString;
+@class OFDate;
+
+/*!
+ * @brief A precompiled format for converting dates to strings and back.
+ *
+ * The format is parsed once when the formatter is created, so formatting a
+ * date only writes the fields into a buffer, without calling strftime() or
+ * gmtime() and without allocating memory. All dates are in UTC.
+ *
+ * The following format specifiers are supported, which all produce a fixed
+ * number of characters: %%a (abbreviated English day of the week), %%b
+ * (abbreviated English month), %%d, %%H, %%m, %%M, %%S, %%Y (which needs to
+ * have 4 digits) and %%. All other characters are copied literally.
+ *
+ * Formatters are immutable and can therefore be shared between threads.
+ */
+@interface OFDateFormatter: OFObject
+{
+	struct of_date_formatter_token *tokens;
+	size_t tokensCount, formattedLength;
+}
+
+/*!
+ * @brief Returns a formatter for dates in the format specified by RFC 1123,
+ *	  which is used by HTTP, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+ *
+ * @return A shared formatter for dates in the format of RFC 1123
+ */
++ (OFDateFormatter*)RFC1123DateFormatter;
+
+/*!
+ * @brief Returns a formatter for dates in the format specified by ISO 8601,
+ *	  e.g. "1994-11-06T08:49:37Z".
+ *
+ * @return A shared formatter for dates in the format of ISO 8601
+ */
++ (OFDateFormatter*)ISO8601DateFormatter;
+
+/*!
+ * @brief Creates a new date formatter with the specified format.
+ *
+ * @param format The format for the date formatter
+ * @return A new, autoreleased OFDateFormatter
+ */
++ (instancetype)formatterWithFormat: (OFString*)format;
+
+/*!
+ * @brief Initializes an already allocated date formatter with the specified
+ *	  format.
+ *
+ * An OFInvalidFormatException is thrown if the format contains an unsupported
+ * format specifier.
+ *
+ * @param format The format for the date formatter
+ * @return An initialized OFDateFormatter
+ */
+- initWithFormat: (OFString*)format;
+
+/*!
+ * @brief Returns the length of a date formatted by the formatter.
+ *
+ * As all format specifiers produce a fixed number of characters, every
+ * formatted date has the same length.
+ *
+ * @return The length of a date formatted by the formatter
+ */
+- (size_t)formattedLength;
+
+/*!
+ * @brief Formats the specified date into the specified buffer.
+ *
+ * The result is not terminated by a zero byte. If the buffer is smaller than
+ * @ref formattedLength or the year is not between 0 and 9999, an
+ * OFOutOfRangeException is thrown.
+ *
+ * @param date The date to format
+ * @param buffer The buffer to write the formatted date to
+ * @param length The length of the buffer
+ * @return The number of bytes written to the buffer
+ */
+- (size_t)formatDate: (OFDate*)date
+	  intoBuffer: (char*)buffer
+	      length: (size_t)length;
+
+/*!
+ * @brief Formats the specified date as a string.
+ *
+ * @param date The date to format
+ * @return A new, autoreleased OFString
+ */
+- (OFString*)stringFromDate: (OFDate*)date;
+
+/*!
+ * @brief Parses the specified UTF-8 string into a date.
+ *
+ * This does not throw an exception if the string does not match the format.
+ *
+ * @param UTF8String The UTF-8 string to parse, which does not need to be
+ *		     terminated by a zero byte
+ * @param UTF8StringLength The length of the UTF-8 string
+ * @return A new, autoreleased OFDate or nil if the string does not match the
+ *	   format or is not a valid date
+ */
+- (OFDate*)dateFromUTF8String: (const char*)UTF8String
+		       length: (size_t)UTF8StringLength;
+
+/*!
+ * @brief Parses the specified string into a date.
+ *
+ * An OFInvalidFormatException is thrown if the string does not match the
+ * format or is not a valid date.
+ *
+ * @param string The string to parse
+ * @return A new, autoreleased OFDate
+ */
+- (OFDate*)dateFromString: (OFString*)string;
+@end
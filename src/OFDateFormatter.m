@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <assert.h>
+
+#import "OFDateFormatter.h"
+#import "OFDate.h"
+#import "OFString.h"
+
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+
+#import "autorelease.h"
+#import "macros.h"
+
+/* 0000-01-01T00:00:00Z and 10000-01-01T00:00:00Z */
+#define MIN_SECONDS -62167219200.0
+#define MAX_SECONDS 253402300800.0
+
+enum {
+	TOKEN_LITERAL,
+	TOKEN_DAY_NAME,
+	TOKEN_MONTH_NAME,
+	TOKEN_DAY,
+	TOKEN_HOUR,
+	TOKEN_MONTH,
+	TOKEN_MINUTE,
+	TOKEN_SECOND,
+	TOKEN_YEAR
+};
+
+struct of_date_formatter_token {
+	uint8_t type;
+	char literal;
+};
+
+static const char *dayNames[7] = {
+	"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+};
+static const char *monthNames[12] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+static OFDateFormatter *RFC1123DateFormatter = nil;
+static OFDateFormatter *ISO8601DateFormatter = nil;
+
+static OF_INLINE size_t
+token_length(uint8_t type)
+{
+	switch (type) {
+	case TOKEN_LITERAL:
+		return 1;
+	case TOKEN_DAY_NAME:
+	case TOKEN_MONTH_NAME:
+		return 3;
+	case TOKEN_YEAR:
+		return 4;
+	default:
+		return 2;
+	}
+}
+
+static OF_INLINE BOOL
+parse_digits(const char *string, size_t length, unsigned *value)
+{
+	size_t i;
+
+	*value = 0;
+
+	for (i = 0; i < length; i++) {
+		if (string[i] < '0' || string[i] > '9')
+			return NO;
+
+		*value = (*value * 10) + (string[i] - '0');
+	}
+
+	return YES;
+}
+
+static OF_INLINE int
+parse_name(const char *string, const char **names, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		if (memcmp(string, names[i], 3) == 0)
+			return i;
+
+	return -1;
+}
+
+/* Returns the days since 1970-01-01 for a date in the Gregorian calendar */
+static int64_t
+days_from_civil(int64_t year, unsigned month, unsigned day)
+{
+	int64_t era, yoe, doy, doe;
+
+	/* Count years from March, so that the leap day is the last day */
+	if (month <= 2)
+		year--;
+
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = year - era * 400;
+	doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + doe - 719468;
+}
+
+static OF_INLINE unsigned
+days_in_month(unsigned year, unsigned month)
+{
+	static const uint8_t days[12] = {
+		31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+	};
+
+	if (month == 2 &&
+	    ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0))
+		return 29;
+
+	return days[month - 1];
+}
+
+@implementation OFDateFormatter
++ (void)initialize
+{
+	if (self != [OFDateFormatter class])
+		return;
+
+	RFC1123DateFormatter = [[self alloc]
+	    initWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
+	ISO8601DateFormatter = [[self alloc]
+	    initWithFormat: @"%Y-%m-%dT%H:%M:%SZ"];
+}
+
++ (OFDateFormatter*)RFC1123DateFormatter
+{
+	return RFC1123DateFormatter;
+}
+
++ (OFDateFormatter*)ISO8601DateFormatter
+{
+	return ISO8601DateFormatter;
+}
+
++ (instancetype)formatterWithFormat: (OFString*)format
+{
+	return [[[self alloc] initWithFormat: format] autorelease];
+}
+
+- initWithFormat: (OFString*)format
+{
+	self = [super init];
+
+	@try {
+		const char *UTF8String = [format UTF8String];
+		size_t i, UTF8StringLength = [format UTF8StringLength];
+
+		/* There can't be more tokens than bytes */
+		tokens = [self
+		    allocMemoryWithSize: sizeof(struct of_date_formatter_token)
+				  count: UTF8StringLength];
+
+		for (i = 0; i < UTF8StringLength; i++) {
+			struct of_date_formatter_token *token =
+			    &tokens[tokensCount++];
+
+			token->literal = '\0';
+
+			if (UTF8String[i] != '%') {
+				token->type = TOKEN_LITERAL;
+				token->literal = UTF8String[i];
+				formattedLength++;
+				continue;
+			}
+
+			if (++i >= UTF8StringLength)
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			switch (UTF8String[i]) {
+			case 'a':
+				token->type = TOKEN_DAY_NAME;
+				break;
+			case 'b':
+				token->type = TOKEN_MONTH_NAME;
+				break;
+			case 'd':
+				token->type = TOKEN_DAY;
+				break;
+			case 'H':
+				token->type = TOKEN_HOUR;
+				break;
+			case 'm':
+				token->type = TOKEN_MONTH;
+				break;
+			case 'M':
+				token->type = TOKEN_MINUTE;
+				break;
+			case 'S':
+				token->type = TOKEN_SECOND;
+				break;
+			case 'Y':
+				token->type = TOKEN_YEAR;
+				break;
+			case '%':
+				token->type = TOKEN_LITERAL;
+				token->literal = '%';
+				break;
+			default:
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+			}
+
+			formattedLength += token_length(token->type);
+		}
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self freeMemory: tokens];
+
+	[super dealloc];
+}
+
+- (size_t)formattedLength
+{
+	return formattedLength;
+}
+
+- (size_t)formatDate: (OFDate*)date
+	  intoBuffer: (char*)buffer
+	      length: (size_t)length
+{
+	double seconds = [date timeIntervalSince1970];
+	unsigned value;
+	size_t i, j;
+
+	if (length < formattedLength)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	if (!(seconds >= MIN_SECONDS && seconds < MAX_SECONDS))
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	for (i = j = 0; i < tokensCount; i++) {
+		switch (tokens[i].type) {
+		case TOKEN_LITERAL:
+			buffer[j++] = tokens[i].literal;
+			continue;
+		case TOKEN_DAY_NAME:
+			memcpy(buffer + j, dayNames[[date dayOfWeek]], 3);
+			j += 3;
+			continue;
+		case TOKEN_MONTH_NAME:
+			memcpy(buffer + j,
+			    monthNames[[date monthOfYear] - 1], 3);
+			j += 3;
+			continue;
+		case TOKEN_YEAR:
+			value = [date year];
+			buffer[j++] = '0' + value / 1000;
+			buffer[j++] = '0' + value / 100 % 10;
+			buffer[j++] = '0' + value / 10 % 10;
+			buffer[j++] = '0' + value % 10;
+			continue;
+		case TOKEN_DAY:
+			value = [date dayOfMonth];
+			break;
+		case TOKEN_HOUR:
+			value = [date hour];
+			break;
+		case TOKEN_MONTH:
+			value = [date monthOfYear];
+			break;
+		case TOKEN_MINUTE:
+			value = [date minute];
+			break;
+		case TOKEN_SECOND:
+			value = [date second];
+			break;
+		default:
+			assert(0);
+		}
+
+		buffer[j++] = '0' + value / 10;
+		buffer[j++] = '0' + value % 10;
+	}
+
+	return j;
+}
+
+- (OFString*)stringFromDate: (OFDate*)date
+{
+	char stackBuffer[64];
+	char *buffer = stackBuffer;
+	size_t length = formattedLength;
+	OFString *ret;
+
+	if (length > sizeof(stackBuffer))
+		buffer = [self allocMemoryWithSize: length];
+
+	@try {
+		length = [self formatDate: date
+			       intoBuffer: buffer
+				   length: length];
+
+		ret = [OFString stringWithUTF8String: buffer
+					      length: length];
+	} @finally {
+		if (buffer != stackBuffer)
+			[self freeMemory: buffer];
+	}
+
+	return ret;
+}
+
+- (OFDate*)dateFromUTF8String: (const char*)UTF8String
+		       length: (size_t)UTF8StringLength
+{
+	unsigned year = 1970, month = 1, day = 1;
+	unsigned hour = 0, minute = 0, second = 0;
+	int dayOfWeek = -1;
+	int64_t days;
+	size_t i, j;
+
+	if (UTF8StringLength != formattedLength)
+		return nil;
+
+	for (i = j = 0; i < tokensCount; i++) {
+		const char *field = UTF8String + j;
+		BOOL valid = YES;
+
+		j += token_length(tokens[i].type);
+
+		switch (tokens[i].type) {
+		case TOKEN_LITERAL:
+			valid = (*field == tokens[i].literal);
+			break;
+		case TOKEN_DAY_NAME:
+			dayOfWeek = parse_name(field, dayNames, 7);
+			valid = (dayOfWeek != -1);
+			break;
+		case TOKEN_MONTH_NAME:
+			month = parse_name(field, monthNames, 12) + 1;
+			valid = (month != 0);
+			break;
+		case TOKEN_YEAR:
+			valid = parse_digits(field, 4, &year);
+			break;
+		case TOKEN_DAY:
+			valid = parse_digits(field, 2, &day);
+			break;
+		case TOKEN_HOUR:
+			valid = parse_digits(field, 2, &hour);
+			break;
+		case TOKEN_MONTH:
+			valid = parse_digits(field, 2, &month);
+			break;
+		case TOKEN_MINUTE:
+			valid = parse_digits(field, 2, &minute);
+			break;
+		case TOKEN_SECOND:
+			valid = parse_digits(field, 2, &second);
+			break;
+		}
+
+		if (!valid)
+			return nil;
+	}
+
+	/* A second of 60 is allowed for leap seconds */
+	if (month < 1 || month > 12 || day < 1 ||
+	    day > days_in_month(year, month) || hour > 23 || minute > 59 ||
+	    second > 60)
+		return nil;
+
+	days = days_from_civil(year, month, day);
+
+	/* 1970-01-01 was a Thursday */
+	if (dayOfWeek != -1 && ((days % 7) + 11) % 7 != dayOfWeek)
+		return nil;
+
+	return [OFDate dateWithTimeIntervalSince1970:
+	    (double)(days * 86400 + hour * 3600 + minute * 60 + second)];
+}
+
+- (OFDate*)dateFromString: (OFString*)string
+{
+	OFDate *date = [self dateFromUTF8String: [string UTF8String]
+					 length: [string UTF8StringLength]];
+
+	if (date == nil)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+
+	return date;
+}
+@end
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFStream.h"
+
+@class OFString;
+
+struct of_deflate_huffman_tree;
+
+/*!
+ * @brief A class which compresses or decompresses data in the Deflate format
+ *	  (RFC 1951) while it is written to or read from another stream.
+ *
+ * Reading from an OFDeflateStream decompresses the data read from the
+ * underlying stream. As the underlying stream is read in blocks, an
+ * OFDeflateStream might read past the end of the compressed data.
+ *
+ * Writing to an OFDeflateStream compresses the data and writes it to the
+ * underlying stream. Written data is collected into blocks of 32 KB, which are
+ * compressed using the fixed Huffman codes and can refer to the 32 KB written
+ * before them. The compressed data is only complete after the stream has been
+ * closed.
+ *
+ * The data is processed incrementally, so that only a window of 32 KB of it
+ * needs to be kept in memory.
+ *
+ * A stream created without a mode only finishes the compressed data when it
+ * is closed if data has been written to it. To create valid compressed data
+ * even if no data is written, create the stream with the mode @"w".
+ */
+@interface OFDeflateStream: OFStream
+{
+	OFStream *stream;
+	uint8_t *inBuffer;
+	size_t inBufferIndex, inBufferLength;
+	uint32_t bitBuffer;
+	unsigned bitCount;
+	uint8_t *window;
+	size_t windowIndex, windowFilled;
+	int state;
+	BOOL lastBlock, atEndOfStream;
+	size_t storedLength, copyLength, copyDistance;
+	struct of_deflate_huffman_tree *litLenTree, *distTree;
+	struct of_deflate_huffman_tree *dynamicTrees;
+	uint32_t outBitBuffer;
+	unsigned outBitCount;
+	uint8_t *history, *outBuffer;
+	size_t *head;
+	size_t historyLength, historyOffset, pendingStart;
+	BOOL compressing, writeMode;
+}
+
+/*!
+ * @brief Creates a new OFDeflateStream with the specified underlying stream.
+ *
+ * @param stream The underlying stream for the compressed data
+ * @return A new, autoreleased OFDeflateStream
+ */
++ (instancetype)streamWithStream: (OFStream*)stream;
+
+/*!
+ * @brief Creates a new OFDeflateStream with the specified underlying stream
+ *	  and mode.
+ *
+ * @param stream The underlying stream for the compressed data
+ * @param mode The mode for the stream, either @"r" for decompressing or @"w"
+ *	       for compressing
+ * @return A new, autoreleased OFDeflateStream
+ */
++ (instancetype)streamWithStream: (OFStream*)stream
+			    mode: (OFString*)mode;
+
+/*!
+ * @brief Initializes an already allocated OFDeflateStream with the specified
+ *	  underlying stream.
+ *
+ * @param stream The underlying stream for the compressed data
+ * @return An initialized OFDeflateStream
+ */
+- initWithStream: (OFStream*)stream;
+
+/*!
+ * @brief Initializes an already allocated OFDeflateStream with the specified
+ *	  underlying stream and mode.
+ *
+ * @param stream The underlying stream for the compressed data
+ * @param mode The mode for the stream, either @"r" for decompressing or @"w"
+ *	       for compressing
+ * @return An initialized OFDeflateStream
+ */
+- initWithStream: (OFStream*)stream
+	    mode: (OFString*)mode;
+
+/*!
+ * @brief Finishes the compressed data if the stream was created with the mode
+ *	  @"w" or data has been written, and closes the underlying stream.
+ */
+- (void)close;
+
+- (uint16_t)OF_readBits: (unsigned)count;
+- (void)OF_skipToByteBoundary;
+- (void)OF_finishCompressing;
+@end
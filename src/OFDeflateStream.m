@@ -0,0 +1,740 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFDeflateStream.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidFormatException.h"
+#import "OFNotImplementedException.h"
+#import "OFTruncatedDataException.h"
+
+#define BUFFER_SIZE 4096
+#define WINDOW_SIZE 32768
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+#define HISTORY_SIZE (2 * WINDOW_SIZE)
+#define MAX_BITS 15
+#define HASH_BITS 14
+#define HASH_SIZE (1 << HASH_BITS)
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+
+enum {
+	STATE_BLOCK_HEADER,
+	STATE_STORED_BLOCK,
+	STATE_HUFFMAN_BLOCK,
+	STATE_COPY,
+	STATE_END
+};
+
+/*
+ * A canonical Huffman code, stored as the number of codes of each length and
+ * the symbols ordered by their codes.
+ */
+struct of_deflate_huffman_tree {
+	uint16_t counts[MAX_BITS + 1];
+	uint16_t symbols[288];
+};
+
+static const uint16_t lengthBases[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51,
+	59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtraBits[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,
+	4, 5, 5, 5, 5, 0
+};
+static const uint16_t distanceBases[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+	513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distanceExtraBits[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10,
+	10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t codeLengthsOrder[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static struct of_deflate_huffman_tree fixedLitLenTree, fixedDistTree;
+
+static BOOL
+build_tree(struct of_deflate_huffman_tree *tree, const uint8_t *lengths,
+    uint16_t count)
+{
+	uint16_t offsets[MAX_BITS + 1];
+	uint16_t i;
+	int left = 1;
+
+	memset(tree->counts, 0, sizeof(tree->counts));
+
+	for (i = 0; i < count; i++)
+		tree->counts[lengths[i]]++;
+
+	/* Reject over-subscribed sets of code lengths */
+	for (i = 1; i <= MAX_BITS; i++) {
+		left <<= 1;
+		left -= tree->counts[i];
+
+		if (left < 0)
+			return NO;
+	}
+
+	offsets[1] = 0;
+	for (i = 1; i < MAX_BITS; i++)
+		offsets[i + 1] = offsets[i] + tree->counts[i];
+
+	for (i = 0; i < count; i++)
+		if (lengths[i] != 0)
+			tree->symbols[offsets[lengths[i]]++] = i;
+
+	return YES;
+}
+
+static uint16_t
+reverse_bits(uint16_t bits, unsigned count)
+{
+	uint16_t ret = 0;
+
+	while (count-- > 0) {
+		ret = (ret << 1) | (bits & 1);
+		bits >>= 1;
+	}
+
+	return ret;
+}
+
+static OF_INLINE void
+write_bits(uint32_t *bitBuffer, unsigned *bitCount, uint8_t *out,
+    size_t *outLength, uint16_t bits, unsigned count)
+{
+	*bitBuffer |= (uint32_t)bits << *bitCount;
+	*bitCount += count;
+
+	while (*bitCount >= 8) {
+		out[(*outLength)++] = (uint8_t)*bitBuffer;
+		*bitBuffer >>= 8;
+		*bitCount -= 8;
+	}
+}
+
+/* Writes a symbol using the fixed literal/length code */
+static OF_INLINE void
+write_lit_len(uint32_t *bitBuffer, unsigned *bitCount, uint8_t *out,
+    size_t *outLength, uint16_t symbol)
+{
+	if (symbol < 144)
+		write_bits(bitBuffer, bitCount, out, outLength,
+		    reverse_bits(0x30 + symbol, 8), 8);
+	else if (symbol < 256)
+		write_bits(bitBuffer, bitCount, out, outLength,
+		    reverse_bits(0x190 + symbol - 144, 9), 9);
+	else if (symbol < 280)
+		write_bits(bitBuffer, bitCount, out, outLength,
+		    reverse_bits(symbol - 256, 7), 7);
+	else
+		write_bits(bitBuffer, bitCount, out, outLength,
+		    reverse_bits(0xC0 + symbol - 280, 8), 8);
+}
+
+static void
+add_to_window(uint8_t *window, size_t *windowIndex, size_t *windowFilled,
+    const uint8_t *bytes, size_t length)
+{
+	while (length > 0) {
+		size_t n = WINDOW_SIZE - *windowIndex;
+
+		if (n > length)
+			n = length;
+
+		memcpy(window + *windowIndex, bytes, n);
+		*windowIndex = (*windowIndex + n) & WINDOW_MASK;
+		bytes += n;
+		length -= n;
+
+		if (*windowFilled + n < WINDOW_SIZE)
+			*windowFilled += n;
+		else
+			*windowFilled = WINDOW_SIZE;
+	}
+}
+
+@interface OFDeflateStream (OF_PrivateMethods)
+- (void)OF_allocateCompressionBuffers;
+- (void)OF_compressPending;
+@end
+
+@implementation OFDeflateStream
++ (void)initialize
+{
+	uint8_t lengths[288];
+	uint16_t i;
+
+	if (self != [OFDeflateStream class])
+		return;
+
+	for (i = 0; i < 144; i++)
+		lengths[i] = 8;
+	for (; i < 256; i++)
+		lengths[i] = 9;
+	for (; i < 280; i++)
+		lengths[i] = 7;
+	for (; i < 288; i++)
+		lengths[i] = 8;
+	build_tree(&fixedLitLenTree, lengths, 288);
+
+	for (i = 0; i < 30; i++)
+		lengths[i] = 5;
+	build_tree(&fixedDistTree, lengths, 30);
+}
+
++ (instancetype)streamWithStream: (OFStream*)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
++ (instancetype)streamWithStream: (OFStream*)stream
+			    mode: (OFString*)mode
+{
+	return [[[self alloc] initWithStream: stream
+					mode: mode] autorelease];
+}
+
+- init
+{
+	Class c = [self class];
+	[self release];
+	@throw [OFNotImplementedException exceptionWithClass: c
+						    selector: _cmd];
+}
+
+- initWithStream: (OFStream*)stream_
+{
+	self = [super init];
+
+	@try {
+		stream = [stream_ retain];
+		inBuffer = [self allocMemoryWithSize: BUFFER_SIZE];
+		window = [self allocMemoryWithSize: WINDOW_SIZE];
+		state = STATE_BLOCK_HEADER;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- initWithStream: (OFStream*)stream_
+	    mode: (OFString*)mode
+{
+	self = [self initWithStream: stream_];
+
+	if ([mode isEqual: @"w"]) {
+		writeMode = YES;
+
+		@try {
+			[self OF_allocateCompressionBuffers];
+		} @catch (id e) {
+			[self release];
+			@throw e;
+		}
+	} else if (![mode isEqual: @"r"]) {
+		Class c = [self class];
+		[self release];
+		@throw [OFInvalidArgumentException exceptionWithClass: c
+							     selector: _cmd];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[stream release];
+
+	[super dealloc];
+}
+
+- (void)OF_refillInputBuffer
+{
+	do {
+		if ([stream isAtEndOfStream])
+			@throw [OFTruncatedDataException
+			    exceptionWithClass: [self class]];
+
+		inBufferLength = [stream readIntoBuffer: inBuffer
+						 length: BUFFER_SIZE];
+		inBufferIndex = 0;
+	} while (inBufferLength == 0);
+}
+
+- (uint16_t)OF_readBits: (unsigned)count
+{
+	uint16_t ret;
+
+	while (bitCount < count) {
+		if (inBufferIndex == inBufferLength)
+			[self OF_refillInputBuffer];
+
+		bitBuffer |= (uint32_t)inBuffer[inBufferIndex++] << bitCount;
+		bitCount += 8;
+	}
+
+	ret = bitBuffer & ((1u << count) - 1);
+	bitBuffer >>= count;
+	bitCount -= count;
+
+	return ret;
+}
+
+- (void)OF_skipToByteBoundary
+{
+	/* The bit buffer never contains a complete byte between reads */
+	bitBuffer = 0;
+	bitCount = 0;
+}
+
+- (uint16_t)OF_decodeSymbolWithTree: (struct of_deflate_huffman_tree*)tree
+{
+	int code = 0, first = 0, index = 0;
+	unsigned length;
+
+	for (length = 1; length <= MAX_BITS; length++) {
+		int count;
+
+		if (bitCount == 0) {
+			if (inBufferIndex == inBufferLength)
+				[self OF_refillInputBuffer];
+
+			bitBuffer = inBuffer[inBufferIndex++];
+			bitCount = 8;
+		}
+
+		code |= bitBuffer & 1;
+		bitBuffer >>= 1;
+		bitCount--;
+
+		count = tree->counts[length];
+		if (code - first < count)
+			return tree->symbols[index + code - first];
+
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	@throw [OFInvalidFormatException exceptionWithClass: [self class]];
+}
+
+- (void)OF_readDynamicTrees
+{
+	uint8_t lengths[286 + 30];
+	struct of_deflate_huffman_tree codeLengthsTree;
+	uint16_t litLenCount, distCount, codeLengthsCount, i;
+
+	litLenCount = [self OF_readBits: 5] + 257;
+	distCount = [self OF_readBits: 5] + 1;
+	codeLengthsCount = [self OF_readBits: 4] + 4;
+
+	if (litLenCount > 286 || distCount > 30)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+
+	memset(lengths, 0, 19);
+	for (i = 0; i < codeLengthsCount; i++)
+		lengths[codeLengthsOrder[i]] = [self OF_readBits: 3];
+
+	if (!build_tree(&codeLengthsTree, lengths, 19))
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+
+	for (i = 0; i < litLenCount + distCount;) {
+		uint16_t symbol =
+		    [self OF_decodeSymbolWithTree: &codeLengthsTree];
+		uint8_t value = 0;
+		uint16_t repeat;
+
+		if (symbol < 16) {
+			lengths[i++] = (uint8_t)symbol;
+			continue;
+		}
+
+		if (symbol == 16) {
+			if (i == 0)
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			value = lengths[i - 1];
+			repeat = 3 + [self OF_readBits: 2];
+		} else if (symbol == 17)
+			repeat = 3 + [self OF_readBits: 3];
+		else
+			repeat = 11 + [self OF_readBits: 7];
+
+		if (i + repeat > litLenCount + distCount)
+			@throw [OFInvalidFormatException
+			    exceptionWithClass: [self class]];
+
+		while (repeat-- > 0)
+			lengths[i++] = value;
+	}
+
+	/* The end of block code is required */
+	if (lengths[256] == 0)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+
+	if (dynamicTrees == NULL)
+		dynamicTrees = [self allocMemoryWithSize:
+		    sizeof(struct of_deflate_huffman_tree)
+				   count: 2];
+
+	litLenTree = &dynamicTrees[0];
+	distTree = &dynamicTrees[1];
+
+	if (!build_tree(litLenTree, lengths, litLenCount) ||
+	    !build_tree(distTree, lengths + litLenCount, distCount))
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer_
+			  length: (size_t)length
+{
+	uint8_t *buffer = buffer_;
+	size_t written = 0;
+
+	while (written < length) {
+		uint16_t symbol;
+		size_t n;
+
+		/*
+		 * Don't wait for more input if there already is something to
+		 * return.
+		 */
+		if (written > 0 && inBufferIndex == inBufferLength &&
+		    state != STATE_COPY)
+			return written;
+
+		switch (state) {
+		case STATE_BLOCK_HEADER:
+			if (lastBlock) {
+				state = STATE_END;
+				break;
+			}
+
+			lastBlock = [self OF_readBits: 1];
+
+			switch ([self OF_readBits: 2]) {
+			case 0:
+				[self OF_skipToByteBoundary];
+
+				storedLength = [self OF_readBits: 16];
+				if ((storedLength ^ 0xFFFF) !=
+				    [self OF_readBits: 16])
+					@throw [OFInvalidFormatException
+					    exceptionWithClass: [self class]];
+
+				state = STATE_STORED_BLOCK;
+				break;
+			case 1:
+				litLenTree = &fixedLitLenTree;
+				distTree = &fixedDistTree;
+				state = STATE_HUFFMAN_BLOCK;
+				break;
+			case 2:
+				[self OF_readDynamicTrees];
+				state = STATE_HUFFMAN_BLOCK;
+				break;
+			default:
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+			}
+
+			break;
+		case STATE_STORED_BLOCK:
+			if (storedLength == 0) {
+				state = STATE_BLOCK_HEADER;
+				break;
+			}
+
+			if (inBufferIndex == inBufferLength)
+				[self OF_refillInputBuffer];
+
+			n = length - written;
+			if (n > storedLength)
+				n = storedLength;
+			if (n > inBufferLength - inBufferIndex)
+				n = inBufferLength - inBufferIndex;
+
+			memcpy(buffer + written, inBuffer + inBufferIndex, n);
+			add_to_window(window, &windowIndex, &windowFilled,
+			    buffer + written, n);
+
+			inBufferIndex += n;
+			storedLength -= n;
+			written += n;
+
+			break;
+		case STATE_HUFFMAN_BLOCK:
+			symbol = [self OF_decodeSymbolWithTree: litLenTree];
+
+			if (symbol < 256) {
+				buffer[written++] = (uint8_t)symbol;
+
+				window[windowIndex] = (uint8_t)symbol;
+				windowIndex = (windowIndex + 1) & WINDOW_MASK;
+				if (windowFilled < WINDOW_SIZE)
+					windowFilled++;
+
+				break;
+			}
+
+			if (symbol == 256) {
+				state = STATE_BLOCK_HEADER;
+				break;
+			}
+
+			symbol -= 257;
+			if (symbol >= 29)
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			copyLength = lengthBases[symbol] +
+			    [self OF_readBits: lengthExtraBits[symbol]];
+
+			symbol = [self OF_decodeSymbolWithTree: distTree];
+			if (symbol >= 30)
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			copyDistance = distanceBases[symbol] +
+			    [self OF_readBits: distanceExtraBits[symbol]];
+
+			if (copyDistance > windowFilled)
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			state = STATE_COPY;
+			break;
+		case STATE_COPY:
+			while (copyLength > 0 && written < length) {
+				uint8_t byte = window[
+				    (windowIndex - copyDistance) & WINDOW_MASK];
+
+				buffer[written++] = byte;
+
+				window[windowIndex] = byte;
+				windowIndex = (windowIndex + 1) & WINDOW_MASK;
+				if (windowFilled < WINDOW_SIZE)
+					windowFilled++;
+
+				copyLength--;
+			}
+
+			if (copyLength == 0)
+				state = STATE_HUFFMAN_BLOCK;
+
+			break;
+		case STATE_END:
+			atEndOfStream = YES;
+			return written;
+		}
+	}
+
+	return written;
+}
+
+- (BOOL)lowlevelIsAtEndOfStream
+{
+	return atEndOfStream;
+}
+
+- (void)OF_allocateCompressionBuffers
+{
+	size_t i;
+
+	if (head != NULL)
+		return;
+
+	history = [self allocMemoryWithSize: HISTORY_SIZE];
+	/* At most 9 bits per byte, plus the block header and end */
+	outBuffer = [self allocMemoryWithSize:
+	    HISTORY_SIZE + HISTORY_SIZE / 8 + 8];
+	head = [self allocMemoryWithSize: sizeof(size_t)
+				   count: HASH_SIZE];
+
+	for (i = 0; i < HASH_SIZE; i++)
+		head[i] = SIZE_MAX;
+}
+
+- (void)OF_compressPending
+{
+	uint8_t *out = outBuffer;
+	size_t i = pendingStart, outLength = 0;
+
+	if (pendingStart == historyLength)
+		return;
+
+	/* A non-final block using the fixed Huffman codes */
+	write_bits(&outBitBuffer, &outBitCount, out, &outLength, 2, 3);
+
+	while (i < historyLength) {
+		size_t matchLength = 0, matchDistance = 0;
+		uint16_t code;
+
+		if (historyLength - i >= MIN_MATCH) {
+			size_t position = historyOffset + i, candidate;
+			uint32_t hash;
+
+			hash = ((history[i] << 16) | (history[i + 1] << 8) |
+			    history[i + 2]) * 2654435761u;
+			hash >>= 32 - HASH_BITS;
+
+			candidate = head[hash];
+			head[hash] = position;
+
+			/*
+			 * Positions count all bytes written so far, so that the
+			 * table stays valid when the history is moved. Unused
+			 * entries are SIZE_MAX and thus never before position.
+			 */
+			if (candidate < position &&
+			    candidate >= historyOffset &&
+			    position - candidate <= WINDOW_SIZE) {
+				const uint8_t *match =
+				    history + (candidate - historyOffset);
+				size_t max = historyLength - i;
+
+				if (max > MAX_MATCH)
+					max = MAX_MATCH;
+
+				while (matchLength < max &&
+				    match[matchLength] ==
+				    history[i + matchLength])
+					matchLength++;
+
+				matchDistance = position - candidate;
+			}
+		}
+
+		if (matchLength < MIN_MATCH) {
+			write_lit_len(&outBitBuffer, &outBitCount, out,
+			    &outLength, history[i++]);
+			continue;
+		}
+
+		for (code = 28; lengthBases[code] > matchLength; code--);
+
+		write_lit_len(&outBitBuffer, &outBitCount, out, &outLength,
+		    257 + code);
+		write_bits(&outBitBuffer, &outBitCount, out, &outLength,
+		    matchLength - lengthBases[code], lengthExtraBits[code]);
+
+		for (code = 29; distanceBases[code] > matchDistance; code--);
+
+		write_bits(&outBitBuffer, &outBitCount, out, &outLength,
+		    reverse_bits(code, 5), 5);
+		write_bits(&outBitBuffer, &outBitCount, out, &outLength,
+		    matchDistance - distanceBases[code],
+		    distanceExtraBits[code]);
+
+		i += matchLength;
+	}
+
+	write_lit_len(&outBitBuffer, &outBitCount, out, &outLength, 256);
+
+	[stream writeBuffer: out
+		     length: outLength];
+
+	pendingStart = historyLength;
+}
+
+- (void)lowlevelWriteBuffer: (const void*)buffer_
+		     length: (size_t)length
+{
+	const uint8_t *buffer = buffer_;
+
+	if (length == 0)
+		return;
+
+	compressing = YES;
+	[self OF_allocateCompressionBuffers];
+
+	while (length > 0) {
+		size_t n;
+
+		if (historyLength == HISTORY_SIZE) {
+			[self OF_compressPending];
+
+			/* Keep the last window for matches with later data */
+			memmove(history, history + WINDOW_SIZE,
+			    HISTORY_SIZE - WINDOW_SIZE);
+			historyLength -= WINDOW_SIZE;
+			historyOffset += WINDOW_SIZE;
+			pendingStart = historyLength;
+		}
+
+		n = HISTORY_SIZE - historyLength;
+		if (n > length)
+			n = length;
+
+		memcpy(history + historyLength, buffer, n);
+		historyLength += n;
+		buffer += n;
+		length -= n;
+	}
+}
+
+- (void)OF_finishCompressing
+{
+	uint8_t out[4];
+	size_t outLength = 0;
+
+	if (head != NULL)
+		[self OF_compressPending];
+
+	/* An empty final block */
+	write_bits(&outBitBuffer, &outBitCount, out, &outLength, 3, 3);
+	write_lit_len(&outBitBuffer, &outBitCount, out, &outLength, 256);
+
+	if (outBitCount > 0) {
+		out[outLength++] = (uint8_t)outBitBuffer;
+		outBitBuffer = 0;
+		outBitCount = 0;
+	}
+
+	[stream writeBuffer: out
+		     length: outLength];
+}
+
+- (void)close
+{
+	if (compressing || writeMode) {
+		[self OF_finishCompressing];
+		compressing = writeMode = NO;
+	}
+
+	[stream close];
+}
+@end
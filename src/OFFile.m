@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <errno.h>
 
 #include <unistd.h>
 
@@ -693,17 +694,49 @@ of_log(OFConstantString *format, ...)
 
 - (size_t)lowlevelReadIntoBuffer: (void*)buffer
 			  length: (size_t)length
+{
+	size_t ret;
+	int errNo;
+
+	ret = [self lowlevelReadIntoBuffer: buffer
+				    length: length
+				     error: &errNo];
+
+	if (errNo != 0) {
+		OFReadFailedException *e;
+
+		e = [OFReadFailedException exceptionWithClass: [self class]
+						       stream: self
+					      requestedLength: length];
+		e->errNo = errNo;
+
+		@throw e;
+	}
+
+	return ret;
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)length
+			   error: (int*)errNo
 {
 	ssize_t ret;
 
-	if (fd == -1 || atEndOfStream || (ret = read(fd, buffer, length)) < 0)
-		@throw [OFReadFailedException exceptionWithClass: [self class]
-							  stream: self
-						 requestedLength: length];
+	if (fd == -1 || atEndOfStream) {
+		*errNo = EBADF;
+		return 0;
+	}
+
+	if ((ret = read(fd, buffer, length)) < 0) {
+		*errNo = errno;
+		return 0;
+	}
 
 	if (ret == 0)
 		atEndOfStream = YES;
 
+	*errNo = 0;
+
 	return ret;
 }
 
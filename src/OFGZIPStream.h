@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFDeflateStream.h"
+
+/*!
+ * @brief A class which compresses or decompresses data in the gzip format
+ *	  (RFC 1952) while it is written to or read from another stream.
+ *
+ * Only the first member of a gzip file is read. The checksum and the size in
+ * the trailer are verified when the end of the compressed data is reached.
+ */
+@interface OFGZIPStream: OFDeflateStream
+{
+	int gzipState;
+	uint32_t CRC32, uncompressedSize;
+	BOOL headerWritten;
+}
+@end
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFGZIPStream.h"
+
+#import "OFInvalidFormatException.h"
+
+enum {
+	STATE_HEADER,
+	STATE_DATA,
+	STATE_END
+};
+
+enum {
+	FLAG_HCRC = 0x02,
+	FLAG_EXTRA = 0x04,
+	FLAG_NAME = 0x08,
+	FLAG_COMMENT = 0x10,
+	FLAG_RESERVED = 0xE0
+};
+
+static uint32_t CRC32Table[256];
+
+static uint32_t
+crc32_update(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+	size_t i;
+
+	for (i = 0; i < length; i++)
+		crc = CRC32Table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+@interface OFGZIPStream (OF_PrivateMethods)
+- (void)OF_writeHeader;
+@end
+
+@implementation OFGZIPStream
++ (void)initialize
+{
+	uint32_t i;
+
+	if (self != [OFGZIPStream class])
+		return;
+
+	for (i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		int j;
+
+		for (j = 0; j < 8; j++)
+			crc = (crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1);
+
+		CRC32Table[i] = crc;
+	}
+}
+
+- initWithStream: (OFStream*)stream_
+{
+	self = [super initWithStream: stream_];
+
+	gzipState = STATE_HEADER;
+	CRC32 = 0xFFFFFFFF;
+
+	return self;
+}
+
+- (uint32_t)OF_readLittleEndianInt32
+{
+	uint32_t low = [self OF_readBits: 16];
+
+	return low | ((uint32_t)[self OF_readBits: 16] << 16);
+}
+
+- (void)OF_readHeader
+{
+	uint8_t flags;
+
+	if ([self OF_readBits: 8] != 0x1F || [self OF_readBits: 8] != 0x8B ||
+	    [self OF_readBits: 8] != 8)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+
+	flags = (uint8_t)[self OF_readBits: 8];
+
+	if (flags & FLAG_RESERVED)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+
+	/* Modification time, extra flags and operating system */
+	[self OF_readLittleEndianInt32];
+	[self OF_readBits: 16];
+
+	if (flags & FLAG_EXTRA) {
+		uint16_t length = [self OF_readBits: 16];
+
+		while (length-- > 0)
+			[self OF_readBits: 8];
+	}
+
+	if (flags & FLAG_NAME)
+		while ([self OF_readBits: 8] != 0);
+
+	if (flags & FLAG_COMMENT)
+		while ([self OF_readBits: 8] != 0);
+
+	if (flags & FLAG_HCRC)
+		[self OF_readBits: 16];
+}
+
+- (void)OF_readTrailer
+{
+	[self OF_skipToByteBoundary];
+
+	if ([self OF_readLittleEndianInt32] != ~CRC32 ||
+	    [self OF_readLittleEndianInt32] != uncompressedSize)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)length
+{
+	size_t ret;
+
+	if (gzipState == STATE_HEADER) {
+		[self OF_readHeader];
+		gzipState = STATE_DATA;
+	}
+
+	if (gzipState != STATE_DATA)
+		return 0;
+
+	ret = [super lowlevelReadIntoBuffer: buffer
+				     length: length];
+
+	CRC32 = crc32_update(CRC32, buffer, ret);
+	uncompressedSize += (uint32_t)ret;
+
+	if (atEndOfStream) {
+		[self OF_readTrailer];
+		gzipState = STATE_END;
+	}
+
+	return ret;
+}
+
+- (BOOL)lowlevelIsAtEndOfStream
+{
+	return (gzipState == STATE_END);
+}
+
+- (void)lowlevelWriteBuffer: (const void*)buffer
+		     length: (size_t)length
+{
+	if (length == 0)
+		return;
+
+	if (!headerWritten)
+		[self OF_writeHeader];
+
+	CRC32 = crc32_update(CRC32, buffer, length);
+	uncompressedSize += (uint32_t)length;
+
+	[super lowlevelWriteBuffer: buffer
+			    length: length];
+}
+
+- (void)OF_writeHeader
+{
+	/* No name, modification time or extra flags, unknown OS */
+	static const uint8_t header[10] = {
+		0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF
+	};
+
+	[stream writeBuffer: header
+		     length: sizeof(header)];
+	headerWritten = YES;
+}
+
+- (void)OF_finishCompressing
+{
+	/* Even empty data needs a header */
+	if (!headerWritten)
+		[self OF_writeHeader];
+
+	[super OF_finishCompressing];
+
+	[stream writeLittleEndianInt32: ~CRC32];
+	[stream writeLittleEndianInt32: uncompressedSize];
+}
+@end
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+@class OFMutableDictionary;
+@class OFTCPSocket;
+@class OFURL;
+
+/*!
+ * @brief A pool of idle, persistent HTTP connections.
+ *
+ * After an OFHTTPRequest has read a complete response from a server which
+ * allows keeping the connection alive, it returns the socket to its connection
+ * pool. The next request to the same scheme, host and port then reuses the
+ * socket instead of resolving the host and connecting again.
+ *
+ * Before an idle socket is reused, it is checked whether it has been idle for
+ * longer than the idle timeout and whether the server closed it or sent
+ * unexpected data in the meantime. Stale sockets are closed and dropped.
+ */
+@interface OFHTTPConnectionPool: OFObject
+{
+	OFMutableDictionary *idleConnections;
+	size_t maxIdleConnectionsPerHost;
+	double idleTimeout;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property size_t maxIdleConnectionsPerHost;
+@property double idleTimeout;
+#endif
+
+/*!
+ * @brief Returns the connection pool which is used by all OFHTTPRequests by
+ *	  default.
+ *
+ * @return The shared connection pool
+ */
++ (OFHTTPConnectionPool*)sharedPool;
+
+/*!
+ * @brief Creates a new, empty connection pool.
+ *
+ * @return A new, autoreleased OFHTTPConnectionPool
+ */
++ (instancetype)connectionPool;
+
+/*!
+ * @brief Sets the maximum number of idle connections kept per scheme, host
+ *	  and port.
+ *
+ * The default is 4. If more connections are returned to the pool, the ones
+ * which have been idle the longest are closed.
+ *
+ * @param maxIdleConnectionsPerHost The maximum number of idle connections per
+ *				    host
+ */
+- (void)setMaxIdleConnectionsPerHost: (size_t)maxIdleConnectionsPerHost;
+
+/*!
+ * @brief Returns the maximum number of idle connections kept per scheme, host
+ *	  and port.
+ *
+ * @return The maximum number of idle connections per host
+ */
+- (size_t)maxIdleConnectionsPerHost;
+
+/*!
+ * @brief Sets the time after which an idle connection is closed instead of
+ *	  being reused.
+ *
+ * The default is 30 seconds.
+ *
+ * @param idleTimeout The idle timeout in seconds
+ */
+- (void)setIdleTimeout: (double)idleTimeout;
+
+/*!
+ * @brief Returns the time after which an idle connection is closed instead of
+ *	  being reused.
+ *
+ * @return The idle timeout in seconds
+ */
+- (double)idleTimeout;
+
+/*!
+ * @brief Removes an idle socket connected to the scheme, host and port of the
+ *	  specified URL from the pool and returns it.
+ *
+ * @param URL The URL to which a socket is needed
+ * @return An idle, connected socket or nil if there is none
+ */
+- (OFTCPSocket*)socketForURL: (OFURL*)URL;
+
+/*!
+ * @brief Returns a socket which is connected to the scheme, host and port of
+ *	  the specified URL to the pool.
+ *
+ * The socket must not have any unread data and the server must allow sending
+ * further requests on it.
+ *
+ * @param socket The socket to return to the pool
+ * @param URL The URL the socket is connected to
+ */
+- (void)addSocket: (OFTCPSocket*)socket
+	   forURL: (OFURL*)URL;
+
+/*!
+ * @brief Closes all idle sockets and removes them from the pool.
+ */
+- (void)removeAllSockets;
+@end
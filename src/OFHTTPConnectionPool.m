@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#define __NO_EXT_QNX
+
+#ifdef HAVE_POLL_H
+# include <poll.h>
+#elif defined(OF_HAVE_SYS_SELECT_H)
+# include <sys/select.h>
+#endif
+
+#import "OFHTTPConnectionPool.h"
+#import "OFString.h"
+#import "OFArray.h"
+#import "OFDictionary.h"
+#import "OFTCPSocket.h"
+#import "OFURL.h"
+
+#import "autorelease.h"
+#import "macros.h"
+#import "of_clock.h"
+
+static OFHTTPConnectionPool *sharedPool = nil;
+
+@interface OFHTTPConnectionPool_Connection: OFObject
+{
+@public
+	OFTCPSocket *socket;
+	uint64_t idleSince;
+}
+@end
+
+@implementation OFHTTPConnectionPool_Connection
+- (void)dealloc
+{
+	[socket release];
+
+	[super dealloc];
+}
+@end
+
+static OFString*
+key_for_url(OFURL *URL)
+{
+	return [OFString stringWithFormat: @"%@://%@:%d",
+	    [URL scheme], [URL host], [URL port]];
+}
+
+/*
+ * An idle HTTP connection must not become readable. If it does, the server
+ * either closed it or sent data nobody asked for, so it can't be reused.
+ */
+static BOOL
+is_stale(OFTCPSocket *socket)
+{
+	int fd;
+#ifdef HAVE_POLL_H
+	struct pollfd pfd = { 0, POLLIN, 0 };
+#else
+	fd_set readFDs;
+	struct timeval timeout = { 0, 0 };
+#endif
+
+	if ([socket pendingBytes] > 0 || [socket isAtEndOfStream])
+		return YES;
+
+	if ((fd = [socket fileDescriptorForReading]) == -1)
+		return YES;
+
+#ifdef HAVE_POLL_H
+	pfd.fd = fd;
+
+	return (poll(&pfd, 1, 0) != 0);
+#else
+	FD_ZERO(&readFDs);
+	FD_SET(fd, &readFDs);
+
+	return (select(fd + 1, &readFDs, NULL, NULL, &timeout) != 0);
+#endif
+}
+
+static void
+close_connection(OFHTTPConnectionPool_Connection *connection)
+{
+	@try {
+		[connection->socket close];
+	} @catch (id e) {
+		/* We don't care, the connection is dropped anyway */
+	}
+}
+
+static void
+close_all_connections(OFDictionary *idleConnections)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFEnumerator *enumerator = [idleConnections objectEnumerator];
+	OFArray *connections;
+
+	while ((connections = [enumerator nextObject]) != nil) {
+		id *objects = [connections objects];
+		size_t i, count = [connections count];
+
+		for (i = 0; i < count; i++)
+			close_connection(objects[i]);
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+@interface OFHTTPConnectionPool (OF_PrivateMethods)
+- (void)OF_removeExpiredConnections: (uint64_t)now;
+@end
+
+@implementation OFHTTPConnectionPool
++ (void)initialize
+{
+	if (self == [OFHTTPConnectionPool class])
+		sharedPool = [[self alloc] init];
+}
+
++ (OFHTTPConnectionPool*)sharedPool
+{
+	return sharedPool;
+}
+
++ (instancetype)connectionPool
+{
+	return [[[self alloc] init] autorelease];
+}
+
+- init
+{
+	self = [super init];
+
+	@try {
+		idleConnections = [[OFMutableDictionary alloc] init];
+		maxIdleConnectionsPerHost = 4;
+		idleTimeout = 30;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	close_all_connections(idleConnections);
+	[idleConnections release];
+
+	[super dealloc];
+}
+
+- (void)setMaxIdleConnectionsPerHost: (size_t)maxIdleConnectionsPerHost_
+{
+	maxIdleConnectionsPerHost = maxIdleConnectionsPerHost_;
+}
+
+- (size_t)maxIdleConnectionsPerHost
+{
+	return maxIdleConnectionsPerHost;
+}
+
+- (void)setIdleTimeout: (double)idleTimeout_
+{
+	idleTimeout = idleTimeout_;
+}
+
+- (double)idleTimeout
+{
+	return idleTimeout;
+}
+
+- (OFTCPSocket*)socketForURL: (OFURL*)URL
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *key = key_for_url(URL);
+	OFTCPSocket *socket = nil;
+
+	@synchronized (self) {
+		OFMutableArray *connections =
+		    [idleConnections objectForKey: key];
+		uint64_t now = of_monotonic_time();
+
+		[self OF_removeExpiredConnections: now];
+
+		/* Use the most recently used connection first */
+		while ([connections count] > 0) {
+			OFHTTPConnectionPool_Connection *connection =
+			    [connections lastObject];
+
+			[[connection retain] autorelease];
+			[connections removeLastObject];
+
+			if (of_deadline_after(connection->idleSince,
+			    idleTimeout) <= now ||
+			    is_stale(connection->socket)) {
+				close_connection(connection);
+				continue;
+			}
+
+			socket = [connection->socket retain];
+			break;
+		}
+
+		if (connections != nil && [connections count] == 0)
+			[idleConnections removeObjectForKey: key];
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return [socket autorelease];
+}
+
+/*
+ * Closes the expired connections of all hosts, so that connections to hosts
+ * which are never requested again don't stay open. Must be called while
+ * synchronized.
+ */
+- (void)OF_removeExpiredConnections: (uint64_t)now
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFArray *keys = [idleConnections allKeys];
+	OFString **objects = [keys objects];
+	size_t i, count = [keys count];
+
+	for (i = 0; i < count; i++) {
+		OFMutableArray *connections =
+		    [idleConnections objectForKey: objects[i]];
+
+		/* The connections are sorted by the time they became idle */
+		while ([connections count] > 0) {
+			OFHTTPConnectionPool_Connection *connection =
+			    [connections firstObject];
+
+			if (of_deadline_after(connection->idleSince,
+			    idleTimeout) > now)
+				break;
+
+			close_connection(connection);
+			[connections removeObjectAtIndex: 0];
+		}
+
+		if ([connections count] == 0)
+			[idleConnections removeObjectForKey: objects[i]];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)addSocket: (OFTCPSocket*)socket
+	   forURL: (OFURL*)URL
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *key = key_for_url(URL);
+	OFHTTPConnectionPool_Connection *connection;
+
+	connection = [[[OFHTTPConnectionPool_Connection alloc] init]
+	    autorelease];
+	connection->socket = [socket retain];
+	connection->idleSince = of_monotonic_time();
+
+	@synchronized (self) {
+		OFMutableArray *connections;
+
+		[self OF_removeExpiredConnections: connection->idleSince];
+
+		connections = [idleConnections objectForKey: key];
+
+		if (connections == nil) {
+			connections = [OFMutableArray array];
+			[idleConnections setObject: connections
+					    forKey: key];
+		}
+
+		[connections addObject: connection];
+
+		/* Close the connections which have been idle the longest */
+		while ([connections count] > maxIdleConnectionsPerHost) {
+			close_connection([connections firstObject]);
+			[connections removeObjectAtIndex: 0];
+		}
+
+		if ([connections count] == 0)
+			[idleConnections removeObjectForKey: key];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)removeAllSockets
+{
+	OFMutableDictionary *newIdleConnections =
+	    [[OFMutableDictionary alloc] init];
+
+	@synchronized (self) {
+		close_all_connections(idleConnections);
+		[idleConnections release];
+		idleConnections = newIdleConnections;
+	}
+}
+@end
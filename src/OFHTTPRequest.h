@@ -17,12 +17,16 @@
 #import "OFObject.h"
 
 @class OFString;
+@class OFArray;
 @class OFDictionary;
 @class OFURL;
 @class OFHTTPRequest;
 @class OFHTTPRequestResult;
 @class OFTCPSocket;
 @class OFDataArray;
+@class OFHTTPConnectionPool;
+@class OFStream;
+@class OFException;
 
 typedef enum of_http_request_type_t {
 	OF_HTTP_REQUEST_TYPE_GET,
@@ -30,6 +34,11 @@ typedef enum of_http_request_type_t {
 	OF_HTTP_REQUEST_TYPE_HEAD
 } of_http_request_type_t;
 
+#ifdef OF_HAVE_BLOCKS
+typedef void (^of_http_request_block_t)(OFHTTPRequest*, OFHTTPRequestResult*,
+    OFException*);
+#endif
+
 /*!
  * @brief A delegate for OFHTTPRequests.
  */
@@ -44,6 +53,9 @@ typedef enum of_http_request_type_t {
 /*!
  * @brief A callback which is called when an OFHTTPRequest creates a socket.
  *
+ * This is only called for new connections, not when an idle connection from
+ * the connection pool is reused.
+ *
  * This is useful if the connection is using HTTPS and the server requires a
  * client certificate. This callback can then be used to tell the TLS socket
  * about the certificate. Another use case is to tell the socket about a SOCKS5
@@ -98,10 +110,36 @@ typedef enum of_http_request_type_t {
  */
 -	 (BOOL)request: (OFHTTPRequest*)request
   willFollowRedirectTo: (OFURL*)URL;
+
+/*!
+ * @brief A callback which is called when an asynchronously performed
+ *	  OFHTTPRequest finished successfully.
+ *
+ * @param request The OFHTTPRequest which finished
+ * @param result The result of the OFHTTPRequest
+ */
+-	(void)request: (OFHTTPRequest*)request
+  didFinishWithResult: (OFHTTPRequestResult*)result;
+
+/*!
+ * @brief A callback which is called when an asynchronously performed
+ *	  OFHTTPRequest failed.
+ *
+ * @param request The OFHTTPRequest which failed
+ * @param exception The exception describing the failure. This is the
+ *		    exception which performing the request synchronously would
+ *		    have thrown.
+ */
+-	 (void)request: (OFHTTPRequest*)request
+  didFailWithException: (OFException*)exception;
 @end
 
 /*!
  * @brief A class for storing and performing HTTP requests.
+ *
+ * Unless the Accept-Encoding header is set explicitly, synchronously performed
+ * requests accept gzip compressed responses and decompress them while they
+ * are received.
  */
 @interface OFHTTPRequest: OFObject
 {
@@ -111,7 +149,10 @@ typedef enum of_http_request_type_t {
 	OFDictionary *headers;
 	BOOL redirectsFromHTTPSToHTTPAllowed;
 	id <OFHTTPRequestDelegate> delegate;
-	BOOL storesData;
+	BOOL storesData, streamsBody;
+	OFStream *outputStream;
+	size_t receiveBufferSize;
+	OFHTTPConnectionPool *connectionPool;
 }
 
 #ifdef OF_HAVE_PROPERTIES
@@ -121,7 +162,10 @@ typedef enum of_http_request_type_t {
 @property (copy) OFDictionary *headers;
 @property BOOL redirectsFromHTTPSToHTTPAllowed;
 @property (assign) id <OFHTTPRequestDelegate> delegate;
-@property BOOL storesData;
+@property BOOL storesData, streamsBody;
+@property (retain) OFStream *outputStream;
+@property size_t receiveBufferSize;
+@property (retain) OFHTTPConnectionPool *connectionPool;
 #endif
 
 /*!
@@ -131,6 +175,27 @@ typedef enum of_http_request_type_t {
  */
 + (instancetype)request;
 
+/*!
+ * @brief Performs the specified requests to the same server by pipelining
+ *	  them on a single connection.
+ *
+ * All requests are written to the connection at once and the responses are
+ * read in order afterwards, so that the round trip time is only paid once per
+ * batch instead of once per request. If the server closes the connection
+ * before answering all requests, the remaining ones are sent again on a new
+ * connection. The connection pool and the socket callback of the delegate of
+ * the first request are used for the connection.
+ *
+ * Only GET and HEAD requests can be pipelined and all requests need to have
+ * the same scheme, host and port. Unlike @ref perform, redirects are not
+ * followed and no exception is thrown for unsuccessful status codes.
+ *
+ * @param requests An array of OFHTTPRequests
+ * @return An array with an OFHTTPRequestResult for each request, in the same
+ *	   order as the requests
+ */
++ (OFArray*)performRequests: (OFArray*)requests;
+
 /*!
  * @brief Creates a new OFHTTPRequest with the specified URL.
  *
@@ -248,6 +313,81 @@ typedef enum of_http_request_type_t {
  */
 - (BOOL)storesData;
 
+/*!
+ * @brief Sets whether @ref perform should return as soon as the headers have
+ *	  been received, so that the body can be read from the body stream of
+ *	  the result.
+ *
+ * The body stream decodes the chunked transfer encoding and never reads past
+ * the end of the body, so that the connection can be returned to the
+ * connection pool when the body stream is closed after it has been read
+ * completely. This allows handling bodies of any size in constant memory.
+ *
+ * This is ignored for asynchronously performed and pipelined requests.
+ *
+ * @param streamsBody Whether to return the body as a stream
+ */
+- (void)setStreamsBody: (BOOL)streamsBody;
+
+/*!
+ * @brief Returns whether @ref perform returns the body as a stream.
+ *
+ * @return Whether @ref perform returns the body as a stream
+ */
+- (BOOL)streamsBody;
+
+/*!
+ * @brief Sets a stream to which the body is written as it is received.
+ *
+ * If an output stream is set, the body is not stored in an OFDataArray. This
+ * allows writing big bodies directly to an OFFile.
+ *
+ * @param outputStream The stream to write the body to or nil
+ */
+- (void)setOutputStream: (OFStream*)outputStream;
+
+/*!
+ * @brief Returns the stream to which the body is written.
+ *
+ * @return The stream to which the body is written or nil
+ */
+- (OFStream*)outputStream;
+
+/*!
+ * @brief Sets the size of the buffer into which the body is received.
+ *
+ * The default is 64 KB. It needs to be at least 1 byte and at most 16 MB.
+ *
+ * @param receiveBufferSize The size of the buffer for receiving the body
+ */
+- (void)setReceiveBufferSize: (size_t)receiveBufferSize;
+
+/*!
+ * @brief Returns the size of the buffer into which the body is received.
+ *
+ * @return The size of the buffer for receiving the body
+ */
+- (size_t)receiveBufferSize;
+
+/*!
+ * @brief Sets the connection pool from which connections are taken and to
+ *	  which they are returned after the response has been read.
+ *
+ * The default is the shared pool of OFHTTPConnectionPool. Setting this to nil
+ * disables persistent connections and the request asks the server to close
+ * the connection.
+ *
+ * @param connectionPool The connection pool to use or nil
+ */
+- (void)setConnectionPool: (OFHTTPConnectionPool*)connectionPool;
+
+/*!
+ * @brief Returns the connection pool used by the HTTP request.
+ *
+ * @return The connection pool used by the HTTP request or nil
+ */
+- (OFHTTPConnectionPool*)connectionPool;
+
 /*!
  * @brief Performs the HTTP request and returns an OFHTTPRequestResult.
  *
@@ -264,6 +404,50 @@ typedef enum of_http_request_type_t {
  * @return An OFHTTPRequestResult with the result of the HTTP request
  */
 - (OFHTTPRequestResult*)performWithRedirects: (size_t)redirects;
+
+/*!
+ * @brief Asynchronously performs the HTTP request.
+ *
+ * The request is driven by the run loop of the current thread, which must be
+ * running for the request to make progress. Headers, data and the result or
+ * failure are delivered to the delegate. This way, a single thread can have
+ * many requests in flight.
+ */
+- (void)asyncPerform;
+
+/*!
+ * @brief Asynchronously performs the HTTP request.
+ *
+ * @param redirects The maximum number of redirects after which no further
+ *		    attempt is done to follow the redirect, but instead the
+ *		    redirect is returned as the result
+ */
+- (void)asyncPerformWithRedirects: (size_t)redirects;
+
+#ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief Asynchronously performs the HTTP request and calls the specified
+ *	  block when it finished or failed.
+ *
+ * The delegate is still informed about headers and data, but not about the
+ * result or failure.
+ *
+ * @param block The block to call with either the result or the exception
+ */
+- (void)asyncPerformWithBlock: (of_http_request_block_t)block;
+
+/*!
+ * @brief Asynchronously performs the HTTP request and calls the specified
+ *	  block when it finished or failed.
+ *
+ * @param redirects The maximum number of redirects after which no further
+ *		    attempt is done to follow the redirect, but instead the
+ *		    redirect is returned as the result
+ * @param block The block to call with either the result or the exception
+ */
+- (void)asyncPerformWithRedirects: (size_t)redirects
+			    block: (of_http_request_block_t)block;
+#endif
 @end
 
 /*!
@@ -274,12 +458,14 @@ typedef enum of_http_request_type_t {
 	short statusCode;
 	OFDataArray *data;
 	OFDictionary *headers;
+	OFStream *bodyStream;
 }
 
 #ifdef OF_HAVE_PROPERTIES
 @property (readonly) short statusCode;
 @property (readonly, copy) OFDictionary *headers;
 @property (readonly, retain) OFDataArray *data;
+@property (readonly, retain) OFStream *bodyStream;
 #endif
 
 - initWithStatusCode: (short)status
@@ -308,6 +494,16 @@ typedef enum of_http_request_type_t {
  * @return The data received for the HTTP request
  */
 - (OFDataArray*)data;
+
+/*!
+ * @brief Returns a stream from which the body of the response can be read.
+ *
+ * This is only set if the request was performed with streamsBody set to YES
+ * and the response has a body. The stream should be closed when done with it.
+ *
+ * @return A stream from which the body of the response can be read or nil
+ */
+- (OFStream*)bodyStream;
 @end
 
 @interface OFObject (OFHTTPRequestDelegate) <OFHTTPRequestDelegate>
@@ -22,24 +22,33 @@
 #include <ctype.h>
 
 #import "OFHTTPRequest.h"
+#import "OFHTTPConnectionPool.h"
 #import "OFString.h"
 #import "OFURL.h"
+#import "OFArray.h"
 #import "OFTCPSocket.h"
 #import "OFDictionary.h"
 #import "OFDataArray.h"
+#import "OFStream.h"
+#import "OFGZIPStream.h"
 
 #import "OFHTTPRequestFailedException.h"
+#import "OFInvalidArgumentException.h"
 #import "OFInvalidEncodingException.h"
 #import "OFInvalidFormatException.h"
 #import "OFInvalidServerReplyException.h"
 #import "OFOutOfRangeException.h"
+#import "OFReadFailedException.h"
 #import "OFTruncatedDataException.h"
 #import "OFUnsupportedProtocolException.h"
 #import "OFUnsupportedVersionException.h"
+#import "OFWriteFailedException.h"
 
 #import "autorelease.h"
 #import "macros.h"
 
+#define MAX_RECEIVE_BUFFER_SIZE (16 * 1024 * 1024)
+
 Class of_http_request_tls_socket_class = Nil;
 
 static OF_INLINE void
@@ -62,6 +71,717 @@ normalizeKey(OFString *key)
 	}
 }
 
+static BOOL
+keep_alive(OFString *version, OFDictionary *serverHeaders)
+{
+	OFString *connection = [serverHeaders objectForKey: @"Connection"];
+
+	if ([version isEqual: @"1.1"])
+		return (connection == nil || [connection
+		    caseInsensitiveCompare: @"close"] != OF_ORDERED_SAME);
+
+	return (connection != nil && [connection
+	    caseInsensitiveCompare: @"keep-alive"] == OF_ORDERED_SAME);
+}
+
+@interface OFHTTPRequest (OF_PrivateMethods)
+- (OFTCPSocket*)OF_createSocket;
+- (void)OF_writeHeadersToSocket: (OFTCPSocket*)sock
+		     keepAlive: (BOOL)keepAlive
+	    acceptsCompression: (BOOL)acceptsCompression;
+- (void)OF_sendRequestOnSocket: (OFTCPSocket*)sock
+	    acceptsCompression: (BOOL)acceptsCompression;
+- (int)OF_statusCodeFromStatusLine: (OFString*)line
+			   version: (OFString**)version;
+- (void)OF_addHeaderLine: (OFString*)line
+	       toHeaders: (OFMutableDictionary*)serverHeaders;
+- (OFURL*)OF_redirectURLForStatusCode: (int)status
+			      headers: (OFDictionary*)serverHeaders
+			    redirects: (size_t)redirects;
+- (void)OF_followRedirectTo: (OFURL*)URL
+		 statusCode: (int)status;
+- (BOOL)OF_responseHasBodyForStatusCode: (int)status;
+- (BOOL)OF_isIdempotent;
+- (OFHTTPRequestResult*)OF_resultWithStatusCode: (int)status
+					headers: (OFDictionary*)serverHeaders
+					   data: (OFDataArray*)data;
+- (OFString*)OF_readLineFromSocket: (OFTCPSocket*)sock;
+- (BOOL)OF_isGZIPEncoded: (OFDictionary*)serverHeaders;
+- (void)OF_releaseSocket: (OFTCPSocket*)sock
+		reusable: (BOOL)reusable;
+@end
+
+@interface OFHTTPRequestResult (OF_PrivateMethods)
+- (void)OF_setBodyStream: (OFStream*)bodyStream;
+@end
+
+/*
+ * The body of a response as a stream. It reads directly from the socket into
+ * the buffer of the caller, decodes the chunked transfer encoding and never
+ * reads past the end of the body.
+ */
+@interface OFHTTPRequest_BodyStream: OFStream
+{
+	OFHTTPRequest *request;
+	OFTCPSocket *socket;
+	BOOL chunked, hasContentLength, keepAlive;
+	BOOL atEndOfStream, delimited;
+	size_t toRead;
+}
+
+- initWithRequest: (OFHTTPRequest*)request
+	   socket: (OFTCPSocket*)socket
+	  headers: (OFDictionary*)serverHeaders
+	keepAlive: (BOOL)keepAlive;
+- (BOOL)isDelimited;
+@end
+
+enum {
+	STATE_STATUS_LINE,
+	STATE_HEADERS,
+	STATE_BODY,
+	STATE_CHUNK_HEADER,
+	STATE_CHUNK_DATA,
+	STATE_CHUNK_END,
+	STATE_TRAILERS
+};
+
+/*
+ * Performs an OFHTTPRequest asynchronously. It is a state machine driven by
+ * the async reads of the run loop, which retains it for as long as a read is
+ * pending.
+ */
+@interface OFHTTPRequest_AsyncPerformer: OFObject
+{
+@public
+	OFHTTPRequest *request;
+	size_t redirects;
+#ifdef OF_HAVE_BLOCKS
+	of_http_request_block_t block;
+#endif
+	OFTCPSocket *socket;
+	BOOL reused, keepAlive;
+	int state, status;
+	OFString *version;
+	OFMutableDictionary *serverHeaders;
+	OFURL *redirectURL;
+	OFDataArray *data;
+	BOOL hasContentLength, delimited;
+	size_t contentLength, bytesReceived, chunkLength;
+	char *buffer;
+}
+
+- initWithRequest: (OFHTTPRequest*)request
+	redirects: (size_t)redirects;
+- (void)start;
+@end
+
+@implementation OFHTTPRequest_AsyncPerformer
+- initWithRequest: (OFHTTPRequest*)request_
+	redirects: (size_t)redirects_
+{
+	self = [super init];
+
+	@try {
+		request = [request_ retain];
+		redirects = redirects_;
+		buffer = [self allocMemoryWithSize:
+		    [request receiveBufferSize]];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[request release];
+#ifdef OF_HAVE_BLOCKS
+	[block release];
+#endif
+	[socket release];
+	[version release];
+	[serverHeaders release];
+	[redirectURL release];
+	[data release];
+
+	[super dealloc];
+}
+
+/*
+ * Sockets are never closed from a callback, as the run loop still needs the
+ * file descriptor to stop observing them. Instead, the last reference is
+ * dropped and the socket is closed when it is deallocated.
+ */
+- (void)OF_dropSocket
+{
+	[socket release];
+	socket = nil;
+}
+
+- (void)OF_finishWithResult: (OFHTTPRequestResult*)result
+		  exception: (OFException*)exception
+{
+	[self OF_dropSocket];
+
+#ifdef OF_HAVE_BLOCKS
+	if (block != NULL) {
+		block(request, result, exception);
+		return;
+	}
+#endif
+
+	if (exception != nil)
+		[[request delegate] request: request
+		       didFailWithException: exception];
+	else
+		[[request delegate] request: request
+			didFinishWithResult: result];
+}
+
+- (void)OF_readLine
+{
+	SEL selector = @selector(OF_socket:didReadLine:context:exception:);
+
+	[socket asyncReadLineWithTarget: self
+			       selector: selector
+				context: nil];
+}
+
+- (void)OF_readBody
+{
+	SEL selector =
+	    @selector(OF_socket:didReadIntoBuffer:length:context:exception:);
+	size_t length = [request receiveBufferSize];
+
+	if (state == STATE_CHUNK_DATA) {
+		if (chunkLength < length)
+			length = chunkLength;
+	} else if (hasContentLength && contentLength - bytesReceived < length)
+		length = contentLength - bytesReceived;
+
+	[socket asyncReadIntoBuffer: buffer
+			     length: length
+			     target: self
+			   selector: selector
+			    context: nil];
+}
+
+- (void)OF_connect
+{
+	OFURL *URL = [request URL];
+	SEL selector = @selector(OF_socketDidConnect:context:exception:);
+
+	[self OF_dropSocket];
+	reused = NO;
+
+	socket = [[request OF_createSocket] retain];
+	[socket asyncConnectToHost: [URL host]
+			      port: [URL port]
+			    target: self
+			  selector: selector
+			   context: nil];
+}
+
+- (void)start
+{
+	OFURL *URL = [request URL];
+	OFString *scheme = [URL scheme];
+
+	if (![scheme isEqual: @"http"] && ![scheme isEqual: @"https"])
+		@throw [OFUnsupportedProtocolException
+		    exceptionWithClass: [request class]
+				   URL: URL];
+
+	state = STATE_STATUS_LINE;
+	bytesReceived = 0;
+	[serverHeaders release];
+	serverHeaders = nil;
+	serverHeaders = [[OFMutableDictionary alloc] init];
+
+	[self OF_dropSocket];
+
+	/* See -[performWithRedirects:] */
+	if ([request OF_isIdempotent])
+		socket = [[[request connectionPool] socketForURL: URL] retain];
+
+	if (socket == nil) {
+		[self OF_connect];
+		return;
+	}
+
+	reused = YES;
+
+	@try {
+		[request OF_sendRequestOnSocket: socket
+			     acceptsCompression: NO];
+	} @catch (OFWriteFailedException *e) {
+		/* The server closed the idle connection, use a new one */
+		[self OF_connect];
+		return;
+	}
+
+	[self OF_readLine];
+}
+
+- (void)OF_socketDidConnect: (OFTCPSocket*)sock
+		    context: (id)context
+		  exception: (OFException*)exception
+{
+	if (exception == nil) {
+		@try {
+			[request OF_sendRequestOnSocket: sock
+				     acceptsCompression: NO];
+		} @catch (OFException *e) {
+			exception = e;
+		}
+	}
+
+	if (exception != nil) {
+		[self OF_finishWithResult: nil
+				exception: exception];
+		return;
+	}
+
+	[self OF_readLine];
+}
+
+- (void)OF_finishBody
+{
+	OFHTTPConnectionPool *connectionPool = [request connectionPool];
+	OFHTTPRequestResult *result;
+
+	if (delimited && keepAlive && connectionPool != nil)
+		[connectionPool addSocket: socket
+				   forURL: [request URL]];
+
+	[self OF_dropSocket];
+
+	@try {
+		if (redirectURL != nil) {
+			OFURL *new = [redirectURL autorelease];
+
+			redirectURL = nil;
+
+			[request OF_followRedirectTo: new
+					  statusCode: status];
+			redirects--;
+
+			[self start];
+			return;
+		}
+
+		result = [request OF_resultWithStatusCode: status
+						  headers: serverHeaders
+						     data: data];
+	} @catch (OFException *e) {
+		[self OF_finishWithResult: nil
+				exception: e];
+		return;
+	}
+
+	[self OF_finishWithResult: result
+			exception: nil];
+}
+
+/*
+ * This is called from a read callback, while the run loop is still observing
+ * the socket. Handing it to the connection pool or following a redirect on it
+ * right away could start another read before the callback returned NO, so the
+ * rest is done from the run loop once the callback returned.
+ */
+- (void)OF_finishWithDelimitedBody: (BOOL)delimited_
+{
+	delimited = delimited_;
+
+	[self performSelector: @selector(OF_finishBody)
+		   afterDelay: 0];
+}
+
+- (void)OF_startBody
+{
+	OFString *contentLengthHeader;
+
+	if (![request OF_responseHasBodyForStatusCode: status]) {
+		[self OF_finishWithDelimitedBody: YES];
+		return;
+	}
+
+	if ([[serverHeaders objectForKey: @"Transfer-Encoding"]
+	    isEqual: @"chunked"]) {
+		state = STATE_CHUNK_HEADER;
+		[self OF_readLine];
+		return;
+	}
+
+	contentLengthHeader = [serverHeaders objectForKey: @"Content-Length"];
+	hasContentLength = (contentLengthHeader != nil);
+
+	if (hasContentLength) {
+		intmax_t length = [contentLengthHeader decimalValue];
+
+		if (length < 0 || (uintmax_t)length > SIZE_MAX)
+			@throw [OFOutOfRangeException
+			    exceptionWithClass: [request class]];
+
+		if ((contentLength = (size_t)length) == 0) {
+			[self OF_finishWithDelimitedBody: YES];
+			return;
+		}
+	}
+
+	state = STATE_BODY;
+	[self OF_readBody];
+}
+
+- (void)OF_didReceiveHeaders
+{
+	keepAlive = keep_alive(version, serverHeaders);
+
+	redirectURL = [[request OF_redirectURLForStatusCode: status
+						    headers: serverHeaders
+						  redirects: redirects] retain];
+
+	/*
+	 * The body of a redirect is skipped so that the connection can be
+	 * reused, possibly by the redirect itself.
+	 */
+	if (redirectURL == nil) {
+		[[request delegate] request: request
+			  didReceiveHeaders: serverHeaders
+			     withStatusCode: status];
+
+		[data release];
+		data = nil;
+
+		if ([request storesData] && [request outputStream] == nil)
+			data = [[OFDataArray alloc] init];
+	}
+
+	[self OF_startBody];
+}
+
+- (BOOL)OF_handleLine: (OFString*)line
+{
+	of_range_t range;
+
+	switch (state) {
+	case STATE_STATUS_LINE:
+		[version release];
+		version = nil;
+
+		status = [request OF_statusCodeFromStatusLine: line
+						      version: &version];
+		[version retain];
+
+		state = STATE_HEADERS;
+		return YES;
+	case STATE_HEADERS:
+		if (![line isEqual: @""]) {
+			[request OF_addHeaderLine: line
+					toHeaders: serverHeaders];
+			return YES;
+		}
+
+		[self OF_didReceiveHeaders];
+		return NO;
+	case STATE_CHUNK_HEADER:
+		range = [line rangeOfString: @";"];
+		if (range.location != OF_NOT_FOUND)
+			line = [line substringWithRange:
+			    of_range(0, range.location)];
+
+		@try {
+			chunkLength = (size_t)[line hexadecimalValue];
+		} @catch (OFInvalidFormatException *e) {
+			@throw [OFInvalidServerReplyException
+			    exceptionWithClass: [request class]];
+		}
+
+		if (chunkLength == 0) {
+			state = STATE_TRAILERS;
+			return YES;
+		}
+
+		state = STATE_CHUNK_DATA;
+		[self OF_readBody];
+		return NO;
+	case STATE_CHUNK_END:
+		if (![line isEqual: @""])
+			@throw [OFInvalidServerReplyException
+			    exceptionWithClass: [request class]];
+
+		state = STATE_CHUNK_HEADER;
+		return YES;
+	case STATE_TRAILERS:
+		if ([line isEqual: @""]) {
+			[self OF_finishWithDelimitedBody: YES];
+			return NO;
+		}
+
+		return YES;
+	}
+
+	OF_ENSURE(0);
+	return NO;
+}
+
+-    (BOOL)OF_socket: (OFTCPSocket*)sock
+	 didReadLine: (OFString*)line
+	     context: (id)context
+	   exception: (OFException*)exception
+{
+	/*
+	 * If a reused connection fails before the status line, the server
+	 * closed it while it was idle. Retry once on a new connection, which
+	 * is safe as only idempotent requests reuse connections.
+	 */
+	if (reused && state == STATE_STATUS_LINE && (line == nil ||
+	    [exception isKindOfClass: [OFReadFailedException class]])) {
+		@try {
+			[self OF_connect];
+		} @catch (OFException *e) {
+			[self OF_finishWithResult: nil
+					exception: e];
+		}
+
+		return NO;
+	}
+
+	@try {
+		if ([exception isKindOfClass:
+		    [OFInvalidEncodingException class]] ||
+		    (exception == nil && line == nil))
+			@throw [OFInvalidServerReplyException
+			    exceptionWithClass: [request class]];
+
+		if (exception != nil)
+			@throw exception;
+
+		return [self OF_handleLine: line];
+	} @catch (OFException *e) {
+		[self OF_finishWithResult: nil
+				exception: e];
+		return NO;
+	}
+}
+
+-	   (BOOL)OF_socket: (OFTCPSocket*)sock
+	 didReadIntoBuffer: (void*)buffer_
+		    length: (size_t)length
+		   context: (id)context
+		 exception: (OFException*)exception
+{
+	@try {
+		if (exception != nil)
+			@throw exception;
+
+		if (length > 0) {
+			if (redirectURL == nil) {
+				[[request delegate] request: request
+					     didReceiveData: buffer
+						 withLength: length];
+
+				[[request outputStream] writeBuffer: buffer
+							     length: length];
+			}
+
+			[data addItemsFromCArray: buffer
+					   count: length];
+			bytesReceived += length;
+		}
+
+		if (state == STATE_CHUNK_DATA) {
+			chunkLength -= length;
+
+			if (chunkLength == 0) {
+				state = STATE_CHUNK_END;
+				[self OF_readLine];
+				return NO;
+			}
+
+			if ([sock isAtEndOfStream])
+				@throw [OFTruncatedDataException
+				    exceptionWithClass: [request class]];
+		} else if ([sock isAtEndOfStream] ||
+		    (hasContentLength && bytesReceived >= contentLength)) {
+			/*
+			 * We only want to throw on these status codes as we
+			 * will throw an OFHTTPRequestFailedException for all
+			 * other status codes later.
+			 */
+			if (hasContentLength &&
+			    bytesReceived != contentLength && (status == 200 ||
+			    status == 301 || status == 302 || status == 303 ||
+			    status == 307))
+				@throw [OFTruncatedDataException
+				    exceptionWithClass: [request class]];
+
+			[self OF_finishWithDelimitedBody: hasContentLength &&
+			    bytesReceived == contentLength];
+			return NO;
+		}
+
+		[self OF_readBody];
+	} @catch (OFException *e) {
+		[self OF_finishWithResult: nil
+				exception: e];
+	}
+
+	return NO;
+}
+@end
+
+@implementation OFHTTPRequest_BodyStream
+- initWithRequest: (OFHTTPRequest*)request_
+	   socket: (OFTCPSocket*)socket_
+	  headers: (OFDictionary*)serverHeaders
+	keepAlive: (BOOL)keepAlive_
+{
+	self = [super init];
+
+	@try {
+		OFString *contentLengthHeader;
+
+		request = [request_ retain];
+		socket = [socket_ retain];
+		keepAlive = keepAlive_;
+
+		chunked = [[serverHeaders objectForKey: @"Transfer-Encoding"]
+		    isEqual: @"chunked"];
+
+		contentLengthHeader =
+		    [serverHeaders objectForKey: @"Content-Length"];
+
+		if (!chunked && contentLengthHeader != nil) {
+			intmax_t length = [contentLengthHeader decimalValue];
+
+			if (length < 0 || (uintmax_t)length > SIZE_MAX)
+				@throw [OFOutOfRangeException
+				    exceptionWithClass: [request class]];
+
+			hasContentLength = YES;
+			toRead = (size_t)length;
+
+			if (toRead == 0)
+				atEndOfStream = delimited = YES;
+		}
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[request release];
+	[socket release];
+
+	[super dealloc];
+}
+
+- (BOOL)OF_readChunkHeader
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *line = [request OF_readLineFromSocket: socket];
+	of_range_t range;
+
+	range = [line rangeOfString: @";"];
+	if (range.location != OF_NOT_FOUND)
+		line = [line substringWithRange: of_range(0, range.location)];
+
+	@try {
+		toRead = (size_t)[line hexadecimalValue];
+	} @catch (OFInvalidFormatException *e) {
+		@throw [OFInvalidServerReplyException
+		    exceptionWithClass: [request class]];
+	}
+
+	if (toRead == 0) {
+		/* Skip the trailers */
+		while (![[request OF_readLineFromSocket: socket]
+		    isEqual: @""]);
+
+		atEndOfStream = delimited = YES;
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return !atEndOfStream;
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)length
+{
+	size_t ret;
+
+	if (atEndOfStream)
+		return 0;
+
+	if (chunked && toRead == 0 && ![self OF_readChunkHeader])
+		return 0;
+
+	if ((chunked || hasContentLength) && toRead < length)
+		length = toRead;
+
+	ret = [socket readIntoBuffer: buffer
+			      length: length];
+
+	if (!chunked && !hasContentLength) {
+		atEndOfStream = [socket isAtEndOfStream];
+		return ret;
+	}
+
+	if (ret == 0 && [socket isAtEndOfStream])
+		@throw [OFTruncatedDataException
+		    exceptionWithClass: [request class]];
+
+	toRead -= ret;
+
+	if (toRead == 0) {
+		if (chunked) {
+			void *pool = objc_autoreleasePoolPush();
+
+			if (![[request OF_readLineFromSocket: socket]
+			    isEqual: @""])
+				@throw [OFInvalidServerReplyException
+				    exceptionWithClass: [request class]];
+
+			objc_autoreleasePoolPop(pool);
+		} else
+			atEndOfStream = delimited = YES;
+	}
+
+	return ret;
+}
+
+- (BOOL)lowlevelIsAtEndOfStream
+{
+	return atEndOfStream;
+}
+
+- (BOOL)isDelimited
+{
+	return delimited;
+}
+
+- (void)close
+{
+	if (socket == nil)
+		return;
+
+	[request OF_releaseSocket: socket
+			 reusable: delimited && keepAlive];
+
+	[socket release];
+	socket = nil;
+}
+@end
+
 @implementation OFHTTPRequest
 + (instancetype)request
 {
@@ -83,6 +803,8 @@ normalizeKey(OFString *key)
 			    @"<https://webkeks.org/objfw/>"
 		    forKey: @"User-Agent"];
 	storesData = YES;
+	receiveBufferSize = 65536;
+	connectionPool = [[OFHTTPConnectionPool sharedPool] retain];
 
 	return self;
 }
@@ -106,6 +828,8 @@ normalizeKey(OFString *key)
 	[URL release];
 	[queryString release];
 	[headers release];
+	[outputStream release];
+	[connectionPool release];
 
 	[super dealloc];
 }
@@ -172,43 +896,106 @@ normalizeKey(OFString *key)
 
 - (void)setStoresData: (BOOL)storesData_
 {
-	storesData = storesData_;
+	storesData = storesData_;
+}
+
+- (BOOL)storesData
+{
+	return storesData;
+}
+
+- (void)setStreamsBody: (BOOL)streamsBody_
+{
+	streamsBody = streamsBody_;
+}
+
+- (BOOL)streamsBody
+{
+	return streamsBody;
+}
+
+- (void)setOutputStream: (OFStream*)outputStream_
+{
+	OF_SETTER(outputStream, outputStream_, YES, 0)
+}
+
+- (OFStream*)outputStream
+{
+	OF_GETTER(outputStream, YES)
+}
+
+- (void)setReceiveBufferSize: (size_t)receiveBufferSize_
+{
+	if (receiveBufferSize_ == 0 ||
+	    receiveBufferSize_ > MAX_RECEIVE_BUFFER_SIZE)
+		@throw [OFInvalidArgumentException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+
+	receiveBufferSize = receiveBufferSize_;
+}
+
+- (size_t)receiveBufferSize
+{
+	return receiveBufferSize;
+}
+
+- (void)setConnectionPool: (OFHTTPConnectionPool*)connectionPool_
+{
+	OF_SETTER(connectionPool, connectionPool_, YES, 0)
+}
+
+- (OFHTTPConnectionPool*)connectionPool
+{
+	OF_GETTER(connectionPool, YES)
+}
+
+- (OFHTTPRequestResult*)perform
+{
+	return [self performWithRedirects: 10];
+}
+
+- (void)asyncPerform
+{
+	[self asyncPerformWithRedirects: 10];
+}
+
+- (void)asyncPerformWithRedirects: (size_t)redirects
+{
+	OFHTTPRequest_AsyncPerformer *performer =
+	    [[[OFHTTPRequest_AsyncPerformer alloc] initWithRequest: self
+							redirects: redirects]
+	    autorelease];
+
+	[performer start];
 }
 
-- (BOOL)storesData
+#ifdef OF_HAVE_BLOCKS
+- (void)asyncPerformWithBlock: (of_http_request_block_t)block
 {
-	return storesData;
+	[self asyncPerformWithRedirects: 10
+				  block: block];
 }
 
-- (OFHTTPRequestResult*)perform
+- (void)asyncPerformWithRedirects: (size_t)redirects
+			    block: (of_http_request_block_t)block
 {
-	return [self performWithRedirects: 10];
+	OFHTTPRequest_AsyncPerformer *performer =
+	    [[[OFHTTPRequest_AsyncPerformer alloc] initWithRequest: self
+							redirects: redirects]
+	    autorelease];
+
+	performer->block = [block copy];
+
+	[performer start];
 }
+#endif
 
-- (OFHTTPRequestResult*)performWithRedirects: (size_t)redirects
+- (OFTCPSocket*)OF_createSocket
 {
-	void *pool = objc_autoreleasePoolPush();
-	OFString *scheme = [URL scheme];
 	OFTCPSocket *sock;
-	OFHTTPRequestResult *result;
-	OFString *line, *path, *version;
-	OFMutableDictionary *serverHeaders;
-	OFDataArray *data;
-	OFEnumerator *keyEnumerator, *objectEnumerator;
-	OFString *key, *object, *contentLengthHeader;
-	int status;
-	const char *type = NULL;
-	size_t contentLength = 0;
-	BOOL chunked;
-	char *buffer;
-	size_t bytesReceived;
-
-	if (![scheme isEqual: @"http"] && ![scheme isEqual: @"https"])
-		@throw [OFUnsupportedProtocolException
-		    exceptionWithClass: [self class]
-				   URL: URL];
 
-	if ([scheme isEqual: @"http"])
+	if ([[URL scheme] isEqual: @"http"])
 		sock = [OFTCPSocket socket];
 	else {
 		if (of_http_request_tls_socket_class == Nil)
@@ -223,14 +1010,16 @@ normalizeKey(OFString *key)
 	[delegate request: self
 	  didCreateSocket: sock];
 
-	[sock connectToHost: [URL host]
-		       port: [URL port]];
+	return sock;
+}
 
-	/*
-	 * Work around a bug with packet bisection in lighttpd when using
-	 * HTTPS.
-	 */
-	[sock setWriteBufferEnabled: YES];
+- (void)OF_writeHeadersToSocket: (OFTCPSocket*)sock
+		     keepAlive: (BOOL)keepAlive
+	    acceptsCompression: (BOOL)acceptsCompression
+{
+	OFEnumerator *keyEnumerator, *objectEnumerator;
+	OFString *key, *object, *path;
+	const char *type = NULL;
 
 	if (requestType == OF_HTTP_REQUEST_TYPE_GET)
 		type = "GET";
@@ -254,7 +1043,10 @@ normalizeKey(OFString *key)
 		[sock writeFormat: @"Host: %@:%d\r\n", [URL host],
 		    [URL port]];
 
-	[sock writeString: @"Connection: close\r\n"];
+	if (keepAlive)
+		[sock writeString: @"Connection: keep-alive\r\n"];
+	else
+		[sock writeString: @"Connection: close\r\n"];
 
 	keyEnumerator = [headers keyEnumerator];
 	objectEnumerator = [headers objectEnumerator];
@@ -263,6 +1055,14 @@ normalizeKey(OFString *key)
 	    (object = [objectEnumerator nextObject]) != nil)
 		[sock writeFormat: @"%@: %@\r\n", key, object];
 
+	/*
+	 * If the Accept-Encoding header was set explicitly, the body is
+	 * returned as received.
+	 */
+	if (acceptsCompression &&
+	    [headers objectForKey: @"Accept-Encoding"] == nil)
+		[sock writeString: @"Accept-Encoding: gzip\r\n"];
+
 	if (requestType == OF_HTTP_REQUEST_TYPE_POST) {
 		if ([headers objectForKey: @"Content-Type"] == nil)
 			[sock writeString: @"Content-Type: "
@@ -275,6 +1075,20 @@ normalizeKey(OFString *key)
 	}
 
 	[sock writeString: @"\r\n"];
+}
+
+- (void)OF_sendRequestOnSocket: (OFTCPSocket*)sock
+	    acceptsCompression: (BOOL)acceptsCompression
+{
+	/*
+	 * Work around a bug with packet bisection in lighttpd when using
+	 * HTTPS.
+	 */
+	[sock setWriteBufferEnabled: YES];
+
+	[self OF_writeHeadersToSocket: sock
+			    keepAlive: (connectionPool != nil)
+		   acceptsCompression: acceptsCompression];
 
 	/* Work around a bug in lighttpd, see above */
 	[sock flushWriteBuffer];
@@ -282,6 +1096,137 @@ normalizeKey(OFString *key)
 
 	if (requestType == OF_HTTP_REQUEST_TYPE_POST)
 		[sock writeString: queryString];
+}
+
+- (int)OF_statusCodeFromStatusLine: (OFString*)line
+			   version: (OFString**)version
+{
+	if (![line hasPrefix: @"HTTP/"] || [line length] < 12 ||
+	    [line characterAtIndex: 8] != ' ')
+		@throw [OFInvalidServerReplyException
+		    exceptionWithClass: [self class]];
+
+	*version = [line substringWithRange: of_range(5, 3)];
+	if (![*version isEqual: @"1.0"] && ![*version isEqual: @"1.1"])
+		@throw [OFUnsupportedVersionException
+		    exceptionWithClass: [self class]
+			       version: *version];
+
+	return (int)[[line substringWithRange: of_range(9, 3)] decimalValue];
+}
+
+- (void)OF_addHeaderLine: (OFString*)line
+	       toHeaders: (OFMutableDictionary*)serverHeaders
+{
+	OFString *key, *value;
+	const char *line_c = [line UTF8String], *tmp;
+
+	if ((tmp = strchr(line_c, ':')) == NULL)
+		@throw [OFInvalidServerReplyException
+		    exceptionWithClass: [self class]];
+
+	key = [OFString stringWithUTF8String: line_c
+				      length: tmp - line_c];
+	normalizeKey(key);
+
+	do {
+		tmp++;
+	} while (*tmp == ' ');
+
+	value = [OFString stringWithUTF8String: tmp];
+
+	[serverHeaders setObject: value
+			  forKey: key];
+}
+
+/*
+ * Returns the URL to which the response redirects if the redirect should be
+ * followed and nil otherwise.
+ */
+- (OFURL*)OF_redirectURLForStatusCode: (int)status
+			      headers: (OFDictionary*)serverHeaders
+			    redirects: (size_t)redirects
+{
+	OFString *location = [serverHeaders objectForKey: @"Location"];
+	OFURL *new;
+	BOOL follow;
+
+	if (redirects == 0 || location == nil || (status != 301 &&
+	    status != 302 && status != 303 && status != 307))
+		return nil;
+
+	if (!redirectsFromHTTPSToHTTPAllowed && ![[URL scheme]
+	    isEqual: @"http"] && [location hasPrefix: @"http://"])
+		return nil;
+
+	new = [OFURL URLWithString: location
+		     relativeToURL: URL];
+
+	follow = [delegate request: self
+	      willFollowRedirectTo: new];
+
+	if (!follow && delegate != nil)
+		return nil;
+
+	return new;
+}
+
+- (void)OF_followRedirectTo: (OFURL*)new
+		 statusCode: (int)status
+{
+	new = [new retain];
+	[URL release];
+	URL = new;
+
+	if (status == 303) {
+		requestType = OF_HTTP_REQUEST_TYPE_GET;
+		[queryString release];
+		queryString = nil;
+	}
+}
+
+- (BOOL)OF_isIdempotent
+{
+	return (requestType == OF_HTTP_REQUEST_TYPE_GET ||
+	    requestType == OF_HTTP_REQUEST_TYPE_HEAD);
+}
+
+- (BOOL)OF_responseHasBodyForStatusCode: (int)status
+{
+	/* These never have a body, no matter what the headers say */
+	return !(requestType == OF_HTTP_REQUEST_TYPE_HEAD ||
+	    (status >= 100 && status < 200) || status == 204 || status == 304);
+}
+
+- (OFHTTPRequestResult*)OF_resultWithStatusCode: (int)status
+					headers: (OFDictionary*)serverHeaders
+					   data: (OFDataArray*)data
+{
+	OFHTTPRequestResult *result = [[[OFHTTPRequestResult alloc]
+	    initWithStatusCode: status
+		       headers: serverHeaders
+			  data: data] autorelease];
+
+	switch (status) {
+	case 200:
+	case 301:
+	case 302:
+	case 303:
+	case 307:
+		break;
+	default:
+		@throw [OFHTTPRequestFailedException
+		    exceptionWithClass: [self class]
+			       request: self
+				result: result];
+	}
+
+	return result;
+}
+
+- (OFString*)OF_readLineFromSocket: (OFTCPSocket*)sock
+{
+	OFString *line;
 
 	@try {
 		line = [sock readLine];
@@ -290,246 +1235,433 @@ normalizeKey(OFString *key)
 		    exceptionWithClass: [self class]];
 	}
 
-	if (![line hasPrefix: @"HTTP/"] || [line characterAtIndex: 8] != ' ')
+	if (line == nil)
 		@throw [OFInvalidServerReplyException
 		    exceptionWithClass: [self class]];
 
-	version = [line substringWithRange: of_range(5, 3)];
-	if (![version isEqual: @"1.0"] && ![version isEqual: @"1.1"])
-		@throw [OFUnsupportedVersionException
-		    exceptionWithClass: [self class]
-			       version: version];
+	return line;
+}
+
+- (BOOL)OF_isGZIPEncoded: (OFDictionary*)serverHeaders
+{
+	OFString *contentEncoding =
+	    [serverHeaders objectForKey: @"Content-Encoding"];
 
-	status = (int)[[line substringWithRange: of_range(9, 3)] decimalValue];
+	if (contentEncoding == nil ||
+	    [headers objectForKey: @"Accept-Encoding"] != nil)
+		return NO;
 
-	serverHeaders = [OFMutableDictionary dictionary];
+	return ([contentEncoding caseInsensitiveCompare: @"gzip"] ==
+	    OF_ORDERED_SAME || [contentEncoding caseInsensitiveCompare:
+	    @"x-gzip"] == OF_ORDERED_SAME);
+}
+
+/*
+ * Reads the body of the response and returns whether the socket is positioned
+ * right after the end of the response, which is only the case if the length of
+ * the body was known.
+ */
+- (BOOL)OF_readBodyFromSocket: (OFTCPSocket*)sock
+		      headers: (OFDictionary*)serverHeaders
+		   statusCode: (int)status
+			 data: (OFDataArray*)data
+	       notifyDelegate: (BOOL)notifyDelegate
+{
+	OFHTTPRequest_BodyStream *bodyStream;
+	OFStream *stream;
+	char *buffer;
+	BOOL delimited;
 
-	for (;;) {
-		OFString *key, *value;
-		const char *line_c, *tmp;
+	if (![self OF_responseHasBodyForStatusCode: status])
+		return YES;
+
+	bodyStream = [[OFHTTPRequest_BodyStream alloc]
+	    initWithRequest: self
+		     socket: sock
+		    headers: serverHeaders
+		  keepAlive: NO];
+
+	@try {
+		stream = bodyStream;
+		if (notifyDelegate && [self OF_isGZIPEncoded: serverHeaders])
+			stream = [OFGZIPStream streamWithStream: bodyStream];
+
+		buffer = [self allocMemoryWithSize: receiveBufferSize];
 
 		@try {
-			line = [sock readLine];
-		} @catch (OFInvalidEncodingException *e) {
-			@throw [OFInvalidServerReplyException
-			    exceptionWithClass: [self class]];
-		}
+			while (![stream isAtEndOfStream]) {
+				void *pool = objc_autoreleasePoolPush();
+				size_t length;
+
+				length = [stream
+				    readIntoBuffer: buffer
+					    length: receiveBufferSize];
+
+				/* The last read of a chunked body returns 0 */
+				if (length == 0) {
+					objc_autoreleasePoolPop(pool);
+					continue;
+				}
 
-		if (line == nil)
-			@throw [OFInvalidServerReplyException
-			    exceptionWithClass: [self class]];
+				if (notifyDelegate) {
+					[delegate request: self
+					   didReceiveData: buffer
+					       withLength: length];
+
+					[outputStream writeBuffer: buffer
+							   length: length];
+				}
 
-		if ([line isEqual: @""])
-			break;
+				[data addItemsFromCArray: buffer
+						   count: length];
 
-		line_c = [line UTF8String];
+				objc_autoreleasePoolPop(pool);
+			}
 
-		if ((tmp = strchr(line_c, ':')) == NULL)
-			@throw [OFInvalidServerReplyException
-			    exceptionWithClass: [self class]];
+			/*
+			 * Read what follows the compressed data, like the end
+			 * of a chunked body, so that the connection can be
+			 * reused.
+			 */
+			while (![bodyStream isAtEndOfStream])
+				[bodyStream readIntoBuffer: buffer
+						    length: receiveBufferSize];
+		} @catch (OFTruncatedDataException *e) {
+			/*
+			 * We only want to throw on these status codes as we
+			 * will throw an OFHTTPRequestFailedException for all
+			 * other status codes later.
+			 */
+			if (status == 200 || status == 301 || status == 302 ||
+			    status == 303 || status == 307)
+				@throw e;
+		} @finally {
+			[self freeMemory: buffer];
+		}
 
-		key = [OFString stringWithUTF8String: line_c
-					      length: tmp - line_c];
-		normalizeKey(key);
+		delimited = [bodyStream isDelimited];
+	} @finally {
+		[bodyStream release];
+	}
 
-		do {
-			tmp++;
-		} while (*tmp == ' ');
+	return delimited;
+}
 
-		value = [OFString stringWithUTF8String: tmp];
+- (void)OF_releaseSocket: (OFTCPSocket*)sock
+	       reusable: (BOOL)reusable
+{
+	if (reusable && connectionPool != nil)
+		[connectionPool addSocket: sock
+				   forURL: URL];
+	else
+		[sock close];
+}
 
-		if ((redirects > 0 && (status == 301 || status == 302 ||
-		    status == 303 || status == 307) &&
-		    [key isEqual: @"Location"]) &&
-		    (redirectsFromHTTPSToHTTPAllowed ||
-		    [scheme isEqual: @"http"] ||
-		    ![value hasPrefix: @"http://"])) {
-			OFURL *new;
-			BOOL follow;
+- (OFHTTPRequestResult*)performWithRedirects: (size_t)redirects
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *scheme = [URL scheme];
+	OFTCPSocket *sock = nil;
+	OFHTTPRequestResult *result;
+	OFString *line = nil, *version;
+	OFMutableDictionary *serverHeaders;
+	OFDataArray *data;
+	OFURL *new;
+	int status;
+	BOOL keepAlive, reusable;
 
-			new = [OFURL URLWithString: value
-				     relativeToURL: URL];
+	if (![scheme isEqual: @"http"] && ![scheme isEqual: @"https"])
+		@throw [OFUnsupportedProtocolException
+		    exceptionWithClass: [self class]
+				   URL: URL];
 
-			follow = [delegate request: self
-			      willFollowRedirectTo: new];
+	/*
+	 * If a reused connection fails, the server might have processed the
+	 * request already. Therefore, only idempotent requests, which can be
+	 * sent again, use connections from the pool.
+	 */
+	if ([self OF_isIdempotent] &&
+	    (sock = [connectionPool socketForURL: URL]) != nil) {
+		/*
+		 * The server might have closed the idle connection right
+		 * before we sent the request. In this case, retry once on a
+		 * new connection.
+		 */
+		@try {
+			[self OF_sendRequestOnSocket: sock
+				  acceptsCompression: YES];
+			line = [sock readLine];
+		} @catch (OFInvalidEncodingException *e) {
+			@throw [OFInvalidServerReplyException
+			    exceptionWithClass: [self class]];
+		} @catch (OFWriteFailedException *e) {
+			line = nil;
+		} @catch (OFReadFailedException *e) {
+			line = nil;
+		}
 
-			if (!follow && delegate != nil) {
-				[serverHeaders setObject: value
-						  forKey: key];
-				continue;
+		if (line == nil) {
+			@try {
+				[sock close];
+			} @catch (id e) {
+				/* We don't care, we don't use it anymore */
 			}
 
-			new = [new retain];
-			[URL release];
-			URL = new;
+			sock = nil;
+		}
+	}
 
-			if (status == 303) {
-				requestType = OF_HTTP_REQUEST_TYPE_GET;
-				[queryString release];
-				queryString = nil;
-			}
+	if (sock == nil) {
+		sock = [self OF_createSocket];
+		[sock connectToHost: [URL host]
+			       port: [URL port]];
 
-			objc_autoreleasePoolPop(pool);
+		[self OF_sendRequestOnSocket: sock
+			  acceptsCompression: YES];
+		line = [self OF_readLineFromSocket: sock];
+	}
 
-			return [self performWithRedirects: redirects - 1];
-		}
+	status = [self OF_statusCodeFromStatusLine: line
+					   version: &version];
+
+	serverHeaders = [OFMutableDictionary dictionary];
 
-		[serverHeaders setObject: value
-				  forKey: key];
+	while (![(line = [self OF_readLineFromSocket: sock]) isEqual: @""])
+		[self OF_addHeaderLine: line
+			     toHeaders: serverHeaders];
+
+	keepAlive = keep_alive(version, serverHeaders);
+
+	if ((new = [self OF_redirectURLForStatusCode: status
+					     headers: serverHeaders
+					   redirects: redirects]) != nil) {
+		/*
+		 * Skip the body of the redirect so that the connection can be
+		 * reused, possibly by the redirect itself.
+		 */
+		reusable = [self OF_readBodyFromSocket: sock
+					       headers: serverHeaders
+					    statusCode: status
+						  data: nil
+					notifyDelegate: NO];
+		[self OF_releaseSocket: sock
+			      reusable: reusable && keepAlive];
+
+		[self OF_followRedirectTo: new
+			       statusCode: status];
+
+		objc_autoreleasePoolPop(pool);
+
+		return [self performWithRedirects: redirects - 1];
 	}
 
 	[delegate request: self
 	didReceiveHeaders: serverHeaders
 	   withStatusCode: status];
 
-	data = (storesData ? [OFDataArray dataArray] : nil);
-	chunked = [[serverHeaders objectForKey: @"Transfer-Encoding"]
-	    isEqual: @"chunked"];
+	if (streamsBody && [self OF_responseHasBodyForStatusCode: status]) {
+		OFStream *bodyStream;
 
-	contentLengthHeader = [serverHeaders objectForKey: @"Content-Length"];
+		bodyStream = [[[OFHTTPRequest_BodyStream alloc]
+		    initWithRequest: self
+			     socket: sock
+			    headers: serverHeaders
+			  keepAlive: keepAlive] autorelease];
 
-	if (contentLengthHeader != nil) {
-		contentLength = (size_t)[contentLengthHeader decimalValue];
+		if ([self OF_isGZIPEncoded: serverHeaders])
+			bodyStream =
+			    [OFGZIPStream streamWithStream: bodyStream];
 
-		if (contentLength > SIZE_MAX)
-			@throw [OFOutOfRangeException
-			    exceptionWithClass: [self class]];
+		[serverHeaders makeImmutable];
+
+		result = [self OF_resultWithStatusCode: status
+					       headers: serverHeaders
+						  data: nil];
+		[result OF_setBodyStream: bodyStream];
+
+		[result retain];
+		objc_autoreleasePoolPop(pool);
+
+		return [result autorelease];
 	}
 
-	buffer = [self allocMemoryWithSize: of_pagesize];
-	bytesReceived = 0;
-	@try {
-		if (chunked) {
-			for (;;) {
-				void *pool2 = objc_autoreleasePoolPush();
-				size_t toRead;
-				of_range_t range;
-
-				@try {
-					line = [sock readLine];
-				} @catch (OFInvalidEncodingException *e) {
-					@throw [OFInvalidServerReplyException
-					    exceptionWithClass: [self class]];
-				}
+	data = (storesData && outputStream == nil
+	    ? [OFDataArray dataArray] : nil);
 
-				range = [line rangeOfString: @";"];
-				if (range.location != OF_NOT_FOUND)
-					line = [line substringWithRange:
-					    of_range(0, range.location)];
+	reusable = [self OF_readBodyFromSocket: sock
+				       headers: serverHeaders
+				    statusCode: status
+					  data: data
+				notifyDelegate: YES];
+	[self OF_releaseSocket: sock
+		      reusable: reusable && keepAlive];
 
-				@try {
-					toRead =
-					    (size_t)[line hexadecimalValue];
-				} @catch (OFInvalidFormatException *e) {
-					@throw [OFInvalidServerReplyException
-					    exceptionWithClass: [self class]];
-				}
+	[serverHeaders makeImmutable];
+
+	result = [[self OF_resultWithStatusCode: status
+					headers: serverHeaders
+					   data: data] retain];
 
-				if (toRead == 0 ||
-				    (contentLengthHeader != nil &&
-				    contentLength >= bytesReceived))
-					break;
+	objc_autoreleasePoolPop(pool);
 
-				while (toRead > 0) {
-					size_t length = (toRead < of_pagesize
-					    ? toRead : of_pagesize);
+	return [result autorelease];
+}
 
-					length = [sock readIntoBuffer: buffer
-							       length: length];
++ (OFArray*)performRequests: (OFArray*)requests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFHTTPRequest **objects = [requests objects];
+	size_t i, count = [requests count], done = 0;
+	OFMutableArray *results = [OFMutableArray arrayWithCapacity: count];
+	OFHTTPConnectionPool *connectionPool;
+	OFHTTPRequest *first;
+	OFURL *URL;
+
+	if (count == 0) {
+		objc_autoreleasePoolPop(pool);
+		return [OFArray array];
+	}
 
-					[delegate request: self
-					   didReceiveData: buffer
-					       withLength: length];
+	first = objects[0];
+	URL = first->URL;
+	connectionPool = first->connectionPool;
 
-					objc_autoreleasePoolPop(pool2);
-					pool2 = objc_autoreleasePoolPush();
+	if (![[URL scheme] isEqual: @"http"] &&
+	    ![[URL scheme] isEqual: @"https"])
+		@throw [OFUnsupportedProtocolException
+		    exceptionWithClass: self
+				   URL: URL];
 
-					bytesReceived += length;
-					[data addItemsFromCArray: buffer
-							   count: length];
+	/* Only idempotent requests to the same server may be pipelined */
+	for (i = 0; i < count; i++) {
+		OFURL *otherURL = objects[i]->URL;
+
+		if (![objects[i] OF_isIdempotent] ||
+		    ![[otherURL scheme] isEqual: [URL scheme]] ||
+		    ![[otherURL host] isEqual: [URL host]] ||
+		    [otherURL port] != [URL port])
+			@throw [OFInvalidArgumentException
+			    exceptionWithClass: self
+				      selector: _cmd];
+	}
 
-					toRead -= length;
-				}
+	while (done < count) {
+		OFTCPSocket *sock;
+		size_t start = done;
+		BOOL reused, reusable = YES;
 
-				@try {
-					line = [sock readLine];
-				} @catch (OFInvalidEncodingException *e) {
-					@throw [OFInvalidServerReplyException
-					    exceptionWithClass: [self class]];
-				}
+		sock = [connectionPool socketForURL: URL];
+		reused = (sock != nil);
 
-				if (![line isEqual: @""])
-					@throw [OFInvalidServerReplyException
-					    exceptionWithClass: [self class]];
+		if (sock == nil) {
+			sock = [first OF_createSocket];
+			[sock connectToHost: [URL host]
+				       port: [URL port]];
+		}
 
-				objc_autoreleasePoolPop(pool2);
+		/* Send all outstanding requests with a single write */
+		@try {
+			[sock setWriteBufferEnabled: YES];
+
+			for (i = done; i < count; i++)
+				[objects[i]
+				    OF_writeHeadersToSocket: sock
+						  keepAlive: YES
+					 acceptsCompression: YES];
+
+			[sock flushWriteBuffer];
+			[sock setWriteBufferEnabled: NO];
+		} @catch (OFWriteFailedException *e) {
+			if (!reused)
+				@throw e;
+
+			/* The idle connection was closed, use another one */
+			[first OF_releaseSocket: sock
+				       reusable: NO];
+			continue;
+		}
+
+		while (done < count && reusable) {
+			void *pool2 = objc_autoreleasePoolPush();
+			OFHTTPRequest *request = objects[done];
+			OFString *line, *version;
+			OFMutableDictionary *serverHeaders;
+			OFDataArray *data;
+			int status;
+
+			@try {
+				line = [sock readLine];
+			} @catch (OFInvalidEncodingException *e) {
+				@throw [OFInvalidServerReplyException
+				    exceptionWithClass: self];
+			} @catch (OFReadFailedException *e) {
+				line = nil;
 			}
-		} else {
-			size_t length;
 
-			while (![sock isAtEndOfStream]) {
-				void *pool2;
+			/*
+			 * The server closed the connection before answering
+			 * all requests. The remaining requests are sent again
+			 * on another connection, unless this one did not even
+			 * answer a single request.
+			 */
+			if (line == nil) {
+				if (done == start && !reused)
+					@throw [OFInvalidServerReplyException
+					    exceptionWithClass: self];
 
-				length = [sock readIntoBuffer: buffer
-						       length: of_pagesize];
+				objc_autoreleasePoolPop(pool2);
+				reusable = NO;
+				break;
+			}
 
-				pool2 = objc_autoreleasePoolPush();
+			status = [request
+			    OF_statusCodeFromStatusLine: line
+						version: &version];
 
-				[delegate request: self
-				   didReceiveData: buffer
-				       withLength: length];
+			serverHeaders = [OFMutableDictionary dictionary];
 
-				objc_autoreleasePoolPop(pool2);
+			while (![(line = [request OF_readLineFromSocket: sock])
+			    isEqual: @""])
+				[request OF_addHeaderLine: line
+						toHeaders: serverHeaders];
 
-				bytesReceived += length;
-				[data addItemsFromCArray: buffer
-						   count: length];
+			[request->delegate request: request
+				 didReceiveHeaders: serverHeaders
+				    withStatusCode: status];
 
-				if (contentLengthHeader != nil &&
-				    bytesReceived >= contentLength)
-					break;
-			}
-		}
-	} @finally {
-		[self freeMemory: buffer];
-	}
+			data = (request->storesData &&
+			    request->outputStream == nil
+			    ? [OFDataArray dataArray] : nil);
 
-	[sock close];
+			reusable = [request OF_readBodyFromSocket: sock
+							  headers: serverHeaders
+						       statusCode: status
+							     data: data
+						   notifyDelegate: YES];
+			reusable = (reusable && keep_alive(version,
+			    serverHeaders));
 
-	/*
-	 * We only want to throw on these status codes as we will throw an
-	 * OFHTTPRequestFailedException for all other status codes later.
-	 */
-	if (contentLengthHeader != nil && contentLength != bytesReceived &&
-	    (status == 200 || status == 301 || status == 302 || status == 303 ||
-	    status == 307))
-		@throw [OFTruncatedDataException
-		    exceptionWithClass: [self class]];
+			[serverHeaders makeImmutable];
 
-	[serverHeaders makeImmutable];
+			[results addObject: [[[OFHTTPRequestResult alloc]
+			    initWithStatusCode: status
+				       headers: serverHeaders
+					  data: data] autorelease]];
+			done++;
 
-	result = [[OFHTTPRequestResult alloc] initWithStatusCode: status
-							 headers: serverHeaders
-							    data: data];
+			objc_autoreleasePoolPop(pool2);
+		}
 
-	switch (status) {
-	case 200:
-	case 301:
-	case 302:
-	case 303:
-	case 307:
-		break;
-	default:
-		[result autorelease];
-		@throw [OFHTTPRequestFailedException
-		    exceptionWithClass: [self class]
-			       request: self
-				result: result];
+		[first OF_releaseSocket: sock
+			       reusable: reusable];
 	}
 
+	[results makeImmutable];
+
+	[results retain];
 	objc_autoreleasePoolPop(pool);
 
-	return [result autorelease];
+	return [results autorelease];
 }
 @end
 
@@ -551,6 +1683,7 @@ normalizeKey(OFString *key)
 {
 	[data release];
 	[headers release];
+	[bodyStream release];
 
 	[super dealloc];
 }
@@ -569,6 +1702,16 @@ normalizeKey(OFString *key)
 {
 	OF_GETTER(data, YES)
 }
+
+- (OFStream*)bodyStream
+{
+	OF_GETTER(bodyStream, YES)
+}
+
+- (void)OF_setBodyStream: (OFStream*)bodyStream_
+{
+	OF_SETTER(bodyStream, bodyStream_, YES, 0)
+}
 @end
 
 @implementation OFObject (OFHTTPRequestDelegate)
@@ -594,4 +1737,14 @@ normalizeKey(OFString *key)
 {
 	return YES;
 }
+
+-	(void)request: (OFHTTPRequest*)request
+  didFinishWithResult: (OFHTTPRequestResult*)result
+{
+}
+
+-	 (void)request: (OFHTTPRequest*)request
+  didFailWithException: (OFException*)exception
+{
+}
 @end
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+@class OFString;
+@class OFDictionary;
+@class OFMutableDictionary;
+@class OFDataArray;
+@class OFTCPSocket;
+#ifdef OF_THREADS
+@class OFThread;
+@class OFThreadPool;
+#endif
+@class OFHTTPServer;
+@class OFHTTPServerRequest;
+@class OFHTTPServerResponse;
+
+#ifdef OF_HAVE_BLOCKS
+typedef void (^of_http_server_request_handler_t)(OFHTTPServerRequest*,
+    OFHTTPServerResponse*);
+#endif
+
+/*!
+ * @brief A delegate for OFHTTPServer.
+ */
+@protocol OFHTTPServerDelegate <OFObject>
+/*!
+ * @brief This method is called when the server received a request.
+ *
+ * The delegate should set the status code and headers of the response and
+ * write the body to it. When this method returns, the response is finished
+ * automatically if it has not been finished yet.
+ *
+ * @param server The server which received the request
+ * @param request The request the server received
+ * @param response The response to the request
+ */
+-      (void)server: (OFHTTPServer*)server
+  didReceiveRequest: (OFHTTPServerRequest*)request
+	   response: (OFHTTPServerResponse*)response;
+@end
+
+/*!
+ * @brief A class for an HTTP/1.1 server.
+ *
+ * The server accepts connections and reads requests asynchronously using the
+ * run loop of the thread it was started on. Requests are parsed incrementally
+ * directly in the read buffer of the connection, support persistent
+ * connections and may be pipelined by the client. Each request is passed to
+ * the delegate or the request handler, optionally on a thread pool.
+ *
+ * Responses to pipelined requests are always sent in the order the requests
+ * were received, as a connection does not process its next request before
+ * the response to the current one has been finished.
+ */
+@interface OFHTTPServer: OFObject
+{
+	OFString *host;
+	uint16_t port;
+	id <OFHTTPServerDelegate> delegate;
+#ifdef OF_HAVE_BLOCKS
+	of_http_server_request_handler_t requestHandler;
+#endif
+#ifdef OF_THREADS
+	OFThreadPool *threadPool;
+	OFThread *thread;
+#endif
+	size_t maxRequestHeadSize, maxRequestBodySize;
+	OFTCPSocket *listeningSocket;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property (copy) OFString *host;
+@property uint16_t port;
+@property (assign) id <OFHTTPServerDelegate> delegate;
+# ifdef OF_HAVE_BLOCKS
+@property (copy) of_http_server_request_handler_t requestHandler;
+# endif
+# ifdef OF_THREADS
+@property (retain) OFThreadPool *threadPool;
+# endif
+@property size_t maxRequestHeadSize, maxRequestBodySize;
+#endif
+
+/*!
+ * @brief Creates a new HTTP server.
+ *
+ * @return A new, autoreleased OFHTTPServer
+ */
++ (instancetype)server;
+
+/*!
+ * @brief Sets the host on which the server listens.
+ *
+ * The default is 127.0.0.1.
+ *
+ * @param host The host on which the server listens
+ */
+- (void)setHost: (OFString*)host;
+
+/*!
+ * @brief Returns the host on which the server listens.
+ *
+ * @return The host on which the server listens
+ */
+- (OFString*)host;
+
+/*!
+ * @brief Sets the port on which the server listens.
+ *
+ * If the port is 0, an unused port is chosen when the server is started.
+ *
+ * @param port The port on which the server listens
+ */
+- (void)setPort: (uint16_t)port;
+
+/*!
+ * @brief Returns the port on which the server listens.
+ *
+ * @return The port on which the server listens
+ */
+- (uint16_t)port;
+
+/*!
+ * @brief Sets the delegate of the server.
+ *
+ * @param delegate The delegate of the server
+ */
+- (void)setDelegate: (id <OFHTTPServerDelegate>)delegate;
+
+/*!
+ * @brief Returns the delegate of the server.
+ *
+ * @return The delegate of the server
+ */
+- (id <OFHTTPServerDelegate>)delegate;
+
+#ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief Sets a block which handles the requests instead of the delegate.
+ *
+ * @param requestHandler The block which handles the requests
+ */
+- (void)setRequestHandler: (of_http_server_request_handler_t)requestHandler;
+
+/*!
+ * @brief Returns the block which handles the requests.
+ *
+ * @return The block which handles the requests
+ */
+- (of_http_server_request_handler_t)requestHandler;
+#endif
+
+#ifdef OF_THREADS
+/*!
+ * @brief Sets a thread pool on which the requests are handled.
+ *
+ * If no thread pool is set, requests are handled on the thread which started
+ * the server.
+ *
+ * @param threadPool The thread pool on which the requests are handled
+ */
+- (void)setThreadPool: (OFThreadPool*)threadPool;
+
+/*!
+ * @brief Returns the thread pool on which the requests are handled.
+ *
+ * @return The thread pool on which the requests are handled
+ */
+- (OFThreadPool*)threadPool;
+#endif
+
+/*!
+ * @brief Sets the maximum size of the request line and headers of a request.
+ *
+ * The default is 16 KB. Connections sending a bigger head are answered with
+ * status code 431 and closed.
+ *
+ * @param maxRequestHeadSize The maximum size of the head of a request
+ */
+- (void)setMaxRequestHeadSize: (size_t)maxRequestHeadSize;
+
+/*!
+ * @brief Returns the maximum size of the request line and headers of a
+ *	  request.
+ *
+ * @return The maximum size of the head of a request
+ */
+- (size_t)maxRequestHeadSize;
+
+/*!
+ * @brief Sets the maximum size of the body of a request.
+ *
+ * The default is 1 MB. Requests with a bigger body are answered with status
+ * code 413 and the connection is closed.
+ *
+ * @param maxRequestBodySize The maximum size of the body of a request
+ */
+- (void)setMaxRequestBodySize: (size_t)maxRequestBodySize;
+
+/*!
+ * @brief Returns the maximum size of the body of a request.
+ *
+ * @return The maximum size of the body of a request
+ */
+- (size_t)maxRequestBodySize;
+
+/*!
+ * @brief Starts listening and accepting connections.
+ *
+ * The connections are handled by the run loop of the current thread, which
+ * needs to be running.
+ */
+- (void)start;
+@end
+
+/*!
+ * @brief A request received by an OFHTTPServer.
+ */
+@interface OFHTTPServerRequest: OFObject
+{
+	OFString *method, *path, *query, *version;
+	OFDictionary *headers;
+	OFDataArray *body;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property (readonly, copy) OFString *method, *path, *query, *version;
+@property (readonly, copy) OFDictionary *headers;
+@property (readonly, retain) OFDataArray *body;
+#endif
+
+/*!
+ * @brief Returns the method of the request, for example GET.
+ *
+ * @return The method of the request
+ */
+- (OFString*)method;
+
+/*!
+ * @brief Returns the path of the request, without the query.
+ *
+ * @return The path of the request
+ */
+- (OFString*)path;
+
+/*!
+ * @brief Returns the query of the request.
+ *
+ * @return The query of the request or nil
+ */
+- (OFString*)query;
+
+/*!
+ * @brief Returns the HTTP version of the request, either 1.0 or 1.1.
+ *
+ * @return The HTTP version of the request
+ */
+- (OFString*)version;
+
+/*!
+ * @brief Returns the headers of the request.
+ *
+ * The keys are normalized like the keys of the headers received by
+ * OFHTTPRequest, e.g. Content-Length.
+ *
+ * @return The headers of the request
+ */
+- (OFDictionary*)headers;
+
+/*!
+ * @brief Returns the body of the request.
+ *
+ * @return The body of the request or nil if it has no body
+ */
+- (OFDataArray*)body;
+@end
+
+/*!
+ * @brief A response to a request received by an OFHTTPServer.
+ *
+ * The head of the response is sent with the first write or when the response
+ * is finished. If no Content-Length header has been set by then, the body is
+ * sent using the chunked transfer encoding, or for HTTP/1.0 clients by closing
+ * the connection afterwards.
+ */
+@interface OFHTTPServerResponse: OFObject
+{
+	OFTCPSocket *socket;
+	OFHTTPServerRequest *request;
+	short statusCode;
+	OFMutableDictionary *headers;
+	BOOL HTTP11, keepAlive, omitsBody;
+	BOOL headSent, chunked, finished;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property short statusCode;
+@property (readonly, retain) OFMutableDictionary *headers;
+#endif
+
+/*!
+ * @brief Sets the status code of the response.
+ *
+ * The default is 200. This has no effect after the head has been sent.
+ *
+ * @param statusCode The status code of the response
+ */
+- (void)setStatusCode: (short)statusCode;
+
+/*!
+ * @brief Returns the status code of the response.
+ *
+ * @return The status code of the response
+ */
+- (short)statusCode;
+
+/*!
+ * @brief Returns the headers of the response, which can be modified until the
+ *	  head has been sent.
+ *
+ * @return The headers of the response
+ */
+- (OFMutableDictionary*)headers;
+
+/*!
+ * @brief Writes the specified buffer to the body of the response.
+ *
+ * @param buffer The buffer to write
+ * @param length The length of the buffer
+ */
+- (void)writeBuffer: (const void*)buffer
+	     length: (size_t)length;
+
+/*!
+ * @brief Writes the specified string encoded as UTF-8 to the body of the
+ *	  response.
+ *
+ * @param string The string to write
+ */
+- (void)writeString: (OFString*)string;
+
+/*!
+ * @brief Finishes the response.
+ *
+ * After this, nothing can be written to the response anymore.
+ */
+- (void)finish;
+@end
@@ -0,0 +1,1000 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <ctype.h>
+
+#import "OFHTTPServer.h"
+#import "OFString.h"
+#import "OFDictionary.h"
+#import "OFDataArray.h"
+#import "OFDate.h"
+#import "OFDateFormatter.h"
+#import "OFTCPSocket.h"
+#ifdef OF_THREADS
+# import "OFThread.h"
+# import "OFThreadPool.h"
+#endif
+
+#import "OFAlreadyConnectedException.h"
+#import "OFInvalidArgumentException.h"
+
+#import "autorelease.h"
+#import "macros.h"
+
+@interface OFHTTPServer (OF_PrivateMethods)
+#ifdef OF_THREADS
+- (OFThread*)OF_thread;
+#endif
+- (void)OF_handleRequest: (OFHTTPServerRequest*)request
+		response: (OFHTTPServerResponse*)response;
+@end
+
+@interface OFHTTPServerRequest (OF_PrivateMethods)
+- OF_initWithMethod: (OFString*)method
+	       path: (OFString*)path
+	      query: (OFString*)query
+	    version: (OFString*)version
+	    headers: (OFDictionary*)headers;
+- (void)OF_setBody: (OFDataArray*)body;
+@end
+
+@interface OFHTTPServerResponse (OF_PrivateMethods)
+- OF_initWithSocket: (OFTCPSocket*)socket
+	    request: (OFHTTPServerRequest*)request;
+- (OFHTTPServerRequest*)OF_request;
+- (BOOL)OF_keepsConnectionAlive;
+- (void)OF_abort;
+@end
+
+/*
+ * A connection to a client. It is retained by the run loop for as long as a
+ * read is pending and by the thread pool while a request is handled.
+ */
+@interface OFHTTPServer_Connection: OFObject
+{
+	OFHTTPServer *server;
+	OFTCPSocket *socket;
+	char *buffer;
+	size_t bufferSize, bufferLength, scanned;
+	OFHTTPServerRequest *request;
+	size_t headLength, contentLength;
+	BOOL busy, closesAfterResponse, closed;
+}
+
+- initWithServer: (OFHTTPServer*)server
+	  socket: (OFTCPSocket*)socket;
+- (void)start;
+@end
+
+static const char*
+status_code_to_string(short code)
+{
+	switch (code) {
+	case 100:
+		return "Continue";
+	case 200:
+		return "OK";
+	case 201:
+		return "Created";
+	case 202:
+		return "Accepted";
+	case 204:
+		return "No Content";
+	case 206:
+		return "Partial Content";
+	case 301:
+		return "Moved Permanently";
+	case 302:
+		return "Found";
+	case 303:
+		return "See Other";
+	case 304:
+		return "Not Modified";
+	case 307:
+		return "Temporary Redirect";
+	case 400:
+		return "Bad Request";
+	case 401:
+		return "Unauthorized";
+	case 403:
+		return "Forbidden";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	case 408:
+		return "Request Timeout";
+	case 411:
+		return "Length Required";
+	case 413:
+		return "Request Entity Too Large";
+	case 431:
+		return "Request Header Fields Too Large";
+	case 500:
+		return "Internal Server Error";
+	case 501:
+		return "Not Implemented";
+	case 503:
+		return "Service Unavailable";
+	}
+
+	if (code >= 200 && code < 300)
+		return "Success";
+	if (code >= 300 && code < 400)
+		return "Redirection";
+	if (code >= 400 && code < 500)
+		return "Client Error";
+
+	return "Server Error";
+}
+
+static void
+normalize_key(char *key, size_t length)
+{
+	BOOL firstLetter = YES;
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		if (!isalnum((unsigned char)key[i])) {
+			firstLetter = YES;
+			continue;
+		}
+
+		key[i] = (firstLetter ? toupper((unsigned char)key[i]) :
+		    tolower((unsigned char)key[i]));
+		firstLetter = NO;
+	}
+}
+
+static OFString*
+string_from_bytes(const char *bytes, size_t length)
+{
+	int errNo;
+
+	return [OFString stringWithUTF8String: bytes
+				       length: length
+					error: &errNo];
+}
+
+/*
+ * Parses the head of a request in place. Header keys are normalized directly
+ * in the buffer and only the final strings are created. Returns nil if the
+ * head is malformed.
+ */
+static OFHTTPServerRequest*
+parse_head(char *head, size_t length)
+{
+	char *end = head + length, *line = head, *lineEnd, *tmp, *tmp2;
+	OFString *method, *path, *query = nil, *version;
+	OFMutableDictionary *headers = [OFMutableDictionary dictionary];
+
+	/* Request line */
+	if ((lineEnd = memchr(line, '\n', end - line)) == NULL)
+		return nil;
+	tmp2 = (lineEnd > line && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd);
+
+	if ((tmp = memchr(line, ' ', tmp2 - line)) == NULL || tmp == line)
+		return nil;
+	if ((method = string_from_bytes(line, tmp - line)) == nil)
+		return nil;
+
+	line = tmp + 1;
+	if ((tmp = memchr(line, ' ', tmp2 - line)) == NULL || tmp == line)
+		return nil;
+
+	if (tmp2 - (tmp + 1) != 8 || memcmp(tmp + 1, "HTTP/1.", 7) != 0 ||
+	    (tmp[8] != '0' && tmp[8] != '1'))
+		return nil;
+	version = (tmp[8] == '1' ? @"1.1" : @"1.0");
+
+	tmp2 = memchr(line, '?', tmp - line);
+	if (tmp2 != NULL) {
+		if ((query = string_from_bytes(tmp2 + 1, tmp - tmp2 - 1)) ==
+		    nil)
+			return nil;
+		tmp = tmp2;
+	}
+	if ((path = string_from_bytes(line, tmp - line)) == nil)
+		return nil;
+
+	/* Headers */
+	for (line = lineEnd + 1; line < end; line = lineEnd + 1) {
+		OFString *key, *value, *old;
+		char *colon;
+
+		if ((lineEnd = memchr(line, '\n', end - line)) == NULL)
+			return nil;
+		tmp2 = (lineEnd > line && lineEnd[-1] == '\r'
+		    ? lineEnd - 1 : lineEnd);
+
+		/* The empty line which ends the head */
+		if (tmp2 == line)
+			break;
+
+		/* Obsolete line folding is not supported */
+		if (*line == ' ' || *line == '\t')
+			return nil;
+
+		if ((colon = memchr(line, ':', tmp2 - line)) == NULL ||
+		    colon == line)
+			return nil;
+
+		tmp = colon + 1;
+		while (tmp < tmp2 && (*tmp == ' ' || *tmp == '\t'))
+			tmp++;
+		while (tmp2 > tmp && (tmp2[-1] == ' ' || tmp2[-1] == '\t'))
+			tmp2--;
+
+		normalize_key(line, colon - line);
+
+		if ((key = string_from_bytes(line, colon - line)) == nil ||
+		    (value = string_from_bytes(tmp, tmp2 - tmp)) == nil)
+			return nil;
+
+		/* Repeated headers are combined into a list */
+		if ((old = [headers objectForKey: key]) != nil)
+			value = [OFString stringWithFormat: @"%@, %@",
+							    old, value];
+
+		[headers setObject: value
+			    forKey: key];
+	}
+
+	[headers makeImmutable];
+
+	return [[[OFHTTPServerRequest alloc]
+	    OF_initWithMethod: method
+			 path: path
+			query: query
+		      version: version
+		      headers: headers] autorelease];
+}
+
+@implementation OFHTTPServer_Connection
+- initWithServer: (OFHTTPServer*)server_
+	  socket: (OFTCPSocket*)socket_
+{
+	self = [super init];
+
+	@try {
+		server = [server_ retain];
+		socket = [socket_ retain];
+		bufferSize = of_pagesize;
+		buffer = [self allocMemoryWithSize: bufferSize];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[server release];
+	[socket release];
+	[request release];
+
+	[super dealloc];
+}
+
+/*
+ * The socket is never closed directly, as this might happen from a callback
+ * of the run loop, which still needs the file descriptor to stop observing
+ * it. Instead, the last reference is dropped and it is closed when it is
+ * deallocated.
+ */
+- (void)OF_close
+{
+	closed = YES;
+
+	[socket release];
+	socket = nil;
+}
+
+- (void)OF_read
+{
+	SEL selector =
+	    @selector(OF_socket:didReadIntoBuffer:length:context:exception:);
+
+	if (bufferLength == bufferSize) {
+		buffer = [self resizeMemory: buffer
+				       size: bufferSize * 2];
+		bufferSize *= 2;
+	}
+
+	[socket asyncReadIntoBuffer: buffer + bufferLength
+			     length: bufferSize - bufferLength
+			     target: self
+			   selector: selector
+			    context: nil];
+}
+
+- (void)start
+{
+	[self OF_read];
+}
+
+- (void)OF_sendErrorWithStatusCode: (short)statusCode
+{
+	@try {
+		[socket writeFormat: @"HTTP/1.1 %d %s\r\n"
+				     @"Connection: close\r\n"
+				     @"Content-Length: 0\r\n\r\n",
+				     statusCode,
+				     status_code_to_string(statusCode)];
+	} @catch (id e) {
+		/* We close the connection anyway */
+	}
+
+	[self OF_close];
+}
+
+/*
+ * Returns whether a complete request has been received. If so, it is stored
+ * in request and removed from the buffer.
+ */
+- (BOOL)OF_parseRequest
+{
+	size_t maxHeadSize = [server maxRequestHeadSize];
+	OFDataArray *body;
+
+	if (request == nil) {
+		char *end = NULL, *tmp = buffer + scanned;
+		OFString *contentLengthHeader;
+
+		/* Search for the empty line which ends the head */
+		while ((tmp = memchr(tmp, '\n',
+		    bufferLength - (tmp - buffer))) != NULL) {
+			size_t left = bufferLength - (tmp - buffer);
+
+			if (left >= 2 && tmp[1] == '\n') {
+				end = tmp + 2;
+				break;
+			}
+			if (left >= 3 && tmp[1] == '\r' && tmp[2] == '\n') {
+				end = tmp + 3;
+				break;
+			}
+
+			tmp++;
+		}
+
+		if (end == NULL) {
+			if (bufferLength > maxHeadSize)
+				[self OF_sendErrorWithStatusCode: 431];
+
+			/* Only the last two bytes need to be searched again */
+			scanned = (bufferLength > 2 ? bufferLength - 2 : 0);
+
+			return NO;
+		}
+
+		headLength = end - buffer;
+		scanned = 0;
+
+		if (headLength > maxHeadSize) {
+			[self OF_sendErrorWithStatusCode: 431];
+			return NO;
+		}
+
+		if ((request = [parse_head(buffer, headLength) retain]) ==
+		    nil) {
+			[self OF_sendErrorWithStatusCode: 400];
+			return NO;
+		}
+
+		if ([[request headers] objectForKey: @"Transfer-Encoding"] !=
+		    nil) {
+			[self OF_sendErrorWithStatusCode: 501];
+			return NO;
+		}
+
+		contentLength = 0;
+		contentLengthHeader =
+		    [[request headers] objectForKey: @"Content-Length"];
+
+		if (contentLengthHeader != nil) {
+			int errNo;
+			intmax_t length =
+			    [contentLengthHeader decimalValueWithError: &errNo];
+
+			if (errNo != 0 || length < 0) {
+				[self OF_sendErrorWithStatusCode: 400];
+				return NO;
+			}
+
+			if ((uintmax_t)length > [server maxRequestBodySize]) {
+				[self OF_sendErrorWithStatusCode: 413];
+				return NO;
+			}
+
+			contentLength = (size_t)length;
+		}
+	}
+
+	if (bufferLength - headLength < contentLength)
+		return NO;
+
+	if (contentLength > 0) {
+		body = [OFDataArray dataArray];
+		[body addItemsFromCArray: buffer + headLength
+				   count: contentLength];
+		[request OF_setBody: body];
+	}
+
+	/* Keep pipelined requests which have already been received */
+	memmove(buffer, buffer + headLength + contentLength,
+	    bufferLength - headLength - contentLength);
+	bufferLength -= headLength + contentLength;
+
+	return YES;
+}
+
+- (void)OF_handleResponse: (OFHTTPServerResponse*)response
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	@try {
+		[server OF_handleRequest: [response OF_request]
+				response: response];
+		[response finish];
+	} @catch (id e) {
+		[response OF_abort];
+	}
+
+	closesAfterResponse = ![response OF_keepsConnectionAlive];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+#ifdef OF_THREADS
+- (void)OF_handleResponseInThreadPool: (OFHTTPServerResponse*)response
+{
+	[self OF_handleResponse: response];
+
+	[self performSelector: @selector(OF_resume)
+		     onThread: [server OF_thread]
+		waitUntilDone: NO];
+}
+#endif
+
+- (void)OF_processRequests
+{
+	while (!busy && !closed) {
+		void *pool = objc_autoreleasePoolPush();
+		OFHTTPServerResponse *response;
+
+		if (![self OF_parseRequest]) {
+			objc_autoreleasePoolPop(pool);
+			break;
+		}
+
+		response = [[[OFHTTPServerResponse alloc]
+		    OF_initWithSocket: socket
+			      request: request] autorelease];
+		[request release];
+		request = nil;
+
+#ifdef OF_THREADS
+		if ([server threadPool] != nil) {
+			SEL selector =
+			    @selector(OF_handleResponseInThreadPool:);
+
+			busy = YES;
+
+			[[server threadPool] dispatchWithTarget: self
+						       selector: selector
+							 object: response];
+
+			objc_autoreleasePoolPop(pool);
+			break;
+		}
+#endif
+
+		[self OF_handleResponse: response];
+
+		if (closesAfterResponse)
+			[self OF_close];
+
+		objc_autoreleasePoolPop(pool);
+	}
+}
+
+- (void)OF_resume
+{
+	busy = NO;
+
+	if (closesAfterResponse) {
+		[self OF_close];
+		return;
+	}
+
+	[self OF_processRequests];
+
+	if (!busy && !closed)
+		[self OF_read];
+}
+
+-	   (BOOL)OF_socket: (OFTCPSocket*)sock
+	 didReadIntoBuffer: (void*)buffer_
+		    length: (size_t)length
+		   context: (id)context
+		 exception: (OFException*)exception
+{
+	if (exception != nil || (length == 0 && [sock isAtEndOfStream])) {
+		[self OF_close];
+		return NO;
+	}
+
+	bufferLength += length;
+
+	[self OF_processRequests];
+
+	if (!busy && !closed)
+		[self OF_read];
+
+	return NO;
+}
+@end
+
+@implementation OFHTTPServer
++ (instancetype)server
+{
+	return [[[self alloc] init] autorelease];
+}
+
+- init
+{
+	self = [super init];
+
+	@try {
+		host = @"127.0.0.1";
+		maxRequestHeadSize = 16 * 1024;
+		maxRequestBodySize = 1024 * 1024;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[host release];
+#ifdef OF_HAVE_BLOCKS
+	[requestHandler release];
+#endif
+#ifdef OF_THREADS
+	[threadPool release];
+	[thread release];
+#endif
+	[listeningSocket release];
+
+	[super dealloc];
+}
+
+- (void)setHost: (OFString*)host_
+{
+	OF_SETTER(host, host_, YES, 1)
+}
+
+- (OFString*)host
+{
+	OF_GETTER(host, YES)
+}
+
+- (void)setPort: (uint16_t)port_
+{
+	port = port_;
+}
+
+- (uint16_t)port
+{
+	return port;
+}
+
+- (void)setDelegate: (id <OFHTTPServerDelegate>)delegate_
+{
+	delegate = delegate_;
+}
+
+- (id <OFHTTPServerDelegate>)delegate
+{
+	return delegate;
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)setRequestHandler: (of_http_server_request_handler_t)requestHandler_
+{
+	OF_SETTER(requestHandler, requestHandler_, YES, 1)
+}
+
+- (of_http_server_request_handler_t)requestHandler
+{
+	OF_GETTER(requestHandler, YES)
+}
+#endif
+
+#ifdef OF_THREADS
+- (void)setThreadPool: (OFThreadPool*)threadPool_
+{
+	OF_SETTER(threadPool, threadPool_, YES, 0)
+}
+
+- (OFThreadPool*)threadPool
+{
+	OF_GETTER(threadPool, YES)
+}
+#endif
+
+- (void)setMaxRequestHeadSize: (size_t)maxRequestHeadSize_
+{
+	maxRequestHeadSize = maxRequestHeadSize_;
+}
+
+- (size_t)maxRequestHeadSize
+{
+	return maxRequestHeadSize;
+}
+
+- (void)setMaxRequestBodySize: (size_t)maxRequestBodySize_
+{
+	maxRequestBodySize = maxRequestBodySize_;
+}
+
+- (size_t)maxRequestBodySize
+{
+	return maxRequestBodySize;
+}
+
+- (void)start
+{
+	SEL selector =
+	    @selector(OF_socket:didAcceptSocket:context:exception:);
+
+	if (listeningSocket != nil)
+		@throw [OFAlreadyConnectedException
+		    exceptionWithClass: [self class]
+				socket: listeningSocket];
+
+	listeningSocket = [[OFTCPSocket alloc] init];
+	port = [listeningSocket bindToHost: host
+				      port: port];
+	[listeningSocket listen];
+
+#ifdef OF_THREADS
+	thread = [[OFThread currentThread] retain];
+#endif
+
+	[listeningSocket asyncAcceptWithTarget: self
+				      selector: selector
+				       context: nil];
+}
+
+-    (BOOL)OF_socket: (OFTCPSocket*)sock
+     didAcceptSocket: (OFTCPSocket*)clientSocket
+	     context: (id)context
+	   exception: (OFException*)exception
+{
+	OFHTTPServer_Connection *connection;
+
+	/* Failing to accept one connection should not stop the server */
+	if (exception != nil)
+		return YES;
+
+	connection = [[[OFHTTPServer_Connection alloc]
+	    initWithServer: self
+		    socket: clientSocket] autorelease];
+	[connection start];
+
+	return YES;
+}
+
+#ifdef OF_THREADS
+- (OFThread*)OF_thread
+{
+	return thread;
+}
+#endif
+
+- (void)OF_handleRequest: (OFHTTPServerRequest*)request
+		response: (OFHTTPServerResponse*)response
+{
+#ifdef OF_HAVE_BLOCKS
+	if (requestHandler != NULL) {
+		requestHandler(request, response);
+		return;
+	}
+#endif
+
+	[delegate server: self
+	didReceiveRequest: request
+		 response: response];
+}
+@end
+
+@implementation OFHTTPServerRequest
+- OF_initWithMethod: (OFString*)method_
+	       path: (OFString*)path_
+	      query: (OFString*)query_
+	    version: (OFString*)version_
+	    headers: (OFDictionary*)headers_
+{
+	self = [super init];
+
+	@try {
+		method = [method_ copy];
+		path = [path_ copy];
+		query = [query_ copy];
+		version = [version_ copy];
+		headers = [headers_ copy];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[method release];
+	[path release];
+	[query release];
+	[version release];
+	[headers release];
+	[body release];
+
+	[super dealloc];
+}
+
+- (void)OF_setBody: (OFDataArray*)body_
+{
+	OF_SETTER(body, body_, YES, 0)
+}
+
+- (OFString*)method
+{
+	OF_GETTER(method, YES)
+}
+
+- (OFString*)path
+{
+	OF_GETTER(path, YES)
+}
+
+- (OFString*)query
+{
+	OF_GETTER(query, YES)
+}
+
+- (OFString*)version
+{
+	OF_GETTER(version, YES)
+}
+
+- (OFDictionary*)headers
+{
+	OF_GETTER(headers, YES)
+}
+
+- (OFDataArray*)body
+{
+	OF_GETTER(body, YES)
+}
+@end
+
+@implementation OFHTTPServerResponse
+- OF_initWithSocket: (OFTCPSocket*)socket_
+	    request: (OFHTTPServerRequest*)request_
+{
+	self = [super init];
+
+	@try {
+		OFString *connection =
+		    [[request_ headers] objectForKey: @"Connection"];
+
+		socket = [socket_ retain];
+		request = [request_ retain];
+		statusCode = 200;
+		headers = [[OFMutableDictionary alloc] init];
+
+		HTTP11 = [[request_ version] isEqual: @"1.1"];
+		if (HTTP11)
+			keepAlive = (connection == nil || [connection
+			    caseInsensitiveCompare: @"close"] !=
+			    OF_ORDERED_SAME);
+		else
+			keepAlive = (connection != nil && [connection
+			    caseInsensitiveCompare: @"keep-alive"] ==
+			    OF_ORDERED_SAME);
+
+		omitsBody = [[request_ method] isEqual: @"HEAD"];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[socket release];
+	[request release];
+	[headers release];
+
+	[super dealloc];
+}
+
+- (void)setStatusCode: (short)statusCode_
+{
+	statusCode = statusCode_;
+}
+
+- (short)statusCode
+{
+	return statusCode;
+}
+
+- (OFMutableDictionary*)headers
+{
+	OF_GETTER(headers, YES)
+}
+
+- (OFHTTPServerRequest*)OF_request
+{
+	return request;
+}
+
+- (BOOL)OF_keepsConnectionAlive
+{
+	return keepAlive;
+}
+
+- (void)OF_sendHeadWhileFinishing: (BOOL)finishing
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFEnumerator *keyEnumerator, *objectEnumerator;
+	OFString *key, *object;
+
+	if (!(statusCode / 100 == 1 || statusCode == 204 ||
+	    statusCode == 304) &&
+	    [headers objectForKey: @"Content-Length"] == nil) {
+		if (finishing)
+			[headers setObject: @"0"
+				    forKey: @"Content-Length"];
+		else if (HTTP11)
+			chunked = YES;
+		else
+			keepAlive = NO;
+	}
+
+	/* The head and the body are sent with as few writes as possible */
+	[socket setWriteBufferEnabled: YES];
+
+	[socket writeFormat: @"HTTP/%s %d %s\r\n", (HTTP11 ? "1.1" : "1.0"),
+	    statusCode, status_code_to_string(statusCode)];
+
+	if ([headers objectForKey: @"Date"] == nil)
+		[socket writeFormat: @"Date: %@\r\n",
+		    [[OFDateFormatter RFC1123DateFormatter]
+		    stringFromDate: [OFDate date]]];
+
+	keyEnumerator = [headers keyEnumerator];
+	objectEnumerator = [headers objectEnumerator];
+
+	while ((key = [keyEnumerator nextObject]) != nil &&
+	    (object = [objectEnumerator nextObject]) != nil)
+		[socket writeFormat: @"%@: %@\r\n", key, object];
+
+	if (!keepAlive)
+		[socket writeString: @"Connection: close\r\n"];
+	else if (!HTTP11)
+		[socket writeString: @"Connection: keep-alive\r\n"];
+
+	if (chunked)
+		[socket writeString: @"Transfer-Encoding: chunked\r\n"];
+
+	[socket writeString: @"\r\n"];
+
+	headSent = YES;
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)writeBuffer: (const void*)buffer
+	     length: (size_t)length
+{
+	if (finished)
+		@throw [OFInvalidArgumentException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+
+	if (!headSent)
+		[self OF_sendHeadWhileFinishing: NO];
+
+	if (!omitsBody && length > 0) {
+		if (chunked) {
+			[socket writeFormat: @"%zx\r\n", length];
+			[socket writeBuffer: buffer
+				     length: length];
+			[socket writeString: @"\r\n"];
+		} else
+			[socket writeBuffer: buffer
+				     length: length];
+	}
+
+	[socket flushWriteBuffer];
+}
+
+- (void)writeString: (OFString*)string
+{
+	[self writeBuffer: [string UTF8String]
+		   length: [string UTF8StringLength]];
+}
+
+- (void)finish
+{
+	if (finished)
+		return;
+
+	if (!headSent)
+		[self OF_sendHeadWhileFinishing: YES];
+
+	if (chunked && !omitsBody)
+		[socket writeString: @"0\r\n\r\n"];
+
+	[socket flushWriteBuffer];
+	[socket setWriteBufferEnabled: NO];
+
+	finished = YES;
+}
+
+- (void)OF_abort
+{
+	keepAlive = NO;
+
+	if (finished)
+		return;
+
+	finished = YES;
+
+	/*
+	 * If nothing has been sent yet, the client can still be told about
+	 * the error. Otherwise, the connection is just closed.
+	 */
+	@try {
+		if (!headSent) {
+			statusCode = 500;
+			[headers release];
+			headers = nil;
+			headers = [[OFMutableDictionary alloc] init];
+			[self OF_sendHeadWhileFinishing: YES];
+		}
+
+		[socket flushWriteBuffer];
+		[socket setWriteBufferEnabled: NO];
+	} @catch (id e) {
+		/* The connection is closed anyway */
+	}
+}
+@end
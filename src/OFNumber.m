@@ -317,134 +317,308 @@
 		    exceptionWithClass: [self class]];			\
 	}
 
+#if defined(OF_OBJFW_RUNTIME) && defined(OBJC_TAGGED_POINTERS)
+# define TAGGED_NUMBERS
+#endif
+
+#ifdef TAGGED_NUMBERS
+/*
+ * A tagged number stores the type in the lowest 7 bits of the tagged pointer
+ * value and the value itself in the remaining 53 bits. Floats are stored as
+ * their bit pattern, doubles only if they can be represented as a float
+ * without loss of precision.
+ */
+# define TAGGED_TYPE_BITS 7
+# define TAGGED_TYPE_MASK ((1 << TAGGED_TYPE_BITS) - 1)
+# define TAGGED_VALUE_BITS (OBJC_TAGGED_POINTER_BITS - TAGGED_TYPE_BITS)
+# define TAGGED_SIGNED_MAX (((intmax_t)1 << (TAGGED_VALUE_BITS - 1)) - 1)
+# define TAGGED_SIGNED_MIN (-((intmax_t)1 << (TAGGED_VALUE_BITS - 1)))
+# define TAGGED_UNSIGNED_MAX (((uintmax_t)1 << TAGGED_VALUE_BITS) - 1)
+
+@interface OFNumber_tagged: OFNumber
+- (OFNumber*)OF_untaggedNumber;
+@end
+
+static Class numberClass = Nil;
+static int numberTag = -1;
+
+static OF_INLINE OFNumber*
+tagged_number(of_number_type_t type, uintptr_t bits)
+{
+	return (OFNumber*)objc_createTaggedPointer(numberTag,
+	    (bits << TAGGED_TYPE_BITS) | type);
+}
+
+static OF_INLINE of_number_type_t
+tagged_type(OFNumber *number)
+{
+	return (of_number_type_t)
+	    (object_getTaggedPointerValue(number) & TAGGED_TYPE_MASK);
+}
+
+static OF_INLINE intmax_t
+tagged_signed_value(OFNumber *number)
+{
+	return object_getTaggedPointerSignedValue(number) >> TAGGED_TYPE_BITS;
+}
+
+static OF_INLINE uintmax_t
+tagged_unsigned_value(OFNumber *number)
+{
+	return object_getTaggedPointerValue(number) >> TAGGED_TYPE_BITS;
+}
+
+static OF_INLINE float
+tagged_float_value(OFNumber *number)
+{
+	union {
+		float f;
+		uint32_t u;
+	} f;
+
+	f.u = (uint32_t)tagged_unsigned_value(number);
+
+	return f.f;
+}
+
+static OF_INLINE BOOL
+fits_signed(intmax_t value)
+{
+	return (value >= TAGGED_SIGNED_MIN && value <= TAGGED_SIGNED_MAX);
+}
+
+static OF_INLINE BOOL
+fits_unsigned(uintmax_t value)
+{
+	return (value <= TAGGED_UNSIGNED_MAX);
+}
+
+static OF_INLINE uintptr_t
+float_bits(float value)
+{
+	union {
+		float f;
+		uint32_t u;
+	} f;
+
+	f.f = value;
+
+	return f.u;
+}
+
+/*
+ * Only OFNumber itself returns tagged numbers, as subclasses might add
+ * instance variables.
+ */
+# define TRY_TAGGED_SIGNED(t, v)					\
+	if (self == numberClass && fits_signed(v))			\
+		return tagged_number(t, (uintptr_t)(intmax_t)(v));
+# define TRY_TAGGED_UNSIGNED(t, v)					\
+	if (self == numberClass && fits_unsigned(v))			\
+		return tagged_number(t, (uintptr_t)(v));
+# define TRY_TAGGED_FLOAT(t, v)						\
+	if (self == numberClass && (double)(float)(v) == (v))		\
+		return tagged_number(t, float_bits((float)(v)));
+#else
+# define TRY_TAGGED_SIGNED(t, v)
+# define TRY_TAGGED_UNSIGNED(t, v)
+# define TRY_TAGGED_FLOAT(t, v)
+#endif
+
 @implementation OFNumber
+#ifdef TAGGED_NUMBERS
++ (void)initialize
+{
+	if (self != [OFNumber class])
+		return;
+
+	numberTag = objc_registerTaggedPointerClass([OFNumber_tagged class]);
+
+	/* If all tags are taken, OFNumber simply never uses tagged pointers */
+	if (numberTag != -1)
+		numberClass = self;
+}
+#endif
+
 + (instancetype)numberWithBool: (BOOL)bool_
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_BOOL, (bool_ ? 1 : 0))
+
 	return [[[self alloc] initWithBool: bool_] autorelease];
 }
 
 + (instancetype)numberWithChar: (signed char)char_
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_CHAR, char_)
+
 	return [[[self alloc] initWithChar: char_] autorelease];
 }
 
 + (instancetype)numberWithShort: (signed short)short_
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_SHORT, short_)
+
 	return [[[self alloc] initWithShort: short_] autorelease];
 }
 
 + (instancetype)numberWithInt: (signed int)int_
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_INT, int_)
+
 	return [[[self alloc] initWithInt: int_] autorelease];
 }
 
 + (instancetype)numberWithLong: (signed long)long_
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_LONG, long_)
+
 	return [[[self alloc] initWithLong: long_] autorelease];
 }
 
 + (instancetype)numberWithUnsignedChar: (unsigned char)uchar
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UCHAR, uchar)
+
 	return [[[self alloc] initWithUnsignedChar: uchar] autorelease];
 }
 
 + (instancetype)numberWithUnsignedShort: (unsigned short)ushort
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_USHORT, ushort)
+
 	return [[[self alloc] initWithUnsignedShort: ushort] autorelease];
 }
 
 + (instancetype)numberWithUnsignedInt: (unsigned int)uint
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UINT, uint)
+
 	return [[[self alloc] initWithUnsignedInt: uint] autorelease];
 }
 
 + (instancetype)numberWithUnsignedLong: (unsigned long)ulong
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_ULONG, ulong)
+
 	return [[[self alloc] initWithUnsignedLong: ulong] autorelease];
 }
 
 + (instancetype)numberWithInt8: (int8_t)int8
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_INT8, int8)
+
 	return [[[self alloc] initWithInt8: int8] autorelease];
 }
 
 + (instancetype)numberWithInt16: (int16_t)int16
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_INT16, int16)
+
 	return [[[self alloc] initWithInt16: int16] autorelease];
 }
 
 + (instancetype)numberWithInt32: (int32_t)int32
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_INT32, int32)
+
 	return [[[self alloc] initWithInt32: int32] autorelease];
 }
 
 + (instancetype)numberWithInt64: (int64_t)int64
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_INT64, int64)
+
 	return [[[self alloc] initWithInt64: int64] autorelease];
 }
 
 + (instancetype)numberWithUInt8: (uint8_t)uint8
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UINT8, uint8)
+
 	return [[[self alloc] initWithUInt8: uint8] autorelease];
 }
 
 + (instancetype)numberWithUInt16: (uint16_t)uint16
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UINT16, uint16)
+
 	return [[[self alloc] initWithUInt16: uint16] autorelease];
 }
 
 + (instancetype)numberWithUInt32: (uint32_t)uint32
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UINT32, uint32)
+
 	return [[[self alloc] initWithUInt32: uint32] autorelease];
 }
 
 + (instancetype)numberWithUInt64: (uint64_t)uint64
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UINT64, uint64)
+
 	return [[[self alloc] initWithUInt64: uint64] autorelease];
 }
 
 + (instancetype)numberWithSize: (size_t)size
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_SIZE, size)
+
 	return [[[self alloc] initWithSize: size] autorelease];
 }
 
 + (instancetype)numberWithSSize: (ssize_t)ssize
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_SSIZE, ssize)
+
 	return [[[self alloc] initWithSSize: ssize] autorelease];
 }
 
 + (instancetype)numberWithIntMax: (intmax_t)intmax
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_INTMAX, intmax)
+
 	return [[[self alloc] initWithIntMax: intmax] autorelease];
 }
 
 + (instancetype)numberWithUIntMax: (uintmax_t)uintmax
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UINTMAX, uintmax)
+
 	return [[[self alloc] initWithUIntMax: uintmax] autorelease];
 }
 
 + (instancetype)numberWithPtrDiff: (ptrdiff_t)ptrdiff
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_PTRDIFF, ptrdiff)
+
 	return [[[self alloc] initWithPtrDiff: ptrdiff] autorelease];
 }
 
 + (instancetype)numberWithIntPtr: (intptr_t)intptr
 {
+	TRY_TAGGED_SIGNED(OF_NUMBER_INTPTR, intptr)
+
 	return [[[self alloc] initWithIntPtr: intptr] autorelease];
 }
 
 + (instancetype)numberWithUIntPtr: (uintptr_t)uintptr
 {
+	TRY_TAGGED_UNSIGNED(OF_NUMBER_UINTPTR, uintptr)
+
 	return [[[self alloc] initWithUIntPtr: uintptr] autorelease];
 }
 
 + (instancetype)numberWithFloat: (float)float_
 {
+	TRY_TAGGED_FLOAT(OF_NUMBER_FLOAT, float_)
+
 	return [[[self alloc] initWithFloat: float_] autorelease];
 }
 
 + (instancetype)numberWithDouble: (double)double_
 {
+	TRY_TAGGED_FLOAT(OF_NUMBER_DOUBLE, double_)
+
 	return [[[self alloc] initWithDouble: double_] autorelease];
 }
 
@@ -979,16 +1153,19 @@
 - (BOOL)isEqual: (id)object
 {
 	OFNumber *number;
+	of_number_type_t type1, type2;
 
 	if (![object isKindOfClass: [OFNumber class]])
 		return NO;
 
 	number = object;
+	type1 = [self type];
+	type2 = [number type];
 
-	if (type & OF_NUMBER_FLOAT || number->type & OF_NUMBER_FLOAT)
+	if (type1 & OF_NUMBER_FLOAT || type2 & OF_NUMBER_FLOAT)
 		return ([number doubleValue] == [self doubleValue]);
 
-	if (type & OF_NUMBER_SIGNED || number->type & OF_NUMBER_SIGNED)
+	if (type1 & OF_NUMBER_SIGNED || type2 & OF_NUMBER_SIGNED)
 		return ([number intMaxValue] == [self intMaxValue]);
 
 	return ([number uIntMaxValue] == [self uIntMaxValue]);
@@ -997,6 +1174,7 @@
 - (of_comparison_result_t)compare: (id <OFComparing>)object
 {
 	OFNumber *number;
+	of_number_type_t type1, type2;
 
 	if (![object isKindOfClass: [OFNumber class]])
 		@throw [OFInvalidArgumentException
@@ -1004,8 +1182,10 @@
 			      selector: _cmd];
 
 	number = (OFNumber*)object;
+	type1 = [self type];
+	type2 = [number type];
 
-	if (type & OF_NUMBER_FLOAT || number->type & OF_NUMBER_FLOAT) {
+	if (type1 & OF_NUMBER_FLOAT || type2 & OF_NUMBER_FLOAT) {
 		double double1 = [self doubleValue];
 		double double2 = [number doubleValue];
 
@@ -1015,7 +1195,7 @@
 			return OF_ORDERED_ASCENDING;
 
 		return OF_ORDERED_SAME;
-	} else if (type & OF_NUMBER_SIGNED || number->type & OF_NUMBER_SIGNED) {
+	} else if (type1 & OF_NUMBER_SIGNED || type2 & OF_NUMBER_SIGNED) {
 		intmax_t int1 = [self intMaxValue];
 		intmax_t int2 = [number intMaxValue];
 
@@ -1043,14 +1223,14 @@
 	uint32_t hash;
 	uint8_t i;
 
-	switch (type) {
+	switch ([self type]) {
 	case OF_NUMBER_FLOAT:;
 		union {
 			float f;
 			uint8_t b[sizeof(float)];
 		} f;
 
-		f.f = OF_BSWAP_FLOAT_IF_LE(value.float_);
+		f.f = OF_BSWAP_FLOAT_IF_LE([self floatValue]);
 
 		OF_HASH_INIT(hash);
 
@@ -1066,7 +1246,7 @@
 			uint8_t b[sizeof(double)];
 		} d;
 
-		d.d = OF_BSWAP_DOUBLE_IF_LE(value.double_);
+		d.d = OF_BSWAP_DOUBLE_IF_LE([self doubleValue]);
 
 		OF_HASH_INIT(hash);
 
@@ -1231,9 +1411,9 @@
 {
 	OFMutableString *ret;
 
-	switch (type) {
+	switch ([self type]) {
 	case OF_NUMBER_BOOL:
-		return (value.bool_ ? @"YES" : @"NO");
+		return ([self boolValue] ? @"YES" : @"NO");
 	case OF_NUMBER_UCHAR:
 	case OF_NUMBER_USHORT:
 	case OF_NUMBER_UINT:
@@ -1260,7 +1440,8 @@
 	case OF_NUMBER_INTPTR:
 		return [OFString stringWithFormat: @"%jd", [self intMaxValue]];
 	case OF_NUMBER_FLOAT:
-		ret = [OFMutableString stringWithFormat: @"%g", value.float_];
+		ret = [OFMutableString stringWithFormat: @"%g",
+		    [self floatValue]];
 
 		if (![ret containsString: @"."])
 			[ret appendString: @".0"];
@@ -1269,7 +1450,8 @@
 
 		return ret;
 	case OF_NUMBER_DOUBLE:
-		ret = [OFMutableString stringWithFormat: @"%lg", value.double_];
+		ret = [OFMutableString stringWithFormat: @"%lg",
+		    [self doubleValue]];
 
 		if (![ret containsString: @"."])
 			[ret appendString: @".0"];
@@ -1368,9 +1550,359 @@
 
 - (OFString*)JSONRepresentation
 {
-	if (type == OF_NUMBER_BOOL)
-		return (value.bool_ ? @"true" : @"false");
+	if ([self type] == OF_NUMBER_BOOL)
+		return ([self boolValue] ? @"true" : @"false");
 
 	return [self description];
 }
 @end
+
+#ifdef TAGGED_NUMBERS
+# define TAGGED_RETURN_AS(t)						\
+	if (tagged_type(self) & OF_NUMBER_FLOAT)			\
+		return (t)tagged_float_value(self);			\
+	if (tagged_type(self) & OF_NUMBER_SIGNED)			\
+		return (t)tagged_signed_value(self);			\
+	return (t)tagged_unsigned_value(self);
+
+@implementation OFNumber_tagged
+- (OFNumber*)OF_untaggedNumber
+{
+	OFNumber *number;
+
+	switch (tagged_type(self)) {
+	case OF_NUMBER_BOOL:
+		number = [[OFNumber alloc] initWithBool: [self boolValue]];
+		break;
+	case OF_NUMBER_CHAR:
+		number = [[OFNumber alloc] initWithChar: [self charValue]];
+		break;
+	case OF_NUMBER_SHORT:
+		number = [[OFNumber alloc] initWithShort: [self shortValue]];
+		break;
+	case OF_NUMBER_INT:
+		number = [[OFNumber alloc] initWithInt: [self intValue]];
+		break;
+	case OF_NUMBER_LONG:
+		number = [[OFNumber alloc] initWithLong: [self longValue]];
+		break;
+	case OF_NUMBER_UCHAR:
+		number = [[OFNumber alloc]
+		    initWithUnsignedChar: [self unsignedCharValue]];
+		break;
+	case OF_NUMBER_USHORT:
+		number = [[OFNumber alloc]
+		    initWithUnsignedShort: [self unsignedShortValue]];
+		break;
+	case OF_NUMBER_UINT:
+		number = [[OFNumber alloc]
+		    initWithUnsignedInt: [self unsignedIntValue]];
+		break;
+	case OF_NUMBER_ULONG:
+		number = [[OFNumber alloc]
+		    initWithUnsignedLong: [self unsignedLongValue]];
+		break;
+	case OF_NUMBER_INT8:
+		number = [[OFNumber alloc] initWithInt8: [self int8Value]];
+		break;
+	case OF_NUMBER_INT16:
+		number = [[OFNumber alloc] initWithInt16: [self int16Value]];
+		break;
+	case OF_NUMBER_INT32:
+		number = [[OFNumber alloc] initWithInt32: [self int32Value]];
+		break;
+	case OF_NUMBER_INT64:
+		number = [[OFNumber alloc] initWithInt64: [self int64Value]];
+		break;
+	case OF_NUMBER_UINT8:
+		number = [[OFNumber alloc] initWithUInt8: [self uInt8Value]];
+		break;
+	case OF_NUMBER_UINT16:
+		number = [[OFNumber alloc] initWithUInt16: [self uInt16Value]];
+		break;
+	case OF_NUMBER_UINT32:
+		number = [[OFNumber alloc] initWithUInt32: [self uInt32Value]];
+		break;
+	case OF_NUMBER_UINT64:
+		number = [[OFNumber alloc] initWithUInt64: [self uInt64Value]];
+		break;
+	case OF_NUMBER_SIZE:
+		number = [[OFNumber alloc] initWithSize: [self sizeValue]];
+		break;
+	case OF_NUMBER_SSIZE:
+		number = [[OFNumber alloc] initWithSSize: [self sSizeValue]];
+		break;
+	case OF_NUMBER_INTMAX:
+		number = [[OFNumber alloc] initWithIntMax: [self intMaxValue]];
+		break;
+	case OF_NUMBER_UINTMAX:
+		number = [[OFNumber alloc]
+		    initWithUIntMax: [self uIntMaxValue]];
+		break;
+	case OF_NUMBER_PTRDIFF:
+		number = [[OFNumber alloc]
+		    initWithPtrDiff: [self ptrDiffValue]];
+		break;
+	case OF_NUMBER_INTPTR:
+		number = [[OFNumber alloc] initWithIntPtr: [self intPtrValue]];
+		break;
+	case OF_NUMBER_UINTPTR:
+		number = [[OFNumber alloc]
+		    initWithUIntPtr: [self uIntPtrValue]];
+		break;
+	case OF_NUMBER_FLOAT:
+		number = [[OFNumber alloc] initWithFloat: [self floatValue]];
+		break;
+	case OF_NUMBER_DOUBLE:
+		number = [[OFNumber alloc] initWithDouble: [self doubleValue]];
+		break;
+	default:
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+	}
+
+	return [number autorelease];
+}
+
+- (of_number_type_t)type
+{
+	return tagged_type(self);
+}
+
+- (BOOL)boolValue
+{
+	if (tagged_type(self) & OF_NUMBER_FLOAT)
+		return (tagged_float_value(self) != 0);
+
+	return (tagged_unsigned_value(self) != 0);
+}
+
+- (signed char)charValue
+{
+	TAGGED_RETURN_AS(signed char)
+}
+
+- (signed short)shortValue
+{
+	TAGGED_RETURN_AS(signed short)
+}
+
+- (signed int)intValue
+{
+	TAGGED_RETURN_AS(signed int)
+}
+
+- (signed long)longValue
+{
+	TAGGED_RETURN_AS(signed long)
+}
+
+- (unsigned char)unsignedCharValue
+{
+	TAGGED_RETURN_AS(unsigned char)
+}
+
+- (unsigned short)unsignedShortValue
+{
+	TAGGED_RETURN_AS(unsigned short)
+}
+
+- (unsigned int)unsignedIntValue
+{
+	TAGGED_RETURN_AS(unsigned int)
+}
+
+- (unsigned long)unsignedLongValue
+{
+	TAGGED_RETURN_AS(unsigned long)
+}
+
+- (int8_t)int8Value
+{
+	TAGGED_RETURN_AS(int8_t)
+}
+
+- (int16_t)int16Value
+{
+	TAGGED_RETURN_AS(int16_t)
+}
+
+- (int32_t)int32Value
+{
+	TAGGED_RETURN_AS(int32_t)
+}
+
+- (int64_t)int64Value
+{
+	TAGGED_RETURN_AS(int64_t)
+}
+
+- (uint8_t)uInt8Value
+{
+	TAGGED_RETURN_AS(uint8_t)
+}
+
+- (uint16_t)uInt16Value
+{
+	TAGGED_RETURN_AS(uint16_t)
+}
+
+- (uint32_t)uInt32Value
+{
+	TAGGED_RETURN_AS(uint32_t)
+}
+
+- (uint64_t)uInt64Value
+{
+	TAGGED_RETURN_AS(uint64_t)
+}
+
+- (size_t)sizeValue
+{
+	TAGGED_RETURN_AS(size_t)
+}
+
+- (ssize_t)sSizeValue
+{
+	TAGGED_RETURN_AS(ssize_t)
+}
+
+- (intmax_t)intMaxValue
+{
+	TAGGED_RETURN_AS(intmax_t)
+}
+
+- (uintmax_t)uIntMaxValue
+{
+	TAGGED_RETURN_AS(uintmax_t)
+}
+
+- (ptrdiff_t)ptrDiffValue
+{
+	TAGGED_RETURN_AS(ptrdiff_t)
+}
+
+- (intptr_t)intPtrValue
+{
+	TAGGED_RETURN_AS(intptr_t)
+}
+
+- (uintptr_t)uIntPtrValue
+{
+	TAGGED_RETURN_AS(uintptr_t)
+}
+
+- (float)floatValue
+{
+	TAGGED_RETURN_AS(float)
+}
+
+- (double)doubleValue
+{
+	TAGGED_RETURN_AS(double)
+}
+
+- (OFNumber*)numberByAddingNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] numberByAddingNumber: number];
+}
+
+- (OFNumber*)numberBySubtractingNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] numberBySubtractingNumber: number];
+}
+
+- (OFNumber*)numberByMultiplyingWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] numberByMultiplyingWithNumber: number];
+}
+
+- (OFNumber*)numberByDividingWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] numberByDividingWithNumber: number];
+}
+
+- (OFNumber*)numberByANDingWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] numberByANDingWithNumber: number];
+}
+
+- (OFNumber*)numberByORingWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] numberByORingWithNumber: number];
+}
+
+- (OFNumber*)numberByXORingWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] numberByXORingWithNumber: number];
+}
+
+- (OFNumber*)numberByShiftingLeftWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber]
+	    numberByShiftingLeftWithNumber: number];
+}
+
+- (OFNumber*)numberByShiftingRightWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber]
+	    numberByShiftingRightWithNumber: number];
+}
+
+- (OFNumber*)remainderOfDivisionWithNumber: (OFNumber*)number
+{
+	return [[self OF_untaggedNumber] remainderOfDivisionWithNumber: number];
+}
+
+- (OFNumber*)numberByIncreasing
+{
+	return [[self OF_untaggedNumber] numberByIncreasing];
+}
+
+- (OFNumber*)numberByDecreasing
+{
+	return [[self OF_untaggedNumber] numberByDecreasing];
+}
+
+- (OFXMLElement*)XMLElementBySerializing
+{
+	return [[self OF_untaggedNumber] XMLElementBySerializing];
+}
+
+- retain
+{
+	return self;
+}
+
+- autorelease
+{
+	return self;
+}
+
+- (void)release
+{
+}
+
+- (unsigned int)retainCount
+{
+	return OF_RETAIN_COUNT_MAX;
+}
+
+- (BOOL)allowsWeakReference
+{
+	return YES;
+}
+
+- (BOOL)retainWeakReference
+{
+	return YES;
+}
+
+- (void)dealloc
+{
+	@throw [OFNotImplementedException exceptionWithClass: [self class]
+						    selector: _cmd];
+	[super dealloc];	/* Get rid of a stupid warning */
+}
+@end
+#endif
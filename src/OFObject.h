@@ -637,6 +637,31 @@ typedef struct of_rectangle_t
  */
 - (void)freeMemory: (void*)pointer;
 
+/*!
+ * @brief Returns whether a weak reference to the object may be created.
+ *
+ * This is called by the runtime when a weak reference to the object is
+ * created. It returns NO once the object is being deallocated. As a side
+ * effect, the object remembers that its weak references need to be cleared
+ * when it is deallocated.
+ *
+ * Classes which manage their own retain count need to reimplement this!
+ *
+ * @return Whether a weak reference to the object may be created
+ */
+- (BOOL)allowsWeakReference;
+
+/*!
+ * @brief Retains the object if it is not being deallocated.
+ *
+ * This is called by the runtime when a weak reference is loaded.
+ *
+ * Classes which manage their own retain count need to reimplement this!
+ *
+ * @return Whether the object could be retained
+ */
+- (BOOL)retainWeakReference;
+
 /*!
  * @brief Deallocates the object.
  *
@@ -63,16 +63,26 @@
 #import "instance.h"
 #if defined(OF_ATOMIC_OPS)
 # import "atomic.h"
-#elif defined(OF_THREADS)
+#endif
+#if defined(OF_THREADS)
 # import "threading.h"
 #endif
 
+/*
+ * The header in front of every object is kept as small as possible: The
+ * retain count is packed into 32 bits and there is only a single pointer to
+ * the memory allocated with -[allocMemoryWithSize:], which stays NULL unless
+ * that is used.
+ *
+ * The lower 30 bits of the retain count word hold the retain count. Should it
+ * ever get too big, half of it is moved to a side table and the highest bit
+ * is set to indicate this. The bit below is set once a weak reference to the
+ * object has been created, so that only those objects need to look up their
+ * weak references when they are deallocated.
+ */
 struct pre_ivar {
-	int32_t retainCount;
-	struct pre_mem *firstMem, *lastMem;
-#if !defined(OF_ATOMIC_OPS) && defined(OF_THREADS)
-	of_spinlock_t retainCountSpinlock;
-#endif
+	volatile int32_t retainCount;
+	struct pre_mem *firstMem;
 };
 
 struct pre_mem {
@@ -82,12 +92,48 @@ struct pre_mem {
 
 #define PRE_IVAR_ALIGN ((sizeof(struct pre_ivar) + \
 	(__BIGGEST_ALIGNMENT__ - 1)) & ~(__BIGGEST_ALIGNMENT__ - 1))
-#define PRE_IVAR ((struct pre_ivar*)(void*)((char*)self - PRE_IVAR_ALIGN))
+#define PRE_IVAR_OF(obj) \
+	((struct pre_ivar*)(void*)((char*)obj - PRE_IVAR_ALIGN))
+#define PRE_IVAR PRE_IVAR_OF(self)
 
 #define PRE_MEM_ALIGN ((sizeof(struct pre_mem) + \
 	(__BIGGEST_ALIGNMENT__ - 1)) & ~(__BIGGEST_ALIGNMENT__ - 1))
 #define PRE_MEM(mem) ((struct pre_mem*)(void*)((char*)mem - PRE_MEM_ALIGN))
 
+#define RC_MASK		0x3FFFFFFFu
+#define RC_WEAK		0x40000000u
+#define RC_OVERFLOW	0x80000000u
+#define RC_HALF		0x20000000u
+/* Move half of the retain count to the side table once this is reached */
+#define RC_SPILL	0x30000000u
+/* Take it back from the side table once the retain count drops below this */
+#define RC_BORROW	0x10000000u
+/* Whether the object is being deallocated */
+#define RC_IS_DEALLOCATING(rc) (((rc) & (RC_MASK | RC_OVERFLOW)) == 0)
+
+struct rc_overflow {
+	id object;
+	uint64_t count;
+	struct rc_overflow *next;
+};
+
+#ifdef OF_THREADS
+# define NUM_RC_SPINLOCKS 8	/* needs to be a power of 2 */
+# define RC_SPINLOCK_HASH(p) \
+	((unsigned)((uintptr_t)p >> 4) & (NUM_RC_SPINLOCKS - 1))
+static of_spinlock_t rc_spinlocks[NUM_RC_SPINLOCKS];
+static struct rc_overflow *rc_overflow_table[NUM_RC_SPINLOCKS];
+# define RC_LOCK(p) \
+	OF_ENSURE(of_spinlock_lock(&rc_spinlocks[RC_SPINLOCK_HASH(p)]))
+# define RC_UNLOCK(p) \
+	OF_ENSURE(of_spinlock_unlock(&rc_spinlocks[RC_SPINLOCK_HASH(p)]))
+#else
+# define RC_SPINLOCK_HASH(p) 0
+static struct rc_overflow *rc_overflow_table[1];
+# define RC_LOCK(p)
+# define RC_UNLOCK(p)
+#endif
+
 static struct {
 	Class isa;
 } alloc_failed_exception;
@@ -163,6 +209,117 @@ forward_handler(id obj, SEL sel)
 }
 #endif
 
+static OF_INLINE BOOL
+rc_cmpswap(volatile int32_t *rc, uint32_t old, uint32_t new)
+{
+#if defined(OF_ATOMIC_OPS)
+	return of_atomic_cmpswap_32(rc, (int32_t)old, (int32_t)new);
+#else
+	/* All modifications of the retain count hold the spinlock */
+	if ((uint32_t)*rc != old)
+		return NO;
+
+	*rc = (int32_t)new;
+	return YES;
+#endif
+}
+
+static struct rc_overflow**
+rc_overflow_lookup(id object)
+{
+	struct rc_overflow **iter;
+
+	for (iter = &rc_overflow_table[RC_SPINLOCK_HASH(object)];
+	    *iter != NULL; iter = &(*iter)->next)
+		if ((*iter)->object == object)
+			break;
+
+	return iter;
+}
+
+static void
+rc_spill(id object)
+{
+	volatile int32_t *rc = &PRE_IVAR_OF(object)->retainCount;
+	struct rc_overflow **entry;
+
+	RC_LOCK(object);
+
+	entry = rc_overflow_lookup(object);
+
+	if (*entry == NULL) {
+		/* If this fails, we just try again on the next retain */
+		if ((*entry = malloc(sizeof(struct rc_overflow))) == NULL) {
+			RC_UNLOCK(object);
+			return;
+		}
+
+		(*entry)->object = object;
+		(*entry)->count = 0;
+		(*entry)->next = NULL;
+	}
+
+	for (;;) {
+		uint32_t old = *rc;
+
+		/* Somebody else was faster */
+		if ((old & RC_MASK) < RC_SPILL)
+			break;
+
+		if (rc_cmpswap(rc, old, (old - RC_HALF) | RC_OVERFLOW)) {
+			(*entry)->count += RC_HALF;
+			break;
+		}
+	}
+
+	if ((*entry)->count == 0) {
+		struct rc_overflow *next = (*entry)->next;
+		free(*entry);
+		*entry = next;
+	}
+
+	RC_UNLOCK(object);
+}
+
+static void
+rc_borrow(id object)
+{
+	volatile int32_t *rc = &PRE_IVAR_OF(object)->retainCount;
+	struct rc_overflow **entry;
+
+	RC_LOCK(object);
+
+	entry = rc_overflow_lookup(object);
+
+	for (;;) {
+		uint32_t old = *rc, new;
+		uint64_t take;
+
+		/* Somebody else was faster */
+		if (!(old & RC_OVERFLOW) || (old & RC_MASK) >= RC_BORROW)
+			break;
+
+		assert(*entry != NULL);
+
+		take = ((*entry)->count < RC_HALF ? (*entry)->count : RC_HALF);
+		new = old + (uint32_t)take;
+		if ((*entry)->count == take)
+			new &= ~RC_OVERFLOW;
+
+		if (rc_cmpswap(rc, old, new)) {
+			if (((*entry)->count -= take) == 0) {
+				struct rc_overflow *next = (*entry)->next;
+				free(*entry);
+				*entry = next;
+			}
+
+			break;
+		}
+	}
+
+	RC_UNLOCK(object);
+}
+
 #ifndef HAVE_OBJC_ENUMERATIONMUTATION
 void
 objc_enumerationMutation(id object)
@@ -194,16 +351,6 @@ of_alloc_object(Class class, size_t extraSize, size_t extraAlignment,
 
 	((struct pre_ivar*)instance)->retainCount = 1;
 	((struct pre_ivar*)instance)->firstMem = NULL;
-	((struct pre_ivar*)instance)->lastMem = NULL;
-
-#if !defined(OF_ATOMIC_OPS) && defined(OF_THREADS)
-	if OF_UNLIKELY (!of_spinlock_new(
-	    &((struct pre_ivar*)instance)->retainCountSpinlock)) {
-		free(instance);
-		@throw [OFInitializationFailedException
-		    exceptionWithClass: class];
-	}
-#endif
 
 	instance = (OFObject*)((char*)instance + PRE_IVAR_ALIGN);
 
@@ -237,6 +384,13 @@ void _references_to_categories_of_OFObject(void)
 @implementation OFObject
 + (void)load
 {
+#ifdef OF_THREADS
+	size_t i;
+
+	for (i = 0; i < NUM_RC_SPINLOCKS; i++)
+		OF_ENSURE(of_spinlock_new(&rc_spinlocks[i]));
+#endif
+
 #if !defined(OF_APPLE_RUNTIME) || defined(__OBJC2__)
 	objc_setUncaughtExceptionHandler(uncaught_exception_handler);
 #endif
@@ -843,15 +997,13 @@ void _references_to_categories_of_OFObject(void)
 	preMem = pointer;
 
 	preMem->owner = self;
-	preMem->prev = PRE_IVAR->lastMem;
-	preMem->next = NULL;
+	preMem->prev = NULL;
+	preMem->next = PRE_IVAR->firstMem;
 
-	if OF_LIKELY (PRE_IVAR->lastMem != NULL)
-		PRE_IVAR->lastMem->next = preMem;
+	if OF_LIKELY (PRE_IVAR->firstMem != NULL)
+		PRE_IVAR->firstMem->prev = preMem;
 
-	if OF_UNLIKELY (PRE_IVAR->firstMem == NULL)
-		PRE_IVAR->firstMem = preMem;
-	PRE_IVAR->lastMem = preMem;
+	PRE_IVAR->firstMem = preMem;
 
 	return (char*)pointer + PRE_MEM_ALIGN;
 }
@@ -896,13 +1048,11 @@ void _references_to_categories_of_OFObject(void)
 	if OF_UNLIKELY (preMem != PRE_MEM(pointer)) {
 		if OF_LIKELY (preMem->prev != NULL)
 			preMem->prev->next = preMem;
+		else
+			PRE_IVAR->firstMem = preMem;
+
 		if OF_LIKELY (preMem->next != NULL)
 			preMem->next->prev = preMem;
-
-		if OF_UNLIKELY (PRE_IVAR->firstMem == PRE_MEM(pointer))
-			PRE_IVAR->firstMem = preMem;
-		if OF_UNLIKELY (PRE_IVAR->lastMem == PRE_MEM(pointer))
-			PRE_IVAR->lastMem = preMem;
 	}
 
 	return (char*)new + PRE_MEM_ALIGN;
@@ -940,14 +1090,12 @@ void _references_to_categories_of_OFObject(void)
 
 	if OF_LIKELY (PRE_MEM(pointer)->prev != NULL)
 		PRE_MEM(pointer)->prev->next = PRE_MEM(pointer)->next;
+	else
+		PRE_IVAR->firstMem = PRE_MEM(pointer)->next;
+
 	if OF_LIKELY (PRE_MEM(pointer)->next != NULL)
 		PRE_MEM(pointer)->next->prev = PRE_MEM(pointer)->prev;
 
-	if OF_UNLIKELY (PRE_IVAR->firstMem == PRE_MEM(pointer))
-		PRE_IVAR->firstMem = PRE_MEM(pointer)->next;
-	if OF_UNLIKELY (PRE_IVAR->lastMem == PRE_MEM(pointer))
-		PRE_IVAR->lastMem = PRE_MEM(pointer)->prev;
-
 	/* To detect double-free */
 	PRE_MEM(pointer)->owner = nil;
 
@@ -956,48 +1104,135 @@ void _references_to_categories_of_OFObject(void)
 
 - retain
 {
+	uint32_t rc;
+
 #if defined(OF_ATOMIC_OPS)
-	of_atomic_inc_32(&PRE_IVAR->retainCount);
-#elif defined(OF_THREADS)
-	OF_ENSURE(of_spinlock_lock(&PRE_IVAR->retainCountSpinlock));
-	PRE_IVAR->retainCount++;
-	OF_ENSURE(of_spinlock_unlock(&PRE_IVAR->retainCountSspinlock));
+	rc = of_atomic_inc_32(&PRE_IVAR->retainCount);
 #else
-	PRE_IVAR->retainCount++;
+	RC_LOCK(self);
+	rc = ++PRE_IVAR->retainCount;
+	RC_UNLOCK(self);
 #endif
 
+	if OF_UNLIKELY ((rc & RC_MASK) >= RC_SPILL)
+		rc_spill(self);
+
 	return self;
 }
 
 - (unsigned int)retainCount
 {
-	assert(PRE_IVAR->retainCount >= 0);
-	return PRE_IVAR->retainCount;
+	uint32_t rc = PRE_IVAR->retainCount;
+	uint64_t count;
+	struct rc_overflow *entry;
+
+	if OF_LIKELY (!(rc & RC_OVERFLOW))
+		return rc & RC_MASK;
+
+	RC_LOCK(self);
+
+	rc = PRE_IVAR->retainCount;
+	count = rc & RC_MASK;
+
+	if ((rc & RC_OVERFLOW) && (entry = *rc_overflow_lookup(self)) != NULL)
+		count += entry->count;
+
+	RC_UNLOCK(self);
+
+	return (count < OF_RETAIN_COUNT_MAX ? (unsigned int)count
+	    : OF_RETAIN_COUNT_MAX);
 }
 
 - (void)release
 {
+	uint32_t rc;
+
 #if defined(OF_ATOMIC_OPS)
-	if (of_atomic_dec_32(&PRE_IVAR->retainCount) <= 0)
+	rc = of_atomic_dec_32(&PRE_IVAR->retainCount);
+#else
+	RC_LOCK(self);
+	rc = --PRE_IVAR->retainCount;
+	RC_UNLOCK(self);
+#endif
+
+	if OF_LIKELY (RC_IS_DEALLOCATING(rc)) {
 		[self dealloc];
-#elif defined(OF_THREADS)
-	size_t c;
+		return;
+	}
 
-	OF_ENSURE(of_spinlock_lock(&PRE_IVAR->retainCountSpinlock));
-	c = --PRE_IVAR->retainCount;
-	OF_ENSURE(of_spinlock_unlock(&PRE_IVAR->retainCountSpinlock));
+	if OF_UNLIKELY ((rc & RC_OVERFLOW) && (rc & RC_MASK) < RC_BORROW)
+		rc_borrow(self);
+}
 
-	if (c == 0)
-		[self dealloc];
+- autorelease
+{
+	return _objc_rootAutorelease(self);
+}
+
+- (BOOL)allowsWeakReference
+{
+#if defined(OF_ATOMIC_OPS)
+	for (;;) {
+		uint32_t rc = PRE_IVAR->retainCount;
+
+		if OF_UNLIKELY (RC_IS_DEALLOCATING(rc))
+			return NO;
+
+		if OF_LIKELY (rc & RC_WEAK)
+			return YES;
+
+		if (rc_cmpswap(&PRE_IVAR->retainCount, rc, rc | RC_WEAK))
+			return YES;
+	}
 #else
-	if (--PRE_IVAR->retainCount == 0)
-		[self dealloc];
+	BOOL ret = NO;
+
+	RC_LOCK(self);
+
+	if OF_LIKELY (!RC_IS_DEALLOCATING(PRE_IVAR->retainCount)) {
+		PRE_IVAR->retainCount |= RC_WEAK;
+		ret = YES;
+	}
+
+	RC_UNLOCK(self);
+
+	return ret;
 #endif
 }
 
-- autorelease
+- (BOOL)retainWeakReference
 {
-	return _objc_rootAutorelease(self);
+	uint32_t rc;
+
+#if defined(OF_ATOMIC_OPS)
+	for (;;) {
+		rc = PRE_IVAR->retainCount;
+
+		if OF_UNLIKELY (RC_IS_DEALLOCATING(rc))
+			return NO;
+
+		if (rc_cmpswap(&PRE_IVAR->retainCount, rc, rc + 1))
+			break;
+	}
+#else
+	RC_LOCK(self);
+
+	rc = PRE_IVAR->retainCount;
+
+	if OF_UNLIKELY (RC_IS_DEALLOCATING(rc)) {
+		RC_UNLOCK(self);
+		return NO;
+	}
+
+	PRE_IVAR->retainCount = rc + 1;
+
+	RC_UNLOCK(self);
+#endif
+
+	if OF_UNLIKELY (((rc + 1) & RC_MASK) >= RC_SPILL)
+		rc_spill(self);
+
+	return YES;
 }
 
 - self
@@ -1014,6 +1249,11 @@ void _references_to_categories_of_OFObject(void)
 {
 	struct pre_mem *iter;
 
+#ifdef OF_OBJFW_RUNTIME
+	if (PRE_IVAR->retainCount & RC_WEAK)
+		objc_zero_weak_references(self);
+#endif
+
 	objc_destructInstance(self);
 
 	iter = PRE_IVAR->firstMem;
@@ -1109,6 +1349,16 @@ void _references_to_categories_of_OFObject(void)
 	return OF_RETAIN_COUNT_MAX;
 }
 
++ (BOOL)allowsWeakReference
+{
+	return YES;
+}
+
++ (BOOL)retainWeakReference
+{
+	return YES;
+}
+
 + (void)release
 {
 }
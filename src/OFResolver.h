@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#ifndef _WIN32
+# include <sys/types.h>
+# include <sys/socket.h>
+#endif
+
+#import "OFObject.h"
+
+#ifdef _WIN32
+# include <ws2tcpip.h>
+#endif
+
+@class OFResolver;
+@class OFString;
+@class OFDataArray;
+@class OFMutableDictionary;
+@class OFException;
+#ifdef OF_THREADS
+@class OFThreadPool;
+#endif
+
+/*!
+ * @brief A resolved address of a host.
+ *
+ * The port of the address is always 0.
+ */
+typedef struct of_resolver_address_t {
+	/// The address, which can be casted to a struct sockaddr
+	struct sockaddr_storage address;
+	/// The length of the address
+	socklen_t length;
+} of_resolver_address_t;
+
+#ifdef OF_HAVE_BLOCKS
+typedef void (^of_resolver_async_resolve_block_t)(OFResolver*, OFString*,
+    OFDataArray*, OFException*);
+#endif
+
+/*!
+ * @brief A class which resolves host names to addresses and caches the
+ *	  results.
+ *
+ * Resolved addresses are cached for the cache time to live. Lookups for a host
+ * for which a lookup is already in progress do not cause a second lookup, but
+ * wait for the result of the one in progress.
+ *
+ * Asynchronous lookups are performed by a small pool of threads which is
+ * shared by all asynchronous lookups of a resolver, so that they don't require
+ * creating a thread for each lookup.
+ */
+@interface OFResolver: OFObject
+{
+	OFMutableDictionary *cache, *pendingLookups;
+	double cacheTimeToLive;
+#ifdef OF_THREADS
+	OFThreadPool *threadPool;
+#endif
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property double cacheTimeToLive;
+#endif
+
+/*!
+ * @brief Returns the resolver which is used by OFTCPSocket.
+ *
+ * @return The shared resolver
+ */
++ (OFResolver*)sharedResolver;
+
+/*!
+ * @brief Creates a new resolver with an empty cache.
+ *
+ * @return A new, autoreleased OFResolver
+ */
++ (instancetype)resolver;
+
+/*!
+ * @brief Sets the time in seconds for which resolved addresses are cached.
+ *
+ * The system resolver does not report the time to live of the records it
+ * returned, so the same time is used for all hosts. The default is 60 seconds.
+ * A time of 0 disables the cache, but not the coalescing of lookups.
+ *
+ * @param cacheTimeToLive The time in seconds for which resolved addresses are
+ *			  cached
+ */
+- (void)setCacheTimeToLive: (double)cacheTimeToLive;
+
+/*!
+ * @brief Returns the time in seconds for which resolved addresses are cached.
+ *
+ * @return The time in seconds for which resolved addresses are cached
+ */
+- (double)cacheTimeToLive;
+
+/*!
+ * @brief Resolves the specified host.
+ *
+ * @param host The host to resolve
+ * @return An OFDataArray of of_resolver_address_t with the addresses of the
+ *	   host, in the order in which they should be tried
+ */
+- (OFDataArray*)addressesForHost: (OFString*)host;
+
+#ifdef OF_THREADS
+/*!
+ * @brief Asynchronously resolves the specified host.
+ *
+ * The target is called on the thread which started the lookup, so that thread
+ * needs to run its run loop.
+ *
+ * @param host The host to resolve
+ * @param target The target on which to call the selector once the host has
+ *		 been resolved
+ * @param selector The selector to call on the target. The signature must be
+ *		   void (OFResolver *resolver, OFString *host,
+ *		   OFDataArray *addresses, id context, OFException *exception).
+ * @param context A context to pass when the target gets called
+ */
+- (void)asyncResolveHost: (OFString*)host
+		  target: (id)target
+		selector: (SEL)selector
+		 context: (id)context;
+
+# ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief Asynchronously resolves the specified host.
+ *
+ * The block is called on the thread which started the lookup, so that thread
+ * needs to run its run loop.
+ *
+ * @param host The host to resolve
+ * @param block The block to execute once the host has been resolved
+ */
+- (void)asyncResolveHost: (OFString*)host
+		   block: (of_resolver_async_resolve_block_t)block;
+# endif
+#endif
+
+/*!
+ * @brief Removes all addresses from the cache.
+ */
+- (void)removeAllCachedAddresses;
+
+#ifdef OF_THREADS
+- (OFThreadPool*)OF_threadPool;
+#endif
+@end
@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#define __NO_EXT_QNX
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <netinet/in.h>
+# include <netdb.h>
+#endif
+
+#import "OFResolver.h"
+#import "OFString.h"
+#import "OFArray.h"
+#import "OFDictionary.h"
+#import "OFDataArray.h"
+#ifdef OF_THREADS
+# import "OFThread.h"
+# import "OFThreadPool.h"
+# import "OFCondition.h"
+#endif
+
+#import "OFAddressTranslationFailedException.h"
+
+#import "autorelease.h"
+#import "macros.h"
+#import "of_clock.h"
+
+#if defined(OF_THREADS) && !defined(HAVE_THREADSAFE_GETADDRINFO)
+# import "OFMutex.h"
+
+static OFMutex *mutex = nil;
+#endif
+
+#define THREAD_POOL_SIZE 4
+
+static OFResolver *sharedResolver = nil;
+
+@interface OFResolver_CacheEntry: OFObject
+{
+@public
+	OFDataArray *addresses;
+	uint64_t expiration;
+}
+@end
+
+@interface OFResolver_Lookup: OFObject
+{
+@public
+	OFString *host, *key;
+	BOOL started;
+	OFDataArray *addresses;
+#ifdef OF_THREADS
+	OFMutableArray *requests;
+	OFCondition *condition;
+	BOOL done;
+#endif
+}
+
+- initWithHost: (OFString*)host
+	   key: (OFString*)key;
+#ifdef OF_THREADS
+- (void)waitUntilDone;
+#endif
+- (void)didFinishWithAddresses: (OFDataArray*)addresses;
+@end
+
+#ifdef OF_THREADS
+@interface OFResolver_AsyncRequest: OFObject
+{
+@public
+	OFResolver *resolver;
+	OFString *host;
+	OFThread *sourceThread;
+	id target;
+	SEL selector;
+	id context;
+# ifdef OF_HAVE_BLOCKS
+	of_resolver_async_resolve_block_t block;
+# endif
+}
+
+- (void)didResolveWithAddresses: (OFDataArray*)addresses;
+@end
+#endif
+
+@interface OFResolver (OF_PrivateMethods)
+- (OFDataArray*)OF_cachedAddressesForKey: (OFString*)key;
+- (void)OF_performLookup: (OFResolver_Lookup*)lookup;
+#ifdef OF_THREADS
+- (void)OF_performQueuedLookup: (OFResolver_Lookup*)lookup;
+- (void)OF_addAsyncRequest: (OFResolver_AsyncRequest*)request;
+#endif
+@end
+
+static OFDataArray*
+resolve_host(OFString *host)
+{
+	OFDataArray *addresses =
+	    [OFDataArray dataArrayWithItemSize: sizeof(of_resolver_address_t)];
+	of_resolver_address_t address;
+#ifdef HAVE_THREADSAFE_GETADDRINFO
+	struct addrinfo hints, *res, *res0;
+
+	memset(&hints, 0, sizeof(struct addrinfo));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if (getaddrinfo([host cStringWithEncoding: OF_STRING_ENCODING_NATIVE],
+	    NULL, &hints, &res0))
+		return nil;
+
+	@try {
+		for (res = res0; res != NULL; res = res->ai_next) {
+			if (res->ai_addrlen > sizeof(address.address))
+				continue;
+
+			memset(&address, 0, sizeof(address));
+			memcpy(&address.address, res->ai_addr, res->ai_addrlen);
+			address.length = (socklen_t)res->ai_addrlen;
+
+			[addresses addItem: &address];
+		}
+	} @finally {
+		freeaddrinfo(res0);
+	}
+#else
+	struct hostent *he;
+	struct sockaddr_in *addr = (struct sockaddr_in*)&address.address;
+	char **ip;
+
+# ifdef OF_THREADS
+	[mutex lock];
+
+	@try {
+# endif
+		if ((he = gethostbyname([host cStringWithEncoding:
+		    OF_STRING_ENCODING_NATIVE])) == NULL ||
+		    he->h_addrtype != AF_INET)
+			return nil;
+
+		for (ip = he->h_addr_list; *ip != NULL; ip++) {
+			memset(&address, 0, sizeof(address));
+			addr->sin_family = AF_INET;
+			memcpy(&addr->sin_addr.s_addr, *ip, he->h_length);
+			address.length = sizeof(*addr);
+
+			[addresses addItem: &address];
+		}
+# ifdef OF_THREADS
+	} @finally {
+		[mutex unlock];
+	}
+# endif
+#endif
+
+	if ([addresses count] == 0)
+		return nil;
+
+	return addresses;
+}
+
+@implementation OFResolver_CacheEntry
+- (void)dealloc
+{
+	[addresses release];
+
+	[super dealloc];
+}
+@end
+
+@implementation OFResolver_Lookup
+- initWithHost: (OFString*)host_
+	   key: (OFString*)key_
+{
+	self = [super init];
+
+	@try {
+		host = [host_ copy];
+		key = [key_ copy];
+#ifdef OF_THREADS
+		requests = [[OFMutableArray alloc] init];
+		condition = [[OFCondition alloc] init];
+#endif
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[host release];
+	[key release];
+	[addresses release];
+#ifdef OF_THREADS
+	[requests release];
+	[condition release];
+#endif
+
+	[super dealloc];
+}
+
+#ifdef OF_THREADS
+- (void)waitUntilDone
+{
+	[condition lock];
+	@try {
+		while (!done)
+			[condition wait];
+	} @finally {
+		[condition unlock];
+	}
+}
+#endif
+
+- (void)didFinishWithAddresses: (OFDataArray*)addresses_
+{
+#ifdef OF_THREADS
+	void *pool;
+	OFResolver_AsyncRequest **objects;
+	size_t i, count;
+
+	[condition lock];
+	@try {
+		addresses = [addresses_ retain];
+		done = YES;
+		[condition broadcast];
+	} @finally {
+		[condition unlock];
+	}
+
+	/*
+	 * The lookup has already been removed from the pending lookups, so no
+	 * more requests can be added.
+	 */
+	pool = objc_autoreleasePoolPush();
+	objects = (OFResolver_AsyncRequest**)[requests objects];
+	count = [requests count];
+
+	for (i = 0; i < count; i++)
+		[objects[i] performSelector: @selector(didResolveWithAddresses:)
+				   onThread: objects[i]->sourceThread
+				 withObject: [[addresses copy] autorelease]
+			      waitUntilDone: NO];
+
+	[requests removeAllObjects];
+	objc_autoreleasePoolPop(pool);
+#else
+	addresses = [addresses_ retain];
+#endif
+}
+@end
+
+#ifdef OF_THREADS
+@implementation OFResolver_AsyncRequest
+- (void)dealloc
+{
+	[resolver release];
+	[host release];
+	[sourceThread release];
+	[target release];
+	[context release];
+# ifdef OF_HAVE_BLOCKS
+	[block release];
+# endif
+
+	[super dealloc];
+}
+
+- (void)didResolveWithAddresses: (OFDataArray*)addresses
+{
+	OFException *exception = nil;
+
+	if (addresses == nil)
+		exception = [OFAddressTranslationFailedException
+		    exceptionWithClass: [resolver class]
+				socket: nil
+				  host: host];
+
+# ifdef OF_HAVE_BLOCKS
+	if (block != NULL)
+		block(resolver, host, addresses, exception);
+	else {
+# endif
+		void (*func)(id, SEL, OFResolver*, OFString*, OFDataArray*, id,
+		    OFException*) = (void(*)(id, SEL, OFResolver*, OFString*,
+		    OFDataArray*, id, OFException*))[target
+		    methodForSelector: selector];
+
+		func(target, selector, resolver, host, addresses, context,
+		    exception);
+# ifdef OF_HAVE_BLOCKS
+	}
+# endif
+}
+@end
+#endif
+
+@implementation OFResolver
++ (void)initialize
+{
+	if (self != [OFResolver class])
+		return;
+
+#if defined(OF_THREADS) && !defined(HAVE_THREADSAFE_GETADDRINFO)
+	mutex = [[OFMutex alloc] init];
+#endif
+	sharedResolver = [[self alloc] init];
+}
+
++ (OFResolver*)sharedResolver
+{
+	return sharedResolver;
+}
+
++ (instancetype)resolver
+{
+	return [[[self alloc] init] autorelease];
+}
+
+- init
+{
+	self = [super init];
+
+	@try {
+		cache = [[OFMutableDictionary alloc] init];
+		pendingLookups = [[OFMutableDictionary alloc] init];
+		cacheTimeToLive = 60;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[cache release];
+	[pendingLookups release];
+#ifdef OF_THREADS
+	[threadPool release];
+#endif
+
+	[super dealloc];
+}
+
+- (void)setCacheTimeToLive: (double)cacheTimeToLive_
+{
+	@synchronized (self) {
+		cacheTimeToLive = cacheTimeToLive_;
+	}
+}
+
+- (double)cacheTimeToLive
+{
+	return cacheTimeToLive;
+}
+
+- (OFDataArray*)OF_cachedAddressesForKey: (OFString*)key
+{
+	OFResolver_CacheEntry *entry = [cache objectForKey: key];
+
+	if (entry == nil)
+		return nil;
+
+	if (entry->expiration <= of_monotonic_time()) {
+		[cache removeObjectForKey: key];
+		return nil;
+	}
+
+	return [[entry->addresses copy] autorelease];
+}
+
+- (void)OF_performLookup: (OFResolver_Lookup*)lookup
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDataArray *addresses = nil;
+
+	@try {
+		addresses = resolve_host(lookup->host);
+	} @catch (id e) {
+		/* Report it like any other failed lookup */
+	}
+
+	@synchronized (self) {
+		if (addresses != nil && cacheTimeToLive > 0) {
+			uint64_t now = of_monotonic_time();
+			OFResolver_CacheEntry *entry;
+			OFArray *keys = [cache allKeys];
+			id *objects = [keys objects];
+			size_t i, count = [keys count];
+
+			/* Drop expired entries so the cache doesn't grow */
+			for (i = 0; i < count; i++) {
+				entry = [cache objectForKey: objects[i]];
+
+				if (entry->expiration <= now)
+					[cache removeObjectForKey: objects[i]];
+			}
+
+			entry = [[[OFResolver_CacheEntry alloc] init]
+			    autorelease];
+			entry->addresses = [addresses copy];
+			entry->expiration = of_deadline_after(now,
+			    cacheTimeToLive);
+
+			[cache setObject: entry
+				  forKey: lookup->key];
+		}
+
+		[pendingLookups removeObjectForKey: lookup->key];
+	}
+
+	[lookup didFinishWithAddresses: addresses];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (OFDataArray*)addressesForHost: (OFString*)host
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *key = [host lowercaseString];
+	OFResolver_Lookup *lookup = nil;
+	OFDataArray *addresses;
+	BOOL perform = NO;
+
+	@synchronized (self) {
+		if ((addresses = [self OF_cachedAddressesForKey: key]) == nil) {
+			lookup = [pendingLookups objectForKey: key];
+
+			if (lookup == nil) {
+				lookup = [[[OFResolver_Lookup alloc]
+				    initWithHost: host
+					     key: key] autorelease];
+				[pendingLookups setObject: lookup
+						   forKey: key];
+			}
+
+			/*
+			 * If the lookup is still waiting for a thread of the
+			 * pool, perform it right away instead of waiting.
+			 */
+			if (!lookup->started)
+				lookup->started = perform = YES;
+		}
+	}
+
+	if (lookup != nil) {
+		if (perform)
+			[self OF_performLookup: lookup];
+#ifdef OF_THREADS
+		else
+			[lookup waitUntilDone];
+#endif
+
+		addresses = [[lookup->addresses copy] autorelease];
+	}
+
+	[addresses retain];
+	objc_autoreleasePoolPop(pool);
+
+	if (addresses == nil)
+		@throw [OFAddressTranslationFailedException
+		    exceptionWithClass: [self class]
+				socket: nil
+				  host: host];
+
+	return [addresses autorelease];
+}
+
+#ifdef OF_THREADS
+- (void)OF_performQueuedLookup: (OFResolver_Lookup*)lookup
+{
+	BOOL perform = NO;
+
+	@synchronized (self) {
+		/* It might have been performed by -[addressesForHost:] */
+		if (!lookup->started)
+			lookup->started = perform = YES;
+	}
+
+	if (perform)
+		[self OF_performLookup: lookup];
+}
+
+- (void)OF_addAsyncRequest: (OFResolver_AsyncRequest*)request
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *key = [request->host lowercaseString];
+	OFResolver_Lookup *lookup = nil;
+	OFDataArray *addresses;
+	BOOL dispatch = NO;
+
+	@synchronized (self) {
+		if ((addresses = [self OF_cachedAddressesForKey: key]) == nil) {
+			lookup = [pendingLookups objectForKey: key];
+
+			if (lookup == nil) {
+				lookup = [[[OFResolver_Lookup alloc]
+				    initWithHost: request->host
+					     key: key] autorelease];
+				[pendingLookups setObject: lookup
+						   forKey: key];
+				dispatch = YES;
+			}
+
+			[lookup->requests addObject: request];
+		}
+	}
+
+	if (lookup == nil)
+		/* Still call the target from the run loop, never directly */
+		[request performSelector: @selector(didResolveWithAddresses:)
+				onThread: request->sourceThread
+			      withObject: addresses
+			   waitUntilDone: NO];
+	else if (dispatch)
+		[[self OF_threadPool]
+		    dispatchWithTarget: self
+			      selector: @selector(OF_performQueuedLookup:)
+				object: lookup];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)asyncResolveHost: (OFString*)host
+		  target: (id)target
+		selector: (SEL)selector
+		 context: (id)context
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFResolver_AsyncRequest *request =
+	    [[[OFResolver_AsyncRequest alloc] init] autorelease];
+
+	request->resolver = [self retain];
+	request->host = [host copy];
+	request->sourceThread = [[OFThread currentThread] retain];
+	request->target = [target retain];
+	request->selector = selector;
+	request->context = [context retain];
+
+	[self OF_addAsyncRequest: request];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+# ifdef OF_HAVE_BLOCKS
+- (void)asyncResolveHost: (OFString*)host
+		   block: (of_resolver_async_resolve_block_t)block
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFResolver_AsyncRequest *request =
+	    [[[OFResolver_AsyncRequest alloc] init] autorelease];
+
+	request->resolver = [self retain];
+	request->host = [host copy];
+	request->sourceThread = [[OFThread currentThread] retain];
+	request->block = [block copy];
+
+	[self OF_addAsyncRequest: request];
+
+	objc_autoreleasePoolPop(pool);
+}
+# endif
+
+- (OFThreadPool*)OF_threadPool
+{
+	@synchronized (self) {
+		if (threadPool == nil)
+			threadPool = [[OFThreadPool alloc]
+			    initWithSize: THREAD_POOL_SIZE];
+	}
+
+	return threadPool;
+}
+#endif
+
+- (void)removeAllCachedAddresses
+{
+	OFMutableDictionary *newCache = [[OFMutableDictionary alloc] init];
+
+	@synchronized (self) {
+		[cache release];
+		cache = newCache;
+	}
+}
+@end
@@ -30,7 +30,7 @@
 {
 	OFSortedList *timersQueue;
 	OFStreamObserver *streamObserver;
-	OFMutableDictionary *readQueues;
+	OFMutableDictionary *readQueues, *connectQueueItems;
 }
 
 /*!
@@ -69,6 +69,15 @@
 			       target: (id)target
 			     selector: (SEL)selector
 			      context: (id)context;
++ (void)OF_addAsyncAcceptBatchForTCPSocket: (OFTCPSocket*)socket
+				    target: (id)target
+				  selector: (SEL)selector
+				   context: (id)context;
++ (void)OF_addAsyncConnectForTCPSocket: (OFTCPSocket*)socket
+				target: (id)target
+			      selector: (SEL)selector
+			       context: (id)context;
++ (void)OF_removeAsyncConnectForTCPSocket: (OFTCPSocket*)socket;
 #ifdef OF_HAVE_BLOCKS
 + (void)OF_addAsyncReadForStream: (OFStream*)stream
 			  buffer: (void*)buffer
@@ -83,6 +92,8 @@
 			       block: (of_stream_async_read_line_block_t)block;
 + (void)OF_addAsyncAcceptForTCPSocket: (OFTCPSocket*)socket
 				block: (of_tcpsocket_async_accept_block_t)block;
++ (void)OF_addAsyncAcceptBatchForTCPSocket: (OFTCPSocket*)socket
+    block: (of_tcpsocket_async_accept_batch_block_t)block;
 #endif
 
 /*!
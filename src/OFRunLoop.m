@@ -18,13 +18,15 @@
 
 #import "OFRunLoop.h"
 #import "OFDictionary.h"
+#import "OFArray.h"
 #import "OFThread.h"
 #import "OFSortedList.h"
 #import "OFTimer.h"
-#import "OFDate.h"
+#import "OFTCPSocket+Private.h"
 
 #import "autorelease.h"
 #import "macros.h"
+#import "of_clock.h"
 
 static OFRunLoop *mainRunLoop = nil;
 
@@ -78,6 +80,18 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+@interface OFRunLoop_AcceptBatchQueueItem: OFRunLoop_QueueItem
+{
+@public
+#ifdef OF_HAVE_BLOCKS
+	of_tcpsocket_async_accept_batch_block_t block;
+#endif
+}
+@end
+
+@interface OFRunLoop_ConnectQueueItem: OFRunLoop_QueueItem
+@end
+
 @implementation OFRunLoop_QueueItem
 - (void)dealloc
 {
@@ -132,6 +146,20 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+@implementation OFRunLoop_AcceptBatchQueueItem
+- (void)dealloc
+{
+#ifdef OF_HAVE_BLOCKS
+	[block release];
+#endif
+
+	[super dealloc];
+}
+@end
+
+@implementation OFRunLoop_ConnectQueueItem
+@end
+
 @implementation OFRunLoop
 + (OFRunLoop*)mainRunLoop
 {
@@ -229,6 +257,53 @@ static OFRunLoop *mainRunLoop = nil;
 	})
 }
 
++ (void)OF_addAsyncAcceptBatchForTCPSocket: (OFTCPSocket*)stream
+				    target: (id)target
+				  selector: (SEL)selector
+				   context: (id)context
+{
+	ADD(OFRunLoop_AcceptBatchQueueItem, {
+		queueItem->target = [target retain];
+		queueItem->selector = selector;
+		queueItem->context = [context retain];
+	})
+}
+
++ (void)OF_addAsyncConnectForTCPSocket: (OFTCPSocket*)socket
+				target: (id)target
+			      selector: (SEL)selector
+			       context: (id)context
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFRunLoop *runLoop = [self currentRunLoop];
+	OFRunLoop_ConnectQueueItem *queueItem;
+
+	/* A socket can only be connected once, so there is no queue */
+	OF_ENSURE([runLoop->connectQueueItems objectForKey: socket] == nil);
+
+	queueItem = [[[OFRunLoop_ConnectQueueItem alloc] init] autorelease];
+	queueItem->target = [target retain];
+	queueItem->selector = selector;
+	queueItem->context = [context retain];
+
+	[runLoop->connectQueueItems setObject: queueItem
+				       forKey: socket];
+	[runLoop->streamObserver addStreamForWriting: socket];
+
+	objc_autoreleasePoolPop(pool);
+}
+
++ (void)OF_removeAsyncConnectForTCPSocket: (OFTCPSocket*)socket
+{
+	OFRunLoop *runLoop = [self currentRunLoop];
+
+	if ([runLoop->connectQueueItems objectForKey: socket] == nil)
+		return;
+
+	[runLoop->streamObserver removeStreamForWriting: socket];
+	[runLoop->connectQueueItems removeObjectForKey: socket];
+}
+
 #ifdef OF_HAVE_BLOCKS
 + (void)OF_addAsyncReadForStream: (OFStream*)stream
 			  buffer: (void*)buffer
@@ -271,6 +346,14 @@ static OFRunLoop *mainRunLoop = nil;
 		queueItem->block = [block copy];
 	})
 }
+
++ (void)OF_addAsyncAcceptBatchForTCPSocket: (OFTCPSocket*)stream
+    block: (of_tcpsocket_async_accept_batch_block_t)block
+{
+	ADD(OFRunLoop_AcceptBatchQueueItem, {
+		queueItem->block = [block copy];
+	})
+}
 #endif
 
 #undef ADD
@@ -286,6 +369,7 @@ static OFRunLoop *mainRunLoop = nil;
 		[streamObserver setDelegate: self];
 
 		readQueues = [[OFMutableDictionary alloc] init];
+		connectQueueItems = [[OFMutableDictionary alloc] init];
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -299,6 +383,7 @@ static OFRunLoop *mainRunLoop = nil;
 	[timersQueue release];
 	[streamObserver release];
 	[readQueues release];
+	[connectQueueItems release];
 
 	[super dealloc];
 }
@@ -490,70 +575,171 @@ static OFRunLoop *mainRunLoop = nil;
 	} else if ([listObject->object isKindOfClass:
 	    [OFRunLoop_AcceptQueueItem class]]) {
 		OFRunLoop_AcceptQueueItem *queueItem = listObject->object;
-		OFTCPSocket *newSocket;
+		OFTCPSocket *socket = (OFTCPSocket*)stream;
+		size_t i, limit = [socket acceptBatchLimit];
+		BOOL (*func)(id, SEL, OFTCPSocket*, OFTCPSocket*, id,
+		    OFException*) = NULL;
+		BOOL again = YES;
+
+#ifdef OF_HAVE_BLOCKS
+		if (queueItem->block == NULL)
+#endif
+			func = (BOOL(*)(id, SEL, OFTCPSocket*, OFTCPSocket*,
+			    id, OFException*))
+			    [queueItem->target methodForSelector:
+			    queueItem->selector];
+
+		/* The target might close the last reference to the socket */
+		[[socket retain] autorelease];
+
+		/*
+		 * Accept all pending connections up to the limit, so that a
+		 * burst of connections does not need a wakeup per connection.
+		 */
+		/* Only changes the mode if -[setBlocking:] was called since */
+		[socket OF_setAcceptQueueNonBlocking];
+
+		for (i = 0; i < limit && again; i++) {
+			OFTCPSocket *newSocket;
+			OFException *exception = nil;
+
+			@try {
+				newSocket = [socket OF_acceptIfPending];
+			} @catch (OFException *e) {
+				newSocket = nil;
+				exception = e;
+			}
+
+			if (newSocket == nil && exception == nil)
+				break;
+
+#ifdef OF_HAVE_BLOCKS
+			if (queueItem->block != NULL)
+				again = queueItem->block(socket, newSocket,
+				    exception);
+			else
+#endif
+				again = func(queueItem->target,
+				    queueItem->selector, socket, newSocket,
+				    queueItem->context, exception);
+
+			if (exception != nil)
+				break;
+		}
+
+		if (!again) {
+			[queue removeListObject: listObject];
+
+			if ([queue count] == 0) {
+				[streamObserver removeStreamForReading: stream];
+				[readQueues removeObjectForKey: stream];
+			}
+		}
+	} else if ([listObject->object isKindOfClass:
+	    [OFRunLoop_AcceptBatchQueueItem class]]) {
+		OFRunLoop_AcceptBatchQueueItem *queueItem = listObject->object;
+		OFTCPSocket *socket = (OFTCPSocket*)stream;
+		size_t limit = [socket acceptBatchLimit];
+		OFMutableArray *newSockets = [OFMutableArray array];
 		OFException *exception = nil;
+		BOOL again;
+
+		[[socket retain] autorelease];
 
 		@try {
-			newSocket = [(OFTCPSocket*)stream accept];
+			[socket OF_setAcceptQueueNonBlocking];
+
+			while ([newSockets count] < limit) {
+				OFTCPSocket *newSocket =
+				    [socket OF_acceptIfPending];
+
+				if (newSocket == nil)
+					break;
+
+				[newSockets addObject: newSocket];
+			}
 		} @catch (OFException *e) {
-			newSocket = nil;
 			exception = e;
 		}
 
-#ifdef OF_HAVE_BLOCKS
-		if (queueItem->block != NULL) {
-			if (!queueItem->block((OFTCPSocket*)stream,
-			    newSocket, exception)) {
-				[queue removeListObject: listObject];
+		/* Another process might have accepted the connection already */
+		if ([newSockets count] == 0 && exception == nil)
+			return;
 
-				if ([queue count] == 0) {
-					[streamObserver
-					    removeStreamForReading: stream];
-					[readQueues removeObjectForKey: stream];
-				}
-			}
-		} else {
+		[newSockets makeImmutable];
+
+#ifdef OF_HAVE_BLOCKS
+		if (queueItem->block != NULL)
+			again = queueItem->block(socket, newSockets, exception);
+		else {
 #endif
-			BOOL (*func)(id, SEL, OFTCPSocket*, OFTCPSocket*,
-			    id, OFException*) =
-			    (BOOL(*)(id, SEL, OFTCPSocket*, OFTCPSocket*,
-			    id, OFException*))
+			BOOL (*func)(id, SEL, OFTCPSocket*, OFArray*, id,
+			    OFException*) = (BOOL(*)(id, SEL, OFTCPSocket*,
+			    OFArray*, id, OFException*))
 			    [queueItem->target methodForSelector:
 			    queueItem->selector];
 
-			if (!func(queueItem->target, queueItem->selector,
-			    (OFTCPSocket*)stream, newSocket, queueItem->context,
-			    exception)) {
-				[queue removeListObject: listObject];
-
-				if ([queue count] == 0) {
-					[streamObserver
-					    removeStreamForReading: stream];
-					[readQueues removeObjectForKey: stream];
-				}
-			}
+			again = func(queueItem->target, queueItem->selector,
+			    socket, newSockets, queueItem->context, exception);
 #ifdef OF_HAVE_BLOCKS
 		}
 #endif
+
+		if (!again) {
+			[queue removeListObject: listObject];
+
+			if ([queue count] == 0) {
+				[streamObserver removeStreamForReading: stream];
+				[readQueues removeObjectForKey: stream];
+			}
+		}
 	} else
 		OF_ENSURE(0);
 }
 
+- (void)streamIsReadyForWriting: (OFStream*)stream
+{
+	OFRunLoop_ConnectQueueItem *queueItem =
+	    [connectQueueItems objectForKey: stream];
+	void (*func)(id, SEL, OFTCPSocket*, id);
+
+	/* Only connects wait for a stream to become writable */
+	if (queueItem == nil)
+		return;
+
+	[[queueItem retain] autorelease];
+	[streamObserver removeStreamForWriting: stream];
+	[connectQueueItems removeObjectForKey: stream];
+
+	func = (void(*)(id, SEL, OFTCPSocket*, id))
+	    [queueItem->target methodForSelector: queueItem->selector];
+	func(queueItem->target, queueItem->selector, (OFTCPSocket*)stream,
+	    queueItem->context);
+}
+
+- (void)streamDidReceiveException: (OFStream*)stream
+{
+	/*
+	 * Some systems only report a failed connect as an exception. The
+	 * target then finds out about the failure itself.
+	 */
+	[self streamIsReadyForWriting: stream];
+}
+
 - (void)run
 {
 	for (;;) {
 		void *pool = objc_autoreleasePoolPush();
-		OFDate *now = [OFDate date];
+		uint64_t now = of_monotonic_time();
+		uint64_t nextDeadline = OF_DEADLINE_NEVER;
 		OFTimer *timer;
-		OFDate *nextTimer;
 
 		@synchronized (timersQueue) {
 			of_list_object_t *listObject =
 			    [timersQueue firstListObject];
 
 			if (listObject != NULL &&
-			    [[listObject->object fireDate] compare: now] !=
-			    OF_ORDERED_DESCENDING) {
+			    [listObject->object fireDeadline] <= now) {
 				timer =
 				    [[listObject->object retain] autorelease];
 
@@ -566,12 +752,18 @@ static OFRunLoop *mainRunLoop = nil;
 			[timer fire];
 
 		@synchronized (timersQueue) {
-			nextTimer = [[timersQueue firstObject] fireDate];
+			of_list_object_t *listObject =
+			    [timersQueue firstListObject];
+
+			if (listObject != NULL)
+				nextDeadline =
+				    [listObject->object fireDeadline];
 		}
 
 		/* Watch for stream events until the next timer is due */
-		if (nextTimer != nil) {
-			double timeout = [nextTimer timeIntervalSinceNow];
+		if (nextDeadline != OF_DEADLINE_NEVER) {
+			double timeout = of_deadline_remaining(nextDeadline,
+			    of_monotonic_time());
 
 			if (timeout > 0)
 				[streamObserver observeWithTimeout: timeout];
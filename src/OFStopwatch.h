@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+/*!
+ * @brief A class for measuring elapsed time with a monotonic clock.
+ *
+ * A stopwatch can be started and stopped several times, in which case the
+ * elapsed time accumulates until it is reset. Starting and stopping only reads
+ * the clock and does not allocate memory, so a stopwatch can be used to
+ * measure hot paths.
+ */
+@interface OFStopwatch: OFObject
+{
+	uint64_t startTime, elapsed;
+	BOOL running;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property (readonly, getter=isRunning) BOOL running;
+#endif
+
+/*!
+ * @brief Creates a new stopwatch which has not been started yet.
+ *
+ * @return A new, autoreleased OFStopwatch
+ */
++ (instancetype)stopwatch;
+
+/*!
+ * @brief Creates a new stopwatch which is already running.
+ *
+ * @return A new, autoreleased, running OFStopwatch
+ */
++ (instancetype)startedStopwatch;
+
+/*!
+ * @brief Starts the stopwatch or resumes it if it had been stopped.
+ *
+ * Starting a running stopwatch does nothing.
+ */
+- (void)start;
+
+/*!
+ * @brief Stops the stopwatch, adding the time since it was started to the
+ *	  elapsed time.
+ *
+ * Stopping a stopwatch which is not running does nothing.
+ */
+- (void)stop;
+
+/*!
+ * @brief Resets the elapsed time to zero.
+ *
+ * If the stopwatch is running, it keeps running from now on.
+ */
+- (void)reset;
+
+/*!
+ * @brief Returns whether the stopwatch is running.
+ *
+ * @return Whether the stopwatch is running
+ */
+- (BOOL)isRunning;
+
+/*!
+ * @brief Returns the elapsed time in nanoseconds.
+ *
+ * If the stopwatch is running, this includes the time since it was started.
+ *
+ * @return The elapsed time in nanoseconds
+ */
+- (uint64_t)elapsedNanoseconds;
+
+/*!
+ * @brief Returns the elapsed time in seconds.
+ *
+ * If the stopwatch is running, this includes the time since it was started.
+ *
+ * @return The elapsed time in seconds
+ */
+- (double)elapsedTime;
+@end
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFStopwatch.h"
+
+#import "of_clock.h"
+
+@implementation OFStopwatch
++ (instancetype)stopwatch
+{
+	return [[[self alloc] init] autorelease];
+}
+
++ (instancetype)startedStopwatch
+{
+	OFStopwatch *stopwatch = [[[self alloc] init] autorelease];
+
+	[stopwatch start];
+
+	return stopwatch;
+}
+
+- (void)start
+{
+	if (running)
+		return;
+
+	startTime = of_monotonic_time();
+	running = YES;
+}
+
+- (void)stop
+{
+	if (!running)
+		return;
+
+	elapsed += of_monotonic_time() - startTime;
+	running = NO;
+}
+
+- (void)reset
+{
+	elapsed = 0;
+
+	if (running)
+		startTime = of_monotonic_time();
+}
+
+- (BOOL)isRunning
+{
+	return running;
+}
+
+- (uint64_t)elapsedNanoseconds
+{
+	if (running)
+		return elapsed + (of_monotonic_time() - startTime);
+
+	return elapsed;
+}
+
+- (double)elapsedTime
+{
+	return (double)[self elapsedNanoseconds] / 1000000000;
+}
+@end
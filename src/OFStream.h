@@ -54,6 +54,9 @@ typedef BOOL (^of_stream_async_read_line_block_t)(OFStream*, OFString*,
  *	 methods and does all the caching and other stuff for you. If you
  *	 override these methods without the lowlevel prefix, you <i>will</i>
  *	 break caching and get broken results!
+ *	 If reading can fail, you should also override
+ *	 @ref lowlevelReadIntoBuffer:length:error:, as otherwise
+ *	 @ref readIntoBuffer:length:error: needs to catch an exception.
  */
 @interface OFStream: OFObject <OFCopying>
 {
@@ -94,6 +97,25 @@ typedef BOOL (^of_stream_async_read_line_block_t)(OFStream*, OFString*,
 - (size_t)readIntoBuffer: (void*)buffer
 		  length: (size_t)length;
 
+/*!
+ * @brief Reads <i>at most</i> size bytes from the stream into a buffer without
+ *	  throwing an exception if reading fails.
+ *
+ * This is useful if failing reads are expected, as no exception needs to be
+ * created and thrown. Otherwise, it behaves like
+ * @ref readIntoBuffer:length:.
+ *
+ * @param buffer The buffer into which the data is read
+ * @param length The length of the data that should be read at most.
+ *		 The buffer <i>must</i> be at least this big!
+ * @param errNo A pointer to an int in which the error number is stored if
+ *		reading failed. If reading did not fail, 0 is stored.
+ * @return The number of bytes read
+ */
+- (size_t)readIntoBuffer: (void*)buffer
+		  length: (size_t)length
+		   error: (int*)errNo;
+
 /*!
  * @brief Reads exactly the specified length bytes from the stream into a
  *	  buffer.
@@ -1026,6 +1048,26 @@ typedef BOOL (^of_stream_async_read_line_block_t)(OFStream*, OFString*,
 - (size_t)lowlevelReadIntoBuffer: (void*)buffer
 			  length: (size_t)length;
 
+/*!
+ * @brief Performs a lowlevel read without throwing an exception if reading
+ *	  fails.
+ *
+ * @warning Do not call this directly!
+ *
+ * The default implementation calls @ref lowlevelReadIntoBuffer:length: and
+ * catches the OFReadFailedException. Override this method if reading can fail
+ * without an exception being thrown.
+ *
+ * @param buffer The buffer for the data to read
+ * @param length The length of the buffer
+ * @param errNo A pointer to an int in which the error number is stored if
+ *		reading failed. If reading did not fail, 0 is stored.
+ * @return The number of bytes read
+ */
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)length
+			   error: (int*)errNo;
+
 /*!
  * @brief Performs a lowlevel write.
  *
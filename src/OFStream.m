@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include <assert.h>
+#include <errno.h>
 
 #include <fcntl.h>
 
@@ -39,6 +40,7 @@
 #import "OFInvalidArgumentException.h"
 #import "OFInvalidFormatException.h"
 #import "OFNotImplementedException.h"
+#import "OFReadFailedException.h"
 #import "OFSetOptionFailedException.h"
 
 #import "macros.h"
@@ -84,6 +86,25 @@
 						    selector: _cmd];
 }
 
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)length
+			   error: (int*)errNo
+{
+	size_t ret;
+
+	@try {
+		ret = [self lowlevelReadIntoBuffer: buffer
+					    length: length];
+	} @catch (OFReadFailedException *e) {
+		*errNo = ([e errNo] != 0 ? [e errNo] : EIO);
+		return 0;
+	}
+
+	*errNo = 0;
+
+	return ret;
+}
+
 - (void)lowlevelWriteBuffer: (const void*)buffer
 		     length: (size_t)length
 {
@@ -134,6 +155,22 @@
 	}
 }
 
+- (size_t)readIntoBuffer: (void*)buffer
+		  length: (size_t)length
+		   error: (int*)errNo
+{
+	if (cache == NULL)
+		return [self lowlevelReadIntoBuffer: buffer
+					     length: length
+					      error: errNo];
+
+	/* Reading from the cache can't fail */
+	*errNo = 0;
+
+	return [self readIntoBuffer: buffer
+			     length: length];
+}
+
 - (void)readIntoBuffer: (void*)buffer
 	   exactLength: (size_t)length
 {
@@ -1476,6 +1513,8 @@
 		@throw [OFSetOptionFailedException
 		    exceptionWithClass: [self class]
 				stream: self];
+
+	blocking = enable;
 #else
 	@throw [OFNotImplementedException exceptionWithClass: [self class]
 						    selector: _cmd];
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFStreamSocket.h"
+
+@interface OFStreamSocket (OF_PrivateMethods)
+/*
+ * Sets an integer socket option. Throws an OFSetOptionFailedException if
+ * setting it fails.
+ */
+- (void)OF_setSocketOption: (int)option
+		     level: (int)level
+		     value: (int)value;
+
+/*
+ * Returns the value of an integer socket option. Throws an
+ * OFGetOptionFailedException if retrieving it fails.
+ */
+- (int)OF_socketOption: (int)option
+		 level: (int)level;
+@end
@@ -38,4 +38,41 @@
  * @return A new, autoreleased OFTCPSocket
  */
 + (instancetype)socket;
+
+/*!
+ * @brief Sets the size of the send buffer of the socket (SO_SNDBUF).
+ *
+ * @param size The size of the send buffer in bytes
+ */
+- (void)setSendBufferSize: (size_t)size;
+
+/*!
+ * @brief Returns the size of the send buffer of the socket.
+ *
+ * Some systems reserve additional space for bookkeeping, so this can return
+ * more than has been set.
+ *
+ * @return The size of the send buffer in bytes
+ */
+- (size_t)sendBufferSize;
+
+/*!
+ * @brief Sets the size of the receive buffer of the socket (SO_RCVBUF).
+ *
+ * To have an effect on the window size of a TCP connection, this needs to be
+ * set before connecting or, for accepted sockets, on the listening socket.
+ *
+ * @param size The size of the receive buffer in bytes
+ */
+- (void)setReceiveBufferSize: (size_t)size;
+
+/*!
+ * @brief Returns the size of the receive buffer of the socket.
+ *
+ * Some systems reserve additional space for bookkeeping, so this can return
+ * more than has been set.
+ *
+ * @return The size of the receive buffer in bytes
+ */
+- (size_t)receiveBufferSize;
 @end
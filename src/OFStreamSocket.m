@@ -19,6 +19,7 @@
 #define __NO_EXT_QNX
 
 #include <string.h>
+#include <limits.h>
 
 #include <unistd.h>
 
@@ -30,9 +31,12 @@
 #endif
 
 #import "OFStreamSocket.h"
+#import "OFStreamSocket+Private.h"
 
+#import "OFGetOptionFailedException.h"
 #import "OFInitializationFailedException.h"
 #import "OFNotConnectedException.h"
+#import "OFOutOfRangeException.h"
 #import "OFReadFailedException.h"
 #import "OFSetOptionFailedException.h"
 #import "OFWriteFailedException.h"
@@ -70,39 +74,94 @@
 	return atEndOfStream;
 }
 
+- (size_t)OF_receiveIntoBuffer: (void*)buffer
+			length: (size_t)length
+			 error: (int*)errNo
+{
+	ssize_t ret;
+
+	if (atEndOfStream) {
+#ifndef _WIN32
+		*errNo = ENOTCONN;
+#else
+		*errNo = WSAENOTCONN;
+#endif
+		return 0;
+	}
+
+	if ((ret = recv(sock, buffer, length, 0)) < 0) {
+#ifndef _WIN32
+		*errNo = errno;
+#else
+		*errNo = WSAGetLastError();
+#endif
+		return 0;
+	}
+
+	if (ret == 0)
+		atEndOfStream = YES;
+
+	*errNo = 0;
+
+	return ret;
+}
+
 - (size_t)lowlevelReadIntoBuffer: (void*)buffer
 			  length: (size_t)length
 {
-	ssize_t ret;
+	size_t ret;
+	int errNo;
 
 	if (sock == INVALID_SOCKET)
 		@throw [OFNotConnectedException exceptionWithClass: [self class]
 							    socket: self];
 
-	if (atEndOfStream) {
+	ret = [self OF_receiveIntoBuffer: buffer
+				  length: length
+				   error: &errNo];
+
+	if (errNo != 0) {
 		OFReadFailedException *e;
 
 		e = [OFReadFailedException exceptionWithClass: [self class]
 						       stream: self
 					      requestedLength: length];
-#ifndef _WIN32
-		e->errNo = ENOTCONN;
-#else
-		e->errNo = WSAENOTCONN;
-#endif
+		e->errNo = errNo;
 
 		@throw e;
 	}
 
-	if ((ret = recv(sock, buffer, length, 0)) < 0)
-		@throw [OFReadFailedException exceptionWithClass: [self class]
-							  stream: self
-						 requestedLength: length];
+	return ret;
+}
 
-	if (ret == 0)
-		atEndOfStream = YES;
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)length
+			   error: (int*)errNo
+{
+	/*
+	 * Subclasses like TLS sockets might only override
+	 * lowlevelReadIntoBuffer:length:, so receiving directly would bypass
+	 * them.
+	 */
+	if ([self methodForSelector: @selector(lowlevelReadIntoBuffer:length:)]
+	    != [OFStreamSocket instanceMethodForSelector:
+	    @selector(lowlevelReadIntoBuffer:length:)])
+		return [super lowlevelReadIntoBuffer: buffer
+					      length: length
+					       error: errNo];
+
+	if (sock == INVALID_SOCKET) {
+#ifndef _WIN32
+		*errNo = ENOTCONN;
+#else
+		*errNo = WSAENOTCONN;
+#endif
+		return 0;
+	}
 
-	return ret;
+	return [self OF_receiveIntoBuffer: buffer
+				   length: length
+				    error: errNo];
 }
 
 - (void)lowlevelWriteBuffer: (const void*)buffer
@@ -133,10 +192,74 @@
 						  requestedLength: length];
 }
 
+- (void)OF_setSocketOption: (int)option
+		     level: (int)level
+		     value: (int)value
+{
+	if (sock == INVALID_SOCKET)
+		@throw [OFNotConnectedException exceptionWithClass: [self class]
+							    socket: self];
+
+	if (setsockopt(sock, level, option, (char*)&value, sizeof(value)))
+		@throw [OFSetOptionFailedException
+		    exceptionWithClass: [self class]
+				stream: self];
+}
+
+- (int)OF_socketOption: (int)option
+		 level: (int)level
+{
+	int value = 0;
+	socklen_t length = sizeof(value);
+
+	if (sock == INVALID_SOCKET)
+		@throw [OFNotConnectedException exceptionWithClass: [self class]
+							    socket: self];
+
+	if (getsockopt(sock, level, option, (char*)&value, &length))
+		@throw [OFGetOptionFailedException
+		    exceptionWithClass: [self class]
+				stream: self];
+
+	return value;
+}
+
+- (void)setSendBufferSize: (size_t)size
+{
+	if (size > INT_MAX)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	[self OF_setSocketOption: SO_SNDBUF
+			   level: SOL_SOCKET
+			   value: (int)size];
+}
+
+- (size_t)sendBufferSize
+{
+	return [self OF_socketOption: SO_SNDBUF
+			       level: SOL_SOCKET];
+}
+
+- (void)setReceiveBufferSize: (size_t)size
+{
+	if (size > INT_MAX)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	[self OF_setSocketOption: SO_RCVBUF
+			   level: SOL_SOCKET
+			   value: (int)size];
+}
+
+- (size_t)receiveBufferSize
+{
+	return [self OF_socketOption: SO_RCVBUF
+			       level: SOL_SOCKET];
+}
+
 #ifdef _WIN32
 - (void)setBlocking: (BOOL)enable
 {
-	u_long v = enable;
+	u_long v = !enable;
 	blocking = enable;
 
 	if (ioctlsocket(sock, FIONBIO, &v) == SOCKET_ERROR)
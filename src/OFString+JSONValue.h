@@ -16,6 +16,8 @@
 
 #import "OFString.h"
 
+@class OFInvalidJSONException;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,4 +45,18 @@ extern int _OFString_JSONValue_reference;
  * @return An object
  */
 - (id)JSONValue;
+
+/*!
+ * @brief Creates an object from the JSON value of the string without throwing
+ *	  an exception if the string is not valid JSON.
+ *
+ * This is useful if invalid JSON is expected as part of normal operation, as
+ * it avoids the cost of throwing and catching an exception.
+ *
+ * @param error A pointer to an OFInvalidJSONException* which is set to an
+ *		autoreleased, not thrown exception describing the error or to
+ *		nil on success. May be NULL.
+ * @return An object or nil if the string is not valid JSON
+ */
+- (id)JSONValueWithError: (OFInvalidJSONException**)error;
 @end
@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #include <assert.h>
 
@@ -31,6 +32,14 @@
 
 #import "macros.h"
 
+/*
+ * It seems strtod is buggy on Win32.
+ * However, the MinGW version __strtod seems to be ok.
+ */
+#ifdef _WIN32
+# define strtod __strtod
+#endif
+
 int _OFString_JSONValue_reference;
 
 static id nextObject(const char *restrict *, const char*,
@@ -264,13 +273,12 @@ parseString(const char *restrict *pointer, const char *stop,
 		/* End of string found */
 		} else if (**pointer == delimiter) {
 			OFString *ret;
+			int errNo;
 
-			@try {
-				ret = [OFString stringWithUTF8String: buffer
-							      length: i];
-			} @finally {
-				free(buffer);
-			}
+			ret = [OFString stringWithUTF8String: buffer
+						      length: i
+						       error: &errNo];
+			free(buffer);
 
 			(*pointer)++;
 
@@ -366,18 +374,17 @@ parseIdentifier(const char *restrict *pointer, const char *stop)
 			*pointer += 11;
 		} else {
 			OFString *ret;
+			int errNo;
 
 			if (i == 0 || (buffer[0] >= '0' && buffer[0] <= '9')) {
 				free(buffer);
 				return nil;
 			}
 
-			@try {
-				ret = [OFString stringWithUTF8String: buffer
-							      length: i];
-			} @finally {
-				free(buffer);
-			}
+			ret = [OFString stringWithUTF8String: buffer
+						      length: i
+						       error: &errNo];
+			free(buffer);
 
 			return ret;
 		}
@@ -523,9 +530,8 @@ parseNumber(const char *restrict *pointer, const char *stop,
 {
 	BOOL isHex = (*pointer + 1 < stop && (*pointer)[1] == 'x');
 	BOOL hasDecimal = NO;
+	const char *p, *end;
 	size_t i;
-	OFString *string;
-	OFNumber *number;
 
 	for (i = 0; *pointer + i < stop; i++) {
 		if ((*pointer)[i] == '.')
@@ -542,25 +548,85 @@ parseNumber(const char *restrict *pointer, const char *stop,
 		}
 	}
 
-	string = [[OFString alloc] initWithUTF8String: *pointer
-					       length: i];
-	*pointer += i;
-
-	@try {
-		if (hasDecimal)
-			number = [OFNumber numberWithDouble:
-			    [string doubleValue]];
-		else if (isHex)
-			number = [OFNumber numberWithIntMax:
-			    [string hexadecimalValue]];
-		else
-			number = [OFNumber numberWithIntMax:
-			    [string decimalValue]];
-	} @finally {
-		[string release];
+	end = *pointer + i;
+
+	/*
+	 * The number is parsed in place instead of creating a string first, so
+	 * that an invalid number does not cause an exception to be thrown.
+	 */
+	if (hasDecimal) {
+		char *endPointer;
+		double value;
+
+		/*
+		 * The input is always terminated by a zero byte, so strtod()
+		 * can never read past it. However, it might stop before or
+		 * after the end of the token, which means it is invalid.
+		 */
+		value = strtod(*pointer, &endPointer);
+		if (endPointer != end)
+			return nil;
+
+		*pointer = end;
+
+		return [OFNumber numberWithDouble: value];
 	}
 
-	return number;
+	if (isHex) {
+		uintmax_t value = 0;
+
+		if ((p = *pointer + 2) == end)
+			return nil;
+
+		for (; p < end; p++) {
+			uintmax_t digit;
+
+			if (*p >= '0' && *p <= '9')
+				digit = *p - '0';
+			else if (*p >= 'a' && *p <= 'f')
+				digit = *p - 'a' + 10;
+			else if (*p >= 'A' && *p <= 'F')
+				digit = *p - 'A' + 10;
+			else
+				return nil;
+
+			if (value > (UINTMAX_MAX >> 4))
+				return nil;
+
+			value = (value << 4) | digit;
+		}
+
+		*pointer = end;
+
+		return [OFNumber numberWithIntMax: (intmax_t)value];
+	} else {
+		intmax_t value = 0;
+		BOOL negative = NO;
+
+		p = *pointer;
+
+		if (*p == '-') {
+			negative = YES;
+			p++;
+		}
+
+		if (p == end)
+			return nil;
+
+		for (; p < end; p++) {
+			if (*p < '0' || *p > '9')
+				return nil;
+
+			if (value > (INTMAX_MAX - (*p - '0')) / 10)
+				return nil;
+
+			value = (value * 10) + (*p - '0');
+		}
+
+		*pointer = end;
+
+		return [OFNumber numberWithIntMax: (negative ? -value : value)];
+	}
 }
 
 static id
@@ -630,6 +696,17 @@ nextObject(const char *restrict *pointer, const char *stop,
 
 @implementation OFString (JSONValue)
 - (id)JSONValue
+{
+	OFInvalidJSONException *error;
+	id object;
+
+	if ((object = [self JSONValueWithError: &error]) == nil)
+		@throw error;
+
+	return object;
+}
+
+- (id)JSONValueWithError: (OFInvalidJSONException**)error
 {
 	const char *pointer = [self UTF8String];
 	const char *stop = pointer + [self UTF8StringLength];
@@ -639,9 +716,17 @@ nextObject(const char *restrict *pointer, const char *stop,
 	object = nextObject(&pointer, stop, &line);
 	skipWhitespacesAndComments(&pointer, stop, &line);
 
-	if (pointer < stop || object == nil)
-		@throw [OFInvalidJSONException exceptionWithClass: [self class]
-							     line: line];
+	if (pointer < stop || object == nil) {
+		if (error != NULL)
+			*error = [OFInvalidJSONException
+			    exceptionWithClass: [self class]
+					  line: line];
+
+		return nil;
+	}
+
+	if (error != NULL)
+		*error = nil;
 
 	return object;
 }
@@ -20,26 +20,99 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
 #import "OFString.h"
 
 #import "OFOutOfMemoryException.h"
 
+#import "macros.h"
+
 int _OFString_XMLEscaping_reference;
 
+static OF_INLINE size_t
+escaped_length(char c)
+{
+	switch (c) {
+	case '<':
+	case '>':
+		return 4;
+	case '"':
+	case '\'':
+		return 6;
+	case '&':
+	case '\r':
+		return 5;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Returns the index of the first character that needs to be escaped or length
+ * if there is none. As most strings don't need any escaping at all, this is
+ * worth doing 16 bytes at a time where SSE2 is available.
+ */
+static size_t
+find_first_to_escape(const char *string, size_t length)
+{
+	size_t i = 0;
+
+#ifdef __SSE2__
+	const __m128i lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>');
+	const __m128i quot = _mm_set1_epi8('"'), apos = _mm_set1_epi8('\'');
+	const __m128i amp = _mm_set1_epi8('&'), cr = _mm_set1_epi8('\r');
+
+	for (; i + 16 <= length; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*)(string + i));
+		__m128i match;
+		int mask;
+
+		match = _mm_or_si128(
+		    _mm_or_si128(_mm_cmpeq_epi8(chunk, lt),
+		    _mm_cmpeq_epi8(chunk, gt)),
+		    _mm_or_si128(_mm_cmpeq_epi8(chunk, quot),
+		    _mm_cmpeq_epi8(chunk, apos)));
+		match = _mm_or_si128(match,
+		    _mm_or_si128(_mm_cmpeq_epi8(chunk, amp),
+		    _mm_cmpeq_epi8(chunk, cr)));
+
+		if OF_UNLIKELY ((mask = _mm_movemask_epi8(match)) != 0)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+
+	for (; i < length; i++)
+		if (escaped_length(string[i]) > 0)
+			return i;
+
+	return length;
+}
+
 @implementation OFString (XMLEscaping)
 - (OFString*)stringByXMLEscaping
 {
 	char *retCString;
-	const char *string, *append;
-	size_t length, retLength, appendLen;
+	const char *string;
+	size_t length, retLength, first;
 	size_t i, j;
 	OFString *ret;
 
 	string = [self UTF8String];
 	length = [self UTF8StringLength];
 
-	j = 0;
+	if ((first = find_first_to_escape(string, length)) == length)
+		return [[self copy] autorelease];
+
 	retLength = length;
+	for (i = first; i < length; i++) {
+		size_t appendLen = escaped_length(string[i]);
+
+		if (appendLen > 0)
+			retLength += appendLen - 1;
+	}
 
 	/*
 	 * We can't use allocMemoryWithSize: here as it might be a @"" literal
@@ -48,7 +121,13 @@ int _OFString_XMLEscaping_reference;
 		@throw [OFOutOfMemoryException exceptionWithClass: [self class]
 						    requestedSize: retLength];
 
-	for (i = 0; i < length; i++) {
+	memcpy(retCString, string, first);
+	j = first;
+
+	for (i = first; i < length; i++) {
+		const char *append;
+		size_t appendLen;
+
 		switch (string[i]) {
 			case '<':
 				append = "&lt;";
@@ -80,18 +159,6 @@ int _OFString_XMLEscaping_reference;
 		}
 
 		if (append != NULL) {
-			char *newRetCString;
-
-			if ((newRetCString = realloc(retCString,
-			    retLength + appendLen)) == NULL) {
-				free(retCString);
-				@throw [OFOutOfMemoryException
-				     exceptionWithClass: [self class]
-					  requestedSize: retLength + appendLen];
-			}
-			retCString = newRetCString;
-			retLength += appendLen - 1;
-
 			memcpy(retCString + j, append, appendLen);
 			j += appendLen;
 		} else
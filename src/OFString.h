@@ -108,6 +108,24 @@ extern size_t of_utf16_string_length(const uint16_t*);
 + (instancetype)stringWithUTF8String: (const char*)UTF8String
 			      length: (size_t)UTF8StringLength;
 
+/*!
+ * @brief Creates a new OFString from a UTF-8 encoded C string with the
+ *	  specified length without throwing an exception if it is not valid
+ *	  UTF-8.
+ *
+ * This is useful for parsers which need to handle invalid input as part of
+ * their normal operation.
+ *
+ * @param UTF8String A UTF-8 encoded C string to initialize the OFString with
+ * @param UTF8StringLength The length of the UTF-8 encoded C string
+ * @param errNo A pointer to an int which is set to 0 on success or to EILSEQ
+ *		if the string is not valid UTF-8
+ * @return A new autoreleased OFString or nil if the string is not valid UTF-8
+ */
++ (instancetype)stringWithUTF8String: (const char*)UTF8String
+			      length: (size_t)UTF8StringLength
+			       error: (int*)errNo;
+
 /*!
  * @brief Creates a new OFString from a C string with the specified encoding.
  *
@@ -310,6 +328,22 @@ extern size_t of_utf16_string_length(const uint16_t*);
 - initWithUTF8String: (const char*)UTF8String
 	      length: (size_t)UTF8StringLength;
 
+/*!
+ * @brief Initializes an already allocated OFString from a UTF-8 encoded C
+ *	  string with the specified length without throwing an exception if it
+ *	  is not valid UTF-8.
+ *
+ * @param UTF8String A UTF-8 encoded C string to initialize the OFString with
+ * @param UTF8StringLength The length of the UTF-8 encoded C string
+ * @param errNo A pointer to an int which is set to 0 on success or to EILSEQ
+ *		if the string is not valid UTF-8
+ * @return An initialized OFString or nil if the string is not valid UTF-8, in
+ *	   which case the receiver has been released
+ */
+- initWithUTF8String: (const char*)UTF8String
+	      length: (size_t)UTF8StringLength
+	       error: (int*)errNo;
+
 /*!
  * @brief Initializes an already allocated OFString from an UTF-8 encoded C
  *	  string without copying it, if possible.
@@ -832,6 +866,17 @@ extern size_t of_utf16_string_length(const uint16_t*);
  */
 - (intmax_t)decimalValue;
 
+/*!
+ * @brief Returns the decimal value of the string as an intmax_t without
+ *	  throwing an exception if the string is not a valid number.
+ *
+ * @param errNo A pointer to an int which is set to 0 on success, to EINVAL if
+ *		the string contains non-number characters or to ERANGE if the
+ *		number does not fit into an intmax_t
+ * @return An intmax_t with the value of the string or 0 on error
+ */
+- (intmax_t)decimalValueWithError: (int*)errNo;
+
 /*!
  * @brief Returns the hexadecimal value of the string as an uintmax_t.
  *
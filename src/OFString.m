@@ -19,6 +19,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 #include <sys/stat.h>
 
@@ -55,6 +56,9 @@
 # define strtod __strtod
 #endif
 
+#define IS_WHITESPACE(c) \
+	(c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f')
+
 /* References for static linking */
 void _references_to_categories_of_OFString(void)
 {
@@ -93,6 +97,117 @@ of_utf16_string_length(const uint16_t *string)
 	return (size_t)(string_ - string);
 }
 
+#if defined(OF_OBJFW_RUNTIME) && defined(OBJC_TAGGED_POINTERS)
+# define TAGGED_STRINGS
+#endif
+
+#ifdef TAGGED_STRINGS
+/*
+ * A tagged string stores its length in the lowest 3 bits of the tagged
+ * pointer value, followed by up to 7 ASCII characters of 8 bits each.
+ */
+# define TAGGED_MAX_LENGTH 7
+
+@interface OFString_tagged: OFString
+@end
+
+static int stringTag = -1;
+
+static OF_INLINE size_t
+tagged_length(OFString *string)
+{
+	return (size_t)(object_getTaggedPointerValue(string) & 7);
+}
+
+static OF_INLINE char
+tagged_character(OFString *string, size_t index)
+{
+	return (char)
+	    ((object_getTaggedPointerValue(string) >> (3 + index * 8)) & 0xFF);
+}
+
+static OF_INLINE BOOL
+is_ascii_compatible(of_string_encoding_t encoding)
+{
+	switch (encoding) {
+	case OF_STRING_ENCODING_UTF_8:
+	case OF_STRING_ENCODING_ASCII:
+	case OF_STRING_ENCODING_ISO_8859_1:
+	case OF_STRING_ENCODING_ISO_8859_15:
+	case OF_STRING_ENCODING_WINDOWS_1252:
+		return YES;
+	default:
+		return NO;
+	}
+}
+
+static id
+tagged_string(const char *cString, size_t length)
+{
+	uintptr_t value;
+	size_t i;
+
+	if (stringTag == -1 || length > TAGGED_MAX_LENGTH)
+		return nil;
+
+	value = length;
+
+	for (i = 0; i < length; i++) {
+		/* Only ASCII, and no NUL which would end the C string */
+		if (cString[i] == '\0' || cString[i] & 0x80)
+			return nil;
+
+		value |= (uintptr_t)(unsigned char)cString[i] << (3 + i * 8);
+	}
+
+	return objc_createTaggedPointer(stringTag, value);
+}
+#endif
+
+static intmax_t
+parse_decimal(const char *string, size_t length, int *errNo)
+{
+	const char *end = string + length;
+	intmax_t value = 0;
+	BOOL negative = NO;
+
+	while (string < end && IS_WHITESPACE(*string))
+		string++;
+
+	if (string < end && (*string == '-' || *string == '+'))
+		negative = (*string++ == '-');
+
+	for (; string < end; string++) {
+		if (*string >= '0' && *string <= '9') {
+			if (INTMAX_MAX / 10 < value ||
+			    INTMAX_MAX - value * 10 < *string - '0') {
+				*errNo = ERANGE;
+				return 0;
+			}
+
+			value = (value * 10) + (*string - '0');
+		} else if (IS_WHITESPACE(*string)) {
+			/* Only whitespaces are allowed after the number */
+			while (string < end && IS_WHITESPACE(*string))
+				string++;
+
+			if (string < end) {
+				*errNo = EINVAL;
+				return 0;
+			}
+
+			break;
+		} else {
+			*errNo = EINVAL;
+			return 0;
+		}
+	}
+
+	*errNo = 0;
+
+	return (negative ? -value : value);
+}
+
 static struct {
 	Class isa;
 } placeholder;
@@ -113,6 +228,12 @@ static struct {
 	void *storage;
 
 	length = strlen(UTF8String);
+
+#ifdef TAGGED_STRINGS
+	if ((string = tagged_string(UTF8String, length)) != nil)
+		return string;
+#endif
+
 	string = of_alloc_object([OFString_UTF8 class],
 	    length + 1, 1, &storage);
 
@@ -127,6 +248,11 @@ static struct {
 	id string;
 	void *storage;
 
+#ifdef TAGGED_STRINGS
+	if ((string = tagged_string(UTF8String, UTF8StringLength)) != nil)
+		return string;
+#endif
+
 	string = of_alloc_object([OFString_UTF8 class],
 	    UTF8StringLength + 1, 1, &storage);
 
@@ -135,6 +261,29 @@ static struct {
 					 storage: storage];
 }
 
+- initWithUTF8String: (const char*)UTF8String
+	      length: (size_t)UTF8StringLength
+	       error: (int*)errNo
+{
+	id string;
+	void *storage;
+
+#ifdef TAGGED_STRINGS
+	if ((string = tagged_string(UTF8String, UTF8StringLength)) != nil) {
+		*errNo = 0;
+		return string;
+	}
+#endif
+
+	string = of_alloc_object([OFString_UTF8 class],
+	    UTF8StringLength + 1, 1, &storage);
+
+	return (id)[string OF_initWithUTF8String: UTF8String
+					  length: UTF8StringLength
+					 storage: storage
+					   error: errNo];
+}
+
 - initWithUTF8StringNoCopy: (const char*)UTF8String
 	      freeWhenDone: (BOOL)freeWhenDone
 {
@@ -146,6 +295,15 @@ static struct {
 - initWithCString: (const char*)cString
 	 encoding: (of_string_encoding_t)encoding
 {
+#ifdef TAGGED_STRINGS
+	if (is_ascii_compatible(encoding)) {
+		id string = tagged_string(cString, strlen(cString));
+
+		if (string != nil)
+			return string;
+	}
+#endif
+
 	if (encoding == OF_STRING_ENCODING_UTF_8) {
 		id string;
 		size_t length;
@@ -168,6 +326,15 @@ static struct {
 	 encoding: (of_string_encoding_t)encoding
 	   length: (size_t)cStringLength
 {
+#ifdef TAGGED_STRINGS
+	if (is_ascii_compatible(encoding)) {
+		id string = tagged_string(cString, cStringLength);
+
+		if (string != nil)
+			return string;
+	}
+#endif
+
 	if (encoding == OF_STRING_ENCODING_UTF_8) {
 		id string;
 		void *storage;
@@ -340,8 +507,14 @@ static struct {
 @implementation OFString
 + (void)initialize
 {
-	if (self == [OFString class])
-		placeholder.isa = [OFString_placeholder class];
+	if (self != [OFString class])
+		return;
+
+	placeholder.isa = [OFString_placeholder class];
+
+#ifdef TAGGED_STRINGS
+	stringTag = objc_registerTaggedPointerClass([OFString_tagged class]);
+#endif
 }
 
 + alloc
@@ -370,6 +543,16 @@ static struct {
 			length: UTF8StringLength] autorelease];
 }
 
++ (instancetype)stringWithUTF8String: (const char*)UTF8String
+			      length: (size_t)UTF8StringLength
+			       error: (int*)errNo
+{
+	return [[[self alloc]
+	    initWithUTF8String: UTF8String
+			length: UTF8StringLength
+			 error: errNo] autorelease];
+}
+
 + (instancetype)stringWithCString: (const char*)cString
 			 encoding: (of_string_encoding_t)encoding
 {
@@ -524,6 +707,27 @@ static struct {
 			      length: UTF8StringLength];
 }
 
+- initWithUTF8String: (const char*)UTF8String
+	      length: (size_t)UTF8StringLength
+	       error: (int*)errNo
+{
+	/*
+	 * Subclasses can override this to avoid the exception, but the
+	 * placeholder for OFString already does so.
+	 */
+	@try {
+		self = [self initWithUTF8String: UTF8String
+					 length: UTF8StringLength];
+	} @catch (OFInvalidEncodingException *e) {
+		*errNo = EILSEQ;
+		return nil;
+	}
+
+	*errNo = 0;
+
+	return self;
+}
+
 - initWithUTF8StringNoCopy: (const char*)UTF8String
 	      freeWhenDone: (BOOL)freeWhenDone
 {
@@ -1666,55 +1870,25 @@ static struct {
 
 - (intmax_t)decimalValue
 {
-	void *pool = objc_autoreleasePoolPush();
-	const of_unichar_t *string = [self unicodeString];
-	size_t length = [self length];
-	int i = 0;
-	intmax_t value = 0;
-	BOOL expectWhitespace = NO;
-
-	while (*string == ' ' || *string == '\t' || *string == '\n' ||
-	    *string == '\r' || *string == '\f') {
-		string++;
-		length--;
-	}
-
-	if (length == 0) {
-		objc_autoreleasePoolPop(pool);
-		return 0;
-	}
+	int errNo;
+	intmax_t value = [self decimalValueWithError: &errNo];
 
-	if (string[0] == '-' || string[0] == '+')
-		i++;
-
-	for (; i < length; i++) {
-		if (expectWhitespace) {
-			if (string[i] != ' ' && string[i] != '\t' &&
-			    string[i] != '\n' && string[i] != '\r' &&
-			    string[i] != '\f')
-				@throw [OFInvalidFormatException
-				    exceptionWithClass: [self class]];
-			continue;
-		}
+	if (errNo == ERANGE)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+	if (errNo != 0)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
 
-		if (string[i] >= '0' && string[i] <= '9') {
-			if (INTMAX_MAX / 10 < value ||
-			    INTMAX_MAX - value * 10 < string[i] - '0')
-				@throw [OFOutOfRangeException
-				    exceptionWithClass: [self class]];
+	return value;
+}
 
-			value = (value * 10) + (string[i] - '0');
-		} else if (string[i] == ' ' || string[i] == '\t' ||
-		    string[i] == '\n' || string[i] == '\r' ||
-		    string[i] == '\f')
-			expectWhitespace = YES;
-		else
-			@throw [OFInvalidFormatException
-			    exceptionWithClass: [self class]];
-	}
+- (intmax_t)decimalValueWithError: (int*)errNo
+{
+	void *pool = objc_autoreleasePoolPush();
+	intmax_t value;
 
-	if (string[0] == '-')
-		value *= -1;
+	value = parse_decimal([self UTF8String], [self UTF8StringLength],
+	    errNo);
 
 	objc_autoreleasePoolPop(pool);
 
@@ -1955,3 +2129,227 @@ static struct {
 }
 #endif
 @end
+
+#ifdef TAGGED_STRINGS
+@implementation OFString_tagged
+- (size_t)length
+{
+	return tagged_length(self);
+}
+
+- (size_t)UTF8StringLength
+{
+	return tagged_length(self);
+}
+
+- (size_t)cStringLengthWithEncoding: (of_string_encoding_t)encoding
+{
+	if (is_ascii_compatible(encoding))
+		return tagged_length(self);
+
+	return [super cStringLengthWithEncoding: encoding];
+}
+
+- (const char*)UTF8String
+{
+	OFObject *object = [[[OFObject alloc] init] autorelease];
+	size_t i, length = tagged_length(self);
+	char *UTF8String;
+
+	UTF8String = [object allocMemoryWithSize: length + 1];
+
+	for (i = 0; i < length; i++)
+		UTF8String[i] = tagged_character(self, i);
+
+	UTF8String[length] = '\0';
+
+	return UTF8String;
+}
+
+- (const char*)cStringWithEncoding: (of_string_encoding_t)encoding
+{
+	if (is_ascii_compatible(encoding))
+		return [self UTF8String];
+
+	return [super cStringWithEncoding: encoding];
+}
+
+- (of_unichar_t)characterAtIndex: (size_t)index
+{
+	if (index >= tagged_length(self))
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	return tagged_character(self, index);
+}
+
+- (void)getCharacters: (of_unichar_t*)buffer
+	      inRange: (of_range_t)range
+{
+	size_t i;
+
+	if (range.length > SIZE_MAX - range.location ||
+	    range.location + range.length > tagged_length(self))
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	for (i = 0; i < range.length; i++)
+		buffer[i] = tagged_character(self, range.location + i);
+}
+
+- (BOOL)isEqual: (id)object
+{
+	OFString *otherString;
+	size_t i, length;
+
+	if (object == self)
+		return YES;
+
+	/*
+	 * Equal tagged strings have the same bits, so another tagged pointer
+	 * can never be equal.
+	 */
+	if (object_isTaggedPointer(object))
+		return NO;
+
+	if (![object isKindOfClass: [OFString class]])
+		return NO;
+
+	otherString = object;
+	length = tagged_length(self);
+
+	if ([otherString length] != length)
+		return NO;
+
+	for (i = 0; i < length; i++)
+		if ([otherString characterAtIndex: i] !=
+		    (of_unichar_t)tagged_character(self, i))
+			return NO;
+
+	return YES;
+}
+
+- (of_comparison_result_t)compare: (id <OFComparing>)object
+{
+	OFString *otherString;
+	size_t i, length, otherLength, minimumLength;
+
+	if (object == self)
+		return OF_ORDERED_SAME;
+
+	if (![object isKindOfClass: [OFString class]])
+		@throw [OFInvalidArgumentException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+
+	otherString = (OFString*)object;
+	length = tagged_length(self);
+	otherLength = [otherString length];
+	minimumLength = (length > otherLength ? otherLength : length);
+
+	for (i = 0; i < minimumLength; i++) {
+		of_unichar_t c = tagged_character(self, i);
+		of_unichar_t oc = [otherString characterAtIndex: i];
+
+		if (c > oc)
+			return OF_ORDERED_DESCENDING;
+		if (c < oc)
+			return OF_ORDERED_ASCENDING;
+	}
+
+	if (length > otherLength)
+		return OF_ORDERED_DESCENDING;
+	if (length < otherLength)
+		return OF_ORDERED_ASCENDING;
+
+	return OF_ORDERED_SAME;
+}
+
+/*
+ * -[OFString hasPrefix:] and -[OFString hasSuffix:] allocate memory owned by
+ * the receiver, which a tagged pointer does not have.
+ */
+- (BOOL)hasPrefix: (OFString*)prefix
+{
+	size_t i, prefixLength = [prefix length];
+
+	if (prefixLength > tagged_length(self))
+		return NO;
+
+	for (i = 0; i < prefixLength; i++)
+		if ([prefix characterAtIndex: i] !=
+		    (of_unichar_t)tagged_character(self, i))
+			return NO;
+
+	return YES;
+}
+
+- (BOOL)hasSuffix: (OFString*)suffix
+{
+	size_t i, length = tagged_length(self), suffixLength = [suffix length];
+
+	if (suffixLength > length)
+		return NO;
+
+	for (i = 0; i < suffixLength; i++)
+		if ([suffix characterAtIndex: i] != (of_unichar_t)
+		    tagged_character(self, length - suffixLength + i))
+			return NO;
+
+	return YES;
+}
+
+- (uint32_t)hash
+{
+	size_t i, length = tagged_length(self);
+	uint32_t hash;
+
+	/* Must match -[OFString hash] */
+	OF_HASH_INIT(hash);
+
+	for (i = 0; i < length; i++) {
+		OF_HASH_ADD(hash, 0);
+		OF_HASH_ADD(hash, 0);
+		OF_HASH_ADD(hash, tagged_character(self, i));
+	}
+
+	OF_HASH_FINALIZE(hash);
+
+	return hash;
+}
+
+- retain
+{
+	return self;
+}
+
+- autorelease
+{
+	return self;
+}
+
+- (void)release
+{
+}
+
+- (unsigned int)retainCount
+{
+	return OF_RETAIN_COUNT_MAX;
+}
+
+- (BOOL)allowsWeakReference
+{
+	return YES;
+}
+
+- (BOOL)retainWeakReference
+{
+	return YES;
+}
+
+- (void)dealloc
+{
+	@throw [OFNotImplementedException exceptionWithClass: [self class]
+						    selector: _cmd];
+	[super dealloc];	/* Get rid of a stupid warning */
+}
+@end
+#endif
@@ -41,4 +41,8 @@
 - OF_initWithUTF8String: (const char*)UTF8String
 		 length: (size_t)UTF8StringLength
 		storage: (char*)storage;
+- OF_initWithUTF8String: (const char*)UTF8String
+		 length: (size_t)UTF8StringLength
+		storage: (char*)storage
+		  error: (int*)errNo;
 @end
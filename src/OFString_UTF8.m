@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 
 #include <sys/types.h>
 
@@ -239,37 +240,54 @@ of_string_utf8_get_position(const char *string, size_t index, size_t length)
 		 length: (size_t)UTF8StringLength
 		storage: (char*)storage
 {
-	self = [super init];
+	Class c = [self class];
+	int errNo;
 
-	@try {
-		if (UTF8StringLength >= 3 &&
-		    !memcmp(UTF8String, "\xEF\xBB\xBF", 3)) {
-			UTF8String += 3;
-			UTF8StringLength -= 3;
-		}
+	self = [self OF_initWithUTF8String: UTF8String
+				    length: UTF8StringLength
+				   storage: storage
+				     error: &errNo];
 
-		s = &s_store;
+	if (self == nil)
+		@throw [OFInvalidEncodingException exceptionWithClass: c];
 
-		s->cString = storage;
-		s->cStringLength = UTF8StringLength;
+	return self;
+}
 
-		switch (of_string_utf8_check(UTF8String, UTF8StringLength,
-		    &s->length)) {
-		case 1:
-			s->isUTF8 = YES;
-			break;
-		case -1:
-			@throw [OFInvalidEncodingException
-			    exceptionWithClass: [self class]];
-		}
+- OF_initWithUTF8String: (const char*)UTF8String
+		 length: (size_t)UTF8StringLength
+		storage: (char*)storage
+		  error: (int*)errNo
+{
+	self = [super init];
 
-		memcpy(s->cString, UTF8String, UTF8StringLength);
-		s->cString[UTF8StringLength] = 0;
-	} @catch (id e) {
+	if (UTF8StringLength >= 3 &&
+	    !memcmp(UTF8String, "\xEF\xBB\xBF", 3)) {
+		UTF8String += 3;
+		UTF8StringLength -= 3;
+	}
+
+	s = &s_store;
+
+	s->cString = storage;
+	s->cStringLength = UTF8StringLength;
+
+	switch (of_string_utf8_check(UTF8String, UTF8StringLength,
+	    &s->length)) {
+	case 1:
+		s->isUTF8 = YES;
+		break;
+	case -1:
 		[self release];
-		@throw e;
+		*errNo = EILSEQ;
+		return nil;
 	}
 
+	memcpy(s->cString, UTF8String, UTF8StringLength);
+	s->cString[UTF8StringLength] = 0;
+
+	*errNo = 0;
+
 	return self;
 }
 
@@ -836,6 +854,12 @@ of_string_utf8_get_position(const char *string, size_t index, size_t length)
 	if (object == self)
 		return YES;
 
+#if defined(OF_OBJFW_RUNTIME) && defined(OBJC_TAGGED_POINTERS)
+	/* Tagged strings can compare without creating a C string */
+	if (object_isTaggedPointer(object))
+		return [object isEqual: self];
+#endif
+
 	if (![object isKindOfClass: [OFString class]])
 		return NO;
 
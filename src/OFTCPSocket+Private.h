@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFTCPSocket.h"
+#import "OFResolver.h"
+
+@interface OFTCPSocket (OF_PrivateMethods)
+- (int)OF_startConnectToAddress: (const of_resolver_address_t*)address;
+- (int)OF_finishConnect;
+- (void)OF_connectToAddresses: (OFDataArray*)addresses
+			 host: (OFString*)host
+			 port: (uint16_t)port
+		     deadline: (uint64_t)deadline;
+- (void)OF_takeOverConnectionOfSocket: (OFTCPSocket*)socket;
+
+/*
+ * Makes the listening socket non-blocking for the run loop without changing
+ * -[isBlocking]. Does nothing if this has already been done.
+ */
+- (void)OF_setAcceptQueueNonBlocking;
+
+/*
+ * Accepts a connection. Returns nil if there is none pending and the socket
+ * is non-blocking, either because of -[setBlocking:] or
+ * OF_setAcceptQueueNonBlocking.
+ */
+- (OFTCPSocket*)OF_acceptIfPending;
+@end
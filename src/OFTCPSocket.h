@@ -35,11 +35,14 @@
 
 @class OFTCPSocket;
 @class OFString;
+@class OFArray;
 
 #ifdef OF_HAVE_BLOCKS
 typedef void (^of_tcpsocket_async_connect_block_t)(OFTCPSocket*, OFException*);
 typedef BOOL (^of_tcpsocket_async_accept_block_t)(OFTCPSocket*, OFTCPSocket*,
     OFException*);
+typedef BOOL (^of_tcpsocket_async_accept_batch_block_t)(OFTCPSocket*, OFArray*,
+    OFException*);
 #endif
 
 /*!
@@ -51,16 +54,27 @@ typedef BOOL (^of_tcpsocket_async_accept_block_t)(OFTCPSocket*, OFTCPSocket*,
 @interface OFTCPSocket: OFStreamSocket
 {
 	BOOL			listening;
-	struct sockaddr_storage	*sockAddr;
+	struct sockaddr_storage	sockAddr;
 	socklen_t		sockAddrLen;
 	OFString		*SOCKS5Host;
 	uint16_t		SOCKS5Port;
+	double			connectTimeout, connectionAttemptDelay;
+	BOOL			reusesPort;
+	int			fastOpenQueueLength;
+	double			deferredAcceptTimeout;
+	size_t			acceptBatchLimit;
+	BOOL			acceptQueueNonBlocking;
 }
 
 #ifdef OF_HAVE_PROPERTIES
 @property (readonly, getter=isListening) BOOL listening;
 @property (copy) OFString *SOCKS5Host;
 @property uint16_t SOCKS5Port;
+@property double connectTimeout, connectionAttemptDelay;
+@property BOOL reusesPort;
+@property int fastOpenQueueLength;
+@property double deferredAcceptTimeout;
+@property size_t acceptBatchLimit;
 #endif
 
 /*!
@@ -121,6 +135,42 @@ typedef BOOL (^of_tcpsocket_async_accept_block_t)(OFTCPSocket*, OFTCPSocket*,
  */
 - (uint16_t)SOCKS5Port;
 
+/*!
+ * @brief Sets the time in seconds after which connecting fails.
+ *
+ * The time includes resolving the host. The default is 0, which means that
+ * only the timeout of the system applies.
+ *
+ * @param connectTimeout The time in seconds after which connecting fails
+ */
+- (void)setConnectTimeout: (double)connectTimeout;
+
+/*!
+ * @brief Returns the time in seconds after which connecting fails.
+ *
+ * @return The time in seconds after which connecting fails
+ */
+- (double)connectTimeout;
+
+/*!
+ * @brief Sets the time in seconds an asynchronous connect waits for an address
+ *	  before it tries the next one in parallel.
+ *
+ * The default is 0.25 seconds, as recommended by RFC 8305.
+ *
+ * @param connectionAttemptDelay The time in seconds to wait before trying the
+ *				 next address
+ */
+- (void)setConnectionAttemptDelay: (double)connectionAttemptDelay;
+
+/*!
+ * @brief Returns the time in seconds an asynchronous connect waits for an
+ *	  address before it tries the next one in parallel.
+ *
+ * @return The time in seconds to wait before trying the next address
+ */
+- (double)connectionAttemptDelay;
+
 /*!
  * @brief Connect the OFTCPSocket to the specified destination.
  *
@@ -133,6 +183,14 @@ typedef BOOL (^of_tcpsocket_async_accept_block_t)(OFTCPSocket*, OFTCPSocket*,
 /*!
  * @brief Asyncronously connect the OFTCPSocket to the specified destination.
  *
+ * The addresses of the host are tried in parallel as described in RFC 8305
+ * ("Happy Eyeballs"): IPv6 and IPv4 addresses are tried alternately and the
+ * next address is tried if the previous one did not connect within the
+ * connection attempt delay. The first connection which succeeds is used.
+ *
+ * Connecting does not need a thread, but the current thread needs to run its
+ * run loop.
+ *
  * @param host The host to connect to
  * @param port The port on the host to connect to
  * @param target The target on which to call the selector once the connection
@@ -195,6 +253,10 @@ typedef BOOL (^of_tcpsocket_async_accept_block_t)(OFTCPSocket*, OFTCPSocket*,
 /*!
  * @brief Asyncronously accept an incoming connection.
  *
+ * When the socket becomes readable, up to @ref acceptBatchLimit pending
+ * connections are accepted and passed to the target one by one, until the
+ * target returns NO.
+ *
  * @param target The target on which to execute the selector when a new
  *		 connection has been accepted. The method returns whether the
  *		 next incoming connection should be accepted by the specified
@@ -219,6 +281,62 @@ typedef BOOL (^of_tcpsocket_async_accept_block_t)(OFTCPSocket*, OFTCPSocket*,
 - (void)asyncAcceptWithBlock: (of_tcpsocket_async_accept_block_t)block;
 #endif
 
+/*!
+ * @brief Asyncronously accept incoming connections in batches.
+ *
+ * When the socket becomes readable, up to @ref acceptBatchLimit pending
+ * connections are accepted and passed to the target in a single call. If
+ * accepting fails after some connections have been accepted, the accepted
+ * connections are passed together with the exception.
+ *
+ * @param target The target on which to execute the selector when new
+ *		 connections have been accepted. The method returns whether the
+ *		 next incoming connections should be accepted by the specified
+ *		 target as well.
+ * @param selector The selector to call on the target. The signature must be
+ *		   BOOL (OFTCPSocket *socket, OFArray *acceptedSockets,
+ *		   id context, OFException *exception).
+ * @param context A context to pass when the target gets called
+ */
+- (void)asyncAcceptBatchWithTarget: (id)target
+			  selector: (SEL)selector
+			   context: (id)context;
+
+#ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief Asyncronously accept incoming connections in batches.
+ *
+ * When the socket becomes readable, up to @ref acceptBatchLimit pending
+ * connections are accepted and passed to the block in a single call.
+ *
+ * @param block The block to execute when new connections have been accepted.
+ *		Returns whether the next incoming connections should be
+ *		accepted by the specified block as well.
+ */
+- (void)asyncAcceptBatchWithBlock:
+    (of_tcpsocket_async_accept_batch_block_t)block;
+#endif
+
+/*!
+ * @brief Sets the maximum number of connections accepted each time an
+ *	  asynchronously accepting socket becomes readable.
+ *
+ * A higher limit needs fewer wakeups when many clients connect at once, while
+ * a lower limit lets other streams of the run loop be handled sooner. The
+ * default is 16.
+ *
+ * @param acceptBatchLimit The maximum number of connections to accept at once
+ */
+- (void)setAcceptBatchLimit: (size_t)acceptBatchLimit;
+
+/*!
+ * @brief Returns the maximum number of connections accepted each time an
+ *	  asynchronously accepting socket becomes readable.
+ *
+ * @return The maximum number of connections to accept at once
+ */
+- (size_t)acceptBatchLimit;
+
 /*!
  * @brief Enable or disable keep alives for the connection.
  *
@@ -226,6 +344,104 @@ typedef BOOL (^of_tcpsocket_async_accept_block_t)(OFTCPSocket*, OFTCPSocket*,
  */
 - (void)setKeepAlivesEnabled: (BOOL)enable;
 
+/*!
+ * @brief Enable or disable sending data without waiting for more data to
+ *	  combine it with (TCP_NODELAY).
+ *
+ * This disables Nagle's algorithm, which reduces the latency of small writes
+ * at the cost of sending more packets.
+ *
+ * @param enable Whether to send data without waiting for more data
+ */
+- (void)setNoDelayEnabled: (BOOL)enable;
+
+/*!
+ * @brief Returns whether data is sent without waiting for more data to
+ *	  combine it with.
+ *
+ * @return Whether data is sent without waiting for more data
+ */
+- (BOOL)isNoDelayEnabled;
+
+/*!
+ * @brief Enable or disable holding back partial packets (TCP_CORK or
+ *	  TCP_NOPUSH).
+ *
+ * While enabled, only full packets are sent, so that several writes can be
+ * combined. Disabling it sends the pending data.
+ *
+ * @param enable Whether to hold back partial packets
+ */
+- (void)setCorkEnabled: (BOOL)enable;
+
+/*!
+ * @brief Returns whether partial packets are held back.
+ *
+ * @return Whether partial packets are held back
+ */
+- (BOOL)isCorkEnabled;
+
+/*!
+ * @brief Sets whether other sockets can bind to the same address and port
+ *	  (SO_REUSEPORT).
+ *
+ * This allows several listening sockets, e.g. one per thread, among which the
+ * system distributes incoming connections. It is applied when binding, so it
+ * needs to be set before @ref bindToHost:port: is called.
+ *
+ * @param reusesPort Whether other sockets can bind to the same address and
+ *		     port
+ */
+- (void)setReusesPort: (BOOL)reusesPort;
+
+/*!
+ * @brief Returns whether other sockets can bind to the same address and port.
+ *
+ * @return Whether other sockets can bind to the same address and port
+ */
+- (BOOL)reusesPort;
+
+/*!
+ * @brief Sets the maximum number of pending TCP Fast Open requests of a
+ *	  listening socket (TCP_FASTOPEN).
+ *
+ * TCP Fast Open allows clients which connected before to send data with the
+ * first packet. It is applied when listening, so it needs to be set before
+ * @ref listenWithBackLog: is called. The default is 0, which disables it.
+ *
+ * @param fastOpenQueueLength The maximum number of pending TCP Fast Open
+ *			      requests
+ */
+- (void)setFastOpenQueueLength: (int)fastOpenQueueLength;
+
+/*!
+ * @brief Returns the maximum number of pending TCP Fast Open requests of a
+ *	  listening socket.
+ *
+ * @return The maximum number of pending TCP Fast Open requests
+ */
+- (int)fastOpenQueueLength;
+
+/*!
+ * @brief Sets the time in seconds a listening socket waits for data before it
+ *	  reports a connection (TCP_DEFER_ACCEPT).
+ *
+ * This avoids waking up for connections which did not send a request yet. It
+ * is applied when listening, so it needs to be set before
+ * @ref listenWithBackLog: is called. The default is 0, which disables it.
+ *
+ * @param deferredAcceptTimeout The time in seconds to wait for data
+ */
+- (void)setDeferredAcceptTimeout: (double)deferredAcceptTimeout;
+
+/*!
+ * @brief Returns the time in seconds a listening socket waits for data before
+ *	  it reports a connection.
+ *
+ * @return The time in seconds to wait for data
+ */
+- (double)deferredAcceptTimeout;
+
 /*!
  * @brief Returns the remote address of the socket.
  *
@@ -16,26 +16,44 @@
 
 #include "config.h"
 
+#define _GNU_SOURCE
 #define __NO_EXT_QNX
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <errno.h>
 
 #include <unistd.h>
+#include <fcntl.h>
 
 #include <assert.h>
 
+#ifdef HAVE_POLL_H
+# include <poll.h>
+#elif defined(OF_HAVE_SYS_SELECT_H)
+# include <sys/select.h>
+#endif
+
 #ifndef _WIN32
 # include <netinet/in.h>
+# include <netinet/tcp.h>
 # include <arpa/inet.h>
 # include <netdb.h>
 #endif
 
 #import "OFTCPSocket.h"
 #import "OFTCPSocket+SOCKS5.h"
+#import "OFTCPSocket+Private.h"
+#import "OFStreamSocket+Private.h"
+#import "OFResolver.h"
 #import "OFString.h"
+#import "OFArray.h"
+#import "OFDataArray.h"
 #import "OFThread.h"
+#import "OFThreadPool.h"
 #import "OFTimer.h"
 #import "OFRunLoop.h"
 
@@ -52,6 +70,7 @@
 
 #import "autorelease.h"
 #import "macros.h"
+#import "of_clock.h"
 
 #ifndef INVALID_SOCKET
 # define INVALID_SOCKET -1
@@ -59,13 +78,25 @@
 
 #if defined(OF_THREADS) && !defined(HAVE_THREADSAFE_GETADDRINFO)
 # import "OFMutex.h"
-# import "OFDataArray.h"
 
 static OFMutex *mutex = nil;
 #endif
 
-#ifdef _WIN32
+#ifndef _WIN32
+# define GET_SOCK_ERRNO errno
+# define SET_SOCK_ERRNO(e) errno = e
+# define CONNECT_IN_PROGRESS EINPROGRESS
+# define WOULD_BLOCK(e) (e == EAGAIN || e == EWOULDBLOCK)
+#else
 # define close(sock) closesocket(sock)
+# define GET_SOCK_ERRNO WSAGetLastError()
+# define SET_SOCK_ERRNO(e) WSASetLastError(e)
+# define CONNECT_IN_PROGRESS WSAEWOULDBLOCK
+# define WOULD_BLOCK(e) (e == WSAEWOULDBLOCK)
+#endif
+
+#if defined(HAVE_ACCEPT4) && defined(SOCK_CLOEXEC) && defined(SOCK_NONBLOCK)
+# define USE_ACCEPT4
 #endif
 
 /* References for static linking */
@@ -77,12 +108,16 @@ void _references_to_categories_of_OFTCPSocket(void)
 static OFString *defaultSOCKS5Host = nil;
 static uint16_t defaultSOCKS5Port = 1080;
 
-@interface OFTCPSocket_ConnectThread: OFThread
+@interface OFTCPSocket_AsyncConnectRequest: OFObject
 {
+@public
 	OFThread *sourceThread;
 	OFTCPSocket *sock;
 	OFString *host;
 	uint16_t port;
+	OFString *SOCKS5Host;
+	uint16_t SOCKS5Port;
+	double connectTimeout, connectionAttemptDelay;
 	id target;
 	SEL selector;
 #ifdef OF_HAVE_BLOCKS
@@ -90,118 +125,345 @@ static uint16_t defaultSOCKS5Port = 1080;
 #endif
 	id context;
 	OFException *exception;
+	OFDataArray *candidates;
+	size_t nextCandidate;
+	OFMutableArray *attempts;
+	OFTimer *attemptTimer, *timeoutTimer;
+	int errNo;
+	BOOL done;
 }
 
-- initWithSourceThread: (OFThread*)sourceThread
-		socket: (OFTCPSocket*)socket
-		  host: (OFString*)host
-		  port: (uint16_t)port
-		target: (id)target
-	      selector: (SEL)selector
-	       context: (id)context;
-#ifdef OF_HAVE_BLOCKS
-- initWithSourceThread: (OFThread*)sourceThread
-		socket: (OFTCPSocket*)socket
-		  host: (OFString*)host
-		  port: (uint16_t)port
-		 block: (of_tcpsocket_async_connect_block_t)block;
-#endif
+- (void)start;
 @end
 
-@implementation OFTCPSocket_ConnectThread
-- initWithSourceThread: (OFThread*)sourceThread_
-		socket: (OFTCPSocket*)sock_
-		  host: (OFString*)host_
-		  port: (uint16_t)port_
-		target: (id)target_
-	      selector: (SEL)selector_
-	       context: (id)context_
+static BOOL
+set_socket_nonblocking(int sock, BOOL enable)
 {
-	self = [super init];
+#ifndef _WIN32
+	int flags;
 
-	@try {
-		sourceThread = [sourceThread_ retain];
-		sock = [sock_ retain];
-		host = [host_ copy];
-		port = port_;
-		target = [target_ retain];
-		selector = selector_;
-		context = [context_ retain];
-	} @catch (id e) {
-		[self release];
-		@throw e;
-	}
+	if ((flags = fcntl(sock, F_GETFL)) == -1)
+		return NO;
 
-	return self;
+	if (enable)
+		flags |= O_NONBLOCK;
+	else
+		flags &= ~O_NONBLOCK;
+
+	return (fcntl(sock, F_SETFL, flags) != -1);
+#else
+	u_long v = enable;
+
+	return (ioctlsocket(sock, FIONBIO, &v) != SOCKET_ERROR);
+#endif
 }
 
-#ifdef OF_HAVE_BLOCKS
-- initWithSourceThread: (OFThread*)sourceThread_
-		socket: (OFTCPSocket*)sock_
-		  host: (OFString*)host_
-		  port: (uint16_t)port_
-		 block: (of_tcpsocket_async_connect_block_t)block_
+static void
+set_port(of_resolver_address_t *address, uint16_t port)
 {
-	self = [super init];
+	struct sockaddr *addr = (struct sockaddr*)&address->address;
 
-	@try {
-		sourceThread = [sourceThread_ retain];
-		sock = [sock_ retain];
-		host = [host_ copy];
-		port = port_;
-		connectBlock = [block_ copy];
-	} @catch (id e) {
-		[self release];
-		@throw e;
+	if (addr->sa_family == AF_INET)
+		((struct sockaddr_in*)addr)->sin_port = OF_BSWAP16_IF_LE(port);
+	else if (addr->sa_family == AF_INET6)
+		((struct sockaddr_in6*)addr)->sin6_port =
+		    OF_BSWAP16_IF_LE(port);
+}
+
+static BOOL
+wait_until_writable(int fd, double timeout)
+{
+#ifdef HAVE_POLL_H
+	struct pollfd pfd = { 0, POLLOUT, 0 };
+
+	pfd.fd = fd;
+
+	return (poll(&pfd, 1, (timeout >= 0 ? (int)(timeout * 1000) : -1)) > 0);
+#else
+	fd_set writeFDs, exceptFDs;
+	struct timeval tv;
+
+	FD_ZERO(&writeFDs);
+	FD_ZERO(&exceptFDs);
+	FD_SET(fd, &writeFDs);
+	FD_SET(fd, &exceptFDs);
+
+	tv.tv_sec = (time_t)timeout;
+	tv.tv_usec = (int)((timeout - tv.tv_sec) * 1000000);
+
+	return (select(fd + 1, NULL, &writeFDs, &exceptFDs,
+	    (timeout >= 0 ? &tv : NULL)) > 0);
+#endif
+}
+
+/*
+ * Orders the addresses as described in RFC 8305, so that the address families
+ * alternate, starting with the one of the preferred address.
+ */
+static OFDataArray*
+interleave_addresses(OFDataArray *addresses)
+{
+	OFDataArray *ret =
+	    [OFDataArray dataArrayWithItemSize: sizeof(of_resolver_address_t)];
+	of_resolver_address_t *addressItems = [addresses cArray];
+	size_t count = [addresses count];
+	size_t firstIndex = 0, otherIndex = 0;
+	int firstFamily;
+
+	if (count == 0)
+		return ret;
+
+	firstFamily = addressItems[0].address.ss_family;
+
+	for (;;) {
+		while (firstIndex < count &&
+		    addressItems[firstIndex].address.ss_family != firstFamily)
+			firstIndex++;
+		while (otherIndex < count &&
+		    addressItems[otherIndex].address.ss_family == firstFamily)
+			otherIndex++;
+
+		if (firstIndex >= count && otherIndex >= count)
+			break;
+
+		if (firstIndex < count)
+			[ret addItem: &addressItems[firstIndex++]];
+		if (otherIndex < count)
+			[ret addItem: &addressItems[otherIndex++]];
 	}
 
-	return self;
+	return ret;
 }
-#endif
 
+@implementation OFTCPSocket_AsyncConnectRequest
 - (void)dealloc
 {
 	[sourceThread release];
 	[sock release];
 	[host release];
+	[SOCKS5Host release];
 	[target release];
 #ifdef OF_HAVE_BLOCKS
 	[connectBlock release];
 #endif
 	[context release];
 	[exception release];
+	[candidates release];
+	[attempts release];
+	[attemptTimer release];
+	[timeoutTimer release];
 
 	[super dealloc];
 }
 
-- (void)didConnect
+- (void)start
 {
-	[self join];
+	SEL resolveSelector =
+	    @selector(resolver:didResolveHost:addresses:context:exception:);
+
+	attempts = [[OFMutableArray alloc] init];
+
+	if (connectTimeout > 0)
+		timeoutTimer = [[OFTimer
+		    scheduledTimerWithTimeInterval: connectTimeout
+					    target: self
+					  selector: @selector(timeout)
+					   repeats: NO] retain];
+
+	[[OFResolver sharedResolver]
+	    asyncResolveHost: (SOCKS5Host != nil ? SOCKS5Host : host)
+		      target: self
+		    selector: resolveSelector
+		     context: nil];
+}
 
-#ifdef OF_HAVE_BLOCKS
-	if (connectBlock != NULL)
-		connectBlock(sock, exception);
-	else {
-#endif
-		void (*func)(id, SEL, OFTCPSocket*, id, OFException*) =
-		    (void(*)(id, SEL, OFTCPSocket*, id, OFException*))[target
-		    methodForSelector: selector];
+-     (void)resolver: (OFResolver*)resolver
+      didResolveHost: (OFString*)resolvedHost
+	   addresses: (OFDataArray*)addresses
+	     context: (id)context_
+	   exception: (OFException*)exception_
+{
+	if (done)
+		return;
+
+	if (exception_ != nil) {
+		[self failWithException: [OFAddressTranslationFailedException
+		    exceptionWithClass: [sock class]
+				socket: sock
+				  host: resolvedHost]];
+		return;
+	}
 
-		func(target, selector, sock, context, exception);
-#ifdef OF_HAVE_BLOCKS
+	candidates = [interleave_addresses(addresses) retain];
+	[self startNextAttempt];
+}
+
+- (void)startNextAttempt
+{
+	SEL readySelector = @selector(attemptIsReady:context:);
+	SEL nextSelector = @selector(startNextAttempt);
+	of_resolver_address_t *addressItems = [candidates cArray];
+	size_t count = [candidates count];
+
+	if (done)
+		return;
+
+	[attemptTimer invalidate];
+	[attemptTimer release];
+	attemptTimer = nil;
+
+	while (nextCandidate < count) {
+		of_resolver_address_t address = addressItems[nextCandidate++];
+		OFTCPSocket *attempt = [OFTCPSocket socket];
+		int error;
+
+		set_port(&address, (SOCKS5Host != nil ? SOCKS5Port : port));
+
+		if ((error = [attempt OF_startConnectToAddress: &address])
+		    == 0) {
+			[self didConnectAttempt: attempt];
+			return;
+		}
+
+		if (error != CONNECT_IN_PROGRESS) {
+			errNo = error;
+			continue;
+		}
+
+		[attempts addObject: attempt];
+		[OFRunLoop OF_addAsyncConnectForTCPSocket: attempt
+						   target: self
+						 selector: readySelector
+						  context: nil];
+
+		/* Give the attempt a head start before racing the next one */
+		if (nextCandidate < count)
+			attemptTimer = [[OFTimer
+			    scheduledTimerWithTimeInterval:
+			    connectionAttemptDelay
+						    target: self
+						  selector: nextSelector
+						   repeats: NO] retain];
+
+		return;
 	}
-#endif
+
+	if ([attempts count] == 0)
+		[self failWithErrNo: errNo];
+}
+
+- (void)attemptIsReady: (OFTCPSocket*)attempt
+	       context: (id)context_
+{
+	int error;
+
+	if (done)
+		return;
+
+	[[attempt retain] autorelease];
+	[attempts removeObjectIdenticalTo: attempt];
+
+	if ((error = [attempt OF_finishConnect]) == 0) {
+		[self didConnectAttempt: attempt];
+		return;
+	}
+
+	errNo = error;
+
+	/*
+	 * Like RFC 8305, start the next attempt as soon as one failed instead
+	 * of waiting for the delay. Once there are no more candidates, this
+	 * fails if nothing is in progress anymore.
+	 */
+	if (nextCandidate < [candidates count] || [attempts count] == 0)
+		[self startNextAttempt];
 }
 
-- (id)main
+- (void)cancelAttempts
+{
+	OFTCPSocket **objects = (OFTCPSocket**)[attempts objects];
+	size_t i, count = [attempts count];
+
+	done = YES;
+
+	/*
+	 * The timers retain us as their target until they are deallocated, so
+	 * keeping them would be a retain cycle.
+	 */
+	[attemptTimer invalidate];
+	[attemptTimer release];
+	attemptTimer = nil;
+	[timeoutTimer invalidate];
+	[timeoutTimer release];
+	timeoutTimer = nil;
+
+	for (i = 0; i < count; i++) {
+		[OFRunLoop OF_removeAsyncConnectForTCPSocket: objects[i]];
+		[objects[i] close];
+	}
+
+	[attempts removeAllObjects];
+}
+
+- (void)didConnectAttempt: (OFTCPSocket*)attempt
+{
+	[self cancelAttempts];
+
+	@try {
+		[sock OF_takeOverConnectionOfSocket: attempt];
+	} @catch (OFException *e) {
+		exception = [e retain];
+		[self didConnect];
+		return;
+	}
+
+	/*
+	 * The SOCKS5 handshake still blocks, so it is done by one of the
+	 * resolver's threads.
+	 */
+	if (SOCKS5Host != nil)
+		[[[OFResolver sharedResolver] OF_threadPool]
+		    dispatchWithTarget: self
+			      selector: @selector(performSOCKS5Handshake)
+				object: nil];
+	else
+		[self didConnect];
+}
+
+- (void)failWithErrNo: (int)errNo_
+{
+	SET_SOCK_ERRNO(errNo_);
+
+	[self failWithException: [OFConnectionFailedException
+	    exceptionWithClass: [sock class]
+			socket: sock
+			  host: (SOCKS5Host != nil ? SOCKS5Host : host)
+			  port: (SOCKS5Host != nil ? SOCKS5Port : port)]];
+}
+
+- (void)failWithException: (OFException*)exception_
+{
+	[self cancelAttempts];
+
+	exception = [exception_ retain];
+	[self didConnect];
+}
+
+- (void)timeout
+{
+	if (!done)
+		[self failWithErrNo: ETIMEDOUT];
+}
+
+- (void)performSOCKS5Handshake
 {
 	void *pool = objc_autoreleasePoolPush();
 
 	@try {
-		[sock connectToHost: host
-			       port: port];
+		[sock OF_SOCKS5ConnectToHost: host
+					port: port];
 	} @catch (OFException *e) {
-		exception = [[e retain] autorelease];
+		exception = [e retain];
 	}
 
 	[self performSelector: @selector(didConnect)
@@ -209,8 +471,31 @@ static uint16_t defaultSOCKS5Port = 1080;
 		waitUntilDone: NO];
 
 	objc_autoreleasePoolPop(pool);
+}
 
-	return nil;
+- (void)didConnect
+{
+#ifdef OF_HAVE_BLOCKS
+	if (connectBlock != NULL)
+		connectBlock(sock, exception);
+	else {
+#endif
+		void (*func)(id, SEL, OFTCPSocket*, id, OFException*) =
+		    (void(*)(id, SEL, OFTCPSocket*, id, OFException*))[target
+		    methodForSelector: selector];
+
+		func(target, selector, sock, context, exception);
+#ifdef OF_HAVE_BLOCKS
+	}
+#endif
+
+	/* An invalidated timer might still keep us around for a while */
+	[sock release];
+	sock = nil;
+	[target release];
+	target = nil;
+	[context release];
+	context = nil;
 }
 @end
 
@@ -251,9 +536,10 @@ static uint16_t defaultSOCKS5Port = 1080;
 
 	@try {
 		sock = INVALID_SOCKET;
-		sockAddr = NULL;
 		SOCKS5Host = [defaultSOCKS5Host copy];
 		SOCKS5Port = defaultSOCKS5Port;
+		connectionAttemptDelay = 0.25;
+		acceptBatchLimit = 16;
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -289,138 +575,198 @@ static uint16_t defaultSOCKS5Port = 1080;
 	return SOCKS5Port;
 }
 
-- (void)connectToHost: (OFString*)host
-		 port: (uint16_t)port
+- (void)setConnectTimeout: (double)connectTimeout_
 {
-	OFString *destinationHost = host;
-	uint16_t destinationPort = port;
+	connectTimeout = connectTimeout_;
+}
+
+- (double)connectTimeout
+{
+	return connectTimeout;
+}
+
+- (void)setConnectionAttemptDelay: (double)connectionAttemptDelay_
+{
+	connectionAttemptDelay = connectionAttemptDelay_;
+}
+
+- (double)connectionAttemptDelay
+{
+	return connectionAttemptDelay;
+}
+
+/*
+ * Returns 0 if the socket connected right away and CONNECT_IN_PROGRESS if
+ * connecting is in progress. Otherwise, the error is returned.
+ */
+- (int)OF_startConnectToAddress: (const of_resolver_address_t*)address
+{
+	int errNo;
+
+	if ((sock = socket(address->address.ss_family, SOCK_STREAM,
+	    0)) == INVALID_SOCKET)
+		return GET_SOCK_ERRNO;
+
+	@try {
+		[self setBlocking: NO];
+	} @catch (OFSetOptionFailedException *e) {
+		errNo = GET_SOCK_ERRNO;
+		close(sock);
+		sock = INVALID_SOCKET;
+		return errNo;
+	}
+
+	if (connect(sock, (struct sockaddr*)&address->address,
+	    address->length) == 0) {
+		[self setBlocking: YES];
+		return 0;
+	}
+
+	if ((errNo = GET_SOCK_ERRNO) != CONNECT_IN_PROGRESS) {
+		close(sock);
+		sock = INVALID_SOCKET;
+	}
+
+	return errNo;
+}
+
+/*
+ * Must be called once the socket became writable after connecting was in
+ * progress. Returns 0 if connecting succeeded and the error otherwise.
+ */
+- (int)OF_finishConnect
+{
+	int errNo;
+	socklen_t len = sizeof(errNo);
+
+	if (getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&errNo, &len))
+		errNo = GET_SOCK_ERRNO;
+
+	if (errNo == 0) {
+		@try {
+			[self setBlocking: YES];
+		} @catch (OFSetOptionFailedException *e) {
+			errNo = GET_SOCK_ERRNO;
+		}
+	}
+
+	if (errNo != 0) {
+		close(sock);
+		sock = INVALID_SOCKET;
+	}
+
+	return errNo;
+}
+
+- (void)OF_connectToAddresses: (OFDataArray*)addresses
+			 host: (OFString*)host
+			 port: (uint16_t)port
+		     deadline: (uint64_t)deadline
+{
+	of_resolver_address_t *addressItems = [addresses cArray];
+	size_t i, count = [addresses count];
+	int errNo = 0;
 
 	if (sock != INVALID_SOCKET)
 		@throw [OFAlreadyConnectedException
 		    exceptionWithClass: [self class]
 				socket: self];
 
-	if (SOCKS5Host != nil) {
-		/* Connect to the SOCKS5 proxy instead */
-		host = SOCKS5Host;
-		port = SOCKS5Port;
-	}
+	for (i = 0; i < count; i++) {
+		of_resolver_address_t address = addressItems[i];
+		double timeout = -1;
 
-#ifdef HAVE_THREADSAFE_GETADDRINFO
-	struct addrinfo hints, *res, *res0;
-	char portCString[7];
+		set_port(&address, port);
 
-	memset(&hints, 0, sizeof(struct addrinfo));
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-	snprintf(portCString, 7, "%" PRIu16, port);
+		if (deadline != OF_DEADLINE_NEVER &&
+		    (timeout = of_deadline_remaining(deadline,
+		    of_monotonic_time())) <= 0) {
+			errNo = ETIMEDOUT;
+			break;
+		}
 
-	if (getaddrinfo([host cStringWithEncoding: OF_STRING_ENCODING_NATIVE],
-	    portCString, &hints, &res0))
-		@throw [OFAddressTranslationFailedException
-		    exceptionWithClass: [self class]
-				socket: self
-				  host: host];
+		if ((errNo = [self OF_startConnectToAddress: &address]) !=
+		    CONNECT_IN_PROGRESS) {
+			if (errNo == 0)
+				break;
 
-	for (res = res0; res != NULL; res = res->ai_next) {
-		if ((sock = socket(res->ai_family, res->ai_socktype,
-		    res->ai_protocol)) == INVALID_SOCKET)
 			continue;
+		}
 
-		if (connect(sock, res->ai_addr, res->ai_addrlen) == -1) {
+		if (wait_until_writable(sock, timeout)) {
+			if ((errNo = [self OF_finishConnect]) == 0)
+				break;
+		} else {
 			close(sock);
 			sock = INVALID_SOCKET;
-			continue;
+			errNo = ETIMEDOUT;
+			break;
 		}
-
-		break;
 	}
 
-	freeaddrinfo(res0);
-#else
-	BOOL connected = NO;
-	struct hostent *he;
-	struct sockaddr_in addr;
-	char **ip;
-# ifdef OF_THREADS
-	OFDataArray *addrlist;
-
-	addrlist = [[OFDataArray alloc] initWithItemSize: sizeof(char**)];
-	[mutex lock];
-# endif
-
-	if ((he = gethostbyname([host cStringWithEncoding:
-	    OF_STRING_ENCODING_NATIVE])) == NULL) {
-# ifdef OF_THREADS
-		[addrlist release];
-		[mutex unlock];
-# endif
-		@throw [OFAddressTranslationFailedException
+	if (sock == INVALID_SOCKET) {
+		SET_SOCK_ERRNO(errNo);
+		@throw [OFConnectionFailedException
 		    exceptionWithClass: [self class]
 				socket: self
-				  host: host];
+				  host: host
+				  port: port];
 	}
+}
 
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_port = OF_BSWAP16_IF_LE(port);
-
-	if (he->h_addrtype != AF_INET ||
-	    (sock = socket(AF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET) {
-# ifdef OF_THREADS
-		[addrlist release];
-		[mutex unlock];
-# endif
-		@throw [OFConnectionFailedException
+- (void)OF_takeOverConnectionOfSocket: (OFTCPSocket*)socket
+{
+	if (sock != INVALID_SOCKET)
+		@throw [OFAlreadyConnectedException
 		    exceptionWithClass: [self class]
-				socket: self
-								  host: host
-								  port: port];
-	}
+				socket: self];
 
-# ifdef OF_THREADS
-	@try {
-		for (ip = he->h_addr_list; *ip != NULL; ip++)
-			[addrlist addItem: ip];
+	sock = socket->sock;
+	socket->sock = INVALID_SOCKET;
+}
 
-		/* Add the terminating NULL */
-		[addrlist addItem: ip];
-	} @catch (id e) {
-		[addrlist release];
-		@throw e;
-	} @finally {
-		[mutex unlock];
-	}
+- (void)connectToHost: (OFString*)host
+		 port: (uint16_t)port
+{
+	void *pool;
+	OFString *destinationHost = host;
+	uint16_t destinationPort = port;
+	uint64_t deadline = OF_DEADLINE_NEVER;
+	OFDataArray *addresses;
 
-	for (ip = [addrlist cArray]; *ip != NULL; ip++) {
-# else
-	for (ip = he->h_addr_list; *ip != NULL; ip++) {
-# endif
-		memcpy(&addr.sin_addr.s_addr, *ip, he->h_length);
+	if (sock != INVALID_SOCKET)
+		@throw [OFAlreadyConnectedException
+		    exceptionWithClass: [self class]
+				socket: self];
 
-		if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1)
-			continue;
+	if (connectTimeout > 0)
+		deadline = of_deadline_after(of_monotonic_time(),
+		    connectTimeout);
 
-		connected = YES;
-		break;
+	if (SOCKS5Host != nil) {
+		/* Connect to the SOCKS5 proxy instead */
+		host = SOCKS5Host;
+		port = SOCKS5Port;
 	}
 
-# ifdef OF_THREADS
-	[addrlist release];
-# endif
+	pool = objc_autoreleasePoolPush();
 
-	if (!connected) {
-		close(sock);
-		sock = INVALID_SOCKET;
-	}
-#endif
-
-	if (sock == INVALID_SOCKET)
-		@throw [OFConnectionFailedException
+	@try {
+		addresses = [[OFResolver sharedResolver]
+		    addressesForHost: host];
+	} @catch (OFAddressTranslationFailedException *e) {
+		@throw [OFAddressTranslationFailedException
 		    exceptionWithClass: [self class]
 				socket: self
-				  host: host
-				  port: port];
+				  host: host];
+	}
+
+	[self OF_connectToAddresses: addresses
+			       host: host
+			       port: port
+			   deadline: deadline];
+
+	objc_autoreleasePoolPop(pool);
 
 	if (SOCKS5Host != nil)
 		[self OF_SOCKS5ConnectToHost: destinationHost
@@ -434,15 +780,22 @@ static uint16_t defaultSOCKS5Port = 1080;
 		   context: (id)context
 {
 	void *pool = objc_autoreleasePoolPush();
-
-	[[[[OFTCPSocket_ConnectThread alloc]
-	    initWithSourceThread: [OFThread currentThread]
-			  socket: self
-			    host: host
-			    port: port
-			  target: target
-			selector: selector
-			 context: context] autorelease] start];
+	OFTCPSocket_AsyncConnectRequest *request =
+	    [[[OFTCPSocket_AsyncConnectRequest alloc] init] autorelease];
+
+	request->sourceThread = [[OFThread currentThread] retain];
+	request->sock = [self retain];
+	request->host = [host copy];
+	request->port = port;
+	request->SOCKS5Host = [SOCKS5Host copy];
+	request->SOCKS5Port = SOCKS5Port;
+	request->connectTimeout = connectTimeout;
+	request->connectionAttemptDelay = connectionAttemptDelay;
+	request->target = [target retain];
+	request->selector = selector;
+	request->context = [context retain];
+
+	[request start];
 
 	objc_autoreleasePoolPop(pool);
 }
@@ -453,13 +806,20 @@ static uint16_t defaultSOCKS5Port = 1080;
 		     block: (of_tcpsocket_async_connect_block_t)block
 {
 	void *pool = objc_autoreleasePoolPush();
+	OFTCPSocket_AsyncConnectRequest *request =
+	    [[[OFTCPSocket_AsyncConnectRequest alloc] init] autorelease];
+
+	request->sourceThread = [[OFThread currentThread] retain];
+	request->sock = [self retain];
+	request->host = [host copy];
+	request->port = port;
+	request->SOCKS5Host = [SOCKS5Host copy];
+	request->SOCKS5Port = SOCKS5Port;
+	request->connectTimeout = connectTimeout;
+	request->connectionAttemptDelay = connectionAttemptDelay;
+	request->connectBlock = [block copy];
 
-	[[[[OFTCPSocket_ConnectThread alloc]
-	    initWithSourceThread: [OFThread currentThread]
-			  socket: self
-			    host: host
-			    port: port
-			   block: block] autorelease] start];
+	[request start];
 
 	objc_autoreleasePoolPop(pool);
 }
@@ -474,6 +834,9 @@ static uint16_t defaultSOCKS5Port = 1080;
 		struct sockaddr_in6 in6;
 	} addr;
 	socklen_t addrLen;
+	void *pool;
+	OFDataArray *addresses;
+	of_resolver_address_t address;
 
 	if (sock != INVALID_SOCKET)
 		@throw [OFAlreadyConnectedException
@@ -485,83 +848,47 @@ static uint16_t defaultSOCKS5Port = 1080;
 		    exceptionWithClass: [self class]
 			      selector: _cmd];
 
-#ifdef HAVE_THREADSAFE_GETADDRINFO
-	struct addrinfo hints, *res;
-	char portCString[7];
-
-	memset(&hints, 0, sizeof(struct addrinfo));
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-	snprintf(portCString, 7, "%" PRIu16, port);
+	pool = objc_autoreleasePoolPush();
 
-	if (getaddrinfo([host cStringWithEncoding: OF_STRING_ENCODING_NATIVE],
-	    portCString, &hints, &res))
+	@try {
+		addresses = [[OFResolver sharedResolver]
+		    addressesForHost: host];
+	} @catch (OFAddressTranslationFailedException *e) {
 		@throw [OFAddressTranslationFailedException
 		    exceptionWithClass: [self class]
 				socket: self
 				  host: host];
+	}
 
-	if ((sock = socket(res->ai_family, SOCK_STREAM, 0)) == INVALID_SOCKET)
-		@throw [OFBindFailedException exceptionWithClass: [self class]
-							  socket: self
-							    host: host
-							    port: port];
+	address = *(of_resolver_address_t*)[addresses firstItem];
+	set_port(&address, port);
 
-	if (bind(sock, res->ai_addr, res->ai_addrlen) == -1) {
-		freeaddrinfo(res);
-		close(sock);
-		sock = INVALID_SOCKET;
+	objc_autoreleasePoolPop(pool);
+
+	if ((sock = socket(address.address.ss_family, SOCK_STREAM,
+	    0)) == INVALID_SOCKET)
 		@throw [OFBindFailedException exceptionWithClass: [self class]
 							  socket: self
 							    host: host
 							    port: port];
-	}
-
-	freeaddrinfo(res);
-#else
-	struct hostent *he;
-
-# ifdef OF_THREADS
-	[mutex lock];
-# endif
-
-	if ((he = gethostbyname([host cStringWithEncoding:
-	    OF_STRING_ENCODING_NATIVE])) == NULL) {
-# ifdef OF_THREADS
-		[mutex unlock];
-# endif
-		@throw [OFAddressTranslationFailedException
-		    exceptionWithClass: [self class]
-				socket: self
-				  host: host];
-	}
 
-	memset(&addr, 0, sizeof(addr));
-	addr.in.sin_family = AF_INET;
-	addr.in.sin_port = OF_BSWAP16_IF_LE(port);
+#ifdef SO_REUSEPORT
+	if (reusesPort) {
+		int v = 1;
 
-	if (he->h_addrtype != AF_INET || he->h_addr_list[0] == NULL) {
-# ifdef OF_THREADS
-		[mutex unlock];
-# endif
-		@throw [OFAddressTranslationFailedException
-		    exceptionWithClass: [self class]
-				socket: self
-				  host: host];
+		if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char*)&v,
+		    sizeof(v))) {
+			close(sock);
+			sock = INVALID_SOCKET;
+			@throw [OFSetOptionFailedException
+			    exceptionWithClass: [self class]
+					stream: self];
+		}
 	}
+#endif
 
-	memcpy(&addr.in.sin_addr.s_addr, he->h_addr_list[0], he->h_length);
-
-# ifdef OF_THREADS
-	[mutex unlock];
-# endif
-	if ((sock = socket(AF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET)
-		@throw [OFBindFailedException exceptionWithClass: [self class]
-							  socket: self
-							    host: host
-							    port: port];
-
-	if (bind(sock, (struct sockaddr*)&addr.in, sizeof(addr.in)) == -1) {
+	if (bind(sock, (struct sockaddr*)&address.address,
+	    address.length) == -1) {
 		close(sock);
 		sock = INVALID_SOCKET;
 		@throw [OFBindFailedException exceptionWithClass: [self class]
@@ -569,7 +896,6 @@ static uint16_t defaultSOCKS5Port = 1080;
 							    host: host
 							    port: port];
 	}
-#endif
 
 	if (port > 0)
 		return port;
@@ -603,6 +929,19 @@ static uint16_t defaultSOCKS5Port = 1080;
 		@throw [OFNotConnectedException exceptionWithClass: [self class]
 							    socket: self];
 
+#ifdef TCP_FASTOPEN
+	if (fastOpenQueueLength > 0)
+		[self OF_setSocketOption: TCP_FASTOPEN
+				   level: IPPROTO_TCP
+				   value: fastOpenQueueLength];
+#endif
+#ifdef TCP_DEFER_ACCEPT
+	if (deferredAcceptTimeout > 0)
+		[self OF_setSocketOption: TCP_DEFER_ACCEPT
+				   level: IPPROTO_TCP
+				   value: (int)ceil(deferredAcceptTimeout)];
+#endif
+
 	if (listen(sock, backLog) == -1)
 		@throw [OFListenFailedException exceptionWithClass: [self class]
 							    socket: self
@@ -613,45 +952,29 @@ static uint16_t defaultSOCKS5Port = 1080;
 
 - (void)listen
 {
-	if (sock == INVALID_SOCKET)
-		@throw [OFNotConnectedException exceptionWithClass: [self class]
-							    socket: self];
-
-	if (listen(sock, 5) == -1)
-		@throw [OFListenFailedException exceptionWithClass: [self class]
-							    socket: self
-							   backLog: 5];
-
-	listening = YES;
+	[self listenWithBackLog: 5];
 }
 
 - (OFTCPSocket*)accept
 {
 	OFTCPSocket *newSocket;
-	struct sockaddr_storage *addr;
-	socklen_t addrLen;
-	int newSock;
 
-	newSocket = [[[[self class] alloc] init] autorelease];
-	addrLen = sizeof(*addr);
+	/* The run loop might have made the socket non-blocking */
+	if (acceptQueueNonBlocking) {
+		if (blocking && !set_socket_nonblocking(sock, NO))
+			@throw [OFSetOptionFailedException
+			    exceptionWithClass: [self class]
+					stream: self];
 
-	@try {
-		addr = [newSocket allocMemoryWithSize: addrLen];
-	} @catch (id e) {
-		[newSocket release];
-		@throw e;
+		acceptQueueNonBlocking = NO;
 	}
 
-	if ((newSock = accept(sock, (struct sockaddr*)addr,
-	    &addrLen)) == INVALID_SOCKET) {
-		[newSocket release];
+	newSocket = [self OF_acceptIfPending];
+
+	/* Only happens if the socket has been set to non-blocking */
+	if (newSocket == nil)
 		@throw [OFAcceptFailedException exceptionWithClass: [self class]
 							    socket: self];
-	}
-
-	newSocket->sock = newSock;
-	newSocket->sockAddr = addr;
-	newSocket->sockAddrLen = addrLen;
 
 	return newSocket;
 }
@@ -660,6 +983,8 @@ static uint16_t defaultSOCKS5Port = 1080;
 		     selector: (SEL)selector
 		      context: (id)context
 {
+	[self OF_setAcceptQueueNonBlocking];
+
 	[OFRunLoop OF_addAsyncAcceptForTCPSocket: self
 					  target: target
 					selector: selector
@@ -669,26 +994,173 @@ static uint16_t defaultSOCKS5Port = 1080;
 #ifdef OF_HAVE_BLOCKS
 - (void)asyncAcceptWithBlock: (of_tcpsocket_async_accept_block_t)block
 {
+	[self OF_setAcceptQueueNonBlocking];
+
 	[OFRunLoop OF_addAsyncAcceptForTCPSocket: self
 					   block: block];
 }
 #endif
 
+- (void)asyncAcceptBatchWithTarget: (id)target
+			  selector: (SEL)selector
+			   context: (id)context
+{
+	[self OF_setAcceptQueueNonBlocking];
+
+	[OFRunLoop OF_addAsyncAcceptBatchForTCPSocket: self
+					       target: target
+					     selector: selector
+					      context: context];
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)asyncAcceptBatchWithBlock:
+    (of_tcpsocket_async_accept_batch_block_t)block
+{
+	[self OF_setAcceptQueueNonBlocking];
+
+	[OFRunLoop OF_addAsyncAcceptBatchForTCPSocket: self
+						block: block];
+}
+#endif
+
+- (void)setAcceptBatchLimit: (size_t)acceptBatchLimit_
+{
+	if (acceptBatchLimit_ == 0)
+		@throw [OFInvalidArgumentException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+
+	acceptBatchLimit = acceptBatchLimit_;
+}
+
+- (size_t)acceptBatchLimit
+{
+	return acceptBatchLimit;
+}
+
 - (void)setKeepAlivesEnabled: (BOOL)enable
 {
-	int v = enable;
+	[self OF_setSocketOption: SO_KEEPALIVE
+			   level: SOL_SOCKET
+			   value: enable];
+}
 
-	if (setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (char*)&v, sizeof(v)))
+- (void)setNoDelayEnabled: (BOOL)enable
+{
+	[self OF_setSocketOption: TCP_NODELAY
+			   level: IPPROTO_TCP
+			   value: enable];
+}
+
+- (BOOL)isNoDelayEnabled
+{
+	return ([self OF_socketOption: TCP_NODELAY
+				level: IPPROTO_TCP] != 0);
+}
+
+- (void)setCorkEnabled: (BOOL)enable
+{
+#if defined(TCP_CORK)
+	[self OF_setSocketOption: TCP_CORK
+			   level: IPPROTO_TCP
+			   value: enable];
+#elif defined(TCP_NOPUSH)
+	[self OF_setSocketOption: TCP_NOPUSH
+			   level: IPPROTO_TCP
+			   value: enable];
+
+	/* Unlike TCP_CORK, clearing TCP_NOPUSH does not send pending data */
+	if (!enable && send(sock, "", 0, 0) == -1)
 		@throw [OFSetOptionFailedException
 		    exceptionWithClass: [self class]
 				stream: self];
+#else
+	@throw [OFNotImplementedException exceptionWithClass: [self class]
+						    selector: _cmd];
+#endif
+}
+
+- (BOOL)isCorkEnabled
+{
+#if defined(TCP_CORK)
+	return ([self OF_socketOption: TCP_CORK
+				level: IPPROTO_TCP] != 0);
+#elif defined(TCP_NOPUSH)
+	return ([self OF_socketOption: TCP_NOPUSH
+				level: IPPROTO_TCP] != 0);
+#else
+	@throw [OFNotImplementedException exceptionWithClass: [self class]
+						    selector: _cmd];
+#endif
+}
+
+- (void)setReusesPort: (BOOL)reusesPort_
+{
+#ifdef SO_REUSEPORT
+	reusesPort = reusesPort_;
+#else
+	if (reusesPort_)
+		@throw [OFNotImplementedException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+#endif
+}
+
+- (BOOL)reusesPort
+{
+	return reusesPort;
+}
+
+- (void)setFastOpenQueueLength: (int)fastOpenQueueLength_
+{
+	if (fastOpenQueueLength_ < 0)
+		@throw [OFInvalidArgumentException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+
+#ifdef TCP_FASTOPEN
+	fastOpenQueueLength = fastOpenQueueLength_;
+#else
+	if (fastOpenQueueLength_ > 0)
+		@throw [OFNotImplementedException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+#endif
+}
+
+- (int)fastOpenQueueLength
+{
+	return fastOpenQueueLength;
+}
+
+- (void)setDeferredAcceptTimeout: (double)deferredAcceptTimeout_
+{
+	if (!(deferredAcceptTimeout_ >= 0) || deferredAcceptTimeout_ > INT_MAX)
+		@throw [OFInvalidArgumentException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+
+#ifdef TCP_DEFER_ACCEPT
+	deferredAcceptTimeout = deferredAcceptTimeout_;
+#else
+	if (deferredAcceptTimeout_ > 0)
+		@throw [OFNotImplementedException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+#endif
+}
+
+- (double)deferredAcceptTimeout
+{
+	return deferredAcceptTimeout;
 }
 
 - (OFString*)remoteAddress
 {
 	char *host;
 
-	if (sockAddr == NULL || sockAddrLen == 0)
+	if (sockAddrLen == 0)
 		@throw [OFInvalidArgumentException
 		    exceptionWithClass: [self class]
 			      selector: _cmd];
@@ -697,7 +1169,7 @@ static uint16_t defaultSOCKS5Port = 1080;
 	host = [self allocMemoryWithSize: NI_MAXHOST];
 
 	@try {
-		if (getnameinfo((struct sockaddr*)sockAddr, sockAddrLen, host,
+		if (getnameinfo((struct sockaddr*)&sockAddr, sockAddrLen, host,
 		    NI_MAXHOST, NULL, 0, NI_NUMERICHOST))
 			@throw [OFAddressTranslationFailedException
 			    exceptionWithClass: [self class]];
@@ -713,7 +1185,7 @@ static uint16_t defaultSOCKS5Port = 1080;
 
 	@try {
 # endif
-		host = inet_ntoa(((struct sockaddr_in*)sockAddr)->sin_addr);
+		host = inet_ntoa(((struct sockaddr_in*)&sockAddr)->sin_addr);
 
 		if (host == NULL)
 			@throw [OFAddressTranslationFailedException
@@ -742,8 +1214,92 @@ static uint16_t defaultSOCKS5Port = 1080;
 	[super close];
 
 	listening = NO;
-	[self freeMemory: sockAddr];
-	sockAddr = NULL;
+	acceptQueueNonBlocking = NO;
 	sockAddrLen = 0;
 }
+
+- (void)setBlocking: (BOOL)enable
+{
+	[super setBlocking: enable];
+
+	/* The mode set for the run loop has been overridden */
+	acceptQueueNonBlocking = NO;
+}
+
+- (void)OF_setAcceptQueueNonBlocking
+{
+	if (acceptQueueNonBlocking)
+		return;
+
+	if (sock == INVALID_SOCKET)
+		@throw [OFNotConnectedException exceptionWithClass: [self class]
+							    socket: self];
+
+	/*
+	 * Done only once, so that draining the accept queue on each wakeup
+	 * does not need to switch the mode back and forth.
+	 */
+	if (blocking && !set_socket_nonblocking(sock, YES))
+		@throw [OFSetOptionFailedException
+		    exceptionWithClass: [self class]
+				stream: self];
+
+	acceptQueueNonBlocking = YES;
+}
+
+- (OFTCPSocket*)OF_acceptIfPending
+{
+	OFTCPSocket *newSocket;
+	struct sockaddr_storage addr;
+	socklen_t addrLen = sizeof(addr);
+	int newSock;
+
+	if (sock == INVALID_SOCKET)
+		@throw [OFNotConnectedException exceptionWithClass: [self class]
+							    socket: self];
+
+#ifdef USE_ACCEPT4
+	/* Sets the mode and close-on-exec atomically */
+	newSock = accept4(sock, (struct sockaddr*)&addr, &addrLen,
+	    SOCK_CLOEXEC | (blocking ? 0 : SOCK_NONBLOCK));
+#else
+	newSock = accept(sock, (struct sockaddr*)&addr, &addrLen);
+#endif
+
+	if (newSock == INVALID_SOCKET) {
+		if (WOULD_BLOCK(GET_SOCK_ERRNO))
+			return nil;
+
+		@throw [OFAcceptFailedException exceptionWithClass: [self class]
+							    socket: self];
+	}
+
+	/* Only wrap the socket once there is one, as most drains end empty */
+	@try {
+		newSocket = [[[[self class] alloc] init] autorelease];
+	} @catch (id e) {
+		close(newSock);
+		@throw e;
+	}
+
+	newSocket->sock = newSock;
+	memcpy(&newSocket->sockAddr, &addr, addrLen);
+	newSocket->sockAddrLen = addrLen;
+
+#ifdef USE_ACCEPT4
+	newSocket->blocking = blocking;
+#else
+# if !defined(_WIN32) && defined(FD_CLOEXEC)
+	fcntl(newSock, F_SETFD, FD_CLOEXEC);
+# endif
+
+	/*
+	 * Some systems let accepted sockets inherit O_NONBLOCK, which is set
+	 * while the run loop accepts asynchronously.
+	 */
+	[newSocket setBlocking: blocking];
+#endif
+
+	return newSocket;
+}
 @end
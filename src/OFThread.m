@@ -82,9 +82,9 @@ call_main(id object)
 	[OFTLSKey OF_callAllDestructors];
 #ifdef OF_OBJFW_RUNTIME
 	/*
-	 * As the values returned by objc_autoreleasePoolPush() in the ObjFW
-	 * runtime are not actually pointers, but sequential numbers, 0 means
-	 * we pop everything.
+	 * As objc_autoreleasePoolPush() in the ObjFW runtime never returns
+	 * NULL, popping NULL pops everything and frees the pool pages of the
+	 * thread.
 	 */
 	objc_autoreleasePoolPop(0);
 #endif
@@ -219,9 +219,9 @@ call_main(id object)
 	[OFTLSKey OF_callAllDestructors];
 #ifdef OF_OBJFW_RUNTIME
 	/*
-	 * As the values returned by objc_autoreleasePoolPush() in the ObjFW
-	 * runtime are not actually pointers, but sequential numbers, 0 means
-	 * we pop everything.
+	 * As objc_autoreleasePoolPush() in the ObjFW runtime never returns
+	 * NULL, popping NULL pops everything and frees the pool pages of the
+	 * thread.
 	 */
 	objc_autoreleasePoolPop(0);
 #endif
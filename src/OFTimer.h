@@ -29,7 +29,7 @@ typedef void (^of_timer_block_t)(OFTimer*);
  */
 @interface OFTimer: OFObject <OFComparing>
 {
-	OFDate *fireDate;
+	uint64_t fireDeadline;
 	double interval;
 	id target, object1, object2;
 	SEL selector;
@@ -43,7 +43,8 @@ typedef void (^of_timer_block_t)(OFTimer*);
 }
 
 #ifdef OF_HAVE_PROPERTIES
-@property (readonly, retain) OFDate *fireDate;
+@property (readonly) OFDate *fireDate;
+@property (readonly) uint64_t fireDeadline;
 #endif
 
 /*!
@@ -275,6 +276,17 @@ typedef void (^of_timer_block_t)(OFTimer*);
  */
 - (OFDate*)fireDate;
 
+/*!
+ * @brief Returns the next time at which the timer will fire as a time
+ *	  comparable to of_monotonic_time().
+ *
+ * Unlike the date returned by @ref fireDate, this is not affected by changes
+ * of the system time and does not require creating an object.
+ *
+ * @return The next time at which the timer will fire
+ */
+- (uint64_t)fireDeadline;
+
 /*!
  * @brief Invalidates the timer, preventing it from firing.
  */
@@ -26,6 +26,34 @@
 
 #import "autorelease.h"
 #import "macros.h"
+#import "of_clock.h"
+
+static uint64_t
+deadline_from_date(OFDate *date)
+{
+	if (date == nil)
+		return of_monotonic_time();
+
+	return of_deadline_after(of_monotonic_time(),
+	    [date timeIntervalSinceNow]);
+}
+
+@interface OFTimer (OF_PrivateMethods)
+- OF_initWithFireDeadline: (uint64_t)fireDeadline
+		 interval: (double)interval
+		   target: (id)target
+		 selector: (SEL)selector
+		   object: (id)object1
+		   object: (id)object2
+		arguments: (uint8_t)arguments
+		  repeats: (BOOL)repeats;
+#ifdef OF_HAVE_BLOCKS
+- OF_initWithFireDeadline: (uint64_t)fireDeadline
+		 interval: (double)interval
+		  repeats: (BOOL)repeats
+		    block: (of_timer_block_t)block;
+#endif
+@end
 
 @implementation OFTimer
 + (instancetype)scheduledTimerWithTimeInterval: (double)interval
@@ -34,12 +62,16 @@
 				       repeats: (BOOL)repeats
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					    target: target
-					  selector: selector
-					   repeats: repeats] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			     target: target
+			   selector: selector
+			     object: nil
+			     object: nil
+			  arguments: 0
+			    repeats: repeats] autorelease];
 
 	[[OFRunLoop currentRunLoop] addTimer: timer];
 
@@ -56,13 +88,16 @@
 				       repeats: (BOOL)repeats
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					    target: target
-					  selector: selector
-					    object: object
-					   repeats: repeats] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			     target: target
+			   selector: selector
+			     object: object
+			     object: nil
+			  arguments: 1
+			    repeats: repeats] autorelease];
 
 	[[OFRunLoop currentRunLoop] addTimer: timer];
 
@@ -80,14 +115,16 @@
 				       repeats: (BOOL)repeats
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					    target: target
-					  selector: selector
-					    object: object1
-					    object: object2
-					   repeats: repeats] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			     target: target
+			   selector: selector
+			     object: object1
+			     object: object2
+			  arguments: 2
+			    repeats: repeats] autorelease];
 
 	[[OFRunLoop currentRunLoop] addTimer: timer];
 
@@ -103,11 +140,12 @@
 					 block: (of_timer_block_t)block
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					   repeats: repeats
-					     block: block] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			    repeats: repeats
+			      block: block] autorelease];
 
 	[[OFRunLoop currentRunLoop] addTimer: timer];
 
@@ -124,12 +162,16 @@
 			      repeats: (BOOL)repeats
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					    target: target
-					  selector: selector
-					   repeats: repeats] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			     target: target
+			   selector: selector
+			     object: nil
+			     object: nil
+			  arguments: 0
+			    repeats: repeats] autorelease];
 
 	[timer retain];
 	objc_autoreleasePoolPop(pool);
@@ -144,13 +186,16 @@
 			      repeats: (BOOL)repeats
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					    target: target
-					  selector: selector
-					    object: object
-					   repeats: repeats] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			     target: target
+			   selector: selector
+			     object: object
+			     object: nil
+			  arguments: 1
+			    repeats: repeats] autorelease];
 
 	[timer retain];
 	objc_autoreleasePoolPop(pool);
@@ -166,14 +211,16 @@
 			      repeats: (BOOL)repeats
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					    target: target
-					  selector: selector
-					    object: object1
-					    object: object2
-					   repeats: repeats] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			     target: target
+			   selector: selector
+			     object: object1
+			     object: object2
+			  arguments: 2
+			    repeats: repeats] autorelease];
 
 	[timer retain];
 	objc_autoreleasePoolPop(pool);
@@ -187,11 +234,12 @@
 				block: (of_timer_block_t)block
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFDate *fireDate = [OFDate dateWithTimeIntervalSinceNow: interval];
-	id timer = [[[self alloc] initWithFireDate: fireDate
-					  interval: interval
-					   repeats: repeats
-					     block: block] autorelease];
+	id timer = [[[self alloc]
+	    OF_initWithFireDeadline: of_deadline_after(of_monotonic_time(),
+					 interval)
+			   interval: interval
+			    repeats: repeats
+			      block: block] autorelease];
 
 	[timer retain];
 	objc_autoreleasePoolPop(pool);
@@ -208,19 +256,19 @@
 						    selector: _cmd];
 }
 
-- OF_initWithFireDate: (OFDate*)fireDate_
-	     interval: (double)interval_
-	       target: (id)target_
-	     selector: (SEL)selector_
-	       object: (id)object1_
-	       object: (id)object2_
-	    arguments: (uint8_t)arguments_
-	      repeats: (BOOL)repeats_
+- OF_initWithFireDeadline: (uint64_t)fireDeadline_
+		 interval: (double)interval_
+		   target: (id)target_
+		 selector: (SEL)selector_
+		   object: (id)object1_
+		   object: (id)object2_
+		arguments: (uint8_t)arguments_
+		  repeats: (BOOL)repeats_
 {
 	self = [super init];
 
 	@try {
-		fireDate = [fireDate_ retain];
+		fireDeadline = fireDeadline_;
 		interval = interval_;
 		target = [target_ retain];
 		selector = selector_;
@@ -244,14 +292,14 @@
 	  selector: (SEL)selector_
 	   repeats: (BOOL)repeats_
 {
-	return [self OF_initWithFireDate: fireDate_
-				interval: interval_
-				  target: target_
-				selector: selector_
-				  object: nil
-				  object: nil
-			       arguments: 0
-				 repeats: repeats_];
+	return [self OF_initWithFireDeadline: deadline_from_date(fireDate_)
+				    interval: interval_
+				      target: target_
+				    selector: selector_
+				      object: nil
+				      object: nil
+				   arguments: 0
+				     repeats: repeats_];
 }
 
 - initWithFireDate: (OFDate*)fireDate_
@@ -261,14 +309,14 @@
 	    object: (id)object
 	   repeats: (BOOL)repeats_
 {
-	return [self OF_initWithFireDate: fireDate_
-				interval: interval_
-				  target: target_
-				selector: selector_
-				  object: object
-				  object: nil
-			       arguments: 1
-				 repeats: repeats_];
+	return [self OF_initWithFireDeadline: deadline_from_date(fireDate_)
+				    interval: interval_
+				      target: target_
+				    selector: selector_
+				      object: object
+				      object: nil
+				   arguments: 1
+				     repeats: repeats_];
 }
 
 - initWithFireDate: (OFDate*)fireDate_
@@ -279,14 +327,14 @@
 	    object: (id)object2_
 	   repeats: (BOOL)repeats_
 {
-	return [self OF_initWithFireDate: fireDate_
-				interval: interval_
-				  target: target_
-				selector: selector_
-				  object: object1_
-				  object: object2_
-			       arguments: 2
-				 repeats: repeats_];
+	return [self OF_initWithFireDeadline: deadline_from_date(fireDate_)
+				    interval: interval_
+				      target: target_
+				    selector: selector_
+				      object: object1_
+				      object: object2_
+				   arguments: 2
+				     repeats: repeats_];
 }
 
 #ifdef OF_HAVE_BLOCKS
@@ -294,11 +342,22 @@
 	   interval: (double)interval_
 	    repeats: (BOOL)repeats_
 	      block: (of_timer_block_t)block_
+{
+	return [self OF_initWithFireDeadline: deadline_from_date(fireDate_)
+				    interval: interval_
+				     repeats: repeats_
+				       block: block_];
+}
+
+- OF_initWithFireDeadline: (uint64_t)fireDeadline_
+		 interval: (double)interval_
+		  repeats: (BOOL)repeats_
+		    block: (of_timer_block_t)block_
 {
 	self = [super init];
 
 	@try {
-		fireDate = [fireDate_ retain];
+		fireDeadline = fireDeadline_;
 		interval = interval_;
 		repeats = repeats_;
 		block = [block_ copy];
@@ -315,7 +374,6 @@
 
 - (void)dealloc
 {
-	[fireDate release];
 	[target release];
 	[object1 release];
 	[object2 release];
@@ -338,7 +396,12 @@
 
 	otherTimer = (OFTimer*)object_;
 
-	return [fireDate compare: otherTimer->fireDate];
+	if (fireDeadline < otherTimer->fireDeadline)
+		return OF_ORDERED_ASCENDING;
+	if (fireDeadline > otherTimer->fireDeadline)
+		return OF_ORDERED_DESCENDING;
+
+	return OF_ORDERED_SAME;
 }
 
 - (void)fire
@@ -377,10 +440,7 @@
 	}
 
 	if (repeats && isValid) {
-		OFDate *old = fireDate;
-		fireDate = [[OFDate alloc]
-		    initWithTimeIntervalSinceNow: interval];
-		[old release];
+		fireDeadline = of_deadline_after(of_monotonic_time(), interval);
 
 		[[OFRunLoop currentRunLoop] addTimer: self];
 	} else
@@ -389,7 +449,22 @@
 
 - (OFDate*)fireDate
 {
-	OF_GETTER(fireDate, YES)
+	uint64_t now = of_monotonic_time();
+
+	if (fireDeadline == OF_DEADLINE_NEVER)
+		return [OFDate distantFuture];
+
+	if (fireDeadline < now)
+		return [OFDate dateWithTimeIntervalSinceNow:
+		    -(double)(now - fireDeadline) / 1000000000];
+
+	return [OFDate dateWithTimeIntervalSinceNow:
+	    of_deadline_remaining(fireDeadline, now)];
+}
+
+- (uint64_t)fireDeadline
+{
+	return fireDeadline;
 }
 
 - (double)timeInterval
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFString.h"
+#import "OFXMLReader.h"
+
+@class OFStream;
+@class OFMutableArray;
+@class OFMutableDictionary;
+@class OFXMLNode;
+@class OFXMLElement;
+
+/*!
+ * @brief The type of a node in an OFXMLCompactDocument.
+ */
+typedef enum of_xml_compact_node_type_t {
+	/// An element
+	OF_XML_COMPACT_NODE_ELEMENT,
+	/// Characters
+	OF_XML_COMPACT_NODE_CHARACTERS,
+	/// CDATA
+	OF_XML_COMPACT_NODE_CDATA,
+	/// A comment
+	OF_XML_COMPACT_NODE_COMMENT,
+	/// Processing instructions
+	OF_XML_COMPACT_NODE_PROCESSING_INSTRUCTIONS
+} of_xml_compact_node_type_t;
+
+struct of_xml_compact_node {
+	uint32_t type, parent, nextSibling, childrenCount;
+	uint32_t start, length, ns;
+	uint32_t attributesStart, attributesCount;
+};
+
+struct of_xml_compact_attribute {
+	uint32_t nameStart, nameLength, valueStart, valueLength, ns;
+};
+
+/*!
+ * @brief A compact, read-only representation of an XML document.
+ *
+ * Instead of creating an OFXMLElement, OFXMLAttribute or OFXMLCharacters
+ * object for every node, all nodes are stored in one contiguous array and refer
+ * to their names and contents as ranges of a single copy of the document. This
+ * needs only a fraction of the memory of a tree built by OFXMLElementBuilder.
+ *
+ * Nodes are identified by their index, with the root element having index 0.
+ * The nodes are stored in document order, so the first child of a node, if
+ * any, always directly follows the node.
+ *
+ * Subtrees can be promoted to an OFXMLElement tree using @ref nodeAtIndex:,
+ * so that only the parts of the document that are actually needed as objects
+ * are created as objects.
+ */
+@interface OFXMLCompactDocument: OFObject
+{
+	char *buffer;
+	size_t bufferLength;
+	of_string_encoding_t encoding;
+	struct of_xml_compact_node *nodes;
+	size_t nodesCount;
+	struct of_xml_compact_attribute *attributes;
+	size_t attributesCount;
+	OFMutableArray *namespaces;
+	OFMutableDictionary *promotedNodes;
+}
+
+/*!
+ * @brief Creates a new compact document from the specified buffer.
+ *
+ * The buffer is copied.
+ *
+ * @param buffer The buffer containing the XML document
+ * @param length The length of the buffer
+ * @return A new, autoreleased OFXMLCompactDocument
+ */
++ (instancetype)documentWithBuffer: (const char*)buffer
+			    length: (size_t)length;
+
+/*!
+ * @brief Creates a new compact document from the specified string.
+ *
+ * @param string The string containing the XML document
+ * @return A new, autoreleased OFXMLCompactDocument
+ */
++ (instancetype)documentWithString: (OFString*)string;
+
+/*!
+ * @brief Creates a new compact document from the contents of the specified
+ *	  stream.
+ *
+ * The stream is read until the end of the stream is reached.
+ *
+ * @param stream The stream to read the XML document from
+ * @return A new, autoreleased OFXMLCompactDocument
+ */
++ (instancetype)documentWithStream: (OFStream*)stream;
+
+/*!
+ * @brief Initializes an already allocated compact document with the specified
+ *	  buffer.
+ *
+ * The buffer is copied.
+ *
+ * @param buffer The buffer containing the XML document
+ * @param length The length of the buffer
+ * @return An initialized OFXMLCompactDocument
+ */
+- initWithBuffer: (const char*)buffer
+	  length: (size_t)length;
+
+/*!
+ * @brief Initializes an already allocated compact document with the specified
+ *	  string.
+ *
+ * @param string The string containing the XML document
+ * @return An initialized OFXMLCompactDocument
+ */
+- initWithString: (OFString*)string;
+
+/*!
+ * @brief Initializes an already allocated compact document with the contents
+ *	  of the specified stream.
+ *
+ * The stream is read until the end of the stream is reached.
+ *
+ * @param stream The stream to read the XML document from
+ * @return An initialized OFXMLCompactDocument
+ */
+- initWithStream: (OFStream*)stream;
+
+/*!
+ * @brief Returns the number of nodes in the document.
+ *
+ * @return The number of nodes in the document
+ */
+- (size_t)nodesCount;
+
+/*!
+ * @brief Returns the type of the node at the specified index.
+ *
+ * @param index The index of the node
+ * @return The type of the node
+ */
+- (of_xml_compact_node_type_t)typeOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the index of the parent of the node at the specified index.
+ *
+ * @param index The index of the node
+ * @return The index of the parent or OF_NOT_FOUND for the root element
+ */
+- (size_t)parentOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the number of children of the node at the specified index.
+ *
+ * @param index The index of the node
+ * @return The number of children of the node
+ */
+- (size_t)childrenCountOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the index of the first child of the node at the specified
+ *	  index.
+ *
+ * @param index The index of the node
+ * @return The index of the first child or OF_NOT_FOUND if the node has no
+ *	   children
+ */
+- (size_t)firstChildOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the index of the next sibling of the node at the specified
+ *	  index.
+ *
+ * @param index The index of the node
+ * @return The index of the next sibling or OF_NOT_FOUND if the node is the
+ *	   last child of its parent
+ */
+- (size_t)nextSiblingOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the index of the first child element with the specified name
+ *	  and namespace of the node at the specified index.
+ *
+ * @param name The name of the child element
+ * @param ns The namespace of the child element
+ * @param index The index of the node
+ * @return The index of the child element or OF_NOT_FOUND
+ */
+- (size_t)indexOfChildElementWithName: (OFString*)name
+			    namespace: (OFString*)ns
+			ofNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the local name of the element at the specified index as a
+ *	  slice.
+ *
+ * For nodes which are not elements, the raw content is returned, which is not
+ * unescaped.
+ *
+ * @param index The index of the node
+ * @return The name or raw content of the node as a slice
+ */
+- (of_xml_slice_t)sliceOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the local name of the element at the specified index.
+ *
+ * @param index The index of the node
+ * @return The local name of the element or nil if the node is not an element
+ */
+- (OFString*)nameOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the namespace of the element at the specified index.
+ *
+ * @param index The index of the node
+ * @return The namespace of the element or nil
+ */
+- (OFString*)namespaceOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the string value of the node at the specified index.
+ *
+ * For elements, this is the concatenation of all characters and CDATA inside
+ * the element, like for OFXMLElement.
+ *
+ * @param index The index of the node
+ * @return The string value of the node
+ */
+- (OFString*)stringValueOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the number of attributes of the element at the specified
+ *	  index.
+ *
+ * @param index The index of the node
+ * @return The number of attributes of the element
+ */
+- (size_t)attributesCountOfNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the value of the attribute with the specified name and
+ *	  namespace of the element at the specified index.
+ *
+ * @param name The name of the attribute
+ * @param ns The namespace of the attribute
+ * @param index The index of the node
+ * @return The value of the attribute or nil
+ */
+- (OFString*)valueOfAttributeWithName: (OFString*)name
+			    namespace: (OFString*)ns
+			ofNodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the node at the specified index as an OFXMLNode.
+ *
+ * For elements, the whole subtree is promoted to OFXMLElements. The promoted
+ * node is cached, so calling this again for the same index returns the same
+ * object. Changes to the returned node are not reflected in the document.
+ *
+ * @param index The index of the node
+ * @return The node at the specified index as an OFXMLNode
+ */
+- (OFXMLNode*)nodeAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the root element as an OFXMLElement.
+ *
+ * This promotes the whole document and should thus be avoided for large
+ * documents.
+ *
+ * @return The root element as an OFXMLElement
+ */
+- (OFXMLElement*)rootElement;
+@end
@@ -0,0 +1,657 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFXMLCompactDocument.h"
+#import "OFXMLReader.h"
+#import "OFXMLElement.h"
+#import "OFXMLCharacters.h"
+#import "OFXMLCDATA.h"
+#import "OFXMLComment.h"
+#import "OFXMLProcessingInstructions.h"
+#import "OFString.h"
+#import "OFArray.h"
+#import "OFDictionary.h"
+#import "OFNumber.h"
+#import "OFDataArray.h"
+#import "OFStream.h"
+
+#import "OFMalformedXMLException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+
+#import "autorelease.h"
+#import "macros.h"
+#import "of_xml.h"
+
+#define XMLNS_NS @"http://www.w3.org/2000/xmlns/"
+#define NO_NODE UINT32_MAX
+
+@implementation OFXMLCompactDocument
++ (instancetype)documentWithBuffer: (const char*)buffer
+			    length: (size_t)length
+{
+	return [[[self alloc] initWithBuffer: buffer
+				      length: length] autorelease];
+}
+
++ (instancetype)documentWithString: (OFString*)string
+{
+	return [[[self alloc] initWithString: string] autorelease];
+}
+
++ (instancetype)documentWithStream: (OFStream*)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
+- initWithString: (OFString*)string
+{
+	return [self initWithBuffer: [string UTF8String]
+			     length: [string UTF8StringLength]];
+}
+
+- initWithStream: (OFStream*)stream
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDataArray *data;
+
+	@try {
+		data = [stream readDataArrayTillEndOfStream];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	/* Releases self itself if it fails */
+	self = [self initWithBuffer: [data cArray]
+			     length: [data count]];
+
+	objc_autoreleasePoolPop(pool);
+
+	return self;
+}
+
+- (uint32_t)OF_indexOfNamespace: (OFString*)ns
+{
+	OFString **objects;
+	size_t i, count;
+
+	if (ns == nil)
+		return 0;
+
+	objects = [namespaces objects];
+	count = [namespaces count];
+
+	for (i = 0; i < count; i++)
+		if (objects[i] == ns)
+			return (uint32_t)i + 1;
+
+	for (i = 0; i < count; i++)
+		if ([objects[i] isEqual: ns])
+			return (uint32_t)i + 1;
+
+	[namespaces addObject: ns];
+
+	return (uint32_t)count + 1;
+}
+
+- (uint32_t)OF_addNode: (of_xml_compact_node_type_t)type
+		 slice: (of_xml_slice_t)slice
+		 stack: (uint32_t*)stack
+	     lastChild: (uint32_t*)lastChild
+	    stackCount: (size_t)stackCount
+{
+	struct of_xml_compact_node *node;
+	uint32_t index;
+
+	if (nodesCount >= NO_NODE)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	index = (uint32_t)nodesCount;
+
+	/* Grow exponentially, the array is shrunk after parsing */
+	if ((nodesCount & (nodesCount - 1)) == 0)
+		nodes = [self resizeMemory: nodes
+				      size: sizeof(*nodes)
+				     count: (nodesCount > 0 ? nodesCount * 2 : 1)];
+
+	node = &nodes[nodesCount++];
+	memset(node, 0, sizeof(*node));
+	node->type = type;
+	node->start = (uint32_t)(slice.bytes - buffer);
+	node->length = (uint32_t)slice.length;
+	node->parent = (stackCount > 0 ? stack[stackCount - 1] : NO_NODE);
+
+	if (stackCount > 0) {
+		nodes[stack[stackCount - 1]].childrenCount++;
+
+		if (lastChild[stackCount - 1] != 0)
+			nodes[lastChild[stackCount - 1]].nextSibling = index;
+
+		lastChild[stackCount - 1] = index;
+	}
+
+	return index;
+}
+
+- (void)OF_addAttributesFromReader: (OFXMLReader*)reader
+			    toNode: (struct of_xml_compact_node*)node
+{
+	size_t i, count = [reader attributesCount];
+
+	node->attributesStart = (uint32_t)attributesCount;
+
+	for (i = 0; i < count; i++) {
+		struct of_xml_compact_attribute *attribute;
+		of_xml_slice_t name = [reader attributeNameSliceAtIndex: i];
+		of_xml_slice_t value = [reader attributeValueSliceAtIndex: i];
+		OFString *ns = [reader attributeNamespaceAtIndex: i];
+
+		/* Like OFXMLElementBuilder, drop the default namespace */
+		if (ns == nil && of_xml_slice_is_equal(name, "xmlns"))
+			continue;
+
+		if ((attributesCount & (attributesCount - 1)) == 0)
+			attributes = [self
+			    resizeMemory: attributes
+				    size: sizeof(*attributes)
+				   count: (attributesCount > 0
+					      ? attributesCount * 2 : 1)];
+
+		attribute = &attributes[attributesCount++];
+		attribute->nameStart = (uint32_t)(name.bytes - buffer);
+		attribute->nameLength = (uint32_t)name.length;
+		attribute->valueStart = (uint32_t)(value.bytes - buffer);
+		attribute->valueLength = (uint32_t)value.length;
+		attribute->ns = [self OF_indexOfNamespace: ns];
+
+		node->attributesCount++;
+	}
+}
+
+- (void)OF_buildWithReader: (OFXMLReader*)reader
+{
+	uint32_t *stack = NULL, *lastChild = NULL;
+	size_t stackCount = 0, stackSize = 0;
+	BOOL finished = NO;
+
+	@try {
+		while (!finished) {
+			of_xml_reader_token_t token = [reader nextToken];
+			of_xml_compact_node_type_t type;
+			uint32_t index;
+
+			switch (token) {
+			case OF_XML_READER_TOKEN_START_ELEMENT:
+				index = [self
+				    OF_addNode: OF_XML_COMPACT_NODE_ELEMENT
+					 slice: [reader nameSlice]
+					 stack: stack
+				     lastChild: lastChild
+				    stackCount: stackCount];
+				nodes[index].ns =
+				    [self OF_indexOfNamespace:
+				    [reader namespace]];
+				[self OF_addAttributesFromReader: reader
+							  toNode: &nodes[index]];
+
+				if (stackCount == stackSize) {
+					stackSize = (stackSize > 0
+					    ? stackSize * 2 : 16);
+					stack = [self
+					    resizeMemory: stack
+						    size: sizeof(*stack)
+						   count: stackSize];
+					lastChild = [self
+					    resizeMemory: lastChild
+						    size: sizeof(*lastChild)
+						   count: stackSize];
+				}
+
+				stack[stackCount] = index;
+				lastChild[stackCount] = 0;
+				stackCount++;
+
+				continue;
+			case OF_XML_READER_TOKEN_END_ELEMENT:
+				stackCount--;
+				continue;
+			case OF_XML_READER_TOKEN_CHARACTERS:
+				type = OF_XML_COMPACT_NODE_CHARACTERS;
+				break;
+			case OF_XML_READER_TOKEN_CDATA:
+				type = OF_XML_COMPACT_NODE_CDATA;
+				break;
+			case OF_XML_READER_TOKEN_COMMENT:
+				type = OF_XML_COMPACT_NODE_COMMENT;
+				break;
+			case OF_XML_READER_TOKEN_PROCESSING_INSTRUCTIONS:
+				type =
+				    OF_XML_COMPACT_NODE_PROCESSING_INSTRUCTIONS;
+				break;
+			default:
+				finished = YES;
+				continue;
+			}
+
+			/* Only nodes inside the root element are kept */
+			if (stackCount > 0)
+				[self OF_addNode: type
+					   slice: [reader contentSlice]
+					   stack: stack
+				       lastChild: lastChild
+				      stackCount: stackCount];
+		}
+	} @finally {
+		[self freeMemory: stack];
+		[self freeMemory: lastChild];
+	}
+
+	if (nodesCount == 0)
+		@throw [OFMalformedXMLException exceptionWithClass: [self class]
+							    parser: nil];
+
+	encoding = [reader encoding];
+
+	@try {
+		nodes = [self resizeMemory: nodes
+				      size: sizeof(*nodes)
+				     count: nodesCount];
+
+		if (attributesCount > 0)
+			attributes = [self resizeMemory: attributes
+						   size: sizeof(*attributes)
+						  count: attributesCount];
+	} @catch (OFOutOfMemoryException *e) {
+		/* We don't really care, as we only made it smaller */
+	}
+}
+
+- initWithBuffer: (const char*)buffer_
+	  length: (size_t)length
+{
+	self = [super init];
+
+	@try {
+		void *pool = objc_autoreleasePoolPush();
+
+		if (length > NO_NODE)
+			@throw [OFOutOfRangeException
+			    exceptionWithClass: [self class]];
+
+		buffer = [self allocMemoryWithSize: length];
+		bufferLength = length;
+		memcpy(buffer, buffer_, length);
+
+		namespaces = [[OFMutableArray alloc] init];
+
+		[self OF_buildWithReader:
+		    [OFXMLReader readerWithBuffer: buffer
+					   length: bufferLength]];
+
+		objc_autoreleasePoolPop(pool);
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[namespaces release];
+	[promotedNodes release];
+
+	[super dealloc];
+}
+
+- (struct of_xml_compact_node*)OF_nodeAtIndex: (size_t)index
+{
+	if (index >= nodesCount)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	return &nodes[index];
+}
+
+- (OFString*)OF_stringAt: (uint32_t)start
+		  length: (uint32_t)length
+{
+	return of_xml_string(buffer + start, length, encoding);
+}
+
+- (OFString*)OF_textAt: (uint32_t)start
+		length: (uint32_t)length
+	      unescape: (BOOL)unescape
+{
+	return of_xml_text(buffer + start, length, encoding, unescape);
+}
+
+- (BOOL)OF_isStringAt: (uint32_t)start
+	       length: (uint32_t)length
+	      equalTo: (OFString*)string
+{
+	void *pool;
+	BOOL ret;
+
+	if (encoding == OF_STRING_ENCODING_UTF_8)
+		return ([string UTF8StringLength] == length &&
+		    memcmp(buffer + start, [string UTF8String], length) == 0);
+
+	pool = objc_autoreleasePoolPush();
+	ret = [[self OF_stringAt: start
+			  length: length] isEqual: string];
+	objc_autoreleasePoolPop(pool);
+
+	return ret;
+}
+
+- (OFString*)OF_namespaceAtIndex: (uint32_t)index
+{
+	if (index == 0)
+		return nil;
+
+	return [namespaces objectAtIndex: index - 1];
+}
+
+- (size_t)nodesCount
+{
+	return nodesCount;
+}
+
+- (of_xml_compact_node_type_t)typeOfNodeAtIndex: (size_t)index
+{
+	return [self OF_nodeAtIndex: index]->type;
+}
+
+- (size_t)parentOfNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+
+	return (node->parent != NO_NODE ? node->parent : OF_NOT_FOUND);
+}
+
+- (size_t)childrenCountOfNodeAtIndex: (size_t)index
+{
+	return [self OF_nodeAtIndex: index]->childrenCount;
+}
+
+- (size_t)firstChildOfNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+
+	return (node->childrenCount > 0 ? index + 1 : OF_NOT_FOUND);
+}
+
+- (size_t)nextSiblingOfNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+
+	return (node->nextSibling != 0 ? node->nextSibling : OF_NOT_FOUND);
+}
+
+- (size_t)indexOfChildElementWithName: (OFString*)name
+			    namespace: (OFString*)ns
+			ofNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+	uint32_t child;
+
+	if (node->childrenCount == 0)
+		return OF_NOT_FOUND;
+
+	for (child = (uint32_t)index + 1; child != 0;
+	    child = nodes[child].nextSibling) {
+		OFString *childNS;
+
+		if (nodes[child].type != OF_XML_COMPACT_NODE_ELEMENT)
+			continue;
+
+		if (![self OF_isStringAt: nodes[child].start
+				  length: nodes[child].length
+				 equalTo: name])
+			continue;
+
+		childNS = [self OF_namespaceAtIndex: nodes[child].ns];
+		if (childNS == ns || [childNS isEqual: ns])
+			return child;
+	}
+
+	return OF_NOT_FOUND;
+}
+
+- (of_xml_slice_t)sliceOfNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+	of_xml_slice_t slice;
+
+	slice.bytes = buffer + node->start;
+	slice.length = node->length;
+
+	return slice;
+}
+
+- (OFString*)nameOfNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+
+	if (node->type != OF_XML_COMPACT_NODE_ELEMENT)
+		return nil;
+
+	return [self OF_stringAt: node->start
+			  length: node->length];
+}
+
+- (OFString*)namespaceOfNodeAtIndex: (size_t)index
+{
+	return [self OF_namespaceAtIndex: [self OF_nodeAtIndex: index]->ns];
+}
+
+- (void)OF_appendStringValueOfNodeAtIndex: (uint32_t)index
+				 toString: (OFMutableString*)string
+{
+	struct of_xml_compact_node *node = &nodes[index];
+	uint32_t child;
+
+	switch (node->type) {
+	case OF_XML_COMPACT_NODE_ELEMENT:
+		if (node->childrenCount == 0)
+			return;
+
+		for (child = index + 1; child != 0;
+		    child = nodes[child].nextSibling)
+			[self OF_appendStringValueOfNodeAtIndex: child
+						       toString: string];
+
+		return;
+	case OF_XML_COMPACT_NODE_CHARACTERS:
+	case OF_XML_COMPACT_NODE_CDATA:
+		[string appendString: [self stringValueOfNodeAtIndex: index]];
+		return;
+	default:
+		return;
+	}
+}
+
+- (OFString*)stringValueOfNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+	OFMutableString *ret;
+	void *pool;
+
+	switch (node->type) {
+	case OF_XML_COMPACT_NODE_ELEMENT:
+		break;
+	case OF_XML_COMPACT_NODE_CHARACTERS:
+		return [self OF_textAt: node->start
+				length: node->length
+			      unescape: YES];
+	default:
+		return [self OF_textAt: node->start
+				length: node->length
+			      unescape: NO];
+	}
+
+	ret = [OFMutableString string];
+
+	pool = objc_autoreleasePoolPush();
+	[self OF_appendStringValueOfNodeAtIndex: (uint32_t)index
+				       toString: ret];
+	objc_autoreleasePoolPop(pool);
+
+	[ret makeImmutable];
+
+	return ret;
+}
+
+- (size_t)attributesCountOfNodeAtIndex: (size_t)index
+{
+	return [self OF_nodeAtIndex: index]->attributesCount;
+}
+
+- (OFString*)valueOfAttributeWithName: (OFString*)name
+			    namespace: (OFString*)ns
+			ofNodeAtIndex: (size_t)index
+{
+	struct of_xml_compact_node *node = [self OF_nodeAtIndex: index];
+	uint32_t i;
+
+	for (i = 0; i < node->attributesCount; i++) {
+		struct of_xml_compact_attribute *attribute =
+		    &attributes[node->attributesStart + i];
+		OFString *attributeNS;
+
+		if (![self OF_isStringAt: attribute->nameStart
+				  length: attribute->nameLength
+				 equalTo: name])
+			continue;
+
+		attributeNS = [self OF_namespaceAtIndex: attribute->ns];
+		if (attributeNS == ns || [attributeNS isEqual: ns])
+			return [self OF_textAt: attribute->valueStart
+					length: attribute->valueLength
+				      unescape: YES];
+	}
+
+	return nil;
+}
+
+- (OFXMLNode*)OF_promoteNodeAtIndex: (uint32_t)index
+{
+	struct of_xml_compact_node *node = &nodes[index];
+	OFXMLElement *element;
+	uint32_t i, child;
+
+	switch (node->type) {
+	case OF_XML_COMPACT_NODE_ELEMENT:
+		break;
+	case OF_XML_COMPACT_NODE_CHARACTERS:
+		return [OFXMLCharacters charactersWithString:
+		    [self stringValueOfNodeAtIndex: index]];
+	case OF_XML_COMPACT_NODE_CDATA:
+		return [OFXMLCDATA CDATAWithString:
+		    [self stringValueOfNodeAtIndex: index]];
+	case OF_XML_COMPACT_NODE_COMMENT:
+		return [OFXMLComment commentWithString:
+		    [self stringValueOfNodeAtIndex: index]];
+	default:
+		return [OFXMLProcessingInstructions
+		    processingInstructionsWithString:
+		    [self stringValueOfNodeAtIndex: index]];
+	}
+
+	element = [OFXMLElement
+	    elementWithName: [self OF_stringAt: node->start
+					length: node->length]
+		  namespace: [self OF_namespaceAtIndex: node->ns]];
+
+	for (i = 0; i < node->attributesCount; i++) {
+		void *pool = objc_autoreleasePoolPush();
+		struct of_xml_compact_attribute *attribute =
+		    &attributes[node->attributesStart + i];
+		OFString *name, *ns, *value;
+
+		name = [self OF_stringAt: attribute->nameStart
+				  length: attribute->nameLength];
+		ns = [self OF_namespaceAtIndex: attribute->ns];
+		value = [self OF_textAt: attribute->valueStart
+				 length: attribute->valueLength
+			       unescape: YES];
+
+		if ([ns isEqual: XMLNS_NS])
+			[element setPrefix: name
+			      forNamespace: value];
+
+		[element addAttributeWithName: name
+				    namespace: ns
+				  stringValue: value];
+
+		objc_autoreleasePoolPop(pool);
+	}
+
+	if (node->childrenCount == 0)
+		return element;
+
+	for (child = index + 1; child != 0; child = nodes[child].nextSibling) {
+		void *pool = objc_autoreleasePoolPush();
+
+		[element addChild: [self OF_promoteNodeAtIndex: child]];
+
+		objc_autoreleasePoolPop(pool);
+	}
+
+	return element;
+}
+
+- (OFXMLNode*)nodeAtIndex: (size_t)index
+{
+	void *pool;
+	OFNumber *key;
+	OFXMLNode *node;
+
+	if (index >= nodesCount)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	pool = objc_autoreleasePoolPush();
+
+	key = [OFNumber numberWithSize: index];
+
+	if ((node = [promotedNodes objectForKey: key]) == nil) {
+		node = [self OF_promoteNodeAtIndex: (uint32_t)index];
+
+		if (promotedNodes == nil)
+			promotedNodes = [[OFMutableDictionary alloc] init];
+
+		[promotedNodes setObject: node
+				  forKey: key];
+	}
+
+	[node retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [node autorelease];
+}
+
+- (OFXMLElement*)rootElement
+{
+	return (OFXMLElement*)[self nodeAtIndex: 0];
+}
+@end
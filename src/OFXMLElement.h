@@ -34,6 +34,7 @@
 	OFMutableArray *attributes;
 	OFMutableDictionary *namespaces;
 	OFMutableArray *children;
+	OFMutableDictionary *childrenIndex;
 }
 
 #ifdef OF_HAVE_PROPERTIES
@@ -17,13 +17,13 @@
 #include "config.h"
 
 #include <string.h>
-#include <assert.h>
 
 #import "OFXMLElement.h"
 #import "OFString.h"
 #import "OFArray.h"
 #import "OFDictionary.h"
 #import "OFDataArray.h"
+#import "OFStream.h"
 #import "OFXMLAttribute.h"
 #import "OFXMLCharacters.h"
 #import "OFXMLCDATA.h"
@@ -71,6 +71,118 @@ static Class CDATAClass = Nil;
 }
 @end
 
+static void
+write_indentation(OFStream *stream, size_t count)
+{
+	static const char spaces[] = "                                ";
+
+	while (count > 0) {
+		size_t length = (count < sizeof(spaces) - 1
+		    ? count : sizeof(spaces) - 1);
+
+		[stream writeBuffer: spaces
+			     length: length];
+		count -= length;
+	}
+}
+
+@interface OFXMLElement_DataArrayStream: OFStream
+{
+@public
+	OFDataArray *dataArray;
+}
+@end
+
+@implementation OFXMLElement_DataArrayStream
+- init
+{
+	self = [super init];
+
+	@try {
+		dataArray = [[OFBigDataArray alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[dataArray release];
+
+	[super dealloc];
+}
+
+- (void)lowlevelWriteBuffer: (const void*)buffer
+		     length: (size_t)length
+{
+	[dataArray addItemsFromCArray: buffer
+				count: length];
+}
+@end
+
+/*
+ * Collects the many small writes of serializing into chunks of a fixed size,
+ * so that neither each of them nor the whole document reaches the stream.
+ */
+@interface OFXMLElement_ChunkingStream: OFStream
+{
+	OFStream *stream;
+	char buffer[4096];
+	size_t bufferLength;
+}
+
+- initWithStream: (OFStream*)stream;
+- (void)flushChunk;
+@end
+
+@implementation OFXMLElement_ChunkingStream
+- initWithStream: (OFStream*)stream_
+{
+	self = [super init];
+
+	stream = [stream_ retain];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[stream release];
+
+	[super dealloc];
+}
+
+- (void)lowlevelWriteBuffer: (const void*)buffer_
+		     length: (size_t)length
+{
+	if (bufferLength + length > sizeof(buffer)) {
+		[self flushChunk];
+
+		if (length >= sizeof(buffer)) {
+			[stream writeBuffer: buffer_
+				     length: length];
+			return;
+		}
+	}
+
+	memcpy(buffer + bufferLength, buffer_, length);
+	bufferLength += length;
+}
+
+- (void)flushChunk
+{
+	if (bufferLength == 0)
+		return;
+
+	[stream writeBuffer: buffer
+		     length: bufferLength];
+	bufferLength = 0;
+}
+@end
+
 @implementation OFXMLElement
 + (void)initialize
 {
@@ -412,6 +524,9 @@ static Class CDATAClass = Nil;
 
 - (void)setChildren: (OFArray*)children_
 {
+	[childrenIndex release];
+	childrenIndex = nil;
+
 	OF_SETTER(children, children_, YES, 2)
 }
 
@@ -455,17 +570,16 @@ static Class CDATAClass = Nil;
 	return ret;
 }
 
-- (OFString*)OF_XMLStringWithParent: (OFXMLElement*)parent
-			 namespaces: (OFDictionary*)allNamespaces
-			indentation: (unsigned int)indentation
-			      level: (unsigned int)level
+- (void)OF_writeToStream: (OFStream*)stream
+		  parent: (OFXMLElement*)parent
+	      namespaces: (OFDictionary*)allNamespaces
+	     indentation: (unsigned int)indentation
+		   level: (unsigned int)level
 {
 	void *pool;
-	char *cString;
-	size_t length, i, j, attributesCount;
+	size_t i, attributesCount;
 	OFString *prefix, *parentPrefix;
 	OFXMLAttribute **attributesObjects;
-	OFString *ret;
 	OFString *defaultNS;
 
 	pool = objc_autoreleasePoolPush();
@@ -473,21 +587,33 @@ static Class CDATAClass = Nil;
 	parentPrefix = [allNamespaces objectForKey:
 	    (parent != nil && parent->ns != nil ? parent->ns : (OFString*)@"")];
 
-	/* Add the namespaces of the current element */
+	/*
+	 * Add the namespaces of the current element. The dictionary is only
+	 * copied if this actually changes any binding, which is rarely the
+	 * case as every element contains the bindings for xml and xmlns.
+	 */
 	if (allNamespaces != nil) {
 		OFEnumerator *keyEnumerator = [namespaces keyEnumerator];
 		OFEnumerator *objectEnumerator = [namespaces objectEnumerator];
-		OFMutableDictionary *tmp;
+		OFMutableDictionary *tmp = nil;
 		id key, object;
 
-		tmp = [[allNamespaces mutableCopy] autorelease];
-
 		while ((key = [keyEnumerator nextObject]) != nil &&
-		    (object = [objectEnumerator nextObject]) != nil)
+		    (object = [objectEnumerator nextObject]) != nil) {
+			if (tmp == nil) {
+				if ([[allNamespaces objectForKey: key]
+				    isEqual: object])
+					continue;
+
+				tmp = [[allNamespaces mutableCopy] autorelease];
+			}
+
 			[tmp setObject: object
 				forKey: key];
+		}
 
-		allNamespaces = tmp;
+		if (tmp != nil)
+			allNamespaces = tmp;
 	} else
 		allNamespaces = namespaces;
 
@@ -501,231 +627,196 @@ static Class CDATAClass = Nil;
 	else
 		defaultNS = defaultNamespace;
 
-	i = 0;
-	length = [name UTF8StringLength] + 3 + (level * indentation);
-	cString = [self allocMemoryWithSize: length];
+	if (prefix != nil && [ns isEqual: defaultNS])
+		prefix = nil;
 
-	memset(cString + i, ' ', level * indentation);
-	i += level * indentation;
+	write_indentation(stream, level * indentation);
 
 	/* Start of tag */
-	cString[i++] = '<';
-
-	if (prefix != nil && ![ns isEqual: defaultNS]) {
-		length += [prefix UTF8StringLength] + 1;
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
+	[stream writeBuffer: "<"
+		     length: 1];
 
-		memcpy(cString + i, [prefix UTF8String],
-		    [prefix UTF8StringLength]);
-		i += [prefix UTF8StringLength];
-		cString[i++] = ':';
+	if (prefix != nil) {
+		[stream writeString: prefix];
+		[stream writeBuffer: ":"
+			     length: 1];
 	}
 
-	memcpy(cString + i, [name UTF8String], [name UTF8StringLength]);
-	i += [name UTF8StringLength];
+	[stream writeString: name];
 
 	/* xmlns if necessary */
 	if (prefix == nil && ((ns != nil && ![ns isEqual: defaultNS]) ||
 	    (ns == nil && defaultNS != nil))) {
-		length += [ns UTF8StringLength] + 9;
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		memcpy(cString + i, " xmlns='", 8);
-		i += 8;
-		memcpy(cString + i, [ns UTF8String], [ns UTF8StringLength]);
-		i += [ns UTF8StringLength];
-		cString[i++] = '\'';
+		[stream writeBuffer: " xmlns='"
+			     length: 8];
+		if (ns != nil)
+			[stream writeString: ns];
+		[stream writeBuffer: "'"
+			     length: 1];
 	}
 
 	/* Attributes */
 	attributesObjects = [attributes objects];
 	attributesCount = [attributes count];
 
-	for (j = 0; j < attributesCount; j++) {
+	for (i = 0; i < attributesCount; i++) {
 		void *pool2 = objc_autoreleasePoolPush();
-		OFString *attributeName = [attributesObjects[j] name];
 		OFString *attributePrefix = nil;
-		OFString *tmp =
-		    [[attributesObjects[j] stringValue] stringByXMLEscaping];
 
-		if ([attributesObjects[j] namespace] != nil &&
+		if (attributesObjects[i]->ns != nil &&
 		    (attributePrefix = [allNamespaces objectForKey:
-		    [attributesObjects[j] namespace]]) == nil)
+		    attributesObjects[i]->ns]) == nil)
 			@throw [OFUnboundNamespaceException
 			    exceptionWithClass: [self class]
-				     namespace: [attributesObjects[j]
-						    namespace]];
-
-		length += [attributeName UTF8StringLength] +
-		    (attributePrefix != nil ?
-		    [attributePrefix UTF8StringLength] + 1 : 0) +
-		    [tmp UTF8StringLength] + 4;
-
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
+				     namespace: attributesObjects[i]->ns];
 
-		cString[i++] = ' ';
+		[stream writeBuffer: " "
+			     length: 1];
 		if (attributePrefix != nil) {
-			memcpy(cString + i, [attributePrefix UTF8String],
-			    [attributePrefix UTF8StringLength]);
-			i += [attributePrefix UTF8StringLength];
-			cString[i++] = ':';
+			[stream writeString: attributePrefix];
+			[stream writeBuffer: ":"
+				     length: 1];
 		}
-		memcpy(cString + i, [attributeName UTF8String],
-		    [attributeName UTF8StringLength]);
-		i += [attributeName UTF8StringLength];
-		cString[i++] = '=';
-		cString[i++] = '\'';
-		memcpy(cString + i, [tmp UTF8String], [tmp UTF8StringLength]);
-		i += [tmp UTF8StringLength];
-		cString[i++] = '\'';
+		[stream writeString: attributesObjects[i]->name];
+		[stream writeBuffer: "='"
+			     length: 2];
+		[stream writeString:
+		    [attributesObjects[i]->stringValue stringByXMLEscaping]];
+		[stream writeBuffer: "'"
+			     length: 1];
 
 		objc_autoreleasePoolPop(pool2);
 	}
 
 	/* Childen */
 	if (children != nil) {
-		OFXMLElement **childrenObjects = [children objects];
+		OFXMLNode **childrenObjects = [children objects];
 		size_t childrenCount = [children count];
-		OFDataArray *tmp = [OFDataArray dataArray];
-		BOOL indent;
+		unsigned int ind = 0;
 
 		if (indentation > 0) {
-			indent = YES;
+			ind = indentation;
 
-			for (j = 0; j < childrenCount; j++) {
-				if ([childrenObjects[j] isKindOfClass:
-				    charactersClass] || [childrenObjects[j]
+			for (i = 0; i < childrenCount; i++) {
+				if ([childrenObjects[i] isKindOfClass:
+				    charactersClass] || [childrenObjects[i]
 				    isKindOfClass: CDATAClass]) {
-					indent = NO;
+					ind = 0;
 					break;
 				}
 			}
-		} else
-			indent = NO;
+		}
 
-		for (j = 0; j < childrenCount; j++) {
-			OFString *child;
-			unsigned int ind = (indent ? indentation : 0);
+		[stream writeBuffer: ">"
+			     length: 1];
 
+		for (i = 0; i < childrenCount; i++) {
 			if (ind)
-				[tmp addItem: "\n"];
+				[stream writeBuffer: "\n"
+					     length: 1];
 
-			if ([childrenObjects[j] isKindOfClass:
+			if ([childrenObjects[i] isKindOfClass:
 			    [OFXMLElement class]])
-				child = [childrenObjects[j]
-				    OF_XMLStringWithParent: self
-						namespaces: allNamespaces
-					       indentation: ind
-						     level: level + 1];
+				[(OFXMLElement*)childrenObjects[i]
+				    OF_writeToStream: stream
+					      parent: self
+					  namespaces: allNamespaces
+					 indentation: ind
+					       level: level + 1];
 			else
-				child = [childrenObjects[j]
-				    XMLStringWithIndentation: ind
-						       level: level + 1];
-
-			[tmp addItemsFromCArray: [child UTF8String]
-					  count: [child UTF8StringLength]];
+				[childrenObjects[i] writeToStream: stream
+						      indentation: ind
+							    level: level + 1];
 		}
 
-		if (indent)
-			[tmp addItem: "\n"];
-
-		length += [tmp count] + [name UTF8StringLength] + 2 +
-		    (indent ? level * indentation : 0);
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
+		if (ind) {
+			[stream writeBuffer: "\n"
+				     length: 1];
+			write_indentation(stream, level * indentation);
 		}
 
-		cString[i++] = '>';
-
-		memcpy(cString + i, [tmp cArray], [tmp count]);
-		i += [tmp count];
-
-		if (indent) {
-			memset(cString + i, ' ', level * indentation);
-			i += level * indentation;
-		}
-
-		cString[i++] = '<';
-		cString[i++] = '/';
+		[stream writeBuffer: "</"
+			     length: 2];
 		if (prefix != nil) {
-			length += [prefix UTF8StringLength] + 1;
-			@try {
-				cString = [self resizeMemory: cString
-							size: length];
-			} @catch (id e) {
-				[self freeMemory: cString];
-				@throw e;
-			}
-
-			memcpy(cString + i, [prefix UTF8String],
-			    [prefix UTF8StringLength]);
-			i += [prefix UTF8StringLength];
-			cString[i++] = ':';
+			[stream writeString: prefix];
+			[stream writeBuffer: ":"
+				     length: 1];
 		}
-		memcpy(cString + i, [name UTF8String], [name UTF8StringLength]);
-		i += [name UTF8StringLength];
+		[stream writeString: name];
 	} else
-		cString[i++] = '/';
+		[stream writeBuffer: "/"
+			     length: 1];
 
-	cString[i++] = '>';
-	assert(i == length);
+	[stream writeBuffer: ">"
+		     length: 1];
 
 	objc_autoreleasePoolPop(pool);
+}
 
+- (void)writeToStream: (OFStream*)stream
+	  indentation: (unsigned int)indentation
+		level: (unsigned int)level
+{
+	OFXMLElement_ChunkingStream *chunkingStream;
+
+	/* The caller already takes care of buffering */
+	if ([stream writeBufferEnabled]) {
+		[self OF_writeToStream: stream
+				parent: nil
+			    namespaces: nil
+			   indentation: indentation
+				 level: level];
+		return;
+	}
+
+	chunkingStream = [[OFXMLElement_ChunkingStream alloc]
+	    initWithStream: stream];
 	@try {
-		ret = [OFString stringWithUTF8String: cString
-					      length: length];
+		[self OF_writeToStream: chunkingStream
+				parent: nil
+			    namespaces: nil
+			   indentation: indentation
+				 level: level];
+		[chunkingStream flushChunk];
 	} @finally {
-		[self freeMemory: cString];
+		[chunkingStream release];
 	}
-	return ret;
 }
 
 - (OFString*)XMLString
 {
-	return [self OF_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: 0
-				      level: 0];
+	return [self XMLStringWithIndentation: 0
+					level: 0];
 }
 
 - (OFString*)XMLStringWithIndentation: (unsigned int)indentation
 {
-	return [self OF_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: indentation
-				      level: 0];
+	return [self XMLStringWithIndentation: indentation
+					level: 0];
 }
 
 - (OFString*)XMLStringWithIndentation: (unsigned int)indentation
 				level: (unsigned int)level
 {
-	return [self OF_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: indentation
-				      level: level];
+	OFXMLElement_DataArrayStream *stream;
+	OFString *ret;
+
+	stream = [[OFXMLElement_DataArrayStream alloc] init];
+	@try {
+		[self OF_writeToStream: stream
+				parent: nil
+			    namespaces: nil
+			   indentation: indentation
+				 level: level];
+
+		ret = [OFString
+		    stringWithUTF8String: [stream->dataArray cArray]
+				  length: [stream->dataArray count]];
+	} @finally {
+		[stream release];
+	}
+
+	return ret;
 }
 
 - (OFXMLElement*)XMLElementBySerializing
@@ -941,6 +1032,9 @@ static Class CDATAClass = Nil;
 		children = [[OFMutableArray alloc] init];
 
 	[children addObject: child];
+
+	[childrenIndex release];
+	childrenIndex = nil;
 }
 
 - (void)removeChild: (OFXMLNode*)child
@@ -951,6 +1045,9 @@ static Class CDATAClass = Nil;
 			      selector: _cmd];
 
 	[children removeObject: child];
+
+	[childrenIndex release];
+	childrenIndex = nil;
 }
 
 - (OFXMLElement*)elementForName: (OFString*)elementName
@@ -1099,6 +1196,7 @@ static Class CDATAClass = Nil;
 	[attributes release];
 	[namespaces release];
 	[children release];
+	[childrenIndex release];
 
 	[super dealloc];
 }
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+@class OFString;
+
+struct of_xml_name_table_bucket {
+	OFString *name;
+	uint32_t hash;
+};
+
+/*!
+ * @brief A table which interns element names, attribute names, prefixes and
+ *	  namespaces.
+ *
+ * Looking up the same name twice always returns the same immutable string
+ * instance, so names returned by a name table can be compared by pointer.
+ * A name table can be shared by multiple OFXMLParsers, but it is not
+ * thread-safe.
+ */
+@interface OFXMLNameTable: OFObject
+{
+	struct of_xml_name_table_bucket *buckets;
+	uint32_t size, count;
+}
+
+/*!
+ * @brief Creates a new, empty name table.
+ *
+ * @return A new, autoreleased OFXMLNameTable
+ */
++ (instancetype)nameTable;
+
+/*!
+ * @brief Returns the interned string for the specified UTF-8 string.
+ *
+ * If the name is not in the table yet, a new string is created and added to
+ * the table. Nothing is allocated if the name is already in the table.
+ *
+ * The returned string is owned by the name table and stays valid as long as
+ * the name table exists. Retain it if you need it longer.
+ *
+ * @param UTF8String The UTF-8 string to intern
+ * @param length The length of the UTF-8 string
+ * @return The interned string for the specified UTF-8 string
+ */
+- (OFString*)nameForUTF8String: (const char*)UTF8String
+			length: (size_t)length;
+
+/*!
+ * @brief Returns the interned string for the specified string.
+ *
+ * If an equal string is not in the table yet, an immutable copy of the
+ * specified string is added to the table.
+ *
+ * The returned string is owned by the name table and stays valid as long as
+ * the name table exists. Retain it if you need it longer.
+ *
+ * @param string The string to intern
+ * @return The interned string equal to the specified string
+ */
+- (OFString*)nameForString: (OFString*)string;
+
+/*!
+ * @brief Returns the number of names in the table.
+ *
+ * @return The number of names in the table
+ */
+- (size_t)count;
+@end
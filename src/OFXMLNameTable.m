@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFXMLNameTable.h"
+#import "OFString.h"
+
+#import "OFOutOfRangeException.h"
+
+#import "macros.h"
+
+#define MIN_SIZE 64
+
+static OF_INLINE uint32_t
+hash_bytes(const char *bytes, size_t length)
+{
+	uint32_t hash;
+	size_t i;
+
+	OF_HASH_INIT(hash);
+
+	for (i = 0; i < length; i++)
+		OF_HASH_ADD(hash, bytes[i]);
+
+	OF_HASH_FINALIZE(hash);
+
+	return hash;
+}
+
+@implementation OFXMLNameTable
++ (instancetype)nameTable
+{
+	return [[[self alloc] init] autorelease];
+}
+
+- init
+{
+	self = [super init];
+
+	@try {
+		buckets = [self allocMemoryWithSize: sizeof(*buckets)
+					      count: MIN_SIZE];
+		memset(buckets, 0, sizeof(*buckets) * MIN_SIZE);
+		size = MIN_SIZE;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++)
+		[buckets[i].name release];
+
+	[super dealloc];
+}
+
+- (void)OF_resize
+{
+	struct of_xml_name_table_bucket *newBuckets;
+	uint32_t i, newSize;
+
+	if (size > UINT32_MAX / 2)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	newSize = size * 2;
+	newBuckets = [self allocMemoryWithSize: sizeof(*newBuckets)
+					 count: newSize];
+	memset(newBuckets, 0, sizeof(*newBuckets) * newSize);
+
+	for (i = 0; i < size; i++) {
+		uint32_t j;
+
+		if (buckets[i].name == nil)
+			continue;
+
+		for (j = buckets[i].hash & (newSize - 1);
+		    newBuckets[j].name != nil; j = (j + 1) & (newSize - 1));
+
+		newBuckets[j] = buckets[i];
+	}
+
+	[self freeMemory: buckets];
+	buckets = newBuckets;
+	size = newSize;
+}
+
+- (OFString*)OF_nameForUTF8String: (const char*)UTF8String
+			   length: (size_t)length
+			   string: (OFString*)string
+{
+	uint32_t i, hash = hash_bytes(UTF8String, length);
+
+	for (i = hash & (size - 1); buckets[i].name != nil;
+	    i = (i + 1) & (size - 1))
+		if (buckets[i].hash == hash &&
+		    [buckets[i].name UTF8StringLength] == length &&
+		    memcmp([buckets[i].name UTF8String], UTF8String,
+		    length) == 0)
+			return buckets[i].name;
+
+	if ((count + 1) * 4 > size * 3) {
+		[self OF_resize];
+
+		for (i = hash & (size - 1); buckets[i].name != nil;
+		    i = (i + 1) & (size - 1));
+	}
+
+	if (string != nil)
+		buckets[i].name = [string copy];
+	else
+		buckets[i].name = [[OFString alloc]
+		    initWithUTF8String: UTF8String
+				length: length];
+
+	buckets[i].hash = hash;
+	count++;
+
+	return buckets[i].name;
+}
+
+- (OFString*)nameForUTF8String: (const char*)UTF8String
+			length: (size_t)length
+{
+	return [self OF_nameForUTF8String: UTF8String
+				   length: length
+				   string: nil];
+}
+
+- (OFString*)nameForString: (OFString*)string
+{
+	if (string == nil)
+		return nil;
+
+	return [self OF_nameForUTF8String: [string UTF8String]
+				   length: [string UTF8StringLength]
+				   string: string];
+}
+
+- (size_t)count
+{
+	return count;
+}
+@end
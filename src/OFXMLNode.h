@@ -17,6 +17,8 @@
 #import "OFObject.h"
 #import "OFSerialization.h"
 
+@class OFStream;
+
 /*!
  * @brief A class which stores an XML element.
  */
@@ -84,4 +86,36 @@
  */
 - (OFString*)XMLStringWithIndentation: (unsigned int)indentation
 				level: (unsigned int)level;
+
+/*!
+ * @brief Writes the OFXMLNode as an XML string to the specified stream.
+ *
+ * Unlike @ref XMLString, this does not create a string for the whole node,
+ * which makes it the preferred way to write large documents.
+ *
+ * @param stream The stream to write the OFXMLNode to
+ */
+- (void)writeToStream: (OFStream*)stream;
+
+/*!
+ * @brief Writes the OFXMLNode as an XML string with indentation to the
+ *	  specified stream.
+ *
+ * @param stream The stream to write the OFXMLNode to
+ * @param indentation The indentation for the XML string
+ */
+- (void)writeToStream: (OFStream*)stream
+	  indentation: (unsigned int)indentation;
+
+/*!
+ * @brief Writes the OFXMLNode as an XML string with indentation for the
+ *	  specified level to the specified stream.
+ *
+ * @param stream The stream to write the OFXMLNode to
+ * @param indentation The indentation for the XML string
+ * @param level The level of indentation
+ */
+- (void)writeToStream: (OFStream*)stream
+	  indentation: (unsigned int)indentation
+		level: (unsigned int)level;
 @end
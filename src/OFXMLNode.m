@@ -18,9 +18,12 @@
 
 #import "OFXMLNode.h"
 #import "OFString.h"
+#import "OFStream.h"
 
 #import "OFNotImplementedException.h"
 
+#import "autorelease.h"
+
 @implementation OFXMLNode
 - initWithSerialization: (OFXMLElement*)element
 {
@@ -75,6 +78,33 @@
 						    selector: _cmd];
 }
 
+- (void)writeToStream: (OFStream*)stream
+{
+	[self writeToStream: stream
+		indentation: 0
+		      level: 0];
+}
+
+- (void)writeToStream: (OFStream*)stream
+	  indentation: (unsigned int)indentation
+{
+	[self writeToStream: stream
+		indentation: indentation
+		      level: 0];
+}
+
+- (void)writeToStream: (OFStream*)stream
+	  indentation: (unsigned int)indentation
+		level: (unsigned int)level
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	[stream writeString: [self XMLStringWithIndentation: indentation
+						      level: level]];
+
+	objc_autoreleasePoolPop(pool);
+}
+
 - (OFString*)description
 {
 	return [self XMLStringWithIndentation: 2];
@@ -19,11 +19,18 @@
 #import "OFXMLAttribute.h"
 
 @class OFXMLParser;
+@class OFXMLNameTable;
 @class OFArray;
 @class OFMutableArray;
 @class OFDataArray;
 @class OFStream;
 
+struct of_xml_parser_namespace {
+	OFString *prefix;
+	OFString *ns;
+	size_t level;
+};
+
 /*!
  * @brief A protocol that needs to be implemented by delegates for OFXMLParser.
  */
@@ -155,7 +162,9 @@
 	OFDataArray *cache;
 	OFString *name;
 	OFString *prefix;
-	OFMutableArray *namespaces;
+	OFXMLNameTable *nameTable;
+	struct of_xml_parser_namespace *namespaces;
+	size_t namespacesCount, namespacesSize;
 	OFMutableArray *attributes;
 	OFString *attributeName;
 	OFString *attributePrefix;
@@ -171,6 +180,7 @@
 
 #ifdef OF_HAVE_PROPERTIES
 @property (assign) id <OFXMLParserDelegate> delegate;
+@property (retain) OFXMLNameTable *nameTable;
 #endif
 
 /*!
@@ -194,6 +204,28 @@
  */
 - (void)setDelegate: (id <OFXMLParserDelegate>)delegate;
 
+/*!
+ * @brief Returns the name table used to intern names, prefixes and
+ *	  namespaces.
+ *
+ * @return The name table used to intern names, prefixes and namespaces
+ */
+- (OFXMLNameTable*)nameTable;
+
+/*!
+ * @brief Sets the name table used to intern names, prefixes and namespaces.
+ *
+ * By default, every parser has its own name table. Setting the same name table
+ * on several parsers makes all of them return the same string instances for
+ * the same names, which saves memory when the documents use the same
+ * vocabulary.
+ *
+ * This should be set before parsing starts.
+ *
+ * @param nameTable The name table to use
+ */
+- (void)setNameTable: (OFXMLNameTable*)nameTable;
+
 /*!
  * @brief Parses the specified buffer with the specified size.
  *
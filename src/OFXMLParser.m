@@ -25,13 +25,14 @@
 #import "OFXMLParser.h"
 #import "OFString.h"
 #import "OFArray.h"
-#import "OFDictionary.h"
 #import "OFDataArray.h"
 #import "OFXMLAttribute.h"
+#import "OFXMLNameTable.h"
 #import "OFStream.h"
 #import "OFFile.h"
 
 #import "OFInitializationFailedException.h"
+#import "OFInvalidArgumentException.h"
 #import "OFMalformedXMLException.h"
 #import "OFUnboundNamespaceException.h"
 
@@ -97,27 +98,26 @@ transform_string(OFDataArray *cache, size_t cut, BOOL unescape,
 	return ret;
 }
 
+/*
+ * All prefixes are interned in the parser's name table, so they can be
+ * compared by pointer. The default namespace is bound to the prefix nil.
+ */
 static OFString*
-namespace_for_prefix(OFString *prefix, OFArray *namespaces)
+namespace_for_prefix(OFString *prefix,
+    struct of_xml_parser_namespace *namespaces, size_t count)
 {
-	OFDictionary **objects = [namespaces objects];
 	ssize_t i;
 
-	if (prefix == nil)
-		prefix = @"";
-
-	for (i = [namespaces count] - 1; i >= 0; i--) {
-		OFString *tmp;
-
-		if ((tmp = [objects[i] objectForKey: prefix]) != nil)
-			return tmp;
-	}
+	for (i = (ssize_t)count - 1; i >= 0; i--)
+		if (namespaces[i].prefix == prefix)
+			return namespaces[i].ns;
 
 	return nil;
 }
 
 static OF_INLINE void
-resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
+resolve_attribute_namespace(OFXMLAttribute *attribute,
+    struct of_xml_parser_namespace *namespaces, size_t count,
     OFXMLParser *self)
 {
 	OFString *attributeNS;
@@ -126,7 +126,7 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	if (attributePrefix == nil)
 		return;
 
-	attributeNS = namespace_for_prefix(attributePrefix, namespaces);
+	attributeNS = namespace_for_prefix(attributePrefix, namespaces, count);
 
 	if ((attributePrefix != nil && attributeNS == nil))
 		@throw [OFUnboundNamespaceException
@@ -185,25 +185,19 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	self = [super init];
 
 	@try {
-		void *pool;
-		OFMutableDictionary *dict;
-
 		cache = [[OFBigDataArray alloc] init];
 		previous = [[OFMutableArray alloc] init];
-		namespaces = [[OFMutableArray alloc] init];
 		attributes = [[OFMutableArray alloc] init];
+		nameTable = [[OFXMLNameTable alloc] init];
 
-		pool = objc_autoreleasePoolPush();
-		dict = [OFMutableDictionary dictionaryWithKeysAndObjects:
-		    @"xml", @"http://www.w3.org/XML/1998/namespace",
-		    @"xmlns", @"http://www.w3.org/2000/xmlns/", nil];
-		[namespaces addObject: dict];
+		[self OF_addNamespace: @"http://www.w3.org/XML/1998/namespace"
+			    forPrefix: [nameTable nameForString: @"xml"]];
+		[self OF_addNamespace: @"http://www.w3.org/2000/xmlns/"
+			    forPrefix: [nameTable nameForString: @"xmlns"]];
 
 		acceptProlog = YES;
 		lineNumber = 1;
 		encoding = OF_STRING_ENCODING_UTF_8;
-
-		objc_autoreleasePoolPop(pool);
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -214,10 +208,17 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 
 - (void)dealloc
 {
+	size_t i;
+
+	for (i = 0; i < namespacesCount; i++) {
+		[namespaces[i].prefix release];
+		[namespaces[i].ns release];
+	}
+
 	[cache release];
 	[name release];
 	[prefix release];
-	[namespaces release];
+	[nameTable release];
 	[attributes release];
 	[attributeName release];
 	[attributePrefix release];
@@ -236,6 +237,59 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	delegate = delegate_;
 }
 
+- (OFXMLNameTable*)nameTable
+{
+	OF_GETTER(nameTable, YES)
+}
+
+- (void)setNameTable: (OFXMLNameTable*)nameTable_
+{
+	size_t i;
+
+	if (nameTable_ == nil)
+		@throw [OFInvalidArgumentException
+		    exceptionWithClass: [self class]
+			      selector: _cmd];
+
+	/* Prefixes are compared by pointer, so they need to be interned again */
+	for (i = 0; i < namespacesCount; i++) {
+		OFString *old = namespaces[i].prefix;
+
+		namespaces[i].prefix = [[nameTable_ nameForString: old] retain];
+		[old release];
+	}
+
+	OF_SETTER(nameTable, nameTable_, YES, 0)
+}
+
+- (void)OF_addNamespace: (OFString*)ns
+	      forPrefix: (OFString*)prefix_
+{
+	if (namespacesCount == namespacesSize) {
+		size_t newSize = (namespacesSize > 0 ? namespacesSize * 2 : 8);
+
+		namespaces = [self resizeMemory: namespaces
+					   size: sizeof(*namespaces)
+					  count: newSize];
+		namespacesSize = newSize;
+	}
+
+	namespaces[namespacesCount].prefix = [prefix_ retain];
+	namespaces[namespacesCount].ns = [ns retain];
+	namespaces[namespacesCount].level = [previous count];
+	namespacesCount++;
+}
+
+- (void)OF_removeNamespacesAboveLevel: (size_t)level_
+{
+	while (namespacesCount > 0 &&
+	    namespaces[namespacesCount - 1].level > level_) {
+		namespacesCount--;
+		[namespaces[namespacesCount].prefix release];
+		[namespaces[namespacesCount].ns release];
+	}
+}
+
 - (void)parseBuffer: (const char*)buffer
 	     length: (size_t)length
 {
@@ -507,7 +561,6 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 				  i: (size_t*)i
 			       last: (size_t*)last
 {
-	void *pool;
 	const char *cacheCString, *tmp;
 	size_t length, cacheLength;
 	OFString *cacheString;
@@ -519,29 +572,36 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	if ((length = *i - *last) > 0)
 		cache_append(cache, buffer + *last, encoding, length);
 
-	pool = objc_autoreleasePoolPush();
-
 	cacheCString = [cache cArray];
 	cacheLength = [cache count];
-	cacheString = [OFString stringWithUTF8String: cacheCString
-					      length: cacheLength];
+	cacheString = [nameTable nameForUTF8String: cacheCString
+					    length: cacheLength];
 
 	if ((tmp = memchr(cacheCString, ':', cacheLength)) != NULL) {
-		name = [[OFString alloc]
-		    initWithUTF8String: tmp + 1
-				length: cacheLength - (tmp - cacheCString) - 1];
-		prefix = [[OFString alloc]
-		    initWithUTF8String: cacheCString
-				length: tmp - cacheCString];
+		name = [[nameTable
+		    nameForUTF8String: tmp + 1
+			       length: cacheLength - (tmp - cacheCString) - 1]
+		    retain];
+		prefix = [[nameTable nameForUTF8String: cacheCString
+						length: tmp - cacheCString]
+		    retain];
 	} else {
-		name = [cacheString copy];
+		name = [cacheString retain];
 		prefix = nil;
 	}
 
+	/*
+	 * The element needs to be on the stack before its attributes are
+	 * parsed, as namespaces declared by them are bound to its level.
+	 */
+	if (buffer[*i] != '/')
+		[previous addObject: cacheString];
+
 	if (buffer[*i] == '>' || buffer[*i] == '/') {
+		void *pool = objc_autoreleasePoolPush();
 		OFString *ns;
 
-		ns = namespace_for_prefix(prefix, namespaces);
+		ns = namespace_for_prefix(prefix, namespaces, namespacesCount);
 
 		if (prefix != nil && ns == nil)
 			@throw [OFUnboundNamespaceException
@@ -562,8 +622,9 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 
 			if ([previous count] == 0)
 				finishedParsing = YES;
-		} else
-			[previous addObject: cacheString];
+		}
+
+		objc_autoreleasePoolPop(pool);
 
 		[name release];
 		[prefix release];
@@ -575,11 +636,6 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	} else
 		state = OF_XMLPARSER_IN_TAG;
 
-	if (buffer[*i] != '/')
-		[namespaces addObject: [OFMutableDictionary dictionary]];
-
-	objc_autoreleasePoolPop(pool);
-
 	[cache removeAllItems];
 	*last = *i + 1;
 }
@@ -602,26 +658,26 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	if ((length = *i - *last) > 0)
 		cache_append(cache, buffer + *last, encoding, length);
 
-	pool = objc_autoreleasePoolPush();
-
 	cacheCString = [cache cArray];
 	cacheLength = [cache count];
-	cacheString = [OFString stringWithUTF8String: cacheCString
-					      length: cacheLength];
+	cacheString = [nameTable nameForUTF8String: cacheCString
+					    length: cacheLength];
 
 	if ((tmp = memchr(cacheCString, ':', cacheLength)) != NULL) {
-		name = [[OFString alloc]
-		    initWithUTF8String: tmp + 1
-				length: cacheLength - (tmp - cacheCString) - 1];
-		prefix = [[OFString alloc]
-		    initWithUTF8String: cacheCString
-				length: tmp - cacheCString];
+		name = [[nameTable
+		    nameForUTF8String: tmp + 1
+			       length: cacheLength - (tmp - cacheCString) - 1]
+		    retain];
+		prefix = [[nameTable nameForUTF8String: cacheCString
+						length: tmp - cacheCString]
+		    retain];
 	} else {
-		name = [cacheString copy];
+		name = [cacheString retain];
 		prefix = nil;
 	}
 
-	if (![[previous lastObject] isEqual: cacheString])
+	if ([previous lastObject] != cacheString &&
+	    ![[previous lastObject] isEqual: cacheString])
 		@throw [OFMalformedXMLException exceptionWithClass: [self class]
 							    parser: self];
 
@@ -629,12 +685,14 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 
 	[cache removeAllItems];
 
-	ns = namespace_for_prefix(prefix, namespaces);
+	ns = namespace_for_prefix(prefix, namespaces, namespacesCount);
 	if (prefix != nil && ns == nil)
 		@throw [OFUnboundNamespaceException
 		    exceptionWithClass: [self class]
 				prefix: prefix];
 
+	pool = objc_autoreleasePoolPush();
+
 	[delegate parser: self
 	   didEndElement: name
 	      withPrefix: prefix
@@ -642,7 +700,7 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 
 	objc_autoreleasePoolPop(pool);
 
-	[namespaces removeLastObject];
+	[self OF_removeNamespacesAboveLevel: [previous count]];
 	[name release];
 	[prefix release];
 	name = prefix = nil;
@@ -680,7 +738,7 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	attributesObjects = [attributes objects];
 	attributesCount = [attributes count];
 
-	ns = namespace_for_prefix(prefix, namespaces);
+	ns = namespace_for_prefix(prefix, namespaces, namespacesCount);
 
 	if (prefix != nil && ns == nil)
 		@throw [OFUnboundNamespaceException
@@ -689,7 +747,7 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 
 	for (j = 0; j < attributesCount; j++)
 		resolve_attribute_namespace(attributesObjects[j], namespaces,
-		    self);
+		    namespacesCount, self);
 
 	pool = objc_autoreleasePoolPush();
 
@@ -705,16 +763,13 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 		      withPrefix: prefix
 		       namespace: ns];
 
+		[previous removeLastObject];
+
 		if ([previous count] == 0)
 			finishedParsing = YES;
 
-		[namespaces removeLastObject];
-	} else if (prefix != nil) {
-		OFString *str = [OFString stringWithFormat: @"%@:%@",
-							    prefix, name];
-		[previous addObject: str];
-	} else
-		[previous addObject: name];
+		[self OF_removeNamespacesAboveLevel: [previous count]];
+	}
 
 	objc_autoreleasePoolPop(pool);
 
@@ -734,8 +789,6 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 					i: (size_t*)i
 				     last: (size_t*)last
 {
-	void *pool;
-	OFMutableString *cacheString;
 	const char *cacheCString, *tmp;
 	size_t length, cacheLength;
 
@@ -745,31 +798,37 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	if ((length = *i - *last) > 0)
 		cache_append(cache, buffer + *last, encoding, length);
 
-	pool = objc_autoreleasePoolPush();
-
-	cacheString = [OFMutableString stringWithUTF8String: [cache cArray]
-						     length: [cache count]];
-	[cacheString deleteEnclosingWhitespaces];
-	/* Prevent a useless copy later */
-	[cacheString makeImmutable];
+	cacheCString = [cache cArray];
+	cacheLength = [cache count];
 
-	cacheCString = [cacheString UTF8String];
-	cacheLength = [cacheString UTF8StringLength];
+	/* Delete enclosing whitespaces */
+	while (cacheLength > 0 && (*cacheCString == ' ' ||
+	    *cacheCString == '\t' || *cacheCString == '\n' ||
+	    *cacheCString == '\r')) {
+		cacheCString++;
+		cacheLength--;
+	}
+	while (cacheLength > 0 && (cacheCString[cacheLength - 1] == ' ' ||
+	    cacheCString[cacheLength - 1] == '\t' ||
+	    cacheCString[cacheLength - 1] == '\n' ||
+	    cacheCString[cacheLength - 1] == '\r'))
+		cacheLength--;
 
 	if ((tmp = memchr(cacheCString, ':', cacheLength)) != NULL) {
-		attributeName = [[OFString alloc]
-		    initWithUTF8String: tmp + 1
-				length: cacheLength - (tmp - cacheCString) - 1];
-		attributePrefix = [[OFString alloc]
-		    initWithUTF8String: cacheCString
-				length: tmp - cacheCString];
+		attributeName = [[nameTable
+		    nameForUTF8String: tmp + 1
+			       length: cacheLength - (tmp - cacheCString) - 1]
+		    retain];
+		attributePrefix = [[nameTable
+		    nameForUTF8String: cacheCString
+			       length: tmp - cacheCString] retain];
 	} else {
-		attributeName = [cacheString copy];
+		attributeName = [[nameTable nameForUTF8String: cacheCString
+						       length: cacheLength]
+		    retain];
 		attributePrefix = nil;
 	}
 
-	objc_autoreleasePoolPop(pool);
-
 	[cache removeAllItems];
 
 	*last = *i + 1;
@@ -813,12 +872,15 @@ resolve_attribute_namespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	pool = objc_autoreleasePoolPush();
 	attributeValue = transform_string(cache, 0, YES, self);
 
-	if (attributePrefix == nil && [attributeName isEqual: @"xmlns"])
-		[[namespaces lastObject] setObject: attributeValue
-					    forKey: @""];
-	if ([attributePrefix isEqual: @"xmlns"])
-		[[namespaces lastObject] setObject: attributeValue
-					    forKey: attributeName];
+	if (attributePrefix == nil && [attributeName isEqual: @"xmlns"]) {
+		attributeValue = [nameTable nameForString: attributeValue];
+		[self OF_addNamespace: attributeValue
+			    forPrefix: nil];
+	} else if ([attributePrefix isEqual: @"xmlns"]) {
+		attributeValue = [nameTable nameForString: attributeValue];
+		[self OF_addNamespace: attributeValue
+			    forPrefix: attributeName];
+	}
 
 	[attributes addObject:
 	    [OFXMLAttribute attributeWithName: attributeName
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+@class OFString;
+@class OFArray;
+@class OFDictionary;
+@class OFEnumerator;
+@class OFXMLElement;
+
+#ifdef OF_HAVE_BLOCKS
+typedef void (^of_xml_query_enumeration_block_t)(OFXMLElement *element,
+    BOOL *stop);
+#endif
+
+struct of_xml_query_predicate {
+	OFString *name, *ns, *value;
+};
+
+struct of_xml_query_step {
+	OFString *name, *ns;
+	BOOL descendant, anyNamespace;
+	struct of_xml_query_predicate *predicates;
+	size_t predicatesCount;
+};
+
+/*!
+ * @brief A precompiled query which finds elements in an OFXMLElement tree.
+ *
+ * The query is compiled once from a path expression which is a subset of
+ * XPath:
+ *
+ *  * Steps are separated by <tt>/</tt> for the child axis and by <tt>//</tt>
+ *    for the descendant axis.
+ *  * A leading <tt>/</tt> or <tt>//</tt> makes the path start at the element
+ *    the query is evaluated on instead of at its children.
+ *  * Each step is either <tt>name</tt>, <tt>prefix:name</tt>,
+ *    <tt>prefix:*</tt> or <tt>*</tt>. Prefixes are resolved using the
+ *    namespaces passed when creating the query. Names without a prefix are in
+ *    the namespace for the prefix <tt>@""</tt> if there is one or in no
+ *    namespace otherwise. <tt>*</tt> matches all elements in all namespaces.
+ *  * Each step can be followed by any number of attribute predicates of the
+ *    form <tt>[\@name]</tt> or <tt>[\@name='value']</tt>, which may use a
+ *    prefix as well. Attribute names without a prefix are in no namespace.
+ *
+ * For example, <tt>//a:entry[\@type='text']/a:title</tt> finds the titles
+ * of all entries with type text in the namespace bound to the prefix a.
+ *
+ * Evaluating a query walks the tree only once and returns the elements in
+ * document order, without creating any intermediate arrays.
+ */
+@interface OFXMLQuery: OFObject
+{
+	struct of_xml_query_step *steps;
+	size_t stepsCount;
+	BOOL absolute, usesIndexes;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property BOOL usesIndexes;
+#endif
+
+/*!
+ * @brief Creates a new query from the specified path expression.
+ *
+ * @param string The path expression for the query
+ * @return A new, autoreleased OFXMLQuery
+ */
++ (instancetype)queryWithString: (OFString*)string;
+
+/*!
+ * @brief Creates a new query from the specified path expression, using the
+ *	  specified namespaces to resolve prefixes.
+ *
+ * @param string The path expression for the query
+ * @param namespaces A dictionary mapping prefixes to namespaces
+ * @return A new, autoreleased OFXMLQuery
+ */
++ (instancetype)queryWithString: (OFString*)string
+		     namespaces: (OFDictionary*)namespaces;
+
+/*!
+ * @brief Initializes an already allocated query with the specified path
+ *	  expression.
+ *
+ * @param string The path expression for the query
+ * @return An initialized OFXMLQuery
+ */
+- initWithString: (OFString*)string;
+
+/*!
+ * @brief Initializes an already allocated query with the specified path
+ *	  expression, using the specified namespaces to resolve prefixes.
+ *
+ * @param string The path expression for the query
+ * @param namespaces A dictionary mapping prefixes to namespaces
+ * @return An initialized OFXMLQuery
+ */
+- initWithString: (OFString*)string
+      namespaces: (OFDictionary*)namespaces;
+
+/*!
+ * @brief Returns whether the query uses name indexes.
+ *
+ * @return Whether the query uses name indexes
+ */
+- (BOOL)usesIndexes;
+
+/*!
+ * @brief Sets whether the query uses name indexes.
+ *
+ * If enabled, an element builds an index of its child elements by name the
+ * first time a child step with a name is evaluated on it and keeps it for all
+ * later queries. This speeds up repeated queries on elements with many
+ * children.
+ *
+ * The index is dropped when children are added to or removed from the
+ * element, but renaming a child after the index has been built is not
+ * noticed. Therefore, this should only be used on trees which are not modified
+ * anymore, e.g. parsed documents.
+ *
+ * @param usesIndexes Whether the query uses name indexes
+ */
+- (void)setUsesIndexes: (BOOL)usesIndexes;
+
+/*!
+ * @brief Returns an OFEnumerator which returns all elements matching the query
+ *	  in the specified element.
+ *
+ * The tree must not be modified while the enumerator is used.
+ *
+ * @param element The element to evaluate the query on
+ * @return An OFEnumerator for all matching elements
+ */
+- (OFEnumerator*)matchEnumeratorForElement: (OFXMLElement*)element;
+
+/*!
+ * @brief Returns the first element matching the query in the specified
+ *	  element.
+ *
+ * @param element The element to evaluate the query on
+ * @return The first matching element or nil
+ */
+- (OFXMLElement*)firstMatchInElement: (OFXMLElement*)element;
+
+/*!
+ * @brief Returns all elements matching the query in the specified element.
+ *
+ * @param element The element to evaluate the query on
+ * @return An array of all matching elements
+ */
+- (OFArray*)matchesInElement: (OFXMLElement*)element;
+
+#ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief Executes a block for each element matching the query in the
+ *	  specified element.
+ *
+ * The tree must not be modified while enumerating.
+ *
+ * @param element The element to evaluate the query on
+ * @param block The block to execute for each matching element
+ */
+- (void)enumerateMatchesInElement: (OFXMLElement*)element
+		       usingBlock: (of_xml_query_enumeration_block_t)block;
+#endif
+@end
@@ -0,0 +1,658 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFXMLQuery.h"
+#import "OFXMLElement.h"
+#import "OFXMLAttribute.h"
+#import "OFString.h"
+#import "OFArray.h"
+#import "OFDictionary.h"
+#import "OFEnumerator.h"
+
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+#import "OFUnboundNamespaceException.h"
+
+#import "autorelease.h"
+#import "macros.h"
+
+#define MAX_STEPS 64
+
+struct of_xml_query_frame {
+	id *objects;
+	size_t count, index;
+	uint64_t pending;
+};
+
+@interface OFXMLElement (OF_XMLQuery)
+- (BOOL)OF_matchesQueryStep: (struct of_xml_query_step*)step;
+- (OFArray*)OF_childrenForQuery;
+- (OFArray*)OF_indexedElementsForName: (OFString*)elementName;
+@end
+
+@interface OFXMLQueryEnumerator: OFEnumerator
+{
+	OFXMLQuery *query;
+	OFXMLElement *root;
+	struct of_xml_query_frame *stack;
+	size_t stackCount, stackSize;
+}
+
+- initWithQuery: (OFXMLQuery*)query
+	element: (OFXMLElement*)root;
+@end
+
+@interface OFXMLQuery (OF_XMLQueryEnumerator)
+- (BOOL)OF_isAbsolute;
+- (uint64_t)OF_matchElement: (OFXMLElement*)element
+		    pending: (uint64_t)pending
+		    isMatch: (BOOL*)isMatch;
+- (OFArray*)OF_childrenOfElement: (OFXMLElement*)element
+			 pending: (uint64_t)pending;
+@end
+
+static OF_INLINE BOOL
+is_special(char c)
+{
+	switch (c) {
+	case '/':
+	case '[':
+	case ']':
+	case '@':
+	case '=':
+	case ':':
+	case '\'':
+	case '"':
+	case '*':
+	case ' ':
+	case '\t':
+	case '\r':
+	case '\n':
+		return YES;
+	default:
+		return NO;
+	}
+}
+
+static size_t
+skip_whitespaces(const char *cString, size_t length, size_t i)
+{
+	while (i < length && (cString[i] == ' ' || cString[i] == '\t' ||
+	    cString[i] == '\r' || cString[i] == '\n'))
+		i++;
+
+	return i;
+}
+
+static size_t
+name_end(const char *cString, size_t length, size_t i)
+{
+	while (i < length && !is_special(cString[i]))
+		i++;
+
+	return i;
+}
+
+@implementation OFXMLElement (OF_XMLQuery)
+- (BOOL)OF_matchesQueryStep: (struct of_xml_query_step*)step
+{
+	OFXMLAttribute **objects;
+	size_t i, j, count;
+
+	if (step->name != nil && name != step->name &&
+	    ![name isEqual: step->name])
+		return NO;
+
+	if (!step->anyNamespace && ns != step->ns && ![ns isEqual: step->ns])
+		return NO;
+
+	if (step->predicatesCount == 0)
+		return YES;
+
+	objects = [attributes objects];
+	count = [attributes count];
+
+	for (i = 0; i < step->predicatesCount; i++) {
+		struct of_xml_query_predicate *predicate =
+		    &step->predicates[i];
+
+		for (j = 0; j < count; j++)
+			if ((objects[j]->name == predicate->name ||
+			    [objects[j]->name isEqual: predicate->name]) &&
+			    (objects[j]->ns == predicate->ns ||
+			    [objects[j]->ns isEqual: predicate->ns]))
+				break;
+
+		if (j == count)
+			return NO;
+
+		if (predicate->value != nil &&
+		    ![objects[j]->stringValue isEqual: predicate->value])
+			return NO;
+	}
+
+	return YES;
+}
+
+- (OFArray*)OF_childrenForQuery
+{
+	return children;
+}
+
+- (OFArray*)OF_indexedElementsForName: (OFString*)elementName
+{
+	if (children == nil)
+		return nil;
+
+	if (childrenIndex == nil) {
+		OFXMLElement **objects = [children objects];
+		size_t i, count = [children count];
+
+		childrenIndex = [[OFMutableDictionary alloc] init];
+
+		for (i = 0; i < count; i++) {
+			OFMutableArray *elements;
+
+			if (![objects[i] isKindOfClass: [OFXMLElement class]])
+				continue;
+
+			elements = [childrenIndex objectForKey:
+			    objects[i]->name];
+
+			if (elements == nil) {
+				elements = [[OFMutableArray alloc] init];
+				@try {
+					[childrenIndex
+					    setObject: elements
+					       forKey: objects[i]->name];
+				} @finally {
+					[elements release];
+				}
+			}
+
+			[elements addObject: objects[i]];
+		}
+	}
+
+	return [childrenIndex objectForKey: elementName];
+}
+@end
+
+@implementation OFXMLQueryEnumerator
+- initWithQuery: (OFXMLQuery*)query_
+	element: (OFXMLElement*)root_
+{
+	self = [super init];
+
+	@try {
+		query = [query_ retain];
+		root = [root_ retain];
+
+		stackSize = 16;
+		stack = [self allocMemoryWithSize: sizeof(*stack)
+					    count: stackSize];
+		[self reset];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[query release];
+	[root release];
+
+	[super dealloc];
+}
+
+- (void)OF_pushChildrenOfElement: (OFXMLElement*)element
+			 pending: (uint64_t)pending
+{
+	OFArray *elements;
+	size_t count;
+
+	elements = [query OF_childrenOfElement: element
+				       pending: pending];
+
+	if ((count = [elements count]) == 0)
+		return;
+
+	if (stackCount == stackSize) {
+		stack = [self resizeMemory: stack
+				      size: sizeof(*stack)
+				     count: stackSize * 2];
+		stackSize *= 2;
+	}
+
+	stack[stackCount].objects = [elements objects];
+	stack[stackCount].count = count;
+	stack[stackCount].index = 0;
+	stack[stackCount].pending = pending;
+	stackCount++;
+}
+
+- (id)nextObject
+{
+	while (stackCount > 0) {
+		struct of_xml_query_frame *frame = &stack[stackCount - 1];
+		OFXMLElement *element;
+		uint64_t pending;
+		BOOL isMatch;
+
+		if (frame->index >= frame->count) {
+			stackCount--;
+			continue;
+		}
+
+		element = frame->objects[frame->index++];
+
+		if (![element isKindOfClass: [OFXMLElement class]])
+			continue;
+
+		pending = [query OF_matchElement: element
+					 pending: frame->pending
+					 isMatch: &isMatch];
+
+		/* frame might be invalid after this */
+		if (pending != 0)
+			[self OF_pushChildrenOfElement: element
+					       pending: pending];
+
+		if (isMatch)
+			return element;
+	}
+
+	return nil;
+}
+
+- (void)reset
+{
+	stackCount = 0;
+
+	if ([query OF_isAbsolute]) {
+		stack[0].objects = (id*)&root;
+		stack[0].count = 1;
+		stack[0].index = 0;
+		stack[0].pending = 1;
+		stackCount = 1;
+	} else
+		[self OF_pushChildrenOfElement: root
+				       pending: 1];
+}
+@end
+
+@implementation OFXMLQuery
++ (instancetype)queryWithString: (OFString*)string
+{
+	return [[[self alloc] initWithString: string] autorelease];
+}
+
++ (instancetype)queryWithString: (OFString*)string
+		     namespaces: (OFDictionary*)namespaces
+{
+	return [[[self alloc] initWithString: string
+				  namespaces: namespaces] autorelease];
+}
+
+- initWithString: (OFString*)string
+{
+	return [self initWithString: string
+			 namespaces: nil];
+}
+
+- (size_t)OF_parseName: (OFString**)name
+	     namespace: (OFString**)ns
+	   fromCString: (const char*)cString
+		length: (size_t)length
+		 index: (size_t)i
+	    namespaces: (OFDictionary*)namespaces
+	    forElement: (BOOL)forElement
+{
+	size_t end = name_end(cString, length, i);
+
+	if (end < length && cString[end] == ':') {
+		OFString *prefix;
+
+		if (end == i)
+			@throw [OFInvalidFormatException
+			    exceptionWithClass: [self class]];
+
+		prefix = [OFString stringWithUTF8String: cString + i
+						 length: end - i];
+		if ((*ns = [namespaces objectForKey: prefix]) == nil)
+			@throw [OFUnboundNamespaceException
+			    exceptionWithClass: [self class]
+					prefix: prefix];
+
+		i = end + 1;
+
+		if (forElement && i < length && cString[i] == '*') {
+			*name = nil;
+			return i + 1;
+		}
+
+		end = name_end(cString, length, i);
+	} else
+		*ns = (forElement ? [namespaces objectForKey: @""] : nil);
+
+	if (end == i)
+		@throw [OFInvalidFormatException
+		    exceptionWithClass: [self class]];
+
+	*name = [OFString stringWithUTF8String: cString + i
+					length: end - i];
+
+	return end;
+}
+
+- (size_t)OF_parseStep: (struct of_xml_query_step*)step
+	   fromCString: (const char*)cString
+		length: (size_t)length
+		 index: (size_t)i
+	    namespaces: (OFDictionary*)namespaces
+{
+	OFString *name, *ns;
+
+	if (i < length && cString[i] == '*') {
+		step->anyNamespace = YES;
+		i++;
+	} else {
+		i = [self OF_parseName: &name
+			     namespace: &ns
+			   fromCString: cString
+				length: length
+				 index: i
+			    namespaces: namespaces
+			    forElement: YES];
+
+		step->name = [name copy];
+		step->ns = [ns copy];
+	}
+
+	while (i < length && cString[i] == '[') {
+		struct of_xml_query_predicate *predicate;
+		OFString *value = nil;
+
+		i = skip_whitespaces(cString, length, i + 1);
+
+		if (i >= length || cString[i] != '@')
+			@throw [OFInvalidFormatException
+			    exceptionWithClass: [self class]];
+
+		i = [self OF_parseName: &name
+			     namespace: &ns
+			   fromCString: cString
+				length: length
+				 index: i + 1
+			    namespaces: namespaces
+			    forElement: NO];
+		i = skip_whitespaces(cString, length, i);
+
+		if (i < length && cString[i] == '=') {
+			char quote;
+			size_t start;
+
+			i = skip_whitespaces(cString, length, i + 1);
+
+			if (i >= length ||
+			    (cString[i] != '\'' && cString[i] != '"'))
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			quote = cString[i++];
+			start = i;
+
+			while (i < length && cString[i] != quote)
+				i++;
+
+			if (i >= length)
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			value = [OFString stringWithUTF8String: cString + start
+							length: i - start];
+			i = skip_whitespaces(cString, length, i + 1);
+		}
+
+		if (i >= length || cString[i] != ']')
+			@throw [OFInvalidFormatException
+			    exceptionWithClass: [self class]];
+		i++;
+
+		step->predicates = [self
+		    resizeMemory: step->predicates
+			    size: sizeof(*step->predicates)
+			   count: step->predicatesCount + 1];
+		predicate = &step->predicates[step->predicatesCount++];
+		predicate->name = [name copy];
+		predicate->ns = [ns copy];
+		predicate->value = [value copy];
+	}
+
+	return i;
+}
+
+- initWithString: (OFString*)string
+      namespaces: (OFDictionary*)namespaces
+{
+	self = [super init];
+
+	@try {
+		void *pool = objc_autoreleasePoolPush();
+		const char *cString = [string UTF8String];
+		size_t length = [string UTF8StringLength], i = 0;
+
+		if (length > 0 && cString[0] == '/')
+			absolute = YES;
+
+		do {
+			struct of_xml_query_step *step;
+			BOOL descendant = NO;
+
+			if (cString[i] == '/') {
+				if (++i < length && cString[i] == '/') {
+					descendant = YES;
+					i++;
+				}
+			} else if (i > 0)
+				@throw [OFInvalidFormatException
+				    exceptionWithClass: [self class]];
+
+			if (stepsCount == MAX_STEPS)
+				@throw [OFOutOfRangeException
+				    exceptionWithClass: [self class]];
+
+			steps = [self resizeMemory: steps
+					      size: sizeof(*steps)
+					     count: stepsCount + 1];
+			step = &steps[stepsCount++];
+			memset(step, 0, sizeof(*step));
+			step->descendant = descendant;
+
+			i = [self OF_parseStep: step
+				   fromCString: cString
+					length: length
+					 index: i
+				    namespaces: namespaces];
+		} while (i < length);
+
+		objc_autoreleasePoolPop(pool);
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	size_t i, j;
+
+	for (i = 0; i < stepsCount; i++) {
+		[steps[i].name release];
+		[steps[i].ns release];
+
+		for (j = 0; j < steps[i].predicatesCount; j++) {
+			[steps[i].predicates[j].name release];
+			[steps[i].predicates[j].ns release];
+			[steps[i].predicates[j].value release];
+		}
+	}
+
+	[super dealloc];
+}
+
+- (BOOL)usesIndexes
+{
+	return usesIndexes;
+}
+
+- (void)setUsesIndexes: (BOOL)usesIndexes_
+{
+	usesIndexes = usesIndexes_;
+}
+
+- (BOOL)OF_isAbsolute
+{
+	return absolute;
+}
+
+- (uint64_t)OF_matchElement: (OFXMLElement*)element
+		    pending: (uint64_t)pending
+		    isMatch: (BOOL*)isMatch
+{
+	uint64_t childPending = 0;
+	size_t i;
+
+	*isMatch = NO;
+
+	for (i = 0; i < stepsCount; i++) {
+		if (!(pending & ((uint64_t)1 << i)))
+			continue;
+
+		/* Descendant steps stay pending for all levels below */
+		if (steps[i].descendant)
+			childPending |= (uint64_t)1 << i;
+
+		if (![element OF_matchesQueryStep: &steps[i]])
+			continue;
+
+		if (i == stepsCount - 1)
+			*isMatch = YES;
+		else
+			childPending |= (uint64_t)1 << (i + 1);
+	}
+
+	return childPending;
+}
+
+- (OFArray*)OF_childrenOfElement: (OFXMLElement*)element
+			 pending: (uint64_t)pending
+{
+	OFString *indexName = nil;
+	size_t i;
+
+	if (!usesIndexes)
+		return [element OF_childrenForQuery];
+
+	/*
+	 * The index can only be used if all pending steps are child steps
+	 * that test for the same name.
+	 */
+	for (i = 0; i < stepsCount; i++) {
+		if (!(pending & ((uint64_t)1 << i)))
+			continue;
+
+		if (steps[i].descendant || steps[i].name == nil)
+			return [element OF_childrenForQuery];
+
+		if (indexName == nil)
+			indexName = steps[i].name;
+		else if (![indexName isEqual: steps[i].name])
+			return [element OF_childrenForQuery];
+	}
+
+	return [element OF_indexedElementsForName: indexName];
+}
+
+- (OFEnumerator*)matchEnumeratorForElement: (OFXMLElement*)element
+{
+	return [[[OFXMLQueryEnumerator alloc]
+	    initWithQuery: self
+		  element: element] autorelease];
+}
+
+- (OFXMLElement*)firstMatchInElement: (OFXMLElement*)element
+{
+	OFXMLQueryEnumerator *enumerator;
+	OFXMLElement *ret;
+
+	enumerator = [[OFXMLQueryEnumerator alloc] initWithQuery: self
+							 element: element];
+	@try {
+		ret = [[enumerator nextObject] retain];
+	} @finally {
+		[enumerator release];
+	}
+
+	return [ret autorelease];
+}
+
+- (OFArray*)matchesInElement: (OFXMLElement*)element
+{
+	OFMutableArray *ret = [OFMutableArray array];
+	void *pool = objc_autoreleasePoolPush();
+	OFEnumerator *enumerator = [self matchEnumeratorForElement: element];
+	OFXMLElement *match;
+
+	while ((match = [enumerator nextObject]) != nil)
+		[ret addObject: match];
+
+	objc_autoreleasePoolPop(pool);
+
+	[ret makeImmutable];
+
+	return ret;
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)enumerateMatchesInElement: (OFXMLElement*)element
+		       usingBlock: (of_xml_query_enumeration_block_t)block
+{
+	OFXMLQueryEnumerator *enumerator;
+	BOOL stop = NO;
+
+	enumerator = [[OFXMLQueryEnumerator alloc] initWithQuery: self
+							 element: element];
+	@try {
+		OFXMLElement *match;
+
+		while (!stop && (match = [enumerator nextObject]) != nil)
+			block(match, &stop);
+	} @finally {
+		[enumerator release];
+	}
+}
+#endif
+@end
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include <string.h>
+
+#import "OFObject.h"
+#import "OFString.h"
+
+@class OFStream;
+@class OFArray;
+
+/*!
+ * @brief The type of a token returned by OFXMLReader.
+ */
+typedef enum of_xml_reader_token_t {
+	/// No token has been read yet
+	OF_XML_READER_TOKEN_NONE,
+	/// The start of an element
+	OF_XML_READER_TOKEN_START_ELEMENT,
+	/// The end of an element
+	OF_XML_READER_TOKEN_END_ELEMENT,
+	/// Characters
+	OF_XML_READER_TOKEN_CHARACTERS,
+	/// CDATA
+	OF_XML_READER_TOKEN_CDATA,
+	/// A comment
+	OF_XML_READER_TOKEN_COMMENT,
+	/// Processing instructions
+	OF_XML_READER_TOKEN_PROCESSING_INSTRUCTIONS,
+	/// The end of the document has been reached
+	OF_XML_READER_TOKEN_END_OF_DOCUMENT
+} of_xml_reader_token_t;
+
+/*!
+ * @brief A slice of the buffer of an OFXMLReader.
+ *
+ * A slice is only valid until the next token is read.
+ */
+typedef struct of_xml_slice_t {
+	/// The bytes of the slice, not terminated by a zero byte
+	const char *bytes;
+	/// The length of the slice
+	size_t length;
+} of_xml_slice_t;
+
+/*!
+ * @brief Returns whether the slice is equal to the specified C string.
+ *
+ * @param slice The slice to compare
+ * @param cString The C string to compare the slice with
+ * @return Whether the slice is equal to the specified C string
+ */
+static OF_INLINE BOOL
+of_xml_slice_is_equal(of_xml_slice_t slice, const char *cString)
+{
+	size_t length = strlen(cString);
+
+	return (slice.length == length &&
+	    memcmp(slice.bytes, cString, length) == 0);
+}
+
+struct of_xml_reader_attribute {
+	size_t nameStart, nameLength, prefixLength;
+	size_t valueStart, valueLength;
+};
+
+struct of_xml_reader_namespace {
+	OFString *prefix;
+	OFString *ns;
+	size_t depth;
+};
+
+/*!
+ * @brief A pull-based XML reader.
+ *
+ * Unlike OFXMLParser, which calls a delegate for everything it finds,
+ * OFXMLReader returns one token at a time when asked for it via
+ * @ref nextToken. Names, attributes and text are returned as slices which
+ * point directly into the buffer of the reader, so nothing is copied and no
+ * object is created unless a string is explicitly requested. This makes it
+ * possible to skip over irrelevant parts of a document without any
+ * allocations.
+ *
+ * Empty elements like <tt>&lt;foo/&gt;</tt> are returned as a start element
+ * token immediately followed by an end element token.
+ */
+@interface OFXMLReader: OFObject
+{
+	OFStream *stream;
+	char *buffer;
+	size_t bufferSize, bufferLength, tokenStart, position;
+	of_xml_reader_token_t token;
+	size_t nameStart, nameLength, prefixLength;
+	size_t contentStart, contentLength;
+	struct of_xml_reader_attribute *attributes;
+	size_t attributesCount, attributesSize;
+	char *elementNames;
+	size_t elementNamesLength, elementNamesSize;
+	size_t *elementNameStarts;
+	size_t depth, elementNameStartsSize;
+	struct of_xml_reader_namespace *namespaces;
+	size_t namespacesCount, namespacesSize;
+	of_string_encoding_t encoding;
+	BOOL emptyElement, pendingEndElement, finishedRootElement;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property of_string_encoding_t encoding;
+#endif
+
+/*!
+ * @brief Creates a new XML reader which reads from the specified stream.
+ *
+ * @param stream The stream to read from
+ * @return A new, autoreleased OFXMLReader
+ */
++ (instancetype)readerWithStream: (OFStream*)stream;
+
+/*!
+ * @brief Creates a new XML reader which reads from the specified buffer.
+ *
+ * @warning The buffer is not copied and must stay valid as long as the reader
+ *	    is used!
+ *
+ * @param buffer The buffer to read from
+ * @param length The length of the buffer
+ * @return A new, autoreleased OFXMLReader
+ */
++ (instancetype)readerWithBuffer: (const char*)buffer
+			  length: (size_t)length;
+
+/*!
+ * @brief Initializes an already allocated XML reader to read from the
+ *	  specified stream.
+ *
+ * @param stream The stream to read from
+ * @return An initialized OFXMLReader
+ */
+- initWithStream: (OFStream*)stream;
+
+/*!
+ * @brief Initializes an already allocated XML reader to read from the
+ *	  specified buffer.
+ *
+ * @warning The buffer is not copied and must stay valid as long as the reader
+ *	    is used!
+ *
+ * @param buffer The buffer to read from
+ * @param length The length of the buffer
+ * @return An initialized OFXMLReader
+ */
+- initWithBuffer: (const char*)buffer
+	  length: (size_t)length;
+
+/*!
+ * @brief Returns the encoding used to create strings.
+ *
+ * @return The encoding used to create strings
+ */
+- (of_string_encoding_t)encoding;
+
+/*!
+ * @brief Sets the encoding used to create strings.
+ *
+ * Only UTF-8 and encodings which are a superset of ASCII are supported.
+ *
+ * @param encoding The encoding used to create strings
+ */
+- (void)setEncoding: (of_string_encoding_t)encoding;
+
+/*!
+ * @brief Reads the next token.
+ *
+ * All slices of the previous token become invalid.
+ *
+ * @return The type of the token that has been read
+ */
+- (of_xml_reader_token_t)nextToken;
+
+/*!
+ * @brief Returns the type of the current token.
+ *
+ * @return The type of the current token
+ */
+- (of_xml_reader_token_t)token;
+
+/*!
+ * @brief Returns the depth of the current token.
+ *
+ * The start and end element tokens of the root element as well as everything
+ * directly inside the root element have depth 1.
+ *
+ * @return The depth of the current token
+ */
+- (size_t)depth;
+
+/*!
+ * @brief Returns whether the current start element token is an empty element.
+ *
+ * @return Whether the current start element token is an empty element
+ */
+- (BOOL)isEmptyElement;
+
+/*!
+ * @brief Skips the element that was started by the current token, including
+ *	  all of its children, without creating any objects.
+ *
+ * If the current token is not a start element token, this does nothing. After
+ * this, the current token is the end element token of the skipped element.
+ */
+- (void)skipElement;
+
+/*!
+ * @brief Returns the qualified name of the current element as a slice.
+ *
+ * @return The qualified name of the current element as a slice
+ */
+- (of_xml_slice_t)qualifiedNameSlice;
+
+/*!
+ * @brief Returns the local name of the current element as a slice.
+ *
+ * @return The local name of the current element as a slice
+ */
+- (of_xml_slice_t)nameSlice;
+
+/*!
+ * @brief Returns the prefix of the current element as a slice.
+ *
+ * The slice has a length of 0 if the element has no prefix.
+ *
+ * @return The prefix of the current element as a slice
+ */
+- (of_xml_slice_t)prefixSlice;
+
+/*!
+ * @brief Returns the raw content of the current characters, CDATA, comment or
+ *	  processing instructions token as a slice.
+ *
+ * For characters, entities are not unescaped.
+ *
+ * @return The raw content of the current token as a slice
+ */
+- (of_xml_slice_t)contentSlice;
+
+/*!
+ * @brief Returns the number of attributes of the current start element token.
+ *
+ * @return The number of attributes of the current start element token
+ */
+- (size_t)attributesCount;
+
+/*!
+ * @brief Returns the local name of the attribute at the specified index as a
+ *	  slice.
+ *
+ * @param index The index of the attribute
+ * @return The local name of the attribute as a slice
+ */
+- (of_xml_slice_t)attributeNameSliceAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the prefix of the attribute at the specified index as a
+ *	  slice.
+ *
+ * @param index The index of the attribute
+ * @return The prefix of the attribute as a slice
+ */
+- (of_xml_slice_t)attributePrefixSliceAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the raw value of the attribute at the specified index as a
+ *	  slice.
+ *
+ * Entities are not unescaped.
+ *
+ * @param index The index of the attribute
+ * @return The raw value of the attribute as a slice
+ */
+- (of_xml_slice_t)attributeValueSliceAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the local name of the current element as a string.
+ *
+ * @return The local name of the current element as a new autoreleased string
+ */
+- (OFString*)name;
+
+/*!
+ * @brief Returns the prefix of the current element as a string.
+ *
+ * @return The prefix of the current element as a new autoreleased string or
+ *	   nil
+ */
+- (OFString*)prefix;
+
+/*!
+ * @brief Returns the namespace of the current element.
+ *
+ * @return The namespace of the current element or nil
+ */
+- (OFString*)namespace;
+
+/*!
+ * @brief Returns the content of the current characters, CDATA, comment or
+ *	  processing instructions token as a string.
+ *
+ * For characters, entities are unescaped.
+ *
+ * @return The content of the current token as a new autoreleased string
+ */
+- (OFString*)stringValue;
+
+/*!
+ * @brief Returns the unescaped value of the attribute at the specified index
+ *	  as a string.
+ *
+ * @param index The index of the attribute
+ * @return The value of the attribute as a new autoreleased string
+ */
+- (OFString*)attributeValueAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the unescaped value of the attribute with the specified name
+ *	  and without a prefix.
+ *
+ * @param name The name of the attribute as a C string
+ * @return The value of the attribute as a new autoreleased string or nil
+ */
+- (OFString*)attributeValueForName: (const char*)name;
+
+/*!
+ * @brief Returns the namespace of the attribute at the specified index.
+ *
+ * @param index The index of the attribute
+ * @return The namespace of the attribute or nil
+ */
+- (OFString*)attributeNamespaceAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the attributes of the current start element token as an array
+ *	  of OFXMLAttributes.
+ *
+ * @return The attributes of the current element as an array of
+ *	   OFXMLAttributes
+ */
+- (OFArray*)attributes;
+@end
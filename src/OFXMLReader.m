@@ -0,0 +1,940 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <sys/types.h>
+
+#import "OFXMLReader.h"
+#import "OFString.h"
+#import "OFArray.h"
+#import "OFStream.h"
+#import "OFXMLAttribute.h"
+
+#import "OFMalformedXMLException.h"
+#import "OFOutOfRangeException.h"
+#import "OFUnboundNamespaceException.h"
+
+#import "autorelease.h"
+#import "macros.h"
+#import "of_xml.h"
+
+#define XML_NS @"http://www.w3.org/XML/1998/namespace"
+#define XMLNS_NS @"http://www.w3.org/2000/xmlns/"
+
+/*
+ * All offsets are relative to tokenStart. The buffer is only compacted while
+ * a new token is being scanned, so the offsets of the current token stay
+ * valid until nextToken is called again.
+ */
+#define CHAR(i) buffer[tokenStart + (i)]
+#define HAVE(i) (tokenStart + (i) < bufferLength || [self OF_fillBufferTo: (i)])
+#define MALFORMED							\
+	@throw [OFMalformedXMLException exceptionWithClass: [self class] \
+						    parser: nil]
+
+static OF_INLINE BOOL
+is_whitespace(char c)
+{
+	return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+static OF_INLINE of_xml_slice_t
+slice(const char *bytes, size_t length)
+{
+	of_xml_slice_t ret = { bytes, length };
+
+	return ret;
+}
+
+@implementation OFXMLReader
++ (instancetype)readerWithStream: (OFStream*)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
++ (instancetype)readerWithBuffer: (const char*)buffer_
+			  length: (size_t)length
+{
+	return [[[self alloc] initWithBuffer: buffer_
+				      length: length] autorelease];
+}
+
+- initWithStream: (OFStream*)stream_
+{
+	self = [super init];
+
+	@try {
+		stream = [stream_ retain];
+		buffer = [self allocMemoryWithSize: of_pagesize];
+		bufferSize = of_pagesize;
+		encoding = OF_STRING_ENCODING_UTF_8;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- initWithBuffer: (const char*)buffer_
+	  length: (size_t)length
+{
+	self = [super init];
+
+	/*
+	 * The buffer is never written to if there is no stream, thus it is
+	 * safe to cast away the const.
+	 */
+	buffer = (char*)buffer_;
+	bufferSize = bufferLength = length;
+	encoding = OF_STRING_ENCODING_UTF_8;
+
+	return self;
+}
+
+- (void)dealloc
+{
+	size_t i;
+
+	for (i = 0; i < namespacesCount; i++) {
+		[namespaces[i].prefix release];
+		[namespaces[i].ns release];
+	}
+
+	[stream release];
+
+	[super dealloc];
+}
+
+- (of_string_encoding_t)encoding
+{
+	return encoding;
+}
+
+- (void)setEncoding: (of_string_encoding_t)encoding_
+{
+	encoding = encoding_;
+}
+
+- (BOOL)OF_fillBuffer
+{
+	if (stream == nil)
+		return NO;
+
+	if (tokenStart > 0) {
+		memmove(buffer, buffer + tokenStart, bufferLength - tokenStart);
+		bufferLength -= tokenStart;
+		position -= tokenStart;
+		tokenStart = 0;
+	}
+
+	if (bufferLength == bufferSize) {
+		buffer = [self resizeMemory: buffer
+				       size: bufferSize * 2];
+		bufferSize *= 2;
+	}
+
+	while (![stream isAtEndOfStream]) {
+		size_t length = [stream readIntoBuffer: buffer + bufferLength
+						length: bufferSize -
+							bufferLength];
+
+		if (length > 0) {
+			bufferLength += length;
+			return YES;
+		}
+	}
+
+	return NO;
+}
+
+- (BOOL)OF_fillBufferTo: (size_t)i
+{
+	while (tokenStart + i >= bufferLength)
+		if (![self OF_fillBuffer])
+			return NO;
+
+	return YES;
+}
+
+- (size_t)OF_find: (const char*)needle
+	   length: (size_t)needleLength
+	     from: (size_t)i
+{
+	for (;;) {
+		size_t available = bufferLength - tokenStart;
+
+		if (available >= i + needleLength) {
+			const char *start = buffer + tokenStart;
+			size_t last = available - needleLength;
+
+			while (i <= last) {
+				const char *found = memchr(start + i,
+				    needle[0], last - i + 1);
+
+				if (found == NULL)
+					break;
+
+				i = found - start;
+
+				if (memcmp(found, needle, needleLength) == 0)
+					return i;
+
+				i++;
+			}
+
+			i = last + 1;
+		}
+
+		if (![self OF_fillBuffer])
+			return OF_NOT_FOUND;
+	}
+}
+
+- (OFString*)OF_stringAt: (size_t)start
+		  length: (size_t)length
+{
+	return of_xml_string(buffer + tokenStart + start, length, encoding);
+}
+
+- (OFString*)OF_textAt: (size_t)start
+		length: (size_t)length
+	      unescape: (BOOL)unescape
+{
+	return of_xml_text(buffer + tokenStart + start, length, encoding,
+	    unescape);
+}
+
+- (OFString*)OF_namespaceForPrefix: (const char*)prefix
+			    length: (size_t)length
+{
+	ssize_t i;
+
+	for (i = namespacesCount - 1; i >= 0; i--)
+		if ([namespaces[i].prefix UTF8StringLength] == length &&
+		    memcmp([namespaces[i].prefix UTF8String], prefix,
+		    length) == 0)
+			return namespaces[i].ns;
+
+	if (length == 3 && memcmp(prefix, "xml", 3) == 0)
+		return XML_NS;
+	if (length == 5 && memcmp(prefix, "xmlns", 5) == 0)
+		return XMLNS_NS;
+
+	return nil;
+}
+
+- (void)OF_addNamespace: (OFString*)ns
+	      forPrefix: (OFString*)prefix
+{
+	if (namespacesCount == namespacesSize) {
+		size_t newSize = (namespacesSize > 0 ? namespacesSize * 2 : 4);
+
+		namespaces = [self resizeMemory: namespaces
+					   size: sizeof(*namespaces)
+					  count: newSize];
+		namespacesSize = newSize;
+	}
+
+	namespaces[namespacesCount].prefix = [prefix retain];
+	namespaces[namespacesCount].ns = [ns retain];
+	namespaces[namespacesCount].depth = depth;
+	namespacesCount++;
+}
+
+- (void)OF_parseXMLDeclaration
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *declaration = [self OF_stringAt: contentStart
+					   length: contentLength];
+	of_range_t range = [declaration rangeOfString: @"encoding"];
+	OFString *value;
+	size_t i, length;
+	const char *cString;
+	char delimiter;
+
+	if (range.location == OF_NOT_FOUND) {
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	cString = [declaration UTF8String];
+	length = [declaration UTF8StringLength];
+	i = range.location + 8;
+
+	while (i < length && is_whitespace(cString[i]))
+		i++;
+	if (i >= length || cString[i++] != '=')
+		MALFORMED;
+	while (i < length && is_whitespace(cString[i]))
+		i++;
+	if (i >= length || (cString[i] != '\'' && cString[i] != '"'))
+		MALFORMED;
+
+	delimiter = cString[i++];
+	range.location = i;
+
+	while (i < length && cString[i] != delimiter)
+		i++;
+	if (i >= length)
+		MALFORMED;
+
+	value = [[OFString stringWithUTF8String: cString + range.location
+					 length: i - range.location]
+	    lowercaseString];
+
+	if ([value isEqual: @"utf-8"])
+		encoding = OF_STRING_ENCODING_UTF_8;
+	else if ([value isEqual: @"iso-8859-1"])
+		encoding = OF_STRING_ENCODING_ISO_8859_1;
+	else if ([value isEqual: @"iso-8859-15"])
+		encoding = OF_STRING_ENCODING_ISO_8859_15;
+	else if ([value isEqual: @"windows-1252"])
+		encoding = OF_STRING_ENCODING_WINDOWS_1252;
+	else
+		MALFORMED;
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (size_t)OF_parseStartElement
+{
+	size_t i = 1, j;
+
+	/* Name */
+	prefixLength = 0;
+	for (;;) {
+		char c;
+
+		if (!HAVE(i))
+			MALFORMED;
+
+		c = CHAR(i);
+
+		if (is_whitespace(c) || c == '/' || c == '>')
+			break;
+
+		if (c == ':' && prefixLength == 0)
+			prefixLength = i - 1;
+
+		i++;
+	}
+
+	nameStart = 1;
+	nameLength = i - 1;
+
+	if (nameLength == 0)
+		MALFORMED;
+
+	/* Attributes */
+	attributesCount = 0;
+	for (;;) {
+		struct of_xml_reader_attribute *attribute;
+		char delimiter;
+
+		while (HAVE(i) && is_whitespace(CHAR(i)))
+			i++;
+
+		if (!HAVE(i))
+			MALFORMED;
+
+		if (CHAR(i) == '>') {
+			emptyElement = NO;
+			i++;
+			break;
+		}
+
+		if (CHAR(i) == '/') {
+			if (!HAVE(i + 1) || CHAR(i + 1) != '>')
+				MALFORMED;
+
+			emptyElement = YES;
+			i += 2;
+			break;
+		}
+
+		if (attributesCount == attributesSize) {
+			size_t newSize = (attributesSize > 0
+			    ? attributesSize * 2 : 8);
+
+			attributes = [self resizeMemory: attributes
+						   size: sizeof(*attributes)
+						  count: newSize];
+			attributesSize = newSize;
+		}
+
+		attribute = &attributes[attributesCount];
+		attribute->nameStart = i;
+		attribute->prefixLength = 0;
+
+		while (HAVE(i) && !is_whitespace(CHAR(i)) && CHAR(i) != '=') {
+			if (CHAR(i) == '>' || CHAR(i) == '/' ||
+			    CHAR(i) == '<' || CHAR(i) == '"' ||
+			    CHAR(i) == '\'')
+				MALFORMED;
+
+			if (CHAR(i) == ':' && attribute->prefixLength == 0)
+				attribute->prefixLength =
+				    i - attribute->nameStart;
+
+			i++;
+		}
+
+		attribute->nameLength = i - attribute->nameStart;
+
+		while (HAVE(i) && is_whitespace(CHAR(i)))
+			i++;
+		if (!HAVE(i) || CHAR(i) != '=')
+			MALFORMED;
+		i++;
+
+		while (HAVE(i) && is_whitespace(CHAR(i)))
+			i++;
+		if (!HAVE(i) || (CHAR(i) != '\'' && CHAR(i) != '"'))
+			MALFORMED;
+
+		delimiter = CHAR(i);
+		attribute->valueStart = ++i;
+
+		if ((j = [self OF_find: &delimiter
+				length: 1
+				  from: i]) == OF_NOT_FOUND)
+			MALFORMED;
+
+		attribute->valueLength = j - i;
+		attributesCount++;
+
+		i = j + 1;
+	}
+
+	return i;
+}
+
+- (void)OF_startElement
+{
+	size_t i;
+
+	if (finishedRootElement && depth == 0)
+		MALFORMED;
+
+	/*
+	 * The names of the open elements are kept in a stack of their own, as
+	 * the buffer is compacted and overwritten while reading.
+	 */
+	if (depth == elementNameStartsSize) {
+		size_t newSize = (elementNameStartsSize > 0
+		    ? elementNameStartsSize * 2 : 16);
+
+		elementNameStarts = [self
+		    resizeMemory: elementNameStarts
+			    size: sizeof(*elementNameStarts)
+			   count: newSize];
+		elementNameStartsSize = newSize;
+	}
+
+	if (nameLength > SIZE_MAX - elementNamesLength)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	if (elementNamesLength + nameLength > elementNamesSize) {
+		size_t newSize = (elementNamesSize > 0 ? elementNamesSize : 64);
+
+		while (newSize < elementNamesLength + nameLength)
+			newSize *= 2;
+
+		elementNames = [self resizeMemory: elementNames
+					     size: newSize];
+		elementNamesSize = newSize;
+	}
+
+	memcpy(elementNames + elementNamesLength, buffer + tokenStart +
+	    nameStart, nameLength);
+	elementNameStarts[depth++] = elementNamesLength;
+	elementNamesLength += nameLength;
+
+	for (i = 0; i < attributesCount; i++) {
+		struct of_xml_reader_attribute *attribute = &attributes[i];
+		const char *attributeName = buffer + tokenStart +
+		    attribute->nameStart;
+		void *pool;
+
+		if (attribute->prefixLength == 0 &&
+		    attribute->nameLength == 5 &&
+		    memcmp(attributeName, "xmlns", 5) == 0) {
+			pool = objc_autoreleasePoolPush();
+
+			[self OF_addNamespace: [self attributeValueAtIndex: i]
+				    forPrefix: @""];
+
+			objc_autoreleasePoolPop(pool);
+		} else if (attribute->prefixLength == 5 &&
+		    memcmp(attributeName, "xmlns", 5) == 0) {
+			pool = objc_autoreleasePoolPush();
+
+			[self OF_addNamespace: [self attributeValueAtIndex: i]
+				    forPrefix: [self OF_stringAt:
+						   attribute->nameStart + 6
+							  length:
+						   attribute->nameLength - 6]];
+
+			objc_autoreleasePoolPop(pool);
+		}
+	}
+
+	if (emptyElement)
+		pendingEndElement = YES;
+}
+
+- (size_t)OF_parseEndElement
+{
+	size_t i;
+	const char *tmp;
+
+	if ((i = [self OF_find: ">"
+			length: 1
+			  from: 2]) == OF_NOT_FOUND)
+		MALFORMED;
+
+	nameStart = 2;
+	nameLength = i - 2;
+
+	while (nameLength > 0 &&
+	    is_whitespace(CHAR(nameStart + nameLength - 1)))
+		nameLength--;
+
+	if ((tmp = memchr(buffer + tokenStart + nameStart, ':',
+	    nameLength)) != NULL)
+		prefixLength = tmp - (buffer + tokenStart + nameStart);
+	else
+		prefixLength = 0;
+
+	if (depth == 0 ||
+	    elementNamesLength - elementNameStarts[depth - 1] != nameLength ||
+	    memcmp(elementNames + elementNameStarts[depth - 1],
+	    buffer + tokenStart + nameStart, nameLength) != 0)
+		MALFORMED;
+
+	return i + 1;
+}
+
+- (size_t)OF_skipDoctype
+{
+	size_t i = 9, level = 1;
+
+	for (;;) {
+		if (!HAVE(i))
+			MALFORMED;
+
+		if (CHAR(i) == '<')
+			level++;
+		else if (CHAR(i) == '>' && --level == 0)
+			return i + 1;
+
+		i++;
+	}
+}
+
+- (of_xml_reader_token_t)nextToken
+{
+	if (pendingEndElement) {
+		pendingEndElement = NO;
+		attributesCount = 0;
+
+		if (depth == 1)
+			finishedRootElement = YES;
+
+		return (token = OF_XML_READER_TOKEN_END_ELEMENT);
+	}
+
+	if (token == OF_XML_READER_TOKEN_END_ELEMENT) {
+		elementNamesLength = elementNameStarts[--depth];
+
+		while (namespacesCount > 0 &&
+		    namespaces[namespacesCount - 1].depth > depth) {
+			namespacesCount--;
+			[namespaces[namespacesCount].prefix release];
+			[namespaces[namespacesCount].ns release];
+		}
+	}
+
+	attributesCount = 0;
+	emptyElement = NO;
+
+	for (;;) {
+		size_t i;
+
+		tokenStart = position;
+
+		if (!HAVE(0)) {
+			if (depth > 0)
+				MALFORMED;
+
+			return (token = OF_XML_READER_TOKEN_END_OF_DOCUMENT);
+		}
+
+		/* Characters */
+		if (CHAR(0) != '<') {
+			if ((i = [self OF_find: "<"
+					length: 1
+					  from: 0]) == OF_NOT_FOUND)
+				i = bufferLength - tokenStart;
+
+			position = tokenStart + i;
+
+			if (depth == 0) {
+				size_t j;
+
+				for (j = 0; j < i; j++)
+					if (!is_whitespace(CHAR(j)))
+						MALFORMED;
+
+				continue;
+			}
+
+			contentStart = 0;
+			contentLength = i;
+
+			return (token = OF_XML_READER_TOKEN_CHARACTERS);
+		}
+
+		if (!HAVE(1))
+			MALFORMED;
+
+		switch (CHAR(1)) {
+		case '?':
+			if ((i = [self OF_find: "?>"
+					length: 2
+					  from: 2]) == OF_NOT_FOUND)
+				MALFORMED;
+
+			contentStart = 2;
+			contentLength = i - 2;
+			position = tokenStart + i + 2;
+
+			if (contentLength >= 4 &&
+			    memcmp(buffer + tokenStart + 2, "xml", 3) == 0 &&
+			    is_whitespace(CHAR(5)))
+				[self OF_parseXMLDeclaration];
+
+			return (token =
+			    OF_XML_READER_TOKEN_PROCESSING_INSTRUCTIONS);
+		case '!':
+			if (HAVE(3) && CHAR(2) == '-' && CHAR(3) == '-') {
+				if ((i = [self OF_find: "-->"
+						length: 3
+						  from: 4]) == OF_NOT_FOUND)
+					MALFORMED;
+
+				contentStart = 4;
+				contentLength = i - 4;
+				position = tokenStart + i + 3;
+
+				return (token = OF_XML_READER_TOKEN_COMMENT);
+			}
+
+			if (HAVE(8) && memcmp(buffer + tokenStart + 2,
+			    "[CDATA[", 7) == 0) {
+				if (depth == 0)
+					MALFORMED;
+
+				if ((i = [self OF_find: "]]>"
+						length: 3
+						  from: 9]) == OF_NOT_FOUND)
+					MALFORMED;
+
+				contentStart = 9;
+				contentLength = i - 9;
+				position = tokenStart + i + 3;
+
+				return (token = OF_XML_READER_TOKEN_CDATA);
+			}
+
+			if (HAVE(8) && memcmp(buffer + tokenStart + 2,
+			    "DOCTYPE", 7) == 0 && depth == 0 &&
+			    !finishedRootElement) {
+				position = tokenStart + [self OF_skipDoctype];
+				continue;
+			}
+
+			MALFORMED;
+		case '/':
+			position = tokenStart + [self OF_parseEndElement];
+
+			if (depth == 1)
+				finishedRootElement = YES;
+
+			return (token = OF_XML_READER_TOKEN_END_ELEMENT);
+		default:
+			position = tokenStart + [self OF_parseStartElement];
+			[self OF_startElement];
+
+			return (token = OF_XML_READER_TOKEN_START_ELEMENT);
+		}
+	}
+}
+
+- (of_xml_reader_token_t)token
+{
+	return token;
+}
+
+- (size_t)depth
+{
+	return depth;
+}
+
+- (BOOL)isEmptyElement
+{
+	return emptyElement;
+}
+
+- (void)skipElement
+{
+	size_t elementDepth = depth;
+
+	if (token != OF_XML_READER_TOKEN_START_ELEMENT)
+		return;
+
+	while ([self nextToken] != OF_XML_READER_TOKEN_END_OF_DOCUMENT)
+		if (token == OF_XML_READER_TOKEN_END_ELEMENT &&
+		    depth == elementDepth)
+			return;
+}
+
+- (of_xml_slice_t)qualifiedNameSlice
+{
+	if (token != OF_XML_READER_TOKEN_START_ELEMENT &&
+	    token != OF_XML_READER_TOKEN_END_ELEMENT)
+		return slice(NULL, 0);
+
+	return slice(buffer + tokenStart + nameStart, nameLength);
+}
+
+- (of_xml_slice_t)nameSlice
+{
+	size_t skip = (prefixLength > 0 ? prefixLength + 1 : 0);
+
+	if (token != OF_XML_READER_TOKEN_START_ELEMENT &&
+	    token != OF_XML_READER_TOKEN_END_ELEMENT)
+		return slice(NULL, 0);
+
+	return slice(buffer + tokenStart + nameStart + skip,
+	    nameLength - skip);
+}
+
+- (of_xml_slice_t)prefixSlice
+{
+	if (token != OF_XML_READER_TOKEN_START_ELEMENT &&
+	    token != OF_XML_READER_TOKEN_END_ELEMENT)
+		return slice(NULL, 0);
+
+	return slice(buffer + tokenStart + nameStart, prefixLength);
+}
+
+- (of_xml_slice_t)contentSlice
+{
+	if (token != OF_XML_READER_TOKEN_CHARACTERS &&
+	    token != OF_XML_READER_TOKEN_CDATA &&
+	    token != OF_XML_READER_TOKEN_COMMENT &&
+	    token != OF_XML_READER_TOKEN_PROCESSING_INSTRUCTIONS)
+		return slice(NULL, 0);
+
+	return slice(buffer + tokenStart + contentStart, contentLength);
+}
+
+- (size_t)attributesCount
+{
+	return attributesCount;
+}
+
+- (of_xml_slice_t)attributeNameSliceAtIndex: (size_t)index
+{
+	struct of_xml_reader_attribute *attribute;
+	size_t skip;
+
+	if (index >= attributesCount)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	attribute = &attributes[index];
+	skip = (attribute->prefixLength > 0 ? attribute->prefixLength + 1 : 0);
+
+	return slice(buffer + tokenStart + attribute->nameStart + skip,
+	    attribute->nameLength - skip);
+}
+
+- (of_xml_slice_t)attributePrefixSliceAtIndex: (size_t)index
+{
+	if (index >= attributesCount)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	return slice(buffer + tokenStart + attributes[index].nameStart,
+	    attributes[index].prefixLength);
+}
+
+- (of_xml_slice_t)attributeValueSliceAtIndex: (size_t)index
+{
+	if (index >= attributesCount)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	return slice(buffer + tokenStart + attributes[index].valueStart,
+	    attributes[index].valueLength);
+}
+
+- (OFString*)name
+{
+	of_xml_slice_t name = [self nameSlice];
+
+	if (name.bytes == NULL)
+		return nil;
+
+	return [self OF_stringAt: name.bytes - (buffer + tokenStart)
+			  length: name.length];
+}
+
+- (OFString*)prefix
+{
+	if (prefixLength == 0 ||
+	    (token != OF_XML_READER_TOKEN_START_ELEMENT &&
+	    token != OF_XML_READER_TOKEN_END_ELEMENT))
+		return nil;
+
+	return [self OF_stringAt: nameStart
+			  length: prefixLength];
+}
+
+- (OFString*)namespace
+{
+	OFString *ret;
+
+	if (token != OF_XML_READER_TOKEN_START_ELEMENT &&
+	    token != OF_XML_READER_TOKEN_END_ELEMENT)
+		return nil;
+
+	ret = [self OF_namespaceForPrefix: buffer + tokenStart + nameStart
+				   length: prefixLength];
+
+	if (ret == nil && prefixLength > 0)
+		@throw [OFUnboundNamespaceException
+		    exceptionWithClass: [self class]
+				prefix: [self prefix]];
+
+	return ret;
+}
+
+- (OFString*)stringValue
+{
+	switch (token) {
+	case OF_XML_READER_TOKEN_CHARACTERS:
+		return [self OF_textAt: contentStart
+				length: contentLength
+			      unescape: YES];
+	case OF_XML_READER_TOKEN_CDATA:
+	case OF_XML_READER_TOKEN_COMMENT:
+	case OF_XML_READER_TOKEN_PROCESSING_INSTRUCTIONS:
+		return [self OF_textAt: contentStart
+				length: contentLength
+			      unescape: NO];
+	default:
+		return nil;
+	}
+}
+
+- (OFString*)attributeValueAtIndex: (size_t)index
+{
+	if (index >= attributesCount)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	return [self OF_textAt: attributes[index].valueStart
+			length: attributes[index].valueLength
+		      unescape: YES];
+}
+
+- (OFString*)attributeValueForName: (const char*)name
+{
+	size_t i;
+
+	for (i = 0; i < attributesCount; i++)
+		if (attributes[i].prefixLength == 0 &&
+		    of_xml_slice_is_equal([self attributeNameSliceAtIndex: i],
+		    name))
+			return [self attributeValueAtIndex: i];
+
+	return nil;
+}
+
+- (OFString*)attributeNamespaceAtIndex: (size_t)index
+{
+	struct of_xml_reader_attribute *attribute;
+	OFString *ret;
+
+	if (index >= attributesCount)
+		@throw [OFOutOfRangeException exceptionWithClass: [self class]];
+
+	attribute = &attributes[index];
+
+	if (attribute->prefixLength == 0)
+		return nil;
+
+	ret = [self OF_namespaceForPrefix: buffer + tokenStart +
+					   attribute->nameStart
+				   length: attribute->prefixLength];
+
+	if (ret == nil)
+		@throw [OFUnboundNamespaceException
+		    exceptionWithClass: [self class]
+				prefix: [self OF_stringAt: attribute->nameStart
+						   length: attribute->
+							   prefixLength]];
+
+	return ret;
+}
+
+- (OFArray*)attributes
+{
+	OFMutableArray *ret = [OFMutableArray array];
+	size_t i;
+
+	for (i = 0; i < attributesCount; i++) {
+		void *pool = objc_autoreleasePoolPush();
+		struct of_xml_reader_attribute *attribute = &attributes[i];
+		OFString *name, *ns, *value;
+
+		if (attribute->prefixLength > 0)
+			name = [self OF_stringAt: attribute->nameStart +
+						  attribute->prefixLength + 1
+					  length: attribute->nameLength -
+						  attribute->prefixLength - 1];
+		else
+			name = [self OF_stringAt: attribute->nameStart
+					  length: attribute->nameLength];
+
+		ns = [self attributeNamespaceAtIndex: i];
+		value = [self attributeValueAtIndex: i];
+
+		[ret addObject: [OFXMLAttribute attributeWithName: name
+							namespace: ns
+						      stringValue: value]];
+
+		objc_autoreleasePoolPop(pool);
+	}
+
+	[ret makeImmutable];
+
+	return ret;
+}
+@end
@@ -27,6 +27,7 @@
 
 #import "OFList.h"
 #import "OFSortedList.h"
+#import "OFStopwatch.h"
 
 #import "OFDictionary.h"
 
@@ -41,17 +42,23 @@
 
 #import "OFNumber.h"
 #import "OFDate.h"
+#import "OFDateFormatter.h"
 #import "OFURL.h"
 
 #import "OFStream.h"
 #import "OFFile.h"
+#import "OFDeflateStream.h"
+#import "OFGZIPStream.h"
 #import "OFStreamSocket.h"
+#import "OFResolver.h"
 #import "OFTCPSocket.h"
 #import "OFTLSSocket.h"
 #import "OFProcess.h"
 #import "OFStreamObserver.h"
 
+#import "OFHTTPConnectionPool.h"
 #import "OFHTTPRequest.h"
+#import "OFHTTPServer.h"
 
 #import "OFHash.h"
 #import "OFMD5Hash.h"
@@ -64,8 +71,12 @@
 #import "OFXMLCDATA.h"
 #import "OFXMLComment.h"
 #import "OFXMLProcessingInstructions.h"
+#import "OFXMLNameTable.h"
 #import "OFXMLParser.h"
+#import "OFXMLReader.h"
+#import "OFXMLQuery.h"
 #import "OFXMLElementBuilder.h"
+#import "OFXMLCompactDocument.h"
 
 #import "OFSerialization.h"
 
@@ -94,6 +105,7 @@
 #import "OFDeleteDirectoryFailedException.h"
 #import "OFDeleteFileFailedException.h"
 #import "OFEnumerationMutationException.h"
+#import "OFGetOptionFailedException.h"
 #import "OFHashAlreadyCalculatedException.h"
 #import "OFHTTPRequestFailedException.h"
 #import "OFInitializationFailedException.h"
@@ -155,4 +167,5 @@
 #import "asprintf.h"
 #import "base64.h"
 #import "of_asprintf.h"
+#import "of_clock.h"
 #import "of_strptime.h"
@@ -751,3 +751,20 @@ of_atomic_cmpswap_ptr(void* volatile *p, void *o, void *n)
 # error No atomic operations available!
 #endif
 }
+
+static OF_INLINE void
+of_memory_read_barrier(void)
+{
+#if !defined(OF_THREADS)
+	/* nop */
+#elif defined(OF_X86_ASM) || defined(OF_AMD64_ASM)
+	/* x86 does not reorder loads with other loads */
+	__asm__ __volatile__ ("" ::: "memory");
+#elif defined(OF_HAVE_GCC_ATOMIC_OPS)
+	__sync_synchronize();
+#elif defined(OF_HAVE_OSATOMIC)
+	OSMemoryBarrier();
+#else
+# error No memory barrier available!
+#endif
+}
@@ -20,6 +20,21 @@ extern "C" {
 extern void* objc_autoreleasePoolPush();
 extern void objc_autoreleasePoolPop(void*);
 extern id _objc_rootAutorelease(id object);
+
+/*!
+ * @brief Returns statistics about the autorelease pools of the current thread.
+ *
+ * This is only available if ObjFW provides the autorelease pools, which is the
+ * case if the runtime does not provide objc_autoreleasePoolPush.
+ *
+ * @param peakDepth A pointer to store the highest number of objects that have
+ *		    been in the autorelease pools of the thread at the same
+ *		    time, or NULL
+ * @param autoreleases A pointer to store the total number of objects that
+ *		       have been autoreleased by the thread, or NULL
+ */
+extern void of_autorelease_pool_statistics(size_t *peakDepth,
+    uintmax_t *autoreleases);
 #ifdef __cplusplus
 }
 #endif
@@ -28,103 +28,157 @@
 
 #import "autorelease.h"
 
+/*
+ * The objects of all autorelease pools of a thread are stored in a chain of
+ * pages of of_pagesize bytes each. Pool tokens are pointers to the top of the
+ * current page at the time the pool was pushed.
+ */
+struct page {
+	struct page *previous;
+	id *top, *end;
+};
+
+#define PAGE_OBJECTS(page) ((id*)((page) + 1))
+
+struct thread_state {
+	struct page *page;
+	/* The last page that became empty, kept to avoid malloc churn */
+	struct page *spare;
+	size_t depth, peakDepth;
+	uintmax_t autoreleases;
+};
+
 #ifdef OF_COMPILER_TLS
-static __thread id *objects = NULL;
-static __thread id *top = NULL;
-static __thread size_t size = 0;
+static __thread struct thread_state threadState;
 #else
-static of_tlskey_t objectsKey, topKey, sizeKey;
+static of_tlskey_t stateKey;
 
 static void __attribute__((constructor))
 init(void)
 {
-	OF_ENSURE(of_tlskey_new(&objectsKey));
-	OF_ENSURE(of_tlskey_new(&topKey));
-	OF_ENSURE(of_tlskey_new(&sizeKey));
+	OF_ENSURE(of_tlskey_new(&stateKey));
 }
 #endif
 
-void*
-objc_autoreleasePoolPush()
+static OF_INLINE struct thread_state*
+get_state(void)
 {
-#ifndef OF_COMPILER_TLS
-	id *top = of_tlskey_get(topKey);
-	id *objects = of_tlskey_get(objectsKey);
-#endif
-	ptrdiff_t offset = top - objects;
+#ifdef OF_COMPILER_TLS
+	return &threadState;
+#else
+	struct thread_state *state = of_tlskey_get(stateKey);
+
+	if (state == NULL) {
+		OF_ENSURE((state = calloc(1, sizeof(*state))) != NULL);
+		OF_ENSURE(of_tlskey_set(stateKey, state));
+	}
 
-	return (void*)offset;
+	return state;
+#endif
 }
 
-void
-objc_autoreleasePoolPop(void *offset)
+static struct page*
+add_page(struct thread_state *state)
 {
-#ifndef OF_COMPILER_TLS
-	id *top = of_tlskey_get(topKey);
-	id *objects = of_tlskey_get(objectsKey);
-#endif
-	id *pool = objects + (ptrdiff_t)offset;
-	id *iter;
+	struct page *page;
 
-	for (iter = pool; iter < top; iter++)
-		[*iter release];
+	if (state->spare != NULL) {
+		page = state->spare;
+		state->spare = NULL;
+	} else
+		OF_ENSURE((page = malloc(of_pagesize)) != NULL);
 
-	top = pool;
+	page->previous = state->page;
+	page->top = PAGE_OBJECTS(page);
+	page->end = (id*)(void*)((char*)page + of_pagesize);
 
-	if (top == objects) {
-		free(objects);
+	state->page = page;
 
-		objects = NULL;
-		top = NULL;
-	}
+	return page;
+}
 
-#ifndef OF_COMPILER_TLS
-	OF_ENSURE(of_tlskey_set(topKey, top));
-	OF_ENSURE(of_tlskey_set(objectsKey, objects));
-#endif
+void*
+objc_autoreleasePoolPush()
+{
+	struct thread_state *state = get_state();
+
+	/* Make sure the token is never NULL, as NULL pops everything */
+	if (state->page == NULL)
+		add_page(state);
+
+	return state->page->top;
 }
 
-id
-_objc_rootAutorelease(id object)
+void
+objc_autoreleasePoolPop(void *token)
 {
-#ifndef OF_COMPILER_TLS
-	id *top = of_tlskey_get(topKey);
-	id *objects = of_tlskey_get(objectsKey);
-	size_t size = (size_t)(uintptr_t)of_tlskey_get(sizeKey);
-#endif
+	struct thread_state *state = get_state();
 
-	if (objects == NULL) {
-		OF_ENSURE((objects = malloc(of_pagesize)) != NULL);
+	for (;;) {
+		struct page *page = state->page;
+		id object;
 
-		top = objects;
-		size = of_pagesize;
+		if (page == NULL || page->top == (id*)token)
+			break;
 
-#ifndef OF_COMPILER_TLS
-		OF_ENSURE(of_tlskey_set(objectsKey, objects));
-		OF_ENSURE(of_tlskey_set(sizeKey, (void*)(uintptr_t)size));
-#endif
-	}
+		if (page->top == PAGE_OBJECTS(page)) {
+			state->page = page->previous;
 
-	if ((uintptr_t)top >= (uintptr_t)objects + size) {
-		ptrdiff_t diff = top - objects;
+			if (state->spare == NULL)
+				state->spare = page;
+			else
+				free(page);
 
-		size += of_pagesize;
-		OF_ENSURE((objects = realloc(objects, size)) != NULL);
+			continue;
+		}
 
-#ifndef OF_COMPILER_TLS
-		OF_ENSURE(of_tlskey_set(objectsKey, objects));
-		OF_ENSURE(of_tlskey_set(sizeKey, (void*)(uintptr_t)size));
-#endif
+		/*
+		 * Remove the object before releasing it, as releasing it might
+		 * autorelease other objects.
+		 */
+		object = *--page->top;
+		state->depth--;
 
-		top = objects + diff;
+		[object release];
 	}
 
-	*top = object;
-	top++;
+	/* Popping NULL pops everything, which is done when a thread exits */
+	if (token == NULL) {
+		free(state->spare);
+		state->spare = NULL;
 
 #ifndef OF_COMPILER_TLS
-	OF_ENSURE(of_tlskey_set(topKey, top));
+		free(state);
+		OF_ENSURE(of_tlskey_set(stateKey, NULL));
 #endif
+	}
+}
+
+id
+_objc_rootAutorelease(id object)
+{
+	struct thread_state *state = get_state();
+	struct page *page = state->page;
+
+	if (page == NULL || page->top == page->end)
+		page = add_page(state);
+
+	*page->top++ = object;
+
+	state->autoreleases++;
+	if (++state->depth > state->peakDepth)
+		state->peakDepth = state->depth;
 
 	return object;
 }
+
+void
+of_autorelease_pool_statistics(size_t *peakDepth, uintmax_t *autoreleases)
+{
+	struct thread_state *state = get_state();
+
+	if (peakDepth != NULL)
+		*peakDepth = state->peakDepth;
+	if (autoreleases != NULL)
+		*autoreleases = state->autoreleases;
+}
@@ -93,6 +93,17 @@
 {
 }
 
+/* The exception is static and has no pre-ivars for a weak reference flag */
+- (BOOL)allowsWeakReference
+{
+	return YES;
+}
+
+- (BOOL)retainWeakReference
+{
+	return YES;
+}
+
 - (void)dealloc
 {
 	@throw [OFNotImplementedException exceptionWithClass: [self class]
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFException.h"
+
+@class OFStream;
+
+/*!
+ * @brief An exception indicating that getting an option for a stream failed.
+ */
+@interface OFGetOptionFailedException: OFException
+{
+	OFStream *stream;
+}
+
+#ifdef OF_HAVE_PROPERTIES
+@property (readonly, retain, nonatomic) OFStream *stream;
+#endif
+
+/*!
+ * @brief Creates a new, autoreleased get option failed exception.
+ *
+ * @param class_ The class of the object which caused the exception
+ * @param stream The stream for which the option could not be retrieved
+ * @return A new, autoreleased get option failed exception
+ */
++ (instancetype)exceptionWithClass: (Class)class_
+			    stream: (OFStream*)stream;
+
+/*!
+ * @brief Initializes an already allocated get option failed exception.
+ *
+ * @param class_ The class of the object which caused the exception
+ * @param stream The stream for which the option could not be retrieved
+ * @return An initialized get option failed exception
+ */
+- initWithClass: (Class)class_
+	 stream: (OFStream*)stream;
+
+/*!
+ * @brief Returns the stream for which the option could not be retrieved.
+ *
+ * @return The stream for which the option could not be retrieved
+ */
+- (OFStream*)stream;
+@end
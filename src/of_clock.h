@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+# define __STDC_LIMIT_MACROS
+#endif
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif
+
+#include <stdint.h>
+
+#import "macros.h"
+
+/*!
+ * @brief A deadline which is never reached.
+ */
+#define OF_DEADLINE_NEVER UINT64_MAX
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*!
+ * @brief Returns the current value of a monotonic clock in nanoseconds.
+ *
+ * The clock has an arbitrary starting point and is therefore only useful for
+ * measuring intervals and computing deadlines. Unlike the wall clock used by
+ * OFDate, it is not affected by changes of the system time.
+ *
+ * @return The current value of a monotonic clock in nanoseconds
+ */
+extern uint64_t of_monotonic_time(void);
+#ifdef __cplusplus
+}
+#endif
+
+/*!
+ * @brief Returns the deadline which is the specified interval after the
+ *	  specified monotonic time.
+ *
+ * The result saturates, so that a huge interval results in
+ * @ref OF_DEADLINE_NEVER and a negative interval results in the specified time.
+ *
+ * @param time A time as returned by @ref of_monotonic_time
+ * @param interval The interval in seconds
+ * @return The deadline as a time comparable to @ref of_monotonic_time
+ */
+static OF_INLINE uint64_t
+of_deadline_after(uint64_t time, double interval)
+{
+	double nanoseconds = interval * 1000000000.0;
+
+	if (!(nanoseconds > 0))
+		return time;
+
+	if (nanoseconds >= (double)(OF_DEADLINE_NEVER - time))
+		return OF_DEADLINE_NEVER;
+
+	return time + (uint64_t)nanoseconds;
+}
+
+/*!
+ * @brief Returns the interval in seconds until the specified deadline is
+ *	  reached.
+ *
+ * @param deadline A deadline as returned by @ref of_deadline_after
+ * @param time The current time as returned by @ref of_monotonic_time
+ * @return The interval in seconds until the deadline is reached or 0 if it has
+ *	   already been reached
+ */
+static OF_INLINE double
+of_deadline_remaining(uint64_t deadline, uint64_t time)
+{
+	if (deadline <= time)
+		return 0;
+
+	return (double)(deadline - time) / 1000000000.0;
+}
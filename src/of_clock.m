@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <time.h>
+
+#ifdef __APPLE__
+# include <mach/mach_time.h>
+#endif
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <sys/time.h>
+#endif
+
+#import "of_clock.h"
+
+uint64_t
+of_monotonic_time(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	OF_ENSURE(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#elif defined(__APPLE__)
+	static mach_timebase_info_data_t info;
+
+	/* Racing here is harmless, as every thread gets the same value */
+	if (info.denom == 0)
+		OF_ENSURE(mach_timebase_info(&info) == KERN_SUCCESS);
+
+	return mach_absolute_time() * info.numer / info.denom;
+#elif defined(_WIN32)
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+		OF_ENSURE(QueryPerformanceFrequency(&frequency));
+
+	OF_ENSURE(QueryPerformanceCounter(&counter));
+
+	/* Split to avoid overflowing for large counter values */
+	return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000 +
+	    (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000 /
+	    frequency.QuadPart;
+#else
+	/* No monotonic clock available, fall back to the wall clock */
+	struct timeval t;
+
+	OF_ENSURE(gettimeofday(&t, NULL) == 0);
+
+	return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_usec * 1000;
+#endif
+}
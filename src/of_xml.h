@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include <stddef.h>
+
+#import "OFString.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Creates a string from a token in a buffer of XML in the specified
+ * encoding.
+ */
+extern OFString* of_xml_string(const char *bytes, size_t length,
+    of_string_encoding_t encoding);
+
+/*
+ * Creates a string from text in a buffer of XML in the specified encoding,
+ * normalizing line breaks and, if requested, replacing entities.
+ */
+extern OFString* of_xml_text(const char *bytes, size_t length,
+    of_string_encoding_t encoding, BOOL unescape);
+#ifdef __cplusplus
+}
+#endif
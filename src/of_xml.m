@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFString.h"
+
+#import "of_xml.h"
+
+OFString*
+of_xml_string(const char *bytes, size_t length, of_string_encoding_t encoding)
+{
+	if (encoding == OF_STRING_ENCODING_UTF_8)
+		return [OFString stringWithUTF8String: bytes
+					       length: length];
+
+	return [OFString stringWithCString: bytes
+				  encoding: encoding
+				    length: length];
+}
+
+OFString*
+of_xml_text(const char *bytes, size_t length, of_string_encoding_t encoding,
+    BOOL unescape)
+{
+	OFString *ret = of_xml_string(bytes, length, encoding);
+
+	if (memchr(bytes, '\r', length) != NULL) {
+		OFMutableString *mutableRet = [[ret mutableCopy] autorelease];
+
+		[mutableRet replaceOccurrencesOfString: @"\r\n"
+					    withString: @"\n"];
+		[mutableRet replaceOccurrencesOfString: @"\r"
+					    withString: @"\n"];
+		[mutableRet makeImmutable];
+
+		ret = mutableRet;
+	}
+
+	if (unescape && memchr(bytes, '&', length) != NULL)
+		ret = [ret stringByXMLUnescaping];
+
+	return ret;
+}
@@ -16,14 +16,63 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+
 #import "runtime.h"
+#import "runtime-private.h"
 
 #import "OFObject.h"
 #import "OFBlock.h"
 
+#import "macros.h"
+#ifdef OF_THREADS
+# import "threading.h"
+#endif
+
+/*
+ * Weak references are stored in a side table which maps each weakly
+ * referenced object to all locations referencing it. The table is split into
+ * stripes, each having its own spinlock and hash table.
+ */
+#define NUM_STRIPES 64	/* needs to be a power of 2 */
+#define STRIPE_HASH(p) ((unsigned)((uintptr_t)p >> 4) & (NUM_STRIPES - 1))
+/* The bits used for the stripe are skipped for the bucket */
+#define BUCKET_HASH(p, size) \
+	((unsigned)((uintptr_t)p >> 10) & ((size) - 1))
+
+struct weak_ref {
+	id object;
+	id **locations;
+	size_t count, size;
+	struct weak_ref *next;
+};
+
+static struct {
+#ifdef OF_THREADS
+	of_spinlock_t spinlock;
+#endif
+	struct weak_ref **buckets;
+	uint32_t count, size;
+} stripes[NUM_STRIPES];
+
+#ifdef OF_THREADS
+static void __attribute__((constructor))
+init(void)
+{
+	size_t i;
+
+	for (i = 0; i < NUM_STRIPES; i++)
+		if (!of_spinlock_new(&stripes[i].spinlock))
+			OBJC_ERROR("Failed to initialize spinlocks!")
+}
+#endif
+
 id
 objc_retain(id object)
 {
+	if (object_isTaggedPointer(object))
+		return object;
+
 	return [object retain];
 }
 
@@ -42,12 +91,18 @@ objc_retainAutorelease(id object)
 void
 objc_release(id object)
 {
+	if (object_isTaggedPointer(object))
+		return;
+
 	[object release];
 }
 
 id
 objc_autorelease(id object)
 {
+	if (object_isTaggedPointer(object))
+		return object;
+
 	return [object autorelease];
 }
 
@@ -78,3 +133,279 @@ objc_storeStrong(id *object, id value)
 
 	return value;
 }
+
+static void
+lock_stripes(unsigned a, unsigned b)
+{
+#ifdef OF_THREADS
+	/* Always lock in the same order to avoid deadlocks */
+	if (a > b) {
+		unsigned tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	OF_ENSURE(of_spinlock_lock(&stripes[a].spinlock));
+	if (a != b)
+		OF_ENSURE(of_spinlock_lock(&stripes[b].spinlock));
+#endif
+}
+
+static void
+unlock_stripes(unsigned a, unsigned b)
+{
+#ifdef OF_THREADS
+	OF_ENSURE(of_spinlock_unlock(&stripes[a].spinlock));
+	if (a != b)
+		OF_ENSURE(of_spinlock_unlock(&stripes[b].spinlock));
+#endif
+}
+
+static struct weak_ref**
+lookup(id object)
+{
+	unsigned stripe = STRIPE_HASH(object);
+	struct weak_ref **iter;
+
+	if (stripes[stripe].buckets == NULL)
+		return NULL;
+
+	for (iter = &stripes[stripe].buckets[BUCKET_HASH(object,
+	    stripes[stripe].size)]; *iter != NULL; iter = &(*iter)->next)
+		if ((*iter)->object == object)
+			return iter;
+
+	return NULL;
+}
+
+static void
+resize(unsigned stripe, uint32_t size)
+{
+	struct weak_ref **buckets;
+	uint32_t i;
+
+	if ((buckets = calloc(size, sizeof(struct weak_ref*))) == NULL)
+		OBJC_ERROR("Not enough memory to resize weak reference table!");
+
+	for (i = 0; i < stripes[stripe].size; i++) {
+		struct weak_ref *iter = stripes[stripe].buckets[i];
+
+		while (iter != NULL) {
+			struct weak_ref *next = iter->next;
+			unsigned hash = BUCKET_HASH(iter->object, size);
+
+			iter->next = buckets[hash];
+			buckets[hash] = iter;
+
+			iter = next;
+		}
+	}
+
+	free(stripes[stripe].buckets);
+	stripes[stripe].buckets = buckets;
+	stripes[stripe].size = size;
+}
+
+static void
+add_location(id object, id *location)
+{
+	unsigned stripe = STRIPE_HASH(object);
+	struct weak_ref **ref, *new;
+	unsigned hash;
+
+	if ((ref = lookup(object)) != NULL) {
+		if ((*ref)->count == (*ref)->size) {
+			id **locations = realloc((*ref)->locations,
+			    (*ref)->size * 2 * sizeof(id*));
+
+			if (locations == NULL)
+				OBJC_ERROR("Not enough memory to store weak "
+				    "reference!");
+
+			(*ref)->locations = locations;
+			(*ref)->size *= 2;
+		}
+
+		(*ref)->locations[(*ref)->count++] = location;
+
+		return;
+	}
+
+	if (stripes[stripe].size == 0)
+		resize(stripe, 16);
+	else if (stripes[stripe].count >= stripes[stripe].size * 3 / 4)
+		resize(stripe, stripes[stripe].size * 2);
+
+	if ((new = malloc(sizeof(struct weak_ref))) == NULL ||
+	    (new->locations = malloc(2 * sizeof(id*))) == NULL)
+		OBJC_ERROR("Not enough memory to store weak reference!");
+
+	new->object = object;
+	new->locations[0] = location;
+	new->count = 1;
+	new->size = 2;
+
+	hash = BUCKET_HASH(object, stripes[stripe].size);
+	new->next = stripes[stripe].buckets[hash];
+	stripes[stripe].buckets[hash] = new;
+	stripes[stripe].count++;
+}
+
+static void
+remove_ref(id object, struct weak_ref **ref)
+{
+	struct weak_ref *next = (*ref)->next;
+
+	free((*ref)->locations);
+	free(*ref);
+	*ref = next;
+
+	stripes[STRIPE_HASH(object)].count--;
+}
+
+static void
+remove_location(id object, id *location)
+{
+	struct weak_ref **ref;
+	size_t i;
+
+	if ((ref = lookup(object)) == NULL)
+		return;
+
+	for (i = 0; i < (*ref)->count; i++) {
+		if ((*ref)->locations[i] == location) {
+			(*ref)->locations[i] =
+			    (*ref)->locations[--(*ref)->count];
+			break;
+		}
+	}
+
+	if ((*ref)->count == 0)
+		remove_ref(object, ref);
+}
+
+id
+objc_storeWeak(id *location, id value)
+{
+	unsigned valueStripe, oldStripe;
+	id old;
+
+	/*
+	 * This might run +[initialize] or other code that uses weak
+	 * references, so it must not be called with a stripe locked.
+	 */
+	if (value != nil && !object_isTaggedPointer(value) &&
+	    ![value allowsWeakReference])
+		value = nil;
+
+	valueStripe = STRIPE_HASH(value);
+
+	/* *location might be changed until we hold the lock */
+	for (;;) {
+		old = *location;
+		oldStripe = STRIPE_HASH(old);
+
+		lock_stripes(oldStripe, valueStripe);
+
+		if (*location == old)
+			break;
+
+		unlock_stripes(oldStripe, valueStripe);
+	}
+
+	if (old != nil && !object_isTaggedPointer(old))
+		remove_location(old, location);
+
+	/* Tagged pointers are never deallocated */
+	if (value != nil && !object_isTaggedPointer(value))
+		add_location(value, location);
+
+	*location = value;
+
+	unlock_stripes(oldStripe, valueStripe);
+
+	return value;
+}
+
+id
+objc_loadWeakRetained(id *location)
+{
+	unsigned stripe;
+	id value;
+
+	for (;;) {
+		value = *location;
+		stripe = STRIPE_HASH(value);
+
+		lock_stripes(stripe, stripe);
+
+		if (*location == value)
+			break;
+
+		unlock_stripes(stripe, stripe);
+	}
+
+	if (value != nil && ![value retainWeakReference])
+		value = nil;
+
+	unlock_stripes(stripe, stripe);
+
+	return value;
+}
+
+id
+objc_loadWeak(id *location)
+{
+	return objc_autorelease(objc_loadWeakRetained(location));
+}
+
+id
+objc_initWeak(id *location, id value)
+{
+	*location = nil;
+
+	return objc_storeWeak(location, value);
+}
+
+void
+objc_destroyWeak(id *location)
+{
+	objc_storeWeak(location, nil);
+}
+
+void
+objc_copyWeak(id *dest, id *src)
+{
+	id value = objc_loadWeakRetained(src);
+
+	objc_initWeak(dest, value);
+	objc_release(value);
+}
+
+void
+objc_moveWeak(id *dest, id *src)
+{
+	objc_copyWeak(dest, src);
+	objc_destroyWeak(src);
+}
+
+void
+objc_zero_weak_references(id value)
+{
+	unsigned stripe = STRIPE_HASH(value);
+	struct weak_ref **ref;
+
+	lock_stripes(stripe, stripe);
+
+	if ((ref = lookup(value)) != NULL) {
+		size_t i;
+
+		for (i = 0; i < (*ref)->count; i++)
+			if (*(*ref)->locations[i] == value)
+				*(*ref)->locations[i] = nil;
+
+		remove_ref(value, ref);
+	}
+
+	unlock_stripes(stripe, stripe);
+}
@@ -30,6 +30,10 @@ static Class *load_queue = NULL;
 static size_t load_queue_cnt = 0;
 static struct objc_sparsearray *empty_dtable = NULL;
 
+#ifdef OBJC_TAGGED_POINTERS
+Class objc_tagged_pointer_classes[OBJC_TAGGED_POINTER_CLASSES];
+#endif
+
 static void
 register_class(struct objc_abi_class *cls)
 {
@@ -418,6 +422,30 @@ class_getInstanceSize(Class cls)
 	return cls->instance_size;
 }
 
+#ifdef OBJC_TAGGED_POINTERS
+int
+objc_registerTaggedPointerClass(Class cls)
+{
+	int i;
+
+	objc_global_mutex_lock();
+
+	for (i = 0; i < OBJC_TAGGED_POINTER_CLASSES; i++) {
+		if (objc_tagged_pointer_classes[i] == cls)
+			break;
+
+		if (objc_tagged_pointer_classes[i] == Nil) {
+			objc_tagged_pointer_classes[i] = cls;
+			break;
+		}
+	}
+
+	objc_global_mutex_unlock();
+
+	return (i < OBJC_TAGGED_POINTER_CLASSES ? i : -1);
+}
+#endif
+
 IMP
 class_getMethodImplementation(Class cls, SEL sel)
 {
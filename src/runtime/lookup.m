@@ -76,6 +76,26 @@ nil_method(id self, SEL _cmd)
 	return nil;
 }
 
+static OF_INLINE IMP
+lookup(struct objc_sparsearray *dtable, SEL sel)
+{
+#ifdef OBJC_METHOD_CACHE
+	IMP imp;
+
+	if ((imp = objc_method_cache_get(dtable, sel->uid)) != NULL)
+		return imp;
+
+	imp = objc_sparsearray_get(dtable, (uint32_t)sel->uid);
+
+	if (imp == NULL)
+		return NULL;
+
+	return objc_method_cache_fill(dtable, sel->uid, imp);
+#else
+	return objc_sparsearray_get(dtable, (uint32_t)sel->uid);
+#endif
+}
+
 IMP
 objc_msg_lookup(id obj, SEL sel)
 {
@@ -84,8 +104,7 @@ objc_msg_lookup(id obj, SEL sel)
 	if (obj == nil)
 		return (IMP)nil_method;
 
-	imp = objc_sparsearray_get(object_getClass(obj)->dtable,
-	    (uint32_t)sel->uid);
+	imp = lookup(object_getClass(obj)->dtable, sel);
 
 	if (imp == NULL)
 		return objc_not_found_handler(obj, sel);
@@ -101,7 +120,7 @@ objc_msg_lookup_super(struct objc_super *super, SEL sel)
 	if (super->self == nil)
 		return (IMP)nil_method;
 
-	imp = objc_sparsearray_get(super->cls->dtable, (uint32_t)sel->uid);
+	imp = lookup(super->cls->dtable, sel);
 
 	if (imp == NULL)
 		return objc_not_found_handler(super->self, sel);
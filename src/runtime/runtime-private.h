@@ -102,24 +102,53 @@ struct objc_hashtable {
 	struct objc_hashtable_bucket **data;
 };
 
+/*
+ * The method cache relies on the strong memory ordering of x86 so that a hit
+ * only needs plain loads. It is thus only used on AMD64.
+ */
+#if (defined(__amd64__) || defined(__x86_64__)) && !defined(OF_NO_METHOD_CACHE)
+# define OBJC_METHOD_CACHE
+#endif
+
+#ifdef OBJC_METHOD_CACHE
+# define OBJC_METHOD_CACHE_SIZE 64 /* needs to be a power of 2 */
+# define OBJC_METHOD_CACHE_INVALID UINTPTR_MAX
+# define OBJC_METHOD_CACHE_BUSY (UINTPTR_MAX - 1)
+
+struct objc_method_cache_entry {
+	volatile uintptr_t uid;
+	IMP volatile imp;
+};
+#endif
+
 struct objc_sparsearray {
 	struct objc_sparsearray_level2 *buckets[256];
+#ifdef OBJC_METHOD_CACHE
+	/*
+	 * Needs to stay directly behind the buckets, as the assembly lookup
+	 * accesses it at a fixed offset.
+	 */
+	struct objc_method_cache_entry cache[OBJC_METHOD_CACHE_SIZE];
+#endif
 };
 
 #ifndef OF_SELUID16
 struct objc_sparsearray_level2 {
 	struct objc_sparsearray_level3 *buckets[256];
 	BOOL empty;
+	uint32_t refcnt;
 };
 
 struct objc_sparsearray_level3 {
 	const void *buckets[256];
 	BOOL empty;
+	uint32_t refcnt;
 };
 #else
 struct objc_sparsearray_level2 {
 	const void *buckets[256];
 	BOOL empty;
+	uint32_t refcnt;
 };
 #endif
 
@@ -153,6 +182,9 @@ extern void objc_sparsearray_set(struct objc_sparsearray*, uint32_t,
     const void*);
 extern void objc_sparsearray_free(struct objc_sparsearray*);
 extern void objc_sparsearray_cleanup(void);
+#ifdef OBJC_METHOD_CACHE
+extern IMP objc_method_cache_fill(struct objc_sparsearray*, uintptr_t, IMP);
+#endif
 extern void objc_init_static_instances(struct objc_abi_symtab*);
 extern void __objc_exec_class(struct objc_abi_module*);
 extern void objc_global_mutex_lock(void);
@@ -176,6 +208,27 @@ objc_sparsearray_get(const struct objc_sparsearray *s, uint32_t idx)
 #endif
 }
 
+#ifdef OBJC_METHOD_CACHE
+static inline IMP
+objc_method_cache_get(const struct objc_sparsearray *s, uintptr_t uid)
+{
+	const struct objc_method_cache_entry *entry =
+	    &s->cache[uid & (OBJC_METHOD_CACHE_SIZE - 1)];
+	IMP imp;
+
+	if (entry->uid != uid)
+		return NULL;
+
+	imp = entry->imp;
+
+	/* Make sure the entry was not replaced while reading the IMP */
+	if (entry->uid != uid)
+		return NULL;
+
+	return imp;
+}
+#endif
+
 #define OBJC_ERROR(...)							\
 	{								\
 		fprintf(stderr, "[objc @ " __FILE__ ":%d] ", __LINE__);	\
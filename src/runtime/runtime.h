@@ -30,6 +30,17 @@
 # define OBJC_BRIDGE
 #endif
 
+/*
+ * On 64 bit platforms, objects with the lowest bit set are tagged pointers:
+ * Bits 1 to 3 select one of the registered tagged pointer classes and the
+ * remaining 60 bits are the value of the object.
+ */
+#if UINTPTR_MAX == UINT64_MAX
+# define OBJC_TAGGED_POINTERS
+# define OBJC_TAGGED_POINTER_CLASSES 8
+# define OBJC_TAGGED_POINTER_BITS 60
+#endif
+
 typedef struct objc_class *Class;
 typedef struct objc_object *id;
 typedef const struct objc_selector *SEL;
@@ -197,11 +208,63 @@ extern id objc_autorelease(id);
 extern void* objc_autoreleasePoolPush(void);
 extern void objc_autoreleasePoolPop(void*);
 extern id _objc_rootAutorelease(id);
+#ifdef OBJC_TAGGED_POINTERS
+extern Class objc_tagged_pointer_classes[OBJC_TAGGED_POINTER_CLASSES];
+extern int objc_registerTaggedPointerClass(Class);
+#endif
+extern id objc_storeWeak(id*, id);
+extern id objc_loadWeak(id*);
+extern id objc_loadWeakRetained(id*);
+extern id objc_initWeak(id*, id);
+extern void objc_destroyWeak(id*);
+extern void objc_copyWeak(id*, id*);
+extern void objc_moveWeak(id*, id*);
+extern void objc_zero_weak_references(id);
+
+static inline BOOL
+object_isTaggedPointer(id obj)
+{
+#ifdef OBJC_TAGGED_POINTERS
+	return ((uintptr_t)(OBJC_BRIDGE void*)obj & 1);
+#else
+	return NO;
+#endif
+}
+
+#ifdef OBJC_TAGGED_POINTERS
+static inline id
+objc_createTaggedPointer(int tag, uintptr_t value)
+{
+	return (OBJC_BRIDGE id)(void*)
+	    ((value << 4) | ((uintptr_t)tag << 1) | 1);
+}
+
+static inline uintptr_t
+object_getTaggedPointerValue(id obj)
+{
+	return (uintptr_t)(OBJC_BRIDGE void*)obj >> 4;
+}
+
+static inline intptr_t
+object_getTaggedPointerSignedValue(id obj)
+{
+	/* Relies on the right shift of a signed value being arithmetic */
+	return (intptr_t)(OBJC_BRIDGE void*)obj >> 4;
+}
+#endif
 
 static inline Class
 object_getClass(id obj_)
 {
-	struct objc_object *obj = (OBJC_BRIDGE struct objc_object*)obj_;
+	struct objc_object *obj;
+
+#ifdef OBJC_TAGGED_POINTERS
+	if ((uintptr_t)(OBJC_BRIDGE void*)obj_ & 1)
+		return objc_tagged_pointer_classes[
+		    ((uintptr_t)(OBJC_BRIDGE void*)obj_ >> 1) & 7];
+#endif
+
+	obj = (OBJC_BRIDGE struct objc_object*)obj_;
 
 	return obj->isa;
 }
@@ -209,8 +272,15 @@ object_getClass(id obj_)
 static inline Class
 object_setClass(id obj_, Class cls)
 {
-	struct objc_object *obj = (OBJC_BRIDGE struct objc_object*)obj_;
-	Class old = obj->isa;
+	struct objc_object *obj;
+	Class old;
+
+	/* The class of a tagged pointer is part of its value */
+	if (object_isTaggedPointer(obj_))
+		return object_getClass(obj_);
+
+	obj = (OBJC_BRIDGE struct objc_object*)obj_;
+	old = obj->isa;
 
 	obj->isa = cls;
 
@@ -18,10 +18,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #import "runtime.h"
 #import "runtime-private.h"
 
+#ifdef OBJC_METHOD_CACHE
+# import "atomic.h"
+#endif
+
 static struct objc_sparsearray_level2 *empty_level2 = NULL;
 #ifndef OF_SELUID16
 static struct objc_sparsearray_level3 *empty_level3 = NULL;
@@ -37,6 +42,7 @@ init(void)
 		OBJC_ERROR("Not enough memory to allocate sparse array!");
 
 	empty_level2->empty = YES;
+	empty_level2->refcnt = 0;
 
 #ifndef OF_SELUID16
 	empty_level3 = malloc(sizeof(struct objc_sparsearray_level3));
@@ -44,6 +50,7 @@ init(void)
 		OBJC_ERROR("Not enough memory to allocate sparse array!");
 
 	empty_level3->empty = YES;
+	empty_level3->refcnt = 0;
 #endif
 
 #ifndef OF_SELUID16
@@ -77,9 +84,135 @@ objc_sparsearray_new(void)
 	for (i = 0; i < 256; i++)
 		s->buckets[i] = empty_level2;
 
+#ifdef OBJC_METHOD_CACHE
+	for (i = 0; i < OBJC_METHOD_CACHE_SIZE; i++) {
+		s->cache[i].uid = OBJC_METHOD_CACHE_INVALID;
+		s->cache[i].imp = (IMP)0;
+	}
+#endif
+
 	return s;
 }
 
+#ifdef OBJC_METHOD_CACHE
+static void
+cache_invalidate(struct objc_sparsearray *s, uint32_t idx)
+{
+	struct objc_method_cache_entry *entry =
+	    &s->cache[idx & (OBJC_METHOD_CACHE_SIZE - 1)];
+
+	/*
+	 * The locked compare and swap makes sure the new value in the sparse
+	 * array is visible before the entry is invalidated. If the entry is
+	 * currently being filled, it is left alone: The compare and swap still
+	 * orders our store before the filler publishes the entry, and the
+	 * filler checks the sparse array again after that.
+	 */
+	for (;;) {
+		uintptr_t old = entry->uid;
+		uintptr_t replacement = (old == OBJC_METHOD_CACHE_BUSY
+		    ? OBJC_METHOD_CACHE_BUSY : OBJC_METHOD_CACHE_INVALID);
+
+		if (of_atomic_cmpswap_ptr((void* volatile*)&entry->uid,
+		    (void*)old, (void*)replacement))
+			break;
+	}
+}
+
+IMP
+objc_method_cache_fill(struct objc_sparsearray *s, uintptr_t uid, IMP imp)
+{
+	struct objc_method_cache_entry *entry =
+	    &s->cache[uid & (OBJC_METHOD_CACHE_SIZE - 1)];
+	uintptr_t old = entry->uid;
+
+	/*
+	 * Only one thread may fill an entry at a time. If somebody else is
+	 * already filling it, we just don't cache the IMP.
+	 */
+	if (old == OBJC_METHOD_CACHE_BUSY)
+		return imp;
+
+	if (!of_atomic_cmpswap_ptr((void* volatile*)&entry->uid, (void*)old,
+	    (void*)OBJC_METHOD_CACHE_BUSY))
+		return imp;
+
+	entry->imp = imp;
+
+	/* Nobody else writes the entry while it is busy */
+	of_atomic_cmpswap_ptr((void* volatile*)&entry->uid,
+	    (void*)OBJC_METHOD_CACHE_BUSY, (void*)uid);
+
+	/* The method might have been replaced while we were filling */
+	if (objc_sparsearray_get(s, (uint32_t)uid) != imp)
+		of_atomic_cmpswap_ptr((void* volatile*)&entry->uid,
+		    (void*)uid, (void*)OBJC_METHOD_CACHE_INVALID);
+
+	return imp;
+}
+#endif
+
+/*
+ * Pages are shared between sparse arrays until they are written to. This
+ * returns a level 2 page of the sparse array that can be written to, creating
+ * a new page if it is still the empty one or cloning it if it is shared.
+ */
+static struct objc_sparsearray_level2*
+writable_level2(struct objc_sparsearray *s, uint8_t i)
+{
+	struct objc_sparsearray_level2 *old = s->buckets[i], *t;
+	uint_fast16_t l;
+
+	if (!old->empty && old->refcnt == 1)
+		return old;
+
+	if ((t = malloc(sizeof(struct objc_sparsearray_level2))) == NULL)
+		OBJC_ERROR("Not enough memory to insert into sparse array!");
+
+	t->empty = NO;
+	t->refcnt = 1;
+
+	for (l = 0; l < 256; l++) {
+		t->buckets[l] = old->buckets[l];
+#ifndef OF_SELUID16
+		if (!t->buckets[l]->empty)
+			t->buckets[l]->refcnt++;
+#endif
+	}
+
+	if (!old->empty)
+		old->refcnt--;
+
+	s->buckets[i] = t;
+
+	return t;
+}
+
+#ifndef OF_SELUID16
+static struct objc_sparsearray_level3*
+writable_level3(struct objc_sparsearray_level2 *s, uint8_t j)
+{
+	struct objc_sparsearray_level3 *old = s->buckets[j], *t;
+
+	if (!old->empty && old->refcnt == 1)
+		return old;
+
+	if ((t = malloc(sizeof(struct objc_sparsearray_level3))) == NULL)
+		OBJC_ERROR("Not enough memory to insert into sparse array!");
+
+	memcpy(t->buckets, old->buckets, sizeof(t->buckets));
+	t->empty = NO;
+	t->refcnt = 1;
+
+	if (!old->empty)
+		old->refcnt--;
+
+	s->buckets[j] = t;
+
+	return t;
+}
+#endif
+
 void
 objc_sparsearray_copy(struct objc_sparsearray *dst,
     struct objc_sparsearray *src)
@@ -88,43 +221,53 @@ objc_sparsearray_copy(struct objc_sparsearray *dst,
 #ifndef OF_SELUID16
 	uint_fast16_t k;
 #endif
-	uint32_t idx;
 
 	for (i = 0; i < 256; i++) {
-		if (src->buckets[i]->empty)
-			continue;
-
-#ifndef OF_SELUID16
-		for (j = 0; j < 256; j++) {
-			if (src->buckets[i]->buckets[j]->empty)
-				continue;
-
-			for (k = 0; k < 256; k++) {
-				const void *obj;
+		struct objc_sparsearray_level2 *s2 = src->buckets[i];
+		struct objc_sparsearray_level2 *d2 = dst->buckets[i];
 
-				obj = src->buckets[i]->buckets[j]->buckets[k];
-
-				if (obj == NULL)
-					continue;
+		if (s2->empty || s2 == d2)
+			continue;
 
-				idx = (uint32_t)
-				    (((uint32_t)i << 16) | (j << 8) | k);
-				objc_sparsearray_set(dst, idx, obj);
-			}
+		/*
+		 * Share the whole page if there is nothing in the destination
+		 * yet. Pages are only ever modified after they have been
+		 * cloned, so the page of the source stays untouched.
+		 */
+		if (d2->empty) {
+			s2->refcnt++;
+			dst->buckets[i] = s2;
+			continue;
 		}
-#else
+
 		for (j = 0; j < 256; j++) {
-			const void *obj;
+#ifndef OF_SELUID16
+			struct objc_sparsearray_level3 *s3 = s2->buckets[j];
+			struct objc_sparsearray_level3 *d3;
 
-			obj = src->buckets[i]->buckets[j];
+			/* Setting might have cloned the destination's page */
+			d3 = dst->buckets[i]->buckets[j];
 
-			if (obj == NULL)
+			if (s3->empty || s3 == d3)
 				continue;
 
-			idx = (i << 8) | j;
-			objc_sparsearray_set(dst, idx, obj);
-		}
+			if (d3->empty) {
+				s3->refcnt++;
+				writable_level2(dst, i)->buckets[j] = s3;
+				continue;
+			}
+
+			for (k = 0; k < 256; k++)
+				if (s3->buckets[k] != NULL)
+					objc_sparsearray_set(dst, (uint32_t)
+					    (((uint32_t)i << 16) | (j << 8) |
+					    k), s3->buckets[k]);
+#else
+			if (s2->buckets[j] != NULL)
+				objc_sparsearray_set(dst, (uint32_t)
+				    ((i << 8) | j), s2->buckets[j]);
 #endif
+		}
 	}
 }
 
@@ -140,50 +283,18 @@ objc_sparsearray_set(struct objc_sparsearray *s, uint32_t idx, const void *obj)
 	uint8_t j = idx;
 #endif
 
-	if (s->buckets[i]->empty) {
-		struct objc_sparsearray_level2 *t;
-		uint_fast16_t l;
-
-		t = malloc(sizeof(struct objc_sparsearray_level2));
-
-		if (t == NULL)
-			OBJC_ERROR("Not enough memory to insert into sparse "
-			    "array!");
+	/* Avoid cloning a shared page if nothing changes */
+	if (objc_sparsearray_get(s, idx) == obj)
+		return;
 
-		t->empty = NO;
-
-		for (l = 0; l < 256; l++)
 #ifndef OF_SELUID16
-			t->buckets[l] = empty_level3;
+	writable_level3(writable_level2(s, i), j)->buckets[k] = obj;
 #else
-			t->buckets[l] = NULL;
+	writable_level2(s, i)->buckets[j] = obj;
 #endif
 
-		s->buckets[i] = t;
-	}
-
-#ifndef OF_SELUID16
-	if (s->buckets[i]->buckets[j]->empty) {
-		struct objc_sparsearray_level3 *t;
-		uint_fast16_t l;
-
-		t = malloc(sizeof(struct objc_sparsearray_level3));
-
-		if (t == NULL)
-			OBJC_ERROR("Not enough memory to insert into sparse "
-			    "array!");
-
-		t->empty = NO;
-
-		for (l = 0; l < 256; l++)
-			t->buckets[l] = NULL;
-
-		s->buckets[i]->buckets[j] = t;
-	}
-
-	s->buckets[i]->buckets[j]->buckets[k] = obj;
-#else
-	s->buckets[i]->buckets[j] = obj;
+#ifdef OBJC_METHOD_CACHE
+	cache_invalidate(s, idx);
 #endif
 }
 
@@ -196,16 +307,19 @@ objc_sparsearray_free(struct objc_sparsearray *s)
 #endif
 
 	for (i = 0; i < 256; i++) {
-#ifndef OF_SELUID16
-		if (s->buckets[i]->empty)
+		struct objc_sparsearray_level2 *t = s->buckets[i];
+
+		if (t->empty || --t->refcnt > 0)
 			continue;
 
+#ifndef OF_SELUID16
 		for (j = 0; j < 256; j++)
-			if (!s->buckets[i]->buckets[j]->empty)
-				free(s->buckets[i]->buckets[j]);
+			if (!t->buckets[j]->empty &&
+			    --t->buckets[j]->refcnt == 0)
+				free(t->buckets[j]);
 #endif
 
-		free(s->buckets[i]);
+		free(t);
 	}
 
 	free(s);
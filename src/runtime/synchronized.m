@@ -23,102 +23,215 @@
 #import "runtime-private.h"
 #import "threading.h"
 
+#define NUM_STRIPES 64		/* needs to be a power of 2 */
+#define STRIPE_HASH(p) ((unsigned)((uintptr_t)p >> 4) & (NUM_STRIPES - 1))
+#define MAX_FREE_LOCKS 4	/* per stripe */
+#ifdef OF_COMPILER_TLS
+# define CACHE_SIZE 16
+#endif
+
 struct lock_s {
 	id	      object;
 	int	      count;
 	of_rmutex_t   rmutex;
 	struct lock_s *next;
-} *locks = NULL;
+};
 
-static of_mutex_t mutex;
+/*
+ * Every stripe has its own list of locks and its own pool of unused locks
+ * whose mutexes are kept initialized, so that unrelated objects never contend
+ * and entering @synchronized does not need to create a mutex each time.
+ */
+static struct stripe_s {
+	of_spinlock_t spinlock;
+	struct lock_s *locks;
+	struct lock_s *freeLocks;
+	unsigned      freeLocksCount;
+} stripes[NUM_STRIPES];
+
+#ifdef OF_COMPILER_TLS
+/*
+ * The locks the current thread holds. If a thread enters @synchronized for an
+ * object again, only the depth here is increased, without touching the stripe
+ * or the mutex at all. If the cache is full, the lock is just taken again
+ * recursively.
+ */
+static __thread struct {
+	id	      object;
+	struct lock_s *lock;
+	unsigned      depth;
+} cache[CACHE_SIZE];
+static __thread unsigned cacheCount = 0;
+#endif
 
 static void __attribute__((constructor))
 init(void)
 {
-	if (!of_mutex_new(&mutex))
-		OBJC_ERROR("Failed to create mutex!")
+	size_t i;
+
+	for (i = 0; i < NUM_STRIPES; i++)
+		if (!of_spinlock_new(&stripes[i].spinlock))
+			OBJC_ERROR("Failed to create spinlock!")
 }
 
 int
 objc_sync_enter(id object)
 {
+	struct stripe_s *stripe;
 	struct lock_s *lock;
 
-	if (!of_mutex_lock(&mutex))
-		OBJC_ERROR("Failed to lock mutex!");
-
-	/* Look if we already have a lock */
-	for (lock = locks; lock != NULL; lock = lock->next) {
-		if (lock->object != object)
-			continue;
+	if (object == nil)
+		return 0;
 
-		lock->count++;
+#ifdef OF_COMPILER_TLS
+	{
+		unsigned i;
 
-		if (!of_mutex_unlock(&mutex))
-			OBJC_ERROR("Failed to unlock mutex!");
+		for (i = cacheCount; i > 0; i--) {
+			if (cache[i - 1].object == object) {
+				cache[i - 1].depth++;
+				return 0;
+			}
+		}
+	}
+#endif
 
-		if (!of_rmutex_lock(&lock->rmutex))
-			OBJC_ERROR("Failed to lock mutex!");
+	stripe = &stripes[STRIPE_HASH(object)];
 
-		return 0;
-	}
+	if (!of_spinlock_lock(&stripe->spinlock))
+		OBJC_ERROR("Failed to lock spinlock!");
 
-	/* Create a new lock */
-	if ((lock = malloc(sizeof(*lock))) == NULL)
-		OBJC_ERROR("Failed to allocate memory for mutex!");
+	/* Look if we already have a lock */
+	for (lock = stripe->locks; lock != NULL; lock = lock->next)
+		if (lock->object == object)
+			break;
+
+	if (lock == NULL) {
+		/* Reuse a lock from the pool or create a new one */
+		if ((lock = stripe->freeLocks) != NULL) {
+			stripe->freeLocks = lock->next;
+			stripe->freeLocksCount--;
+		} else {
+			if ((lock = malloc(sizeof(*lock))) == NULL)
+				OBJC_ERROR("Failed to allocate memory for "
+				    "mutex!");
+
+			if (!of_rmutex_new(&lock->rmutex))
+				OBJC_ERROR("Failed to create mutex!");
+		}
 
-	if (!of_rmutex_new(&lock->rmutex))
-		OBJC_ERROR("Failed to create mutex!");
+		lock->object = object;
+		lock->count = 0;
+		lock->next = stripe->locks;
 
-	lock->object = object;
-	lock->count = 1;
-	lock->next = locks;
+		stripe->locks = lock;
+	}
 
-	locks = lock;
+	lock->count++;
 
-	if (!of_mutex_unlock(&mutex))
-		OBJC_ERROR("Failed to unlock mutex!");
+	if (!of_spinlock_unlock(&stripe->spinlock))
+		OBJC_ERROR("Failed to unlock spinlock!");
 
 	if (!of_rmutex_lock(&lock->rmutex))
 		OBJC_ERROR("Failed to lock mutex!");
 
+#ifdef OF_COMPILER_TLS
+	if (cacheCount < CACHE_SIZE) {
+		cache[cacheCount].object = object;
+		cache[cacheCount].lock = lock;
+		cache[cacheCount].depth = 1;
+		cacheCount++;
+	}
+#endif
+
 	return 0;
 }
 
-int
-objc_sync_exit(id object)
+static void
+release_lock(struct stripe_s *stripe, struct lock_s *lock)
 {
-	struct lock_s *lock, *last = NULL;
+	if (!of_rmutex_unlock(&lock->rmutex))
+		OBJC_ERROR("Failed to unlock mutex!");
 
-	if (!of_mutex_lock(&mutex))
-		OBJC_ERROR("Failed to lock mutex!");
+	if (!of_spinlock_lock(&stripe->spinlock))
+		OBJC_ERROR("Failed to lock spinlock!");
 
-	for (lock = locks; lock != NULL; lock = lock->next) {
-		if (lock->object != object) {
-			last = lock;
-			continue;
-		}
+	if (--lock->count == 0) {
+		struct lock_s **iter;
 
-		if (!of_rmutex_unlock(&lock->rmutex))
-			OBJC_ERROR("Failed to unlock mutex!");
+		for (iter = &stripe->locks; *iter != lock;
+		    iter = &(*iter)->next);
+		*iter = lock->next;
 
-		if (--lock->count == 0) {
+		if (stripe->freeLocksCount < MAX_FREE_LOCKS) {
+			lock->object = nil;
+			lock->next = stripe->freeLocks;
+			stripe->freeLocks = lock;
+			stripe->freeLocksCount++;
+		} else {
 			if (!of_rmutex_free(&lock->rmutex))
 				OBJC_ERROR("Failed to destroy mutex!");
 
-			if (last != NULL)
-				last->next = lock->next;
-			if (locks == lock)
-				locks = lock->next;
-
 			free(lock);
 		}
+	}
 
-		if (!of_mutex_unlock(&mutex))
-			OBJC_ERROR("Failed to unlock mutex!");
+	if (!of_spinlock_unlock(&stripe->spinlock))
+		OBJC_ERROR("Failed to unlock spinlock!");
+}
 
+int
+objc_sync_exit(id object)
+{
+	struct stripe_s *stripe;
+	struct lock_s *lock;
+
+	if (object == nil)
 		return 0;
+
+	stripe = &stripes[STRIPE_HASH(object)];
+
+#ifdef OF_COMPILER_TLS
+	{
+		unsigned i;
+
+		for (i = cacheCount; i > 0; i--) {
+			if (cache[i - 1].object != object)
+				continue;
+
+			if (--cache[i - 1].depth > 0)
+				return 0;
+
+			lock = cache[i - 1].lock;
+
+			/* Keep the cache ordered, it's usually the last one */
+			for (; i < cacheCount; i++)
+				cache[i - 1] = cache[i];
+			cacheCount--;
+
+			release_lock(stripe, lock);
+
+			return 0;
+		}
 	}
+#endif
 
-	OBJC_ERROR("objc_sync_exit() was called for an object not locked!");
+	if (!of_spinlock_lock(&stripe->spinlock))
+		OBJC_ERROR("Failed to lock spinlock!");
+
+	for (lock = stripe->locks; lock != NULL; lock = lock->next)
+		if (lock->object == object)
+			break;
+
+	if (!of_spinlock_unlock(&stripe->spinlock))
+		OBJC_ERROR("Failed to unlock spinlock!");
+
+	if (lock == NULL)
+		OBJC_ERROR("objc_sync_exit() was called for an object not "
+		    "locked!");
+
+	/* The lock can't go away, as we still hold a reference to it */
+	release_lock(stripe, lock);
+
+	return 0;
 }
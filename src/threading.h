@@ -20,10 +20,17 @@
 # error No threads available!
 #endif
 
+#include <errno.h>
+
 #import "macros.h"
+#import "of_clock.h"
 
 #if defined(OF_HAVE_PTHREADS)
 # include <pthread.h>
+# include <time.h>
+# ifndef OF_HAVE_PTHREAD_CONDATTR_SETCLOCK
+#  include <sys/time.h>
+# endif
 typedef pthread_t of_thread_t;
 typedef pthread_key_t of_tlskey_t;
 typedef pthread_mutex_t of_mutex_t;
@@ -179,7 +186,23 @@ static OF_INLINE BOOL
 of_condition_new(of_condition_t *condition)
 {
 #if defined(OF_HAVE_PTHREADS)
+# ifdef OF_HAVE_PTHREAD_CONDATTR_SETCLOCK
+	pthread_condattr_t attr;
+	BOOL ret;
+
+	if (pthread_condattr_init(&attr))
+		return NO;
+
+	/* Timed waits should not be affected by changes of the system time */
+	ret = (!pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) &&
+	    !pthread_cond_init(condition, &attr));
+
+	pthread_condattr_destroy(&attr);
+
+	return ret;
+# else
 	return !pthread_cond_init(condition, NULL);
+# endif
 #elif defined(_WIN32)
 	condition->count = 0;
 
@@ -215,6 +238,94 @@ of_condition_wait(of_condition_t *condition, of_mutex_t *mutex)
 #endif
 }
 
+/*
+ * Returns NO and sets errno to ETIMEDOUT if the deadline, which is a time as
+ * returned by of_monotonic_time(), was reached before the condition was
+ * signaled.
+ */
+static OF_INLINE BOOL
+of_condition_timed_wait(of_condition_t *condition, of_mutex_t *mutex,
+    uint64_t deadline)
+{
+	uint64_t now = of_monotonic_time();
+	uint64_t remaining;
+#if defined(OF_HAVE_PTHREADS)
+	struct timespec ts;
+# ifndef OF_HAVE_PTHREAD_CONDATTR_SETCLOCK
+	struct timeval tv;
+# endif
+	int error;
+#elif defined(_WIN32)
+	DWORD milliseconds;
+#endif
+
+	if (deadline <= now) {
+		errno = ETIMEDOUT;
+		return NO;
+	}
+
+	remaining = deadline - now;
+
+	/* Deadlines too far in the future can't be represented */
+	if (remaining / 1000000000 > INT32_MAX)
+		return of_condition_wait(condition, mutex);
+
+#if defined(OF_HAVE_PTHREADS)
+# ifdef OF_HAVE_PTHREAD_CONDATTR_SETCLOCK
+	if (clock_gettime(CLOCK_MONOTONIC, &ts))
+		return NO;
+# else
+	if (gettimeofday(&tv, NULL))
+		return NO;
+
+	ts.tv_sec = tv.tv_sec;
+	ts.tv_nsec = tv.tv_usec * 1000;
+# endif
+
+	ts.tv_sec += (time_t)(remaining / 1000000000);
+	ts.tv_nsec += (long)(remaining % 1000000000);
+
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	if ((error = pthread_cond_timedwait(condition, mutex, &ts)) != 0) {
+		errno = error;
+		return NO;
+	}
+
+	return YES;
+#elif defined(_WIN32)
+	milliseconds = (DWORD)(remaining / 1000000);
+
+	if (!of_mutex_unlock(mutex))
+		return NO;
+
+	of_atomic_inc_int(&condition->count);
+
+	switch (WaitForSingleObject(condition->event, milliseconds)) {
+	case WAIT_OBJECT_0:
+		break;
+	case WAIT_TIMEOUT:
+		of_atomic_dec_int(&condition->count);
+		of_mutex_lock(mutex);
+		errno = ETIMEDOUT;
+		return NO;
+	default:
+		of_mutex_lock(mutex);
+		return NO;
+	}
+
+	of_atomic_dec_int(&condition->count);
+
+	if (!of_mutex_lock(mutex))
+		return NO;
+
+	return YES;
+#endif
+}
+
 static OF_INLINE BOOL
 of_condition_signal(of_condition_t *condition)
 {
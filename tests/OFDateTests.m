@@ -16,10 +16,15 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #import "OFDate.h"
+#import "OFDateFormatter.h"
 #import "OFString.h"
 #import "OFAutoreleasePool.h"
 
+#import "OFInvalidFormatException.h"
+
 #import "TestsAppDelegate.h"
 
 static OFString *module = @"OFDate";
@@ -28,7 +33,9 @@ static OFString *module = @"OFDate";
 - (void)dateTests
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
-	OFDate *d1, *d2;
+	OFDate *d1, *d2, *d3;
+	OFDateFormatter *f;
+	char buffer[32];
 
 	TEST(@"+[dateWithTimeIntervalSince1970:]",
 	    (d1 = [OFDate dateWithTimeIntervalSince1970: 0]))
@@ -40,6 +47,10 @@ static OFString *module = @"OFDate";
 	    [[d1 description] isEqual: @"1970-01-01T00:00:00Z"] &&
 	    [[d2 description] isEqual: @"1970-01-02T01:00:05Z"])
 
+	TEST(@"-[description] for years with more than four digits",
+	    [[[OFDate dateWithTimeIntervalSince1970: 253402300800.0]
+	    description] isEqual: @"10000-01-01T00:00:00Z"])
+
 	TEST(@"+[dateWithDateString:format:]",
 	    [[[OFDate dateWithDateString: @"2000-06-20T12:34:56Z"
 				  format: @"%Y-%m-%dT%H:%M:%SZ"] description]
@@ -70,6 +81,56 @@ static OFString *module = @"OFDate";
 
 	TEST(@"-[dayOfYear]", [d1 dayOfYear] == 1 && [d2 dayOfYear] == 2)
 
+	TEST(@"Civil date before 1970 and in a leap year",
+	    (d3 = [OFDate dateWithTimeIntervalSince1970: -2203891200.5]) &&
+	    [d3 year] == 1900 && [d3 monthOfYear] == 2 &&
+	    [d3 dayOfMonth] == 28 && [d3 hour] == 23 && [d3 second] == 59 &&
+	    [d3 dayOfWeek] == 3 && [d3 dayOfYear] == 59 &&
+	    (d3 = [OFDate dateWithTimeIntervalSince1970: 951782400]) &&
+	    [d3 monthOfYear] == 2 && [d3 dayOfMonth] == 29 &&
+	    [d3 dayOfYear] == 60)
+
+	TEST(@"-[dateStringWithFormat:]",
+	    [[d2 dateStringWithFormat: @"%a %j %d.%m.%Y"]
+	    isEqual: @"Fri 002 02.01.1970"])
+
+	f = [OFDateFormatter RFC1123DateFormatter];
+
+	TEST(@"-[OFDateFormatter formatDate:intoBuffer:length:]",
+	    [f formattedLength] == 29 &&
+	    [f formatDate: [OFDate dateWithTimeIntervalSince1970: 784111777]
+	       intoBuffer: buffer
+		   length: sizeof(buffer)] == 29 &&
+	    !memcmp(buffer, "Sun, 06 Nov 1994 08:49:37 GMT", 29))
+
+	TEST(@"-[OFDateFormatter stringFromDate:]",
+	    [[f stringFromDate: d2] isEqual: @"Fri, 02 Jan 1970 01:00:05 GMT"])
+
+	TEST(@"-[OFDateFormatter dateFromString:]",
+	    [[f dateFromString: @"Sun, 06 Nov 1994 08:49:37 GMT"] isEqual:
+	    [OFDate dateWithTimeIntervalSince1970: 784111777]] &&
+	    [[[OFDateFormatter ISO8601DateFormatter]
+	    dateFromString: @"2000-02-29T12:34:56Z"] isEqual:
+	    [OFDate dateWithTimeIntervalSince1970: 951827696]])
+
+	TEST(@"-[OFDateFormatter dateFromUTF8String:length:]",
+	    [[f dateFromUTF8String: "Sun, 06 Nov 1994 08:49:37 GMT"
+			    length: 29] isEqual:
+	    [OFDate dateWithTimeIntervalSince1970: 784111777]])
+
+	TEST(@"-[OFDateFormatter dateFromUTF8String:length:] with invalid "
+	    @"dates",
+	    [f dateFromUTF8String: "Mon, 06 Nov 1994 08:49:37 GMT"
+			   length: 29] == nil &&
+	    [f dateFromUTF8String: "Tue, 29 Feb 2100 08:49:37 GMT"
+			   length: 29] == nil &&
+	    [f dateFromUTF8String: "Sun, 06 Nov 1994 08:49:37 UTC"
+			   length: 29] == nil)
+
+	EXPECT_EXCEPTION(@"Detect invalid format in -[OFDateFormatter "
+	    @"initWithFormat:]", OFInvalidFormatException,
+	    [OFDateFormatter formatterWithFormat: @"%Y-%j"])
+
 	TEST(@"-[earlierDate:]", [[d1 earlierDate: d2] isEqual: d1])
 
 	TEST(@"-[laterDate:]", [[d1 laterDate: d2] isEqual: d2])
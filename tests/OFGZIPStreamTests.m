@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFGZIPStream.h"
+#import "OFFile.h"
+#import "OFString.h"
+#import "OFDataArray.h"
+#import "OFAutoreleasePool.h"
+
+#import "OFInvalidFormatException.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFGZIPStream";
+
+@implementation TestsAppDelegate (OFGZIPStreamTests)
+- (void)GZIPStreamTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFDataArray *expected = [OFDataArray
+	    dataArrayWithContentsOfFile: @"serialization.xml"];
+	OFDeflateStream *stream;
+	size_t i;
+
+	TEST(@"+[streamWithStream:]",
+	    (stream = [OFGZIPStream streamWithStream:
+	    [OFFile fileWithPath: @"testfile.gz"
+			    mode: @"rb"]]))
+
+	TEST(@"Decompression",
+	    [[stream readDataArrayTillEndOfStream] isEqual: expected] &&
+	    [stream isAtEndOfStream] && R([stream close]))
+
+	stream = [OFGZIPStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"wb"]];
+
+	/* Write in small pieces so that matches need to span writes */
+	for (i = 0; i < [expected count]; i += 100) {
+		size_t length = [expected count] - i;
+
+		if (length > 100)
+			length = 100;
+
+		[stream writeBuffer: (char*)[expected items] + i
+			     length: length];
+	}
+
+	TEST(@"Compression", R([stream close]) &&
+	    (stream = [OFGZIPStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"rb"]]) &&
+	    [[stream readDataArrayTillEndOfStream] isEqual: expected] &&
+	    R([stream close]))
+
+	stream = [OFDeflateStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"wb"]];
+
+	/* The same 100 bytes 1000 times, a match for the previous write */
+	for (i = 0; i < 1000; i++)
+		[stream writeBuffer: [expected items]
+			     length: 100];
+
+	TEST(@"Compression of repeated small writes", R([stream close]) &&
+	    [OFFile sizeOfFileAtPath: @"gziptest.gz"] < 2000 &&
+	    (stream = [OFDeflateStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"rb"]]) &&
+	    [[stream readDataArrayTillEndOfStream] count] == 100000 &&
+	    R([stream close]))
+
+	stream = [OFGZIPStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"wb"]
+					   mode: @"w"];
+
+	TEST(@"Compression of empty data", R([stream close]) &&
+	    (stream = [OFGZIPStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"rb"]]) &&
+	    [[stream readDataArrayTillEndOfStream] count] == 0 &&
+	    [stream isAtEndOfStream] && R([stream close]))
+
+	stream = [OFDeflateStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"wb"]
+					      mode: @"w"];
+
+	TEST(@"Compression of empty data without gzip framing",
+	    R([stream close]) &&
+	    (stream = [OFDeflateStream streamWithStream:
+	    [OFFile fileWithPath: @"gziptest.gz"
+			    mode: @"rb"]]) &&
+	    [[stream readDataArrayTillEndOfStream] count] == 0 &&
+	    R([stream close]))
+
+	[OFFile deleteFileAtPath: @"gziptest.gz"];
+
+	stream = [OFGZIPStream streamWithStream:
+	    [OFFile fileWithPath: @"testfile.txt"
+			    mode: @"rb"]];
+
+	EXPECT_EXCEPTION(@"Detection of invalid data",
+	    OFInvalidFormatException, [stream readDataArrayTillEndOfStream])
+
+	[stream close];
+
+	[pool drain];
+}
+@end
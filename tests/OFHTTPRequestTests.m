@@ -23,12 +23,15 @@
 #include <assert.h>
 
 #import "OFHTTPRequest.h"
+#import "OFHTTPConnectionPool.h"
 #import "OFString.h"
 #import "OFTCPSocket.h"
 #import "OFThread.h"
 #import "OFCondition.h"
 #import "OFURL.h"
+#import "OFArray.h"
 #import "OFDictionary.h"
+#import "OFDataArray.h"
 #import "OFAutoreleasePool.h"
 
 #import "TestsAppDelegate.h"
@@ -47,6 +50,7 @@ static OFCondition *cond;
 - main
 {
 	OFTCPSocket *listener, *client;
+	int i;
 
 	[cond lock];
 
@@ -60,27 +64,34 @@ static OFCondition *cond;
 
 	client = [listener accept];
 
-	if (![[client readLine] isEqual: @"GET /foo HTTP/1.1"])
-		assert(0);
+	/*
+	 * The second request must reuse the connection of the first one and
+	 * the last two requests are pipelined on it.
+	 */
+	for (i = 0; i < 4; i++) {
+		if (![[client readLine] isEqual: @"GET /foo HTTP/1.1"])
+			assert(0);
 
-	if (![[client readLine] isEqual:
-	    [OFString stringWithFormat: @"Host: 127.0.0.1:%" @PRIu16, port]])
-		assert(0);
+		if (![[client readLine] isEqual: [OFString stringWithFormat:
+		    @"Host: 127.0.0.1:%" @PRIu16, port]])
+			assert(0);
 
-	if (![[client readLine] isEqual: @"Connection: close"])
-		assert(0);
+		if (![[client readLine] isEqual: @"Connection: keep-alive"])
+			assert(0);
 
-	if (![[client readLine] hasPrefix: @"User-Agent:"])
-		assert(0);
+		if (![[client readLine] hasPrefix: @"User-Agent:"])
+			assert(0);
 
-	if (![[client readLine] isEqual: @""])
-		assert(0);
+		if (![[client readLine] isEqual: @""])
+			assert(0);
+
+		[client writeString: @"HTTP/1.1 200 OK\r\n"
+				     @"cONTeNT-lENgTH: 7\r\n"
+				     @"\r\n"
+				     @"foo\n"
+				     @"bar"];
+	}
 
-	[client writeString: @"HTTP/1.1 200 OK\r\n"
-			     @"cONTeNT-lENgTH: 7\r\n"
-			     @"\r\n"
-			     @"foo\n"
-			     @"bar"];
 	[client close];
 
 	return nil;
@@ -93,8 +104,12 @@ static OFCondition *cond;
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	OFHTTPRequestTestsServer *server;
 	OFURL *url;
-	OFHTTPRequest *req;
+	OFHTTPRequest *req, *req2;
 	OFHTTPRequestResult *res;
+	OFArray *results;
+	OFHTTPConnectionPool *connectionPool;
+	OFTCPSocket *listener, *sock;
+	uint16_t port;
 
 	cond = [OFCondition condition];
 	[cond lock];
@@ -111,13 +126,49 @@ static OFCondition *cond;
 
 	TEST(@"+[requestWithURL]", (req = [OFHTTPRequest requestWithURL: url]))
 
+	TEST(@"-[setConnectionPool:]",
+	    R([req setConnectionPool: [OFHTTPConnectionPool connectionPool]]))
+
 	TEST(@"-[perform]", (res = [req perform]))
 
 	TEST(@"Normalization of server header keys",
 	     ([[res headers] objectForKey: @"Content-Length"] != nil))
 
+	TEST(@"-[perform] on a persistent connection",
+	    (res = [req perform]) && [[res data] count] == 7)
+
+	req2 = [OFHTTPRequest requestWithURL: url];
+	[req2 setConnectionPool: [req connectionPool]];
+
+	TEST(@"+[performRequests:]",
+	    (results = [OFHTTPRequest performRequests:
+	    [OFArray arrayWithObjects: req, req2, nil]]) &&
+	    [results count] == 2 &&
+	    [[[results objectAtIndex: 0] data] count] == 7 &&
+	    [[[results objectAtIndex: 1] data] count] == 7)
+
 	[server join];
 
+	connectionPool = [OFHTTPConnectionPool connectionPool];
+	[connectionPool setIdleTimeout: 0];
+
+	listener = [OFTCPSocket socket];
+	port = [listener bindToHost: @"127.0.0.1"
+			       port: 0];
+	[listener listen];
+
+	sock = [OFTCPSocket socket];
+	[sock connectToHost: @"127.0.0.1"
+		       port: port];
+
+	[connectionPool addSocket: sock
+			   forURL: [OFURL URLWithString: @"http://a.invalid/"]];
+	[connectionPool addSocket: [listener accept]
+			   forURL: [OFURL URLWithString: @"http://b.invalid/"]];
+
+	TEST(@"Closing of expired connections to other hosts",
+	    [sock fileDescriptorForReading] == -1)
+
 	[pool drain];
 }
 @end
@@ -0,0 +1,513 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFHTTPServer.h"
+#import "OFHTTPRequest.h"
+#import "OFHTTPConnectionPool.h"
+#import "OFString.h"
+#import "OFTCPSocket.h"
+#import "OFThread.h"
+#import "OFCondition.h"
+#import "OFRunLoop.h"
+#import "OFURL.h"
+#import "OFArray.h"
+#import "OFMutableArray.h"
+#import "OFDictionary.h"
+#import "OFDataArray.h"
+#import "OFAutoreleasePool.h"
+
+#import "OFConnectionFailedException.h"
+#import "OFHTTPRequestFailedException.h"
+#import "OFInvalidArgumentException.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFHTTPServer";
+static OFCondition *cond;
+
+@interface OFHTTPServerTestsDataStream: OFStream
+{
+@public
+	OFDataArray *data;
+}
+@end
+
+@implementation OFHTTPServerTestsDataStream
+- init
+{
+	self = [super init];
+
+	@try {
+		data = [[OFDataArray alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[data release];
+
+	[super dealloc];
+}
+
+- (void)lowlevelWriteBuffer: (const void*)buffer
+		     length: (size_t)length
+{
+	[data addItemsFromCArray: buffer
+			   count: length];
+}
+@end
+
+@interface OFHTTPServerTestsDelegate: OFObject <OFHTTPRequestDelegate>
+{
+@public
+	size_t received, largest;
+	BOOL receivedEmpty;
+}
+@end
+
+@implementation OFHTTPServerTestsDelegate
+-  (void)request: (OFHTTPRequest*)request
+  didReceiveData: (const char*)data
+      withLength: (size_t)length
+{
+	received += length;
+
+	if (length > largest)
+		largest = length;
+	if (length == 0)
+		receivedEmpty = YES;
+}
+@end
+
+@interface OFHTTPServerTestsThread: OFThread <OFHTTPServerDelegate>
+{
+@public
+	uint16_t port;
+}
+@end
+
+@implementation OFHTTPServerTestsThread
+- main
+{
+	OFHTTPServer *server = [OFHTTPServer server];
+
+	[cond lock];
+
+	[server setDelegate: self];
+	[server start];
+	port = [server port];
+
+	[cond signal];
+	[cond unlock];
+
+	[[OFRunLoop currentRunLoop] run];
+
+	return nil;
+}
+
+-      (void)server: (OFHTTPServer*)server
+  didReceiveRequest: (OFHTTPServerRequest*)request
+	   response: (OFHTTPServerResponse*)response
+{
+	OFString *path = [request path];
+
+	if ([path isEqual: @"/fixed"]) {
+		[[response headers] setObject: @"3"
+				       forKey: @"Content-Length"];
+		[response writeString: @"foo"];
+	} else if ([path isEqual: @"/chunked"]) {
+		[response writeString: @"foo"];
+		[response writeString: @"bar"];
+	} else if ([path isEqual: @"/redirect"]) {
+		[response setStatusCode: 302];
+		[[response headers] setObject: @"/fixed"
+				       forKey: @"Location"];
+	} else if ([path isEqual: @"/gzip"]) {
+		OFDataArray *body =
+		    [OFDataArray dataArrayWithContentsOfFile: @"testfile.gz"];
+
+		[[response headers] setObject: @"gzip"
+				       forKey: @"Content-Encoding"];
+		[response writeBuffer: [body items]
+			       length: [body count]];
+	} else if ([path isEqual: @"/echo"]) {
+		OFDataArray *body = [request body];
+
+		[[response headers] setObject: [OFString stringWithFormat:
+		    @"%zu", [body count]]
+				       forKey: @"Content-Length"];
+		[response writeBuffer: [body items]
+			       length: [body count]];
+	} else
+		[response setStatusCode: 404];
+}
+@end
+
+/*
+ * Performs one asynchronous request after the other on the run loop of a
+ * separate thread, so that they can reuse the pooled connection, and signals
+ * cond once all are done.
+ */
+@interface OFHTTPServerTestsClientThread: OFThread <OFHTTPRequestDelegate>
+{
+@public
+	OFString *base;
+	id object;
+	size_t count, missing;
+	uint16_t refusedPort;
+	OFMutableArray *results;
+	size_t sockets, redirects;
+	BOOL done;
+	OFHTTPConnectionPool *connectionPool;
+	int step;
+}
+
+- (void)addResult: (id)result;
+- (void)performNextRequest;
+@end
+
+@implementation OFHTTPServerTestsClientThread
+- (void)dealloc
+{
+	[connectionPool release];
+
+	[super dealloc];
+}
+
+- main
+{
+	connectionPool = [[OFHTTPConnectionPool alloc] init];
+
+	[self performNextRequest];
+
+	[[OFRunLoop currentRunLoop] run];
+
+	return nil;
+}
+
+- (void)addResult: (id)result
+{
+	[results addObject: result];
+	[self performNextRequest];
+}
+
+- (void)performNextRequest
+{
+	OFString *path;
+	OFHTTPRequest *request;
+	BOOL useBlock = NO;
+
+	switch (step++) {
+	case 0:
+		path = @"/fixed";
+		break;
+	case 1:
+		path = @"/chunked";
+		break;
+	case 2:
+		path = @"/redirect";
+		break;
+	case 3:
+		path = @"/fixed";
+		useBlock = YES;
+		break;
+	case 4:
+		path = @"/missing";
+		break;
+	case 5:
+		path = nil;
+		useBlock = YES;
+		break;
+	default:
+		[cond lock];
+		done = YES;
+		[cond signal];
+		[cond unlock];
+		return;
+	}
+
+#ifndef OF_HAVE_BLOCKS
+	if (useBlock) {
+		[self performNextRequest];
+		return;
+	}
+#endif
+
+	if (path != nil) {
+		request = [OFHTTPRequest requestWithURL: [OFURL URLWithString:
+		    [base stringByAppendingString: path]]];
+		[request setConnectionPool: connectionPool];
+		[request setDelegate: self];
+	} else
+		request = [OFHTTPRequest requestWithURL: [OFURL URLWithString:
+		    [OFString stringWithFormat: @"http://127.0.0.1:%" @PRIu16,
+						refusedPort]]];
+
+#ifdef OF_HAVE_BLOCKS
+	if (useBlock) {
+		[request asyncPerformWithBlock: ^ (OFHTTPRequest *request_,
+		    OFHTTPRequestResult *result, OFException *exception) {
+			if (exception != nil)
+				[self addResult: exception];
+			else
+				[self addResult: result];
+		}];
+		return;
+	}
+#endif
+
+	[request asyncPerform];
+}
+
+-   (void)request: (OFHTTPRequest*)request
+  didCreateSocket: (OFTCPSocket*)socket
+{
+	sockets++;
+}
+
+-	 (BOOL)request: (OFHTTPRequest*)request
+  willFollowRedirectTo: (OFURL*)URL
+{
+	redirects++;
+
+	return YES;
+}
+
+-	(void)request: (OFHTTPRequest*)request
+  didFinishWithResult: (OFHTTPRequestResult*)result
+{
+	[self addResult: result];
+}
+
+-	 (void)request: (OFHTTPRequest*)request
+  didFailWithException: (OFException*)exception
+{
+	[self addResult: exception];
+}
+@end
+
+@implementation TestsAppDelegate (OFHTTPServerTests)
+- (void)HTTPServerTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFHTTPServerTestsThread *thread;
+	OFHTTPServerTestsClientThread *client;
+	OFHTTPServerTestsDataStream *dataStream;
+	OFHTTPServerTestsDelegate *delegate;
+	OFHTTPConnectionPool *connectionPool;
+	OFHTTPRequest *req, *req2;
+	OFHTTPRequestResult *res;
+	OFArray *results;
+	OFTCPSocket *sock;
+	OFString *base;
+
+	cond = [OFCondition condition];
+	[cond lock];
+
+	thread = [[[OFHTTPServerTestsThread alloc] init] autorelease];
+	[thread start];
+
+	[cond wait];
+	[cond unlock];
+
+	base = [OFString stringWithFormat: @"http://127.0.0.1:%" @PRIu16,
+					   thread->port];
+	connectionPool = [[[OFHTTPConnectionPool alloc] init] autorelease];
+
+	req = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/fixed"]]];
+	[req setConnectionPool: connectionPool];
+
+	TEST(@"Response with Content-Length",
+	    (res = [req perform]) && [res statusCode] == 200 &&
+	    [[res data] count] == 3 && !memcmp([[res data] items], "foo", 3))
+
+	req2 = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/chunked"]]];
+	[req2 setConnectionPool: connectionPool];
+
+	TEST(@"Chunked response on a persistent connection",
+	    (res = [req2 perform]) && [res statusCode] == 200 &&
+	    [[res data] count] == 6 && !memcmp([[res data] items], "foobar", 6))
+
+	[req2 setStreamsBody: YES];
+
+	TEST(@"-[setStreamsBody:]",
+	    (res = [req2 perform]) && [res data] == nil &&
+	    [[[res bodyStream] readLine] isEqual: @"foobar"] &&
+	    [[res bodyStream] isAtEndOfStream] && R([[res bodyStream] close]))
+
+	TEST(@"-[perform] after closing a body stream",
+	    (res = [req perform]) && [[res data] count] == 3)
+
+	dataStream = [[[OFHTTPServerTestsDataStream alloc] init] autorelease];
+	delegate = [[[OFHTTPServerTestsDelegate alloc] init] autorelease];
+	req2 = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/chunked"]]];
+	[req2 setConnectionPool: connectionPool];
+	[req2 setDelegate: delegate];
+	[req2 setOutputStream: dataStream];
+
+	TEST(@"-[setOutputStream:]",
+	    (res = [req2 perform]) && [res data] == nil &&
+	    [dataStream->data count] == 6 &&
+	    !memcmp([dataStream->data items], "foobar", 6) &&
+	    delegate->received == 6 && !delegate->receivedEmpty)
+
+	delegate = [[[OFHTTPServerTestsDelegate alloc] init] autorelease];
+	req2 = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/chunked"]]];
+	[req2 setConnectionPool: connectionPool];
+	[req2 setDelegate: delegate];
+
+	TEST(@"-[setReceiveBufferSize:]",
+	    R([req2 setReceiveBufferSize: 2]) &&
+	    [req2 receiveBufferSize] == 2 && (res = [req2 perform]) &&
+	    [[res data] count] == 6 &&
+	    !memcmp([[res data] items], "foobar", 6) &&
+	    delegate->received == 6 && delegate->largest == 2 &&
+	    !delegate->receivedEmpty)
+
+	EXPECT_EXCEPTION(@"Detect a receive buffer size of 0",
+	    OFInvalidArgumentException, [req2 setReceiveBufferSize: 0])
+
+	EXPECT_EXCEPTION(@"Detect a too big receive buffer size",
+	    OFInvalidArgumentException, [req2 setReceiveBufferSize: SIZE_MAX])
+
+	req2 = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/gzip"]]];
+	[req2 setConnectionPool: connectionPool];
+
+	TEST(@"Decoding of a gzip encoded body",
+	    (res = [req2 perform]) && [[res data] isEqual:
+	    [OFDataArray dataArrayWithContentsOfFile: @"serialization.xml"]])
+
+	req2 = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/echo"]]];
+	[req2 setConnectionPool: connectionPool];
+	[req2 setRequestType: OF_HTTP_REQUEST_TYPE_POST];
+	[req2 setQueryString: @"a=b&c=d"];
+
+	TEST(@"POST request with a body",
+	    (res = [req2 perform]) && [res statusCode] == 200 &&
+	    [[res data] count] == 7 &&
+	    !memcmp([[res data] items], "a=b&c=d", 7))
+
+	req2 = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/chunked"]]];
+	[req2 setConnectionPool: connectionPool];
+
+	TEST(@"Pipelined requests",
+	    (results = [OFHTTPRequest performRequests:
+	    [OFArray arrayWithObjects: req, req2, req, nil]]) &&
+	    [results count] == 3 &&
+	    [[[results objectAtIndex: 0] data] count] == 3 &&
+	    [[[results objectAtIndex: 1] data] count] == 6 &&
+	    [[[results objectAtIndex: 2] data] count] == 3)
+
+	req2 = [OFHTTPRequest requestWithURL:
+	    [OFURL URLWithString: [base stringByAppendingString: @"/missing"]]];
+	[req2 setConnectionPool: connectionPool];
+
+	TEST(@"Status code set by the delegate",
+	    (results = [OFHTTPRequest performRequests:
+	    [OFArray arrayWithObject: req2]]) &&
+	    [[results objectAtIndex: 0] statusCode] == 404)
+
+	sock = [OFTCPSocket socket];
+	[sock connectToHost: @"127.0.0.1"
+		       port: thread->port];
+	[sock writeString: @"GET\r\n\r\n"];
+
+	TEST(@"Malformed request",
+	    [[sock readLine] isEqual: @"HTTP/1.1 400 Bad Request"])
+
+	client = [[[OFHTTPServerTestsClientThread alloc] init] autorelease];
+	client->base = base;
+	client->results = [OFMutableArray array];
+
+	/* Nothing listens on this port once the socket is closed */
+	sock = [OFTCPSocket socket];
+	client->refusedPort = [sock bindToHost: @"127.0.0.1"
+					  port: 0];
+	[sock close];
+
+	[cond lock];
+	[client start];
+
+	while (!client->done)
+		[cond wait];
+
+	[cond unlock];
+
+	results = client->results;
+#ifdef OF_HAVE_BLOCKS
+	count = 6;
+	missing = 4;
+#else
+	count = 4;
+	missing = 3;
+#endif
+
+	TEST(@"-[asyncPerform] with Content-Length",
+	    [results count] == count &&
+	    [(res = [results objectAtIndex: 0])
+	    isKindOfClass: [OFHTTPRequestResult class]] &&
+	    [res statusCode] == 200 && [[res data] count] == 3 &&
+	    !memcmp([[res data] items], "foo", 3))
+
+	TEST(@"-[asyncPerform] with a chunked body",
+	    [(res = [results objectAtIndex: 1])
+	    isKindOfClass: [OFHTTPRequestResult class]] &&
+	    [[res data] count] == 6 && !memcmp([[res data] items], "foobar", 6))
+
+	TEST(@"-[asyncPerform] following a redirect",
+	    [(res = [results objectAtIndex: 2])
+	    isKindOfClass: [OFHTTPRequestResult class]] &&
+	    [res statusCode] == 200 && [[res data] count] == 3 &&
+	    client->redirects == 1)
+
+	TEST(@"-[asyncPerform] reusing a pooled connection",
+	    client->sockets == 1)
+
+	TEST(@"-[asyncPerform] reporting a failure to the delegate",
+	    [(object = [results objectAtIndex: missing])
+	    isKindOfClass: [OFHTTPRequestFailedException class]] &&
+	    [[object result] statusCode] == 404)
+
+#ifdef OF_HAVE_BLOCKS
+	TEST(@"-[asyncPerformWithBlock:]",
+	    [(res = [results objectAtIndex: 3])
+	    isKindOfClass: [OFHTTPRequestResult class]] &&
+	    [[res data] count] == 3 && !memcmp([[res data] items], "foo", 3))
+
+	TEST(@"-[asyncPerformWithBlock:] reporting a failure",
+	    [[results objectAtIndex: 5]
+	    isKindOfClass: [OFConnectionFailedException class]])
+#endif
+
+	[pool drain];
+}
+@end
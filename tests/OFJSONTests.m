@@ -33,6 +33,7 @@ static OFString *module = @"OFJSON";
 - (void)JSONTests
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFInvalidJSONException *e;
 	OFString *s = @"{\"foo\"\t:'ba\\r', \"x\":/*foo*/ [.5\r,0xF,null//bar\n"
 	    @",\"foo\",false]}";
 	OFDictionary *d = [OFDictionary dictionaryWithKeysAndObjects:
@@ -59,6 +60,15 @@ static OFString *module = @"OFJSON";
 	    [@"bar" JSONValue])
 	EXPECT_EXCEPTION(@"-[JSONValue #5]", OFInvalidJSONException,
 	    [@"[\"a\" \"b\"]" JSONValue])
+	EXPECT_EXCEPTION(@"-[JSONValue #6]", OFInvalidJSONException,
+	    [@"[1, -]" JSONValue])
+
+	TEST(@"-[JSONValueWithError:]",
+	    [[@"[-12, 0x10, 1.5]" JSONValueWithError: &e] isEqual:
+	    ([OFArray arrayWithObjects: [OFNumber numberWithIntMax: -12],
+	    [OFNumber numberWithIntMax: 16], [OFNumber numberWithDouble: 1.5],
+	    nil])] && e == nil &&
+	    [@"[1,\n2a]" JSONValueWithError: &e] == nil && [e line] == 2)
 
 	[pool drain];
 }
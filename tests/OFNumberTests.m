@@ -60,6 +60,36 @@ static OFString *module = @"OFNumber";
 	    [[num remainderOfDivisionWithNumber: [OFNumber numberWithInt: 11]]
 	    intValue] == 5)
 
+#if defined(OF_OBJFW_RUNTIME) && defined(OBJC_TAGGED_POINTERS)
+	TEST(@"Tagged pointers for small numbers",
+	    object_isTaggedPointer([OFNumber numberWithInt: -42]) &&
+	    [[OFNumber numberWithInt: -42] intValue] == -42 &&
+	    object_isTaggedPointer([OFNumber numberWithDouble: 0.5]) &&
+	    [[OFNumber numberWithDouble: 0.5] doubleValue] == 0.5 &&
+	    [[OFNumber numberWithBool: YES] boolValue] &&
+	    [[OFNumber numberWithDouble: 0.5] type] == OF_NUMBER_DOUBLE)
+
+	TEST(@"No tagged pointers for large numbers",
+	    !object_isTaggedPointer([OFNumber numberWithUInt64: UINT64_MAX]) &&
+	    [[OFNumber numberWithUInt64: UINT64_MAX] uInt64Value] ==
+	    UINT64_MAX &&
+	    !object_isTaggedPointer([OFNumber numberWithIntMax: INTMAX_MIN]) &&
+	    [[OFNumber numberWithIntMax: INTMAX_MIN] intMaxValue] ==
+	    INTMAX_MIN &&
+	    !object_isTaggedPointer([OFNumber numberWithDouble: 0.1]))
+
+	TEST(@"Tagged and untagged numbers are equal",
+	    (num = [[[OFNumber alloc] initWithInt: 1234] autorelease]) &&
+	    [num isEqual: [OFNumber numberWithShort: 1234]] &&
+	    [[OFNumber numberWithShort: 1234] isEqual: num] &&
+	    [num hash] == [[OFNumber numberWithShort: 1234] hash] &&
+	    [[[OFNumber numberWithShort: 1234] description] isEqual: @"1234"])
+
+	TEST(@"Calculations with tagged numbers",
+	    [[[OFNumber numberWithInt: 40] numberByAddingNumber:
+	    [OFNumber numberWithInt: 2]] isEqual: [OFNumber numberWithInt: 42]])
+#endif
+
 	[pool drain];
 }
 @end
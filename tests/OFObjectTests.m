@@ -22,6 +22,8 @@
 #import "OFMemoryNotPartOfObjectException.h"
 #import "OFOutOfMemoryException.h"
 
+#import "autorelease.h"
+
 #import "TestsAppDelegate.h"
 
 #if defined(__DragonFly__) && defined(__LP64__)
@@ -60,6 +62,112 @@ static OFString *module = @"OFObject";
 	    R([obj freeMemory: p]) && R([obj freeMemory: q]) &&
 	    R([obj freeMemory: r]))
 
+	TEST(@"Freeing memory out of order and resizing",
+	    (p = [obj allocMemoryWithSize: 16]) != NULL &&
+	    (q = [obj allocMemoryWithSize: 16]) != NULL &&
+	    (r = [obj allocMemoryWithSize: 16]) != NULL &&
+	    R([obj freeMemory: q]) &&
+	    (p = [obj resizeMemory: p
+			      size: 65536]) != NULL &&
+	    (r = [obj resizeMemory: r
+			      size: 65536]) != NULL &&
+	    R([obj freeMemory: r]) && R([obj freeMemory: p]))
+
+	TEST(@"-[retainCount]",
+	    (o = [[OFObject alloc] init]) && [o retainCount] == 1 &&
+	    [[o retain] retainCount] == 2 && R([o release]) &&
+	    [o retainCount] == 1 && R([o release]))
+
+	{
+		OFAutoreleasePool *outer, *inner;
+		size_t i;
+
+		o = [[OFObject alloc] init];
+		outer = [[OFAutoreleasePool alloc] init];
+
+		for (i = 0; i < 10000; i++)
+			[[o retain] autorelease];
+
+		inner = [[OFAutoreleasePool alloc] init];
+
+		for (i = 0; i < 10000; i++)
+			[[o retain] autorelease];
+
+		TEST(@"Autorelease pools spanning multiple pages",
+		    [o retainCount] == 20001 && R([inner drain]) &&
+		    [o retainCount] == 10001 && R([outer drain]) &&
+		    [o retainCount] == 1)
+
+		[o release];
+	}
+
+#ifdef HAVE_AUTORELEASE_POOL_STATISTICS
+	{
+		void *outer, *inner;
+		size_t i, count, peakDepth, oldPeakDepth;
+		uintmax_t autoreleases, oldAutoreleases;
+
+		o = [[OFObject alloc] init];
+		of_autorelease_pool_statistics(&oldPeakDepth,
+		    &oldAutoreleases);
+
+		/* Exceeds the old peak even if the current depth is 0 */
+		count = oldPeakDepth + 2;
+
+		outer = objc_autoreleasePoolPush();
+
+		for (i = 0; i < count / 2; i++)
+			[[o retain] autorelease];
+
+		inner = objc_autoreleasePoolPush();
+
+		for (; i < count; i++)
+			[[o retain] autorelease];
+
+		objc_autoreleasePoolPop(inner);
+		objc_autoreleasePoolPop(outer);
+
+		of_autorelease_pool_statistics(&peakDepth, &autoreleases);
+
+		TEST(@"of_autorelease_pool_statistics()",
+		    peakDepth > oldPeakDepth &&
+		    autoreleases == oldAutoreleases + count &&
+		    [o retainCount] == 1)
+
+		[o release];
+	}
+#endif
+
+#ifdef OF_OBJFW_RUNTIME
+	{
+		id o2, weak, strong;
+
+		o = [[OFObject alloc] init];
+
+		TEST(@"objc_initWeak()", objc_initWeak(&weak, o) == o)
+
+		TEST(@"objc_loadWeakRetained()",
+		    (strong = objc_loadWeakRetained(&weak)) == o &&
+		    [o retainCount] == 2 && R([strong release]))
+
+		TEST(@"Zeroing of weak references on dealloc",
+		    R([o release]) && weak == nil &&
+		    objc_loadWeakRetained(&weak) == nil)
+
+		o = [[OFObject alloc] init];
+		o2 = [[OFObject alloc] init];
+
+		TEST(@"objc_storeWeak()",
+		    objc_storeWeak(&weak, o) == o && weak == o &&
+		    objc_storeWeak(&weak, o2) == o2 && weak == o2 &&
+		    R([o release]) && weak == o2 &&
+		    objc_storeWeak(&weak, nil) == nil && weak == nil &&
+		    R([o2 release]) && weak == nil)
+
+		objc_destroyWeak(&weak);
+	}
+#endif
+
 	tmp = [self allocMemoryWithSize: 1024];
 	EXPECT_EXCEPTION(@"Detect freeing of memory not allocated by object",
 	    OFMemoryNotPartOfObjectException, [obj freeMemory: tmp])
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#ifndef _WIN32
+# include <netinet/in.h>
+#endif
+
+#import "OFResolver.h"
+#import "OFString.h"
+#import "OFDataArray.h"
+#import "OFAutoreleasePool.h"
+#ifdef OF_THREADS
+# import "OFThread.h"
+# import "OFCondition.h"
+# import "OFRunLoop.h"
+#endif
+
+#import "OFAddressTranslationFailedException.h"
+
+#import "macros.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFResolver";
+
+#ifdef OF_THREADS
+static OFCondition *cond;
+
+@interface OFResolverTestsThread: OFThread
+{
+@public
+	OFResolver *resolver;
+	int callbacks, failures;
+}
+@end
+
+@implementation OFResolverTestsThread
+- main
+{
+	SEL selector =
+	    @selector(resolver:didResolveHost:addresses:context:exception:);
+
+	/* The second lookup waits for the first one instead of starting one */
+	[resolver asyncResolveHost: @"localhost"
+			    target: self
+			  selector: selector
+			   context: nil];
+	[resolver asyncResolveHost: @"LOCALHOST"
+			    target: self
+			  selector: selector
+			   context: nil];
+
+	[[OFRunLoop currentRunLoop] run];
+
+	return nil;
+}
+
+-     (void)resolver: (OFResolver*)resolver_
+      didResolveHost: (OFString*)host
+	   addresses: (OFDataArray*)addresses
+	     context: (id)context
+	   exception: (OFException*)exception
+{
+	[cond lock];
+
+	if (resolver_ != resolver || [addresses count] == 0 ||
+	    exception != nil)
+		failures++;
+
+	if (++callbacks == 2)
+		[cond signal];
+
+	[cond unlock];
+}
+@end
+#endif
+
+@implementation TestsAppDelegate (OFResolverTests)
+- (void)resolverTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFResolver *resolver;
+	OFDataArray *addresses;
+	struct sockaddr_in *addr;
+#ifdef OF_THREADS
+	OFResolverTestsThread *thread;
+#endif
+
+	TEST(@"+[resolver]", (resolver = [OFResolver resolver]))
+
+	TEST(@"-[addressesForHost:]",
+	    (addresses = [resolver addressesForHost: @"127.0.0.1"]) &&
+	    [addresses count] == 1 &&
+	    (addr = [addresses firstItem]) && addr->sin_family == AF_INET &&
+	    addr->sin_port == 0 &&
+	    addr->sin_addr.s_addr == OF_BSWAP32_IF_LE(0x7F000001))
+
+	TEST(@"-[addressesForHost:] with a cached host",
+	    [[resolver addressesForHost: @"127.0.0.1"] isEqual: addresses])
+
+	EXPECT_EXCEPTION(@"Detection of an unknown host",
+	    OFAddressTranslationFailedException,
+	    [resolver addressesForHost: @"host.invalid"])
+
+#ifdef OF_THREADS
+	cond = [OFCondition condition];
+	[cond lock];
+
+	thread = [[[OFResolverTestsThread alloc] init] autorelease];
+	thread->resolver = resolver;
+	[thread start];
+
+	while (thread->callbacks < 2)
+		[cond wait];
+	[cond unlock];
+
+	TEST(@"-[asyncResolveHost:target:selector:context:]",
+	    thread->failures == 0)
+#endif
+
+	[pool drain];
+}
+@end
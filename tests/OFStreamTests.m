@@ -17,11 +17,14 @@
 #include "config.h"
 
 #include <string.h>
+#include <errno.h>
 
 #import "OFStream.h"
 #import "OFString.h"
 #import "OFAutoreleasePool.h"
 
+#import "OFReadFailedException.h"
+
 #import "TestsAppDelegate.h"
 
 static OFString *module = @"OFStream";
@@ -65,13 +68,37 @@ static OFString *module = @"OFStream";
 }
 @end
 
+@interface FailingStreamTester: OFStream
+@end
+
+@implementation FailingStreamTester
+- (BOOL)lowlevelIsAtEndOfStream
+{
+	return NO;
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)size
+{
+	OFReadFailedException *e = [OFReadFailedException
+	    exceptionWithClass: [self class]
+			stream: self
+	       requestedLength: size];
+	e->errNo = EIO;
+
+	@throw e;
+}
+@end
+
 @implementation TestsAppDelegate (OFStreamTests)
 - (void)streamTests
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	StreamTester *t = [[[StreamTester alloc] init] autorelease];
+	FailingStreamTester *ft;
 	OFString *str;
-	char *cstr;
+	char *cstr, buffer[4];
+	int errNo;
 
 	cstr = [t allocMemoryWithSize: of_pagesize - 2];
 	memset(cstr, 'X', of_pagesize - 3);
@@ -81,6 +108,15 @@ static OFString *module = @"OFStream";
 	    [(str = [t readLine]) length] == of_pagesize - 3 &&
 	    !strcmp([str UTF8String], cstr))
 
+	TEST(@"-[readIntoBuffer:length:error:]",
+	    [t readIntoBuffer: buffer
+		       length: sizeof(buffer)
+			error: &errNo] == 0 && errNo == 0 &&
+	    (ft = [[[FailingStreamTester alloc] init] autorelease]) &&
+	    [ft readIntoBuffer: buffer
+			length: sizeof(buffer)
+			 error: &errNo] == 0 && errNo == EIO)
+
 	[pool drain];
 }
 @end
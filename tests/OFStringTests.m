@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
 
 #import "OFString.h"
 #import "OFArray.h"
@@ -75,7 +76,7 @@ static uint16_t sutf16str[] = {
 	OFMutableString *s[3];
 	OFString *is;
 	OFArray *a;
-	int i;
+	int i, errNo;
 	const of_unichar_t *ua;
 	const uint16_t *u16a;
 	EntityHandler *h;
@@ -191,6 +192,15 @@ static uint16_t sutf16str[] = {
 	    OFInvalidEncodingException,
 	    [OFString stringWithUTF8String: "\xF0\x80\x80\xC0"])
 
+	TEST(@"+[stringWithUTF8String:length:error:]",
+	    (is = [OFString stringWithUTF8String: "foo\xC3\xA4"
+					  length: 5
+					   error: &errNo]) && errNo == 0 &&
+	    [is isEqual: @"fooä"] &&
+	    [OFString stringWithUTF8String: "\xF0\x80\x80\xC0"
+				    length: 4
+				     error: &errNo] == nil && errNo == EILSEQ)
+
 	TEST(@"-[reverse] on UTF-8 strings",
 	    (s[0] = [OFMutableString stringWithUTF8String: "äöü€𝄞"]) &&
 	    R([s[0] reverse]) && [s[0] isEqual: @"𝄞€üöä"])
@@ -338,6 +348,12 @@ static uint16_t sutf16str[] = {
 	    [@"-500\t" decimalValue] == -500 &&
 	    [@"\t\t\r\n" decimalValue] == 0)
 
+	TEST(@"-[decimalValueWithError:]",
+	    [@" -42 " decimalValueWithError: &errNo] == -42 && errNo == 0 &&
+	    [@"0 1" decimalValueWithError: &errNo] == 0 && errNo == EINVAL &&
+	    [@"12345678901234567890123456789012345678901234567890"
+	    decimalValueWithError: &errNo] == 0 && errNo == ERANGE)
+
 	TEST(@"-[hexadecimalValue]",
 	    [@"123f" hexadecimalValue] == 0x123f &&
 	    [@"\t\n0xABcd\r" hexadecimalValue] == 0xABCD &&
@@ -533,7 +549,12 @@ static uint16_t sutf16str[] = {
 
 	TEST(@"-[stringByXMLEscaping]",
 	    (s[0] = (id)[@"<hello> &world'\"!&" stringByXMLEscaping]) &&
-	    [s[0] isEqual: @"&lt;hello&gt; &amp;world&apos;&quot;!&amp;"])
+	    [s[0] isEqual: @"&lt;hello&gt; &amp;world&apos;&quot;!&amp;"] &&
+	    [[@"nothing to escape in here, not even in the tail\r"
+	    stringByXMLEscaping] isEqual:
+	    @"nothing to escape in here, not even in the tail&#xD;"] &&
+	    [[@"nothing to escape" stringByXMLEscaping] isEqual:
+	    @"nothing to escape"])
 
 	TEST(@"-[stringByXMLUnescaping]",
 	    [[s[0] stringByXMLUnescaping] isEqual: @"<hello> &world'\"!&"] &&
@@ -597,6 +618,37 @@ static uint16_t sutf16str[] = {
 	TEST(@"-[enumerateLinesUsingBlock:]", ok)
 #endif
 
+#if defined(OF_OBJFW_RUNTIME) && defined(OBJC_TAGGED_POINTERS)
+	TEST(@"Tagged pointers for short ASCII strings",
+	    (is = [OFString stringWithUTF8String: "tagged"]) &&
+	    object_isTaggedPointer(is) && [is length] == 6 &&
+	    [is characterAtIndex: 5] == 'd' &&
+	    !strcmp([is UTF8String], "tagged") &&
+	    !object_isTaggedPointer(
+	    [OFString stringWithUTF8String: "untagged"]) &&
+	    !object_isTaggedPointer(
+	    [OFString stringWithUTF8String: "t\xC3\xA4g"]))
+
+	TEST(@"Tagged and untagged strings are equal",
+	    [is isEqual: @"tagged"] && [@"tagged" isEqual: is] &&
+	    [is hash] == [@"tagged" hash] &&
+	    [is compare: @"tagges"] == OF_ORDERED_ASCENDING &&
+	    [[is uppercaseString] isEqual: @"TAGGED"])
+
+	TEST(@"-[hasPrefix:] on tagged strings",
+	    [is hasPrefix: @"tag"] && [is hasPrefix: @"tagged"] &&
+	    [is hasPrefix: @""] && ![is hasPrefix: @"tax"] &&
+	    ![is hasPrefix: @"tagged!"])
+
+	TEST(@"-[hasSuffix:] on tagged strings",
+	    [is hasSuffix: @"ged"] && [is hasSuffix: @"tagged"] &&
+	    [is hasSuffix: @""] && ![is hasSuffix: @"gad"] &&
+	    ![is hasSuffix: @"untagged"])
+
+	EXPECT_EXCEPTION(@"Detection of out of range in tagged strings",
+	    OFOutOfRangeException, [is characterAtIndex: 6])
+#endif
+
 	[pool drain];
 }
 @end
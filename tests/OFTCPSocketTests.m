@@ -18,9 +18,23 @@
 
 #include <string.h>
 
+#ifndef _WIN32
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+#endif
+
 #import "OFTCPSocket.h"
 #import "OFString.h"
+#import "OFArray.h"
 #import "OFAutoreleasePool.h"
+#ifdef OF_THREADS
+# import "OFThread.h"
+# import "OFCondition.h"
+# import "OFRunLoop.h"
+#endif
+
+#import "OFConnectionFailedException.h"
+#import "OFInvalidArgumentException.h"
 
 #import "macros.h"
 
@@ -28,6 +42,105 @@
 
 static OFString *module = @"OFTCPSocket";
 
+#ifdef OF_THREADS
+static OFCondition *cond;
+
+@interface OFTCPSocketTestsThread: OFThread
+{
+@public
+	uint16_t port, closedPort;
+	int callbacks;
+	BOOL connected, refused;
+}
+@end
+
+@implementation OFTCPSocketTestsThread
+- main
+{
+	SEL selector = @selector(socketDidConnect:context:exception:);
+
+	[[OFTCPSocket socket] asyncConnectToHost: @"127.0.0.1"
+					    port: port
+					  target: self
+					selector: selector
+					 context: @"connect"];
+	[[OFTCPSocket socket] asyncConnectToHost: @"127.0.0.1"
+					    port: closedPort
+					  target: self
+					selector: selector
+					 context: @"refuse"];
+
+	[[OFRunLoop currentRunLoop] run];
+
+	return nil;
+}
+
+- (void)socketDidConnect: (OFTCPSocket*)socket
+		 context: (id)context
+	       exception: (OFException*)exception
+{
+	[cond lock];
+
+	if ([context isEqual: @"connect"])
+		connected = (exception == nil);
+	else
+		refused = [exception isKindOfClass:
+		    [OFConnectionFailedException class]];
+
+	if (++callbacks == 2)
+		[cond signal];
+
+	[cond unlock];
+}
+@end
+
+@interface OFTCPSocketTestsAcceptThread: OFThread
+{
+@public
+	OFTCPSocket *listener;
+	size_t accepted, largestBatch;
+	BOOL failed;
+}
+@end
+
+@implementation OFTCPSocketTestsAcceptThread
+- main
+{
+	SEL selector = @selector(socket:didAcceptSockets:context:exception:);
+
+	[listener asyncAcceptBatchWithTarget: self
+				    selector: selector
+				     context: nil];
+
+	[[OFRunLoop currentRunLoop] run];
+
+	return nil;
+}
+
+-	  (BOOL)socket: (OFTCPSocket*)socket
+  didAcceptSockets: (OFArray*)sockets
+	   context: (id)context
+	 exception: (OFException*)exception
+{
+	[cond lock];
+
+	if (exception != nil)
+		failed = YES;
+
+	accepted += [sockets count];
+	if ([sockets count] > largestBatch)
+		largestBatch = [sockets count];
+
+	if (accepted >= 3 || failed)
+		[cond signal];
+
+	[cond unlock];
+
+	return (accepted < 3 && !failed);
+}
+@end
+#endif
+
 @implementation TestsAppDelegate (OFTCPSocketTests)
 - (void)TCPSocketTests
 {
@@ -35,6 +148,12 @@ static OFString *module = @"OFTCPSocket";
 	OFTCPSocket *server, *client = nil, *accepted;
 	uint16_t port;
 	char buf[6];
+#ifdef OF_THREADS
+	OFTCPSocketTestsThread *thread;
+	OFTCPSocketTestsAcceptThread *acceptThread;
+	OFTCPSocket *closed;
+	int i;
+#endif
 
 	TEST(@"+[socket]", (server = [OFTCPSocket socket]) &&
 	    (client = [OFTCPSocket socket]))
@@ -60,6 +179,152 @@ static OFString *module = @"OFTCPSocket";
 							     length: 6] &&
 	    !memcmp(buf, "Hello!", 6))
 
+	TEST(@"-[setNoDelayEnabled:]",
+	    R([client setNoDelayEnabled: YES]) && [client isNoDelayEnabled] &&
+	    R([client setNoDelayEnabled: NO]) && ![client isNoDelayEnabled])
+
+#if defined(TCP_CORK) || defined(TCP_NOPUSH)
+	TEST(@"-[setCorkEnabled:]",
+	    R([client setCorkEnabled: YES]) && [client isCorkEnabled] &&
+	    R([client setCorkEnabled: NO]) && ![client isCorkEnabled])
+#endif
+
+	TEST(@"-[setSendBufferSize:]",
+	    R([client setSendBufferSize: 65536]) &&
+	    [client sendBufferSize] >= 65536)
+
+	TEST(@"-[setReceiveBufferSize:]",
+	    R([accepted setReceiveBufferSize: 65536]) &&
+	    [accepted receiveBufferSize] >= 65536)
+
+#ifdef SO_REUSEPORT
+	{
+		OFTCPSocket *first = [OFTCPSocket socket];
+		OFTCPSocket *second = [OFTCPSocket socket];
+		uint16_t reusedPort;
+
+		TEST(@"-[setReusesPort:]",
+		    R([first setReusesPort: YES]) && [first reusesPort] &&
+		    R([second setReusesPort: YES]) &&
+		    (reusedPort = [first bindToHost: @"127.0.0.1"
+					       port: 0]) &&
+		    [second bindToHost: @"127.0.0.1"
+				  port: reusedPort] == reusedPort &&
+		    R([first listen]) && R([second listen]))
+	}
+#endif
+
+#ifdef TCP_FASTOPEN
+	{
+		OFTCPSocket *listener = [OFTCPSocket socket];
+
+		TEST(@"-[setFastOpenQueueLength:]",
+		    R([listener setFastOpenQueueLength: 16]) &&
+		    [listener fastOpenQueueLength] == 16 &&
+		    [listener bindToHost: @"127.0.0.1"
+				    port: 0] && R([listener listen]))
+	}
+#endif
+
+	EXPECT_EXCEPTION(@"Detect negative fast open queue length",
+	    OFInvalidArgumentException,
+	    [[OFTCPSocket socket] setFastOpenQueueLength: -1])
+
+#ifdef TCP_DEFER_ACCEPT
+	{
+		OFTCPSocket *listener = [OFTCPSocket socket];
+
+		TEST(@"-[setDeferredAcceptTimeout:]",
+		    R([listener setDeferredAcceptTimeout: 1.5]) &&
+		    [listener deferredAcceptTimeout] == 1.5 &&
+		    [listener bindToHost: @"127.0.0.1"
+				    port: 0] && R([listener listen]))
+	}
+#endif
+
+	EXPECT_EXCEPTION(@"Detect negative deferred accept timeout",
+	    OFInvalidArgumentException,
+	    [[OFTCPSocket socket] setDeferredAcceptTimeout: -1])
+
+	{
+		OFTCPSocket *full = [OFTCPSocket socket];
+		uint16_t fullPort = [full bindToHost: @"127.0.0.1"
+						port: 0];
+		BOOL failed = NO;
+		size_t j;
+
+		[full listenWithBackLog: 0];
+
+		/*
+		 * Once the backlog is full, connection attempts are either not
+		 * answered at all, so that they time out, or refused.
+		 */
+		for (j = 0; j < 16 && !failed; j++) {
+			OFTCPSocket *socket = [OFTCPSocket socket];
+
+			[socket setConnectTimeout: 0.5];
+
+			@try {
+				[socket connectToHost: @"127.0.0.1"
+						 port: fullPort];
+			} @catch (OFConnectionFailedException *e) {
+				failed = YES;
+			}
+		}
+
+		TEST(@"-[setConnectTimeout:]", failed)
+	}
+
+#ifdef OF_THREADS
+	closed = [OFTCPSocket socket];
+	cond = [OFCondition condition];
+	[cond lock];
+
+	thread = [[[OFTCPSocketTestsThread alloc] init] autorelease];
+	thread->port = port;
+	thread->closedPort = [closed bindToHost: @"127.0.0.1"
+					   port: 0];
+	[closed close];
+	[thread start];
+
+	while (thread->callbacks < 2)
+		[cond wait];
+	[cond unlock];
+
+	TEST(@"-[asyncConnectToHost:port:target:selector:context:]",
+	    thread->connected && R([server accept]))
+
+	TEST(@"-[asyncConnectToHost:port:target:selector:context:] failing",
+	    thread->refused)
+
+	acceptThread =
+	    [[[OFTCPSocketTestsAcceptThread alloc] init] autorelease];
+	acceptThread->listener = [OFTCPSocket socket];
+	port = [acceptThread->listener bindToHost: @"127.0.0.1"
+					     port: 0];
+	[acceptThread->listener listen];
+
+	TEST(@"-[setAcceptBatchLimit:]",
+	    R([acceptThread->listener setAcceptBatchLimit: 2]) &&
+	    [acceptThread->listener acceptBatchLimit] == 2)
+
+	/* All connections are pending before the thread starts accepting */
+	for (i = 0; i < 3; i++)
+		[[OFTCPSocket socket] connectToHost: @"127.0.0.1"
+					       port: port];
+
+	[cond lock];
+	[acceptThread start];
+
+	while (acceptThread->accepted < 3 && !acceptThread->failed)
+		[cond wait];
+	[cond unlock];
+
+	TEST(@"-[asyncAcceptBatchWithTarget:selector:context:]",
+	    !acceptThread->failed && acceptThread->accepted == 3 &&
+	    acceptThread->largestBatch == 2)
+#endif
+
 	[pool drain];
 }
 @end
@@ -17,9 +17,13 @@
 #include "config.h"
 
 #import "OFThread.h"
+#import "OFCondition.h"
+#import "OFStopwatch.h"
 #import "OFString.h"
 #import "OFAutoreleasePool.h"
 
+#import "of_clock.h"
+
 #import "TestsAppDelegate.h"
 
 static OFString *module = @"OFThread";
@@ -43,6 +47,9 @@ static OFString *module = @"OFThread";
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	TestThread *t;
 	OFTLSKey *key;
+	OFCondition *c;
+	OFStopwatch *s;
+	uint64_t now;
 
 	TEST(@"+[threadWithObject:]",
 	    (t = [TestThread threadWithObject: @"foo"]))
@@ -62,6 +69,29 @@ static OFString *module = @"OFThread";
 	TEST(@"+[objectForTLSKey:]",
 	    [[OFThread objectForTLSKey: key] isEqual: @"foo"])
 
+	now = of_monotonic_time();
+	TEST(@"of_deadline_after() and of_deadline_remaining()",
+	    of_deadline_after(now, 1.5) == now + 1500000000 &&
+	    of_deadline_after(now, -1) == now &&
+	    of_deadline_after(now, 1e30) == OF_DEADLINE_NEVER &&
+	    of_deadline_remaining(now + 500000000, now) == 0.5 &&
+	    of_deadline_remaining(now, now + 1) == 0)
+
+	c = [OFCondition condition];
+	s = [OFStopwatch startedStopwatch];
+	[c lock];
+
+	TEST(@"OFCondition's -[waitForTimeInterval:] times out",
+	    ![c waitForTimeInterval: 0.01] &&
+	    ![c waitUntilDeadline: of_monotonic_time()])
+
+	[c unlock];
+	[s stop];
+
+	TEST(@"OFStopwatch", ![s isRunning] && [s elapsedTime] >= 0.01 &&
+	    [s elapsedNanoseconds] == [s elapsedNanoseconds] &&
+	    R([s reset]) && [s elapsedNanoseconds] == 0)
+
 	[pool drain];
 }
 @end
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFXMLCompactDocument.h"
+#import "OFXMLElement.h"
+#import "OFString.h"
+#import "OFAutoreleasePool.h"
+
+#import "OFMalformedXMLException.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFXMLCompactDocument";
+
+@implementation TestsAppDelegate (OFXMLCompactDocumentTests)
+- (void)XMLCompactDocumentTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFXMLCompactDocument *doc;
+	OFXMLElement *element;
+	size_t entry;
+
+	TEST(@"+[documentWithString:]",
+	    (doc = [OFXMLCompactDocument documentWithString:
+	    @"<?xml version='1.0'?><!-- c -->\n"
+	    @"<feed xmlns='urn:feed' xmlns:x='urn:x'>"
+	    @"<entry x:id='1'>a &amp; b<![CDATA[<c>]]></entry>"
+	    @"<entry x:id='2'/><!--d-->"
+	    @"</feed>"]))
+
+	TEST(@"-[nodesCount]", [doc nodesCount] == 6)
+
+	TEST(@"Navigation",
+	    [doc typeOfNodeAtIndex: 0] == OF_XML_COMPACT_NODE_ELEMENT &&
+	    [doc parentOfNodeAtIndex: 0] == OF_NOT_FOUND &&
+	    [doc childrenCountOfNodeAtIndex: 0] == 3 &&
+	    [doc firstChildOfNodeAtIndex: 0] == 1 &&
+	    [doc nextSiblingOfNodeAtIndex: 1] == 4 &&
+	    [doc nextSiblingOfNodeAtIndex: 4] == 5 &&
+	    [doc nextSiblingOfNodeAtIndex: 5] == OF_NOT_FOUND &&
+	    [doc parentOfNodeAtIndex: 3] == 1 &&
+	    [doc typeOfNodeAtIndex: 5] == OF_XML_COMPACT_NODE_COMMENT)
+
+	TEST(@"-[indexOfChildElementWithName:namespace:ofNodeAtIndex:]",
+	    (entry = [doc indexOfChildElementWithName: @"entry"
+					    namespace: @"urn:feed"
+					ofNodeAtIndex: 0]) == 1 &&
+	    [doc indexOfChildElementWithName: @"entry"
+				   namespace: nil
+			       ofNodeAtIndex: 0] == OF_NOT_FOUND)
+
+	TEST(@"-[nameOfNodeAtIndex:] and -[namespaceOfNodeAtIndex:]",
+	    [[doc nameOfNodeAtIndex: entry] isEqual: @"entry"] &&
+	    [[doc namespaceOfNodeAtIndex: entry] isEqual: @"urn:feed"] &&
+	    of_xml_slice_is_equal([doc sliceOfNodeAtIndex: 2], "a &amp; b"))
+
+	TEST(@"-[stringValueOfNodeAtIndex:]",
+	    [[doc stringValueOfNodeAtIndex: 2] isEqual: @"a & b"] &&
+	    [[doc stringValueOfNodeAtIndex: entry] isEqual: @"a & b<c>"])
+
+	TEST(@"-[valueOfAttributeWithName:namespace:ofNodeAtIndex:]",
+	    [doc attributesCountOfNodeAtIndex: 0] == 1 &&
+	    [[doc valueOfAttributeWithName: @"id"
+				 namespace: @"urn:x"
+			     ofNodeAtIndex: 4] isEqual: @"2"] &&
+	    [doc valueOfAttributeWithName: @"id"
+				namespace: nil
+			    ofNodeAtIndex: 4] == nil)
+
+	TEST(@"-[nodeAtIndex:]",
+	    (element = (OFXMLElement*)[doc nodeAtIndex: entry]) &&
+	    [doc nodeAtIndex: entry] == element &&
+	    [[element stringValue] isEqual: @"a & b<c>"] &&
+	    [[[element attributeForName: @"id"
+			      namespace: @"urn:x"] stringValue] isEqual: @"1"])
+
+	TEST(@"-[rootElement]",
+	    [[[doc rootElement] XMLString] isEqual:
+	    @"<feed xmlns='urn:feed' xmlns:x='urn:x'>"
+	    @"<entry x:id='1'>a &amp; b<![CDATA[<c>]]></entry>"
+	    @"<entry x:id='2'/><!--d-->"
+	    @"</feed>"])
+
+	EXPECT_EXCEPTION(@"Detection of missing root element",
+	    OFMalformedXMLException,
+	    [OFXMLCompactDocument documentWithString: @"<!-- foo -->"])
+
+	[pool drain];
+}
+@end
@@ -16,24 +16,48 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #import "OFXMLElement.h"
 #import "OFXMLCharacters.h"
 #import "OFXMLCDATA.h"
 #import "OFXMLComment.h"
 #import "OFString.h"
 #import "OFArray.h"
+#import "OFStream.h"
 #import "OFAutoreleasePool.h"
 
 #import "TestsAppDelegate.h"
 
 static OFString *module = @"OFXMLNode";
 
+@interface XMLNodeStreamTester: OFStream
+{
+@public
+	char buffer[128];
+	size_t length;
+}
+@end
+
+@implementation XMLNodeStreamTester
+- (void)lowlevelWriteBuffer: (const void*)buffer_
+		     length: (size_t)length_
+{
+	if (length + length_ > sizeof(buffer))
+		length_ = sizeof(buffer) - length;
+
+	memcpy(buffer + length, buffer_, length_);
+	length += length_;
+}
+@end
+
 @implementation TestsAppDelegate (OFXMLNodeTests)
 - (void)XMLNodeTests
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	id nodes[4];
 	OFArray *a;
+	XMLNodeStreamTester *stream;
 
 	TEST(@"+[elementWithName:]",
 	    (nodes[0] = [OFXMLElement elementWithName: @"foo"]) &&
@@ -145,6 +169,24 @@ static OFString *module = @"OFXMLNode";
 	    @"<!-- foo --></y></x>"] XMLStringWithIndentation: 2] isEqual:
 	    @"<x>\n  <y>\n    <z>a\nb</z>\n    <!-- foo -->\n  </y>\n</x>"])
 
+	stream = [[[XMLNodeStreamTester alloc] init] autorelease];
+	TEST(@"-[writeToStream:indentation:]",
+	    R([[OFXMLElement elementWithXMLString: @"<x a='&lt;'><y>&amp;</y>"
+	    @"<z/></x>"] writeToStream: stream
+			   indentation: 1]) &&
+	    stream->length == 37 && !memcmp(stream->buffer,
+	    "<x a='&lt;'>\n <y>&amp;</y>\n <z/>\n</x>", 37))
+
+	TEST(@"-[XMLString] with a prefix bound to the default namespace",
+	    (nodes[0] = [OFXMLElement elementWithName: @"x"
+					    namespace: @"urn:objfw:test"]) &&
+	    R([nodes[0] setDefaultNamespace: @"urn:objfw:test"]) &&
+	    R([nodes[0] setPrefix: @"objfw-test"
+		     forNamespace: @"urn:objfw:test"]) &&
+	    R([nodes[0] addChild: [OFXMLElement elementWithName: @"y"
+		       namespace: @"urn:objfw:test"]]) &&
+	    [[nodes[0] XMLString] isEqual: @"<x><y/></x>"])
+
 	[pool drain];
 }
 @end
@@ -20,6 +20,7 @@
 #include <string.h>
 
 #import "OFXMLParser.h"
+#import "OFXMLNameTable.h"
 #import "OFString.h"
 #import "OFArray.h"
 #import "OFAutoreleasePool.h"
@@ -339,6 +340,8 @@ enum event_type {
 	    " </foobar>\n"
 	    "</root>";
 	size_t j, len;
+	OFXMLNameTable *table;
+	OFString *name;
 
 	TEST(@"+[xmlParser]", (parser = [OFXMLParser parser]))
 
@@ -391,6 +394,20 @@ enum event_type {
 	    OFMalformedXMLException,
 	    [parser parseString: @"<x><?xml?></x>"])
 
+	table = [OFXMLNameTable nameTable];
+	TEST(@"-[OFXMLNameTable nameForUTF8String:length:]",
+	    (name = [table nameForUTF8String: "foo:bar"
+				      length: 3]) &&
+	    [name isEqual: @"foo"] &&
+	    [table nameForUTF8String: "foo"
+			      length: 3] == name &&
+	    [table nameForString: @"foo"] == name && [table count] == 1)
+
+	parser = [OFXMLParser parser];
+	TEST(@"-[setNameTable:]", R([parser setNameTable: table]) &&
+	    R([parser parseString: @"<foo xmlns:p='urn:p'><p:foo/></foo>"]) &&
+	    [parser finishedParsing] && [table nameForString: @"foo"] == name)
+
 	[pool drain];
 }
 @end
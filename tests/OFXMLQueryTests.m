@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFXMLQuery.h"
+#import "OFXMLElement.h"
+#import "OFString.h"
+#import "OFArray.h"
+#import "OFDictionary.h"
+#import "OFAutoreleasePool.h"
+
+#import "OFInvalidFormatException.h"
+#import "OFUnboundNamespaceException.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFXMLQuery";
+
+@implementation TestsAppDelegate (OFXMLQueryTests)
+- (void)XMLQueryTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFXMLElement *feed;
+	OFDictionary *namespaces;
+	OFXMLQuery *query;
+	OFArray *matches;
+
+	feed = [OFXMLElement elementWithXMLString:
+	    @"<feed xmlns='urn:feed' xmlns:x='urn:x'>\n"
+	    @" <entry type='text'><title>A</title></entry>\n"
+	    @" <entry type='html'><title>B</title>"
+	    @"<sub><title>C</title></sub></entry>\n"
+	    @" <x:meta x:id='1'/>\n"
+	    @"</feed>"];
+	namespaces = [OFDictionary dictionaryWithKeysAndObjects:
+	    @"f", @"urn:feed", @"x", @"urn:x", nil];
+
+	TEST(@"+[queryWithString:namespaces:]",
+	    (query = [OFXMLQuery queryWithString: @"f:entry/f:title"
+				      namespaces: namespaces]))
+
+	TEST(@"-[matchesInElement:] with child steps",
+	    (matches = [query matchesInElement: feed]) &&
+	    [matches count] == 2 &&
+	    [[[matches objectAtIndex: 0] stringValue] isEqual: @"A"] &&
+	    [[[matches objectAtIndex: 1] stringValue] isEqual: @"B"])
+
+	TEST(@"-[matchesInElement:] with descendant steps",
+	    (matches = [[OFXMLQuery queryWithString: @"/f:feed//f:title"
+					 namespaces: namespaces]
+	    matchesInElement: feed]) && [matches count] == 3 &&
+	    [[[matches objectAtIndex: 2] stringValue] isEqual: @"C"])
+
+	TEST(@"-[firstMatchInElement:] with attribute predicates",
+	    [[[[OFXMLQuery queryWithString: @"f:entry[@type='html']/f:title"
+				namespaces: namespaces]
+	    firstMatchInElement: feed] stringValue] isEqual: @"B"] &&
+	    [[OFXMLQuery queryWithString: @"x:meta[@x:id = \"1\"]"
+			      namespaces: namespaces]
+	    firstMatchInElement: feed] != nil &&
+	    [[OFXMLQuery queryWithString: @"x:meta[@id]"
+			      namespaces: namespaces]
+	    firstMatchInElement: feed] == nil)
+
+	TEST(@"Wildcards",
+	    [[[OFXMLQuery queryWithString: @"*"] matchesInElement: feed]
+	    count] == 3 &&
+	    [[[OFXMLQuery queryWithString: @"x:*"
+			       namespaces: namespaces]
+	    matchesInElement: feed] count] == 1)
+
+	TEST(@"Default namespace",
+	    [[[OFXMLQuery queryWithString: @"entry/title"
+			       namespaces: [OFDictionary
+					       dictionaryWithObject: @"urn:feed"
+							     forKey: @""]]
+	    matchesInElement: feed] count] == 2 &&
+	    [[[OFXMLQuery queryWithString: @"entry/title"]
+	    matchesInElement: feed] count] == 0)
+
+	TEST(@"-[setUsesIndexes:]",
+	    R([query setUsesIndexes: YES]) &&
+	    [[query matchesInElement: feed] count] == 2 &&
+	    [[query matchesInElement: feed] count] == 2 &&
+	    R([feed addChild: [OFXMLElement
+	    elementWithXMLString: @"<entry xmlns='urn:feed'><title>D</title>"
+				  @"</entry>"]]) &&
+	    [[query matchesInElement: feed] count] == 3)
+
+#ifdef OF_HAVE_BLOCKS
+	{
+		__block size_t count = 0;
+
+		[query enumerateMatchesInElement: feed
+				      usingBlock: ^ (OFXMLElement *element,
+						      BOOL *stop) {
+			if (++count == 2)
+				*stop = YES;
+		}];
+
+		TEST(@"-[enumerateMatchesInElement:usingBlock:]", count == 2)
+	}
+#endif
+
+	EXPECT_EXCEPTION(@"Detection of invalid paths",
+	    OFInvalidFormatException,
+	    [OFXMLQuery queryWithString: @"entry/"])
+
+	EXPECT_EXCEPTION(@"Detection of unbound prefixes",
+	    OFUnboundNamespaceException,
+	    [OFXMLQuery queryWithString: @"y:entry"
+			     namespaces: namespaces])
+
+	[pool drain];
+}
+@end
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFXMLReader.h"
+#import "OFXMLAttribute.h"
+#import "OFString.h"
+#import "OFArray.h"
+#import "OFStream.h"
+#import "OFAutoreleasePool.h"
+
+#import "OFMalformedXMLException.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFXMLReader";
+static const char *document = "<?xml version='1.0'?>\r\n"
+    "<root xmlns:foo='urn:foo'>"
+    "<skip><a><b>c</b></a><d/></skip>"
+    "<foo:item id='1' foo:x='&lt;y'>a &amp; b</foo:item>"
+    "<![CDATA[<c>]]><!--comment--><empty/>"
+    "</root>\n";
+
+/* Returns only a few bytes per read, so that tokens are split across reads */
+@interface XMLReaderStreamTester: OFStream
+{
+@public
+	const char *data;
+	size_t length, position;
+}
+@end
+
+@implementation XMLReaderStreamTester
+- (BOOL)lowlevelIsAtEndOfStream
+{
+	return (position >= length);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void*)buffer
+			  length: (size_t)size
+{
+	if (size > 7)
+		size = 7;
+	if (size > length - position)
+		size = length - position;
+
+	memcpy(buffer, data + position, size);
+	position += size;
+
+	return size;
+}
+@end
+
+@implementation TestsAppDelegate (OFXMLReaderTests)
+- (void)XMLReaderTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFXMLReader *reader;
+	OFArray *attrs;
+	OFMutableString *longDocument;
+	XMLReaderStreamTester *stream;
+	size_t i;
+
+	TEST(@"+[readerWithBuffer:length:]",
+	    (reader = [OFXMLReader readerWithBuffer: document
+					     length: strlen(document)]))
+
+	TEST(@"-[nextToken] for processing instructions",
+	    [reader nextToken] == OF_XML_READER_TOKEN_PROCESSING_INSTRUCTIONS &&
+	    [[reader stringValue] isEqual: @"xml version='1.0'"])
+
+	TEST(@"-[nextToken] for start element",
+	    [reader nextToken] == OF_XML_READER_TOKEN_START_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "root") &&
+	    [reader depth] == 1 && [reader attributesCount] == 1)
+
+	TEST(@"-[skipElement]",
+	    [reader nextToken] == OF_XML_READER_TOKEN_START_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "skip") &&
+	    R([reader skipElement]) &&
+	    [reader token] == OF_XML_READER_TOKEN_END_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "skip"))
+
+	TEST(@"Prefixed start element",
+	    [reader nextToken] == OF_XML_READER_TOKEN_START_ELEMENT &&
+	    of_xml_slice_is_equal([reader qualifiedNameSlice], "foo:item") &&
+	    of_xml_slice_is_equal([reader prefixSlice], "foo") &&
+	    [[reader name] isEqual: @"item"] &&
+	    [[reader namespace] isEqual: @"urn:foo"])
+
+	TEST(@"Attribute slices",
+	    [reader attributesCount] == 2 &&
+	    of_xml_slice_is_equal([reader attributeNameSliceAtIndex: 1], "x") &&
+	    of_xml_slice_is_equal([reader attributePrefixSliceAtIndex: 1],
+	    "foo") &&
+	    of_xml_slice_is_equal([reader attributeValueSliceAtIndex: 1],
+	    "&lt;y"))
+
+	TEST(@"-[attributeValueForName:]",
+	    [[reader attributeValueForName: "id"] isEqual: @"1"] &&
+	    [reader attributeValueForName: "x"] == nil)
+
+	TEST(@"-[attributes]", (attrs = [reader attributes]) &&
+	    [attrs count] == 2 &&
+	    [[[attrs objectAtIndex: 1] namespace] isEqual: @"urn:foo"] &&
+	    [[[attrs objectAtIndex: 1] stringValue] isEqual: @"<y"])
+
+	TEST(@"-[nextToken] for characters",
+	    [reader nextToken] == OF_XML_READER_TOKEN_CHARACTERS &&
+	    of_xml_slice_is_equal([reader contentSlice], "a &amp; b") &&
+	    [[reader stringValue] isEqual: @"a & b"])
+
+	TEST(@"-[nextToken] for end element",
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_ELEMENT &&
+	    [[reader namespace] isEqual: @"urn:foo"])
+
+	TEST(@"-[nextToken] for CDATA",
+	    [reader nextToken] == OF_XML_READER_TOKEN_CDATA &&
+	    [[reader stringValue] isEqual: @"<c>"])
+
+	TEST(@"-[nextToken] for comment",
+	    [reader nextToken] == OF_XML_READER_TOKEN_COMMENT &&
+	    [[reader stringValue] isEqual: @"comment"])
+
+	TEST(@"-[nextToken] for empty element",
+	    [reader nextToken] == OF_XML_READER_TOKEN_START_ELEMENT &&
+	    [reader isEmptyElement] && [reader depth] == 2 &&
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "empty"))
+
+	TEST(@"-[nextToken] for end of document",
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_ELEMENT &&
+	    [reader depth] == 1 &&
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_OF_DOCUMENT)
+
+	EXPECT_EXCEPTION(@"Detection of mismatched end element",
+	    OFMalformedXMLException,
+	    reader = [OFXMLReader readerWithBuffer: "<a><b></a>"
+					    length: 10];
+	    while ([reader nextToken] != OF_XML_READER_TOKEN_END_OF_DOCUMENT);)
+
+	EXPECT_EXCEPTION(@"Detection of unclosed element",
+	    OFMalformedXMLException,
+	    reader = [OFXMLReader readerWithBuffer: "<a><b/>"
+					    length: 7];
+	    while ([reader nextToken] != OF_XML_READER_TOKEN_END_OF_DOCUMENT);)
+
+	/* The text is longer than the initial buffer of the reader */
+	longDocument = [OFMutableString stringWithString: @"<root><a>"];
+	for (i = 0; i < 2 * of_pagesize; i++)
+		[longDocument appendString: @"x"];
+	[longDocument appendString: @"</a><b c='d'/></root>"];
+
+	stream = [[[XMLReaderStreamTester alloc] init] autorelease];
+	stream->data = [longDocument UTF8String];
+	stream->length = [longDocument UTF8StringLength];
+
+	TEST(@"+[readerWithStream:]",
+	    (reader = [OFXMLReader readerWithStream: stream]))
+
+	TEST(@"-[nextToken] with tokens split across reads",
+	    [reader nextToken] == OF_XML_READER_TOKEN_START_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "root") &&
+	    [reader nextToken] == OF_XML_READER_TOKEN_START_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "a"))
+
+	TEST(@"-[nextToken] with a token longer than the buffer",
+	    [reader nextToken] == OF_XML_READER_TOKEN_CHARACTERS &&
+	    [reader contentSlice].length == 2 * of_pagesize &&
+	    [reader contentSlice].bytes[0] == 'x' &&
+	    [reader contentSlice].bytes[2 * of_pagesize - 1] == 'x')
+
+	TEST(@"-[nextToken] after growing the buffer",
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "a") &&
+	    [reader nextToken] == OF_XML_READER_TOKEN_START_ELEMENT &&
+	    [[reader attributeValueForName: "c"] isEqual: @"d"] &&
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_ELEMENT &&
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_ELEMENT &&
+	    of_xml_slice_is_equal([reader nameSlice], "root") &&
+	    [reader nextToken] == OF_XML_READER_TOKEN_END_OF_DOCUMENT)
+
+	stream = [[[XMLReaderStreamTester alloc] init] autorelease];
+	stream->data = "<abcdefgh><abcdefgi></abcdefgh></abcdefgi>";
+	stream->length = strlen(stream->data);
+
+	EXPECT_EXCEPTION(@"Detection of mismatched end element in a stream",
+	    OFMalformedXMLException,
+	    reader = [OFXMLReader readerWithStream: stream];
+	    while ([reader nextToken] != OF_XML_READER_TOKEN_END_OF_DOCUMENT);)
+
+	[pool drain];
+}
+@end
@@ -96,10 +96,18 @@
 - (void)forwardingTests;
 @end
 
+@interface TestsAppDelegate (OFGZIPStreamTests)
+- (void)GZIPStreamTests;
+@end
+
 @interface TestsAppDelegate (OFHTTPRequestTests)
 - (void)HTTPRequestTests;
 @end
 
+@interface TestsAppDelegate (OFHTTPServerTests)
+- (void)HTTPServerTests;
+@end
+
 @interface TestsAppDelegate (OFJSONTests)
 - (void)JSONTests;
 @end
@@ -148,6 +156,10 @@
 - (void)stringTests;
 @end
 
+@interface TestsAppDelegate (OFResolverTests)
+- (void)resolverTests;
+@end
+
 @interface TestsAppDelegate (OFTCPSocketTests)
 - (void)TCPSocketTests;
 @end
@@ -164,6 +176,10 @@
 - (void)XMLElementBuilderTests;
 @end
 
+@interface TestsAppDelegate (OFXMLCompactDocumentTests)
+- (void)XMLCompactDocumentTests;
+@end
+
 @interface TestsAppDelegate (OFXMLNodeTests)
 - (void)XMLNodeTests;
 @end
@@ -171,3 +187,11 @@
 @interface TestsAppDelegate (OFXMLParserTests) <OFXMLElementBuilderDelegate>
 - (void)XMLParserTests;
 @end
+
+@interface TestsAppDelegate (OFXMLQueryTests)
+- (void)XMLQueryTests;
+@end
+
+@interface TestsAppDelegate (OFXMLReaderTests)
+- (void)XMLReaderTests;
+@end
@@ -128,6 +128,8 @@ OF_APPLICATION_DELEGATE(TestsAppDelegate)
 	[self dateTests];
 	[self numberTests];
 	[self streamTests];
+	[self GZIPStreamTests];
+	[self resolverTests];
 	[self TCPSocketTests];
 #ifdef OF_THREADS
 	[self threadTests];
@@ -135,10 +137,14 @@ OF_APPLICATION_DELEGATE(TestsAppDelegate)
 	[self URLTests];
 #ifdef OF_THREADS
 	[self HTTPRequestTests];
+	[self HTTPServerTests];
 #endif
 	[self XMLParserTests];
+	[self XMLReaderTests];
 	[self XMLNodeTests];
+	[self XMLQueryTests];
 	[self XMLElementBuilderTests];
+	[self XMLCompactDocumentTests];
 	[self serializationTests];
 	[self JSONTests];
 #ifdef OF_PLUGINS
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#import "OFHTTPServer.h"
+#import "OFHTTPRequest.h"
+#import "OFHTTPConnectionPool.h"
+#import "OFString.h"
+#import "OFThread.h"
+#import "OFCondition.h"
+#import "OFRunLoop.h"
+#import "OFURL.h"
+#import "OFArray.h"
+#import "OFDictionary.h"
+#import "OFStopwatch.h"
+#import "OFAutoreleasePool.h"
+
+#define REQUESTS 10000
+#define PIPELINE_DEPTH 16
+
+static OFCondition *cond;
+
+@interface ServerThread: OFThread <OFHTTPServerDelegate>
+{
+@public
+	uint16_t port;
+}
+@end
+
+@implementation ServerThread
+- main
+{
+	OFHTTPServer *server = [OFHTTPServer server];
+
+	[cond lock];
+
+	[server setDelegate: self];
+	[server start];
+	port = [server port];
+
+	[cond signal];
+	[cond unlock];
+
+	[[OFRunLoop currentRunLoop] run];
+
+	return nil;
+}
+
+-      (void)server: (OFHTTPServer*)server
+  didReceiveRequest: (OFHTTPServerRequest*)request
+	   response: (OFHTTPServerResponse*)response
+{
+	[[response headers] setObject: @"13"
+			       forKey: @"Content-Length"];
+	[response writeString: @"Hello, world!"];
+}
+@end
+
+static void
+report(const char *name, OFStopwatch *stopwatch)
+{
+	printf("%-24s %8d requests in %.3f s, %.0f requests/s\n", name,
+	    REQUESTS, [stopwatch elapsedTime],
+	    REQUESTS / [stopwatch elapsedTime]);
+}
+
+int
+main()
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	ServerThread *thread;
+	OFHTTPConnectionPool *connectionPool;
+	OFHTTPRequest *request;
+	OFMutableArray *batch;
+	OFStopwatch *stopwatch;
+	size_t i;
+
+	cond = [OFCondition condition];
+	[cond lock];
+
+	thread = [[[ServerThread alloc] init] autorelease];
+	[thread start];
+
+	[cond wait];
+	[cond unlock];
+
+	connectionPool = [[[OFHTTPConnectionPool alloc] init] autorelease];
+	request = [OFHTTPRequest requestWithURL: [OFURL URLWithString:
+	    [OFString stringWithFormat: @"http://127.0.0.1:%" @PRIu16 "/",
+					thread->port]]];
+	[request setConnectionPool: connectionPool];
+
+	stopwatch = [OFStopwatch startedStopwatch];
+	for (i = 0; i < REQUESTS; i++) {
+		void *pool2 = objc_autoreleasePoolPush();
+		[request perform];
+		objc_autoreleasePoolPop(pool2);
+	}
+	[stopwatch stop];
+	report("keep-alive", stopwatch);
+
+	batch = [OFMutableArray array];
+	for (i = 0; i < PIPELINE_DEPTH; i++)
+		[batch addObject: request];
+
+	stopwatch = [OFStopwatch startedStopwatch];
+	for (i = 0; i < REQUESTS / PIPELINE_DEPTH; i++) {
+		void *pool2 = objc_autoreleasePoolPush();
+		[OFHTTPRequest performRequests: batch];
+		objc_autoreleasePoolPop(pool2);
+	}
+	[stopwatch stop];
+	report("pipelined", stopwatch);
+
+	[pool drain];
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012
+ *   Jonathan Schleifer <js@webkeks.org>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#import "OFObject.h"
+
+#define ITERATIONS 10000000
+#define NUM_SELECTORS 256
+
+@interface Dispatchee: OFObject
+- (void)hot;
+@end
+
+@implementation Dispatchee
+- (void)hot
+{
+}
+@end
+
+static void
+method(id self, SEL _cmd)
+{
+}
+
+static double
+now(void)
+{
+	struct timeval t;
+
+	gettimeofday(&t, NULL);
+
+	return t.tv_sec + (double)t.tv_usec / 1000000;
+}
+
+static void
+report(const char *name, double start)
+{
+	double seconds = now() - start;
+
+	printf("%-32s %8.3f s  %6.2f ns/lookup\n", name, seconds,
+	    seconds * 1000000000 / ITERATIONS);
+}
+
+int
+main()
+{
+	Dispatchee *obj = [[Dispatchee alloc] init];
+	Class cls = [Dispatchee class];
+	SEL hot = @selector(hot);
+	SEL selectors[NUM_SELECTORS];
+	volatile IMP imp;
+	double start;
+	unsigned i;
+
+	for (i = 0; i < NUM_SELECTORS; i++) {
+		char name[32];
+
+		snprintf(name, sizeof(name), "dispatchBenchmark%u", i);
+		selectors[i] = sel_registerName(name);
+		class_replaceMethod(cls, selectors[i], (IMP)method, "v16@0:8");
+	}
+
+	/* Make sure everything is set up before measuring */
+	[obj hot];
+
+	start = now();
+	for (i = 0; i < ITERATIONS; i++)
+		imp = objc_msg_lookup(obj, hot);
+	report("objc_msg_lookup, one selector", start);
+
+	start = now();
+	for (i = 0; i < ITERATIONS; i++)
+		imp = class_getMethodImplementation(cls, hot);
+	report("dtable only, one selector", start);
+
+	start = now();
+	for (i = 0; i < ITERATIONS; i++)
+		imp = objc_msg_lookup(obj, selectors[i % 8]);
+	report("objc_msg_lookup, 8 selectors", start);
+
+	/* More selectors than cache entries, so most lookups miss */
+	start = now();
+	for (i = 0; i < ITERATIONS; i++)
+		imp = objc_msg_lookup(obj, selectors[i % NUM_SELECTORS]);
+	report("objc_msg_lookup, 256 selectors", start);
+
+	start = now();
+	for (i = 0; i < ITERATIONS; i++)
+		[obj hot];
+	report("message send", start);
+
+	(void)imp;
+	[obj release];
+
+	return 0;
+}